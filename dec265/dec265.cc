@@ -76,6 +76,8 @@ int highestTID = 100;
 int verbosity=0;
 int disable_deblocking=0;
 int disable_sao=0;
+int split_parsing=0;
+const char* trace_filename = NULL;
 
 static struct option long_options[] = {
   {"quiet",      no_argument,       0, 'q' },
@@ -98,6 +100,8 @@ static struct option long_options[] = {
   {"verbose",    no_argument,       0, 'v' },
   {"disable-deblocking", no_argument, &disable_deblocking, 1 },
   {"disable-sao",        no_argument, &disable_sao, 1 },
+  {"split-parsing",      no_argument, &split_parsing, 1 },
+  {"trace",        required_argument, 0, 'R' },
   {0,         0,                 0,  0 }
 };
 
@@ -569,6 +573,7 @@ int main(int argc, char** argv)
     case 'e': show_psnr_map=true; break;
     case 'T': highestTID=atoi(optarg); break;
     case 'v': verbosity++; break;
+    case 'R': trace_filename=optarg; break;
     }
   }
 
@@ -601,6 +606,9 @@ int main(int argc, char** argv)
     fprintf(stderr,"  -T, --highest-TID select highest temporal sublayer to decode\n");
     fprintf(stderr,"      --disable-deblocking   disable deblocking filter\n");
     fprintf(stderr,"      --disable-sao          disable sample-adaptive offset filter\n");
+    fprintf(stderr,"      --split-parsing        reconstruct CTB rows in parallel to parsing (with -t)\n");
+    fprintf(stderr,"      --trace FILE           write timing of decoding tasks as Chrome trace JSON\n");
+    fprintf(stderr,"                             (libde265 has to be built with tracing enabled)\n");
     fprintf(stderr,"  -h, --help        show help\n");
 
     exit(show_help ? 0 : 5);
@@ -616,6 +624,8 @@ int main(int argc, char** argv)
 
   de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_DISABLE_DEBLOCKING, disable_deblocking);
   de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_DISABLE_SAO, disable_sao);
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_SPLIT_PARSING, split_parsing);
+  de265_set_parameter_bool(ctx, DE265_DECODER_PARAM_TRACE, trace_filename != NULL);
 
   if (dump_headers) {
     de265_set_parameter_int(ctx, DE265_DECODER_PARAM_DUMP_SPS_HEADERS, 1);
@@ -786,6 +796,13 @@ int main(int argc, char** argv)
     fclose(reference_file);
   }
 
+  if (trace_filename) {
+    de265_error trace_err = de265_write_trace(ctx, trace_filename);
+    if (trace_err != DE265_OK) {
+      fprintf(stderr,"cannot write trace: %s\n", de265_get_error_text(trace_err));
+    }
+  }
+
   de265_free_decoder(ctx);
 
   struct timeval tv_end;
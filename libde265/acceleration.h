@@ -151,12 +151,16 @@ struct acceleration_functions
   void (*transform_skip_rdpcm_h_8)(uint8_t *_dst, const int16_t *coeffs, int nT, ptrdiff_t _stride);
   void (*transform_4x4_dst_add_8)(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride); // iDST
   void (*transform_add_8[4])(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride); // iDCT
+  void (*transform_add_dc_8)(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT); // iDCT, DC only
+  void (*transform_add_sparse_8[4])(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent); // iDCT, top-left extent x extent
 
   // 9-16 bit
 
   void (*transform_skip_16)(uint16_t *_dst, const int16_t *coeffs, ptrdiff_t _stride, int bit_depth); // no transform
   void (*transform_4x4_dst_add_16)(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth); // iDST
   void (*transform_add_16[4])(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth); // iDCT
+  void (*transform_add_dc_16)(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth); // iDCT, DC only
+  void (*transform_add_sparse_16[4])(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth); // iDCT, top-left extent x extent
 
 
   void (*rotate_coefficients)(int16_t *coeff, int nT);
@@ -184,6 +188,82 @@ struct acceleration_functions
   template <class pixel_t> void transform_skip_rdpcm_h(pixel_t *dst, const int16_t *coeffs, int nT, ptrdiff_t stride, int bit_depth) const;
   template <class pixel_t> void transform_4x4_dst_add(pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
   template <class pixel_t> void transform_add(int sizeIdx, pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const;
+  template <class pixel_t> void transform_add_dc(pixel_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth) const;
+  template <class pixel_t> void transform_add_sparse(int sizeIdx, pixel_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth) const;
+
+
+
+  // --- intra prediction ---
+
+  // 'border' points to the top-left reference sample p[-1][-1] (see fallback-intrapred.h)
+
+  void (*intra_pred_planar_8)(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT);
+  void (*intra_pred_dc_8)(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                          bool filter_edges);
+  void (*intra_pred_angular_8)(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                               int intraPredMode, bool boundary_filter);
+  void (*intra_pred_smooth_border_8)(uint8_t* border, int nT); // [1 2 1] reference filter, in-place
+
+  void (*intra_pred_planar_16)(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                               int bit_depth);
+  void (*intra_pred_dc_16)(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                           bool filter_edges, int bit_depth);
+  void (*intra_pred_angular_16)(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                                int intraPredMode, bool boundary_filter, int bit_depth);
+  void (*intra_pred_smooth_border_16)(uint16_t* border, int nT, int bit_depth);
+
+  template <class pixel_t> void intra_pred_planar(pixel_t* dst, ptrdiff_t stride, const pixel_t* border, int nT, int bit_depth) const;
+  template <class pixel_t> void intra_pred_dc(pixel_t* dst, ptrdiff_t stride, const pixel_t* border, int nT, bool filter_edges, int bit_depth) const;
+  template <class pixel_t> void intra_pred_angular(pixel_t* dst, ptrdiff_t stride, const pixel_t* border, int nT, int intraPredMode, bool boundary_filter, int bit_depth) const;
+  template <class pixel_t> void intra_pred_smooth_border(pixel_t* border, int nT, int bit_depth) const;
+
+
+
+  // --- deblocking ---
+
+  // edge groups of 8 lines (two segments of 4 lines), 'ptr' points to q0 (see fallback-deblock.h)
+
+  void (*deblock_luma_v_8)(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                           const bool filterP[2], const bool filterQ[2]);
+  void (*deblock_luma_h_8)(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                           const bool filterP[2], const bool filterQ[2]);
+  void (*deblock_chroma_v_8)(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                             const bool filterP[2], const bool filterQ[2]);
+  void (*deblock_chroma_h_8)(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                             const bool filterP[2], const bool filterQ[2]);
+
+  void (*deblock_luma_v_16)(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                            const bool filterP[2], const bool filterQ[2], int bit_depth);
+  void (*deblock_luma_h_16)(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                            const bool filterP[2], const bool filterQ[2], int bit_depth);
+  void (*deblock_chroma_v_16)(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                              const bool filterP[2], const bool filterQ[2], int bit_depth);
+  void (*deblock_chroma_h_16)(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                              const bool filterP[2], const bool filterQ[2], int bit_depth);
+
+  template <class pixel_t> void deblock_luma(bool vertical, pixel_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const;
+  template <class pixel_t> void deblock_chroma(bool vertical, pixel_t* ptr, ptrdiff_t stride, const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const;
+
+
+
+  // --- sample adaptive offset ---
+
+  // band and edge offsets of a rectangle, without boundary checks (see fallback-sao.h)
+
+  void (*sao_band_8)(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride,
+                     int width, int height, int bandPosition, const int8_t offsets[4]);
+  void (*sao_edge_8)(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride,
+                     int width, int height, int eoClass, const int8_t offsets[5]);
+
+  void (*sao_band_16)(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride,
+                      int width, int height, int bandPosition, const int8_t offsets[4],
+                      int bit_depth);
+  void (*sao_edge_16)(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride,
+                      int width, int height, int eoClass, const int8_t offsets[5],
+                      int bit_depth);
+
+  template <class pixel_t> void sao_band(pixel_t* dst, ptrdiff_t dststride, const pixel_t* src, ptrdiff_t srcstride, int width, int height, int bandPosition, const int8_t offsets[4], int bit_depth) const;
+  template <class pixel_t> void sao_edge(pixel_t* dst, ptrdiff_t dststride, const pixel_t* src, ptrdiff_t srcstride, int width, int height, int eoClass, const int8_t offsets[5], int bit_depth) const;
 
 
 
@@ -353,7 +433,37 @@ template <> inline void acceleration_functions::transform_4x4_dst_add<uint16_t>(
 template <> inline void acceleration_functions::transform_add<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_add_8[sizeIdx](dst,coeffs,stride); }
 template <> inline void acceleration_functions::transform_add<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth) const { transform_add_16[sizeIdx](dst,coeffs,stride,bit_depth); }
 
+template <> inline void acceleration_functions::transform_add_dc<uint8_t>(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth) const { (void)bit_depth; transform_add_dc_8(dst,stride,dc,nT); }
+template <> inline void acceleration_functions::transform_add_dc<uint16_t>(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth) const { transform_add_dc_16(dst,stride,dc,nT,bit_depth); }
+
+template <> inline void acceleration_functions::transform_add_sparse<uint8_t>(int sizeIdx, uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth) const { (void)bit_depth; transform_add_sparse_8[sizeIdx](dst,coeffs,stride,extent); }
+template <> inline void acceleration_functions::transform_add_sparse<uint16_t>(int sizeIdx, uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth) const { transform_add_sparse_16[sizeIdx](dst,coeffs,stride,extent,bit_depth); }
+
 template <> inline void acceleration_functions::add_residual(uint8_t *dst,  ptrdiff_t stride, const int32_t* r, int nT, int bit_depth) const { add_residual_8(dst,stride,r,nT,bit_depth); }
 template <> inline void acceleration_functions::add_residual(uint16_t *dst, ptrdiff_t stride, const int32_t* r, int nT, int bit_depth) const { add_residual_16(dst,stride,r,nT,bit_depth); }
 
+template <> inline void acceleration_functions::intra_pred_planar<uint8_t>(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT, int bit_depth) const { (void)bit_depth; intra_pred_planar_8(dst,stride,border,nT); }
+template <> inline void acceleration_functions::intra_pred_planar<uint16_t>(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT, int bit_depth) const { intra_pred_planar_16(dst,stride,border,nT,bit_depth); }
+
+template <> inline void acceleration_functions::intra_pred_dc<uint8_t>(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT, bool filter_edges, int bit_depth) const { (void)bit_depth; intra_pred_dc_8(dst,stride,border,nT,filter_edges); }
+template <> inline void acceleration_functions::intra_pred_dc<uint16_t>(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT, bool filter_edges, int bit_depth) const { intra_pred_dc_16(dst,stride,border,nT,filter_edges,bit_depth); }
+
+template <> inline void acceleration_functions::intra_pred_angular<uint8_t>(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT, int intraPredMode, bool boundary_filter, int bit_depth) const { (void)bit_depth; intra_pred_angular_8(dst,stride,border,nT,intraPredMode,boundary_filter); }
+template <> inline void acceleration_functions::intra_pred_angular<uint16_t>(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT, int intraPredMode, bool boundary_filter, int bit_depth) const { intra_pred_angular_16(dst,stride,border,nT,intraPredMode,boundary_filter,bit_depth); }
+
+template <> inline void acceleration_functions::intra_pred_smooth_border<uint8_t>(uint8_t* border, int nT, int bit_depth) const { (void)bit_depth; intra_pred_smooth_border_8(border,nT); }
+template <> inline void acceleration_functions::intra_pred_smooth_border<uint16_t>(uint16_t* border, int nT, int bit_depth) const { intra_pred_smooth_border_16(border,nT,bit_depth); }
+
+template <> inline void acceleration_functions::deblock_luma<uint8_t>(bool vertical, uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const { (void)bit_depth; if (vertical) deblock_luma_v_8(ptr,stride,beta,tc,filterP,filterQ); else deblock_luma_h_8(ptr,stride,beta,tc,filterP,filterQ); }
+template <> inline void acceleration_functions::deblock_luma<uint16_t>(bool vertical, uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const { if (vertical) deblock_luma_v_16(ptr,stride,beta,tc,filterP,filterQ,bit_depth); else deblock_luma_h_16(ptr,stride,beta,tc,filterP,filterQ,bit_depth); }
+
+template <> inline void acceleration_functions::deblock_chroma<uint8_t>(bool vertical, uint8_t* ptr, ptrdiff_t stride, const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const { (void)bit_depth; if (vertical) deblock_chroma_v_8(ptr,stride,tc,filterP,filterQ); else deblock_chroma_h_8(ptr,stride,tc,filterP,filterQ); }
+template <> inline void acceleration_functions::deblock_chroma<uint16_t>(bool vertical, uint16_t* ptr, ptrdiff_t stride, const int tc[2], const bool filterP[2], const bool filterQ[2], int bit_depth) const { if (vertical) deblock_chroma_v_16(ptr,stride,tc,filterP,filterQ,bit_depth); else deblock_chroma_h_16(ptr,stride,tc,filterP,filterQ,bit_depth); }
+
+template <> inline void acceleration_functions::sao_band<uint8_t>(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride, int width, int height, int bandPosition, const int8_t offsets[4], int bit_depth) const { (void)bit_depth; sao_band_8(dst,dststride,src,srcstride,width,height,bandPosition,offsets); }
+template <> inline void acceleration_functions::sao_band<uint16_t>(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride, int width, int height, int bandPosition, const int8_t offsets[4], int bit_depth) const { sao_band_16(dst,dststride,src,srcstride,width,height,bandPosition,offsets,bit_depth); }
+
+template <> inline void acceleration_functions::sao_edge<uint8_t>(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride, int width, int height, int eoClass, const int8_t offsets[5], int bit_depth) const { (void)bit_depth; sao_edge_8(dst,dststride,src,srcstride,width,height,eoClass,offsets); }
+template <> inline void acceleration_functions::sao_edge<uint16_t>(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride, int width, int height, int eoClass, const int8_t offsets[5], int bit_depth) const { sao_edge_16(dst,dststride,src,srcstride,width,height,eoClass,offsets,bit_depth); }
+
 #endif
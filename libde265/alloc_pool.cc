@@ -25,13 +25,14 @@
 #include <assert.h>
 #include <stdio.h>
 
-#define DEBUG_MEMORY 1
+#define DEBUG_MEMORY 0
 
 
 alloc_pool::alloc_pool(size_t objSize, int poolSize, bool grow)
   : mObjSize(objSize),
     mPoolSize(poolSize),
-    mGrow(grow)
+    mGrow(grow),
+    mNumHeapAllocations(0)
 {
   m_freeList.reserve(poolSize);
   m_memBlocks.reserve(8);
@@ -44,6 +45,7 @@ void alloc_pool::add_memory_block()
 {
   uint8_t* p = new uint8_t[mObjSize * mPoolSize];
   m_memBlocks.push_back(p);
+  mNumHeapAllocations++;
 
   for (int i=0;i<mPoolSize;i++)
     {
@@ -61,7 +63,8 @@ alloc_pool::~alloc_pool()
 
 void* alloc_pool::new_obj(const size_t size)
 {
-  if (size != mObjSize) {
+  if (size > mObjSize) {
+    mNumHeapAllocations++;
     return ::operator new(size);
   }
 
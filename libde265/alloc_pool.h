@@ -38,15 +38,20 @@ class alloc_pool
   alloc_pool(size_t objSize, int poolSize=1000, bool grow=true);
   ~alloc_pool();
 
-  void* new_obj(const size_t size);
+  void* new_obj(const size_t size); // objects up to 'objSize' are taken from the pool
   void  delete_obj(void*);
   void  purge();
 
+  // number of allocations that had to go to the heap (new memory blocks and oversized objects)
+  int   num_heap_allocations() const { return mNumHeapAllocations; }
+
  private:
   size_t mObjSize;
   int    mPoolSize;
   bool   mGrow;
 
+  int    mNumHeapAllocations;
+
   std::vector<uint8_t*> m_memBlocks;
   std::vector<void*>    m_freeList;
 
@@ -29,7 +29,7 @@
 #define INITIAL_CABAC_BUFFER_CAPACITY 4096
 
 
-static const uint8_t LPS_table[64][4] =
+const uint8_t LPS_table[64][4] =
   {
     { 128, 176, 208, 240},
     { 128, 167, 197, 227},
@@ -97,7 +97,7 @@ static const uint8_t LPS_table[64][4] =
     {   2,   2,   2,   2}
   };
 
-static const uint8_t renorm_table[32] =
+const uint8_t renorm_table[32] =
   {
     6,  5,  4,  4,
     3,  3,  3,  3,
@@ -109,7 +109,7 @@ static const uint8_t renorm_table[32] =
     1,  1,  1,  1
   };
 
-static const uint8_t next_state_MPS[64] =
+const uint8_t next_state_MPS[64] =
   {
     1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,
     17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,
@@ -117,7 +117,7 @@ static const uint8_t next_state_MPS[64] =
     49,50,51,52,53,54,55,56,57,58,59,60,61,62,62,63
   };
 
-static const uint8_t next_state_LPS[64] =
+const uint8_t next_state_LPS[64] =
   {
     0,0,1,2,2,4,4,5,6,7,8,9,9,11,11,12,
     13,13,15,15,16,16,18,18,19,19,21,21,22,22,23,24,
@@ -140,133 +140,86 @@ void init_CABAC_decoder(CABAC_decoder* decoder, uint8_t* bitstream, int length)
   decoder->bitstream_start = bitstream;
   decoder->bitstream_curr  = bitstream;
   decoder->bitstream_end   = bitstream+length;
+
+  decoder->value = 0;
+  decoder->bits_left = 0;
 }
 
 void init_CABAC_decoder_2(CABAC_decoder* decoder)
 {
-  int length = decoder->bitstream_end - decoder->bitstream_curr;
-
   decoder->range = 510;
-  decoder->bits_needed = 8;
 
+  // the 9 bits of ivlOffset are still missing
   decoder->value = 0;
+  decoder->bits_left = -9;
 
-  if (length>0) { decoder->value  = (*decoder->bitstream_curr++) << 8;  decoder->bits_needed-=8; }
-  if (length>1) { decoder->value |= (*decoder->bitstream_curr++);       decoder->bits_needed-=8; }
+  CABAC_decoder_refill(decoder);
 
-  logtrace(LogCABAC,"[%3d] init_CABAC_decode_2 r:%x v:%x\n", logcnt, decoder->range, decoder->value);
+  logtrace(LogCABAC,"[%3d] init_CABAC_decode_2 r:%x v:%x\n", logcnt, decoder->range,
+           (uint32_t)(decoder->value >> (CABAC_SCALE_BITS-7)));
 }
 
 
-int  decode_CABAC_bit(CABAC_decoder* decoder, context_model* model)
+void CABAC_decoder_refill(CABAC_decoder* decoder)
 {
-  logtrace(LogCABAC,"[%3d] decodeBin r:%x v:%x state:%d\n",logcnt,decoder->range, decoder->value, model->state);
-
-  int decoded_bit;
-  int LPS = LPS_table[model->state][ ( decoder->range >> 6 ) - 4 ];
-  decoder->range -= LPS;
-
-  uint32_t scaled_range = decoder->range << 7;
-
-  logtrace(LogCABAC,"[%3d] sr:%x v:%x\n",logcnt,scaled_range, decoder->value);
-
-  if (decoder->value < scaled_range)
-    {
-      logtrace(LogCABAC,"[%3d] MPS\n",logcnt);
-
-      // MPS path
-
-      decoded_bit = model->MPSbit;
-      model->state = next_state_MPS[model->state];
-
-      if (scaled_range < ( 256 << 7 ) )
-        {
-          // scaled range, highest bit (15) not set
-
-          decoder->range = scaled_range >> 6; // shift range by one bit
-          decoder->value <<= 1;               // shift value by one bit
-          decoder->bits_needed++;
-
-          if (decoder->bits_needed == 0)
-            {
-              decoder->bits_needed = -8;
-              if (decoder->bitstream_curr < decoder->bitstream_end)
-                { decoder->value |= *decoder->bitstream_curr++; }
-            }
-        }
-    }
-  else
-    {
-      logtrace(LogCABAC,"[%3d] LPS\n",logcnt);
-      //printf("%d %d\n", model->state, 0);
-
-      // LPS path
-
-      decoder->value = (decoder->value - scaled_range);
-
-      int num_bits = renorm_table[ LPS >> 3 ];
-      decoder->value <<= num_bits;
-      decoder->range   = LPS << num_bits;  /* this is always >= 0x100 except for state 63,
-                                              but state 63 is never used */
-
-      int num_bitsTab = renorm_table[ LPS >> 3 ];
-
-      assert(num_bits == num_bitsTab);
-
-      decoded_bit      = 1 - model->MPSbit;
-
-      if (model->state==0) { model->MPSbit = 1-model->MPSbit; }
-      model->state = next_state_LPS[model->state];
-
-      decoder->bits_needed += num_bits;
+  // A negative 'bits_left' means that bits at the bottom of ivlOffset are still missing.
 
-      if (decoder->bits_needed >= 0)
-        {
-          logtrace(LogCABAC,"bits_needed: %d\n", decoder->bits_needed);
-          if (decoder->bitstream_curr < decoder->bitstream_end)
-            { decoder->value |= (*decoder->bitstream_curr++) << decoder->bits_needed; }
+  int nBytes = (CABAC_SCALE_BITS - decoder->bits_left) >> 3;
+  int available = decoder->bitstream_end - decoder->bitstream_curr;
+  if (nBytes > available) {
+    nBytes = available;
+  }
 
-          decoder->bits_needed -= 8;
-        }
+  if (nBytes > 0) {
+    uint64_t input = 0;
+    for (int i=0;i<nBytes;i++) {
+      input = (input<<8) | decoder->bitstream_curr[i];
     }
 
-  logtrace(LogCABAC,"[%3d] -> bit %d  r:%x v:%x\n", logcnt, decoded_bit, decoder->range, decoder->value);
-#ifdef DE265_LOG_TRACE
-  logcnt++;
-#endif
+    decoder->bitstream_curr += nBytes;
+    decoder->bits_left += 8*nBytes;
+    decoder->value |= input << (CABAC_SCALE_BITS - decoder->bits_left);
+  }
 
-  return decoded_bit;
+  // Behind the end of the bitstream, the missing bits remain zero.
+  if (decoder->bits_left < 0) {
+    decoder->bits_left = 0;
+  }
 }
 
+
 int  decode_CABAC_term_bit(CABAC_decoder* decoder)
 {
   logtrace(LogCABAC,"CABAC term: range=%x\n", decoder->range);
 
   decoder->range -= 2;
-  uint32_t scaledRange = decoder->range << 7;
+  uint64_t scaledRange = (uint64_t)decoder->range << CABAC_SCALE_BITS;
 
   if (decoder->value >= scaledRange)
     {
+      // The decoding engine stops here. Give back the prefetched bytes such that
+      // PCM sample reading or a reinitialization continues at the correct position.
+
+      int nBytes = decoder->bits_left >> 3;
+      decoder->bitstream_curr -= nBytes;
+      decoder->bits_left -= 8*nBytes;
+      decoder->value &= ~((((uint64_t)1) << (CABAC_SCALE_BITS - decoder->bits_left)) - 1);
+
       return 1;
     }
   else
     {
       // there is a while loop in the standard, but it will always be executed only once
 
-      if (scaledRange < (256<<7))
+      if (decoder->range < 256)
         {
-          decoder->range = scaledRange >> 6;
-          decoder->value *= 2;
+          decoder->range <<= 1;
+          decoder->value <<= 1;
+          decoder->bits_left--;
 
-          decoder->bits_needed++;
-          if (decoder->bits_needed==0)
-            {
-              decoder->bits_needed = -8;
-
-              if (decoder->bitstream_curr < decoder->bitstream_end) {
-                decoder->value += (*decoder->bitstream_curr++);
-              }
-            }
+          if (decoder->bits_left < 0) {
+            CABAC_decoder_refill(decoder);
+          }
         }
 
       return 0;
@@ -274,45 +227,35 @@ int  decode_CABAC_term_bit(CABAC_decoder* decoder)
 }
 
 
-
-int  decode_CABAC_bypass(CABAC_decoder* decoder)
+// number of consecutive 1 bins, starting at the MSB of the nBins bins
+static inline int count_leading_one_bins(uint32_t bins, int nBins)
 {
-  logtrace(LogCABAC,"[%3d] bypass r:%x v:%x\n",logcnt,decoder->range, decoder->value);
+  int n=0;
+  while (n<nBins && (bins & (1U<<(nBins-1-n)))) {
+    n++;
+  }
 
-  decoder->value <<= 1;
-  decoder->bits_needed++;
+  return n;
+}
 
-  if (decoder->bits_needed >= 0)
-    {
-      if (decoder->bitstream_end > decoder->bitstream_curr) {
-        decoder->bits_needed = -8;
-        decoder->value |= *decoder->bitstream_curr++;
-      }
-    }
 
-  int bit;
-  uint32_t scaled_range = decoder->range << 7;
-  if (decoder->value >= scaled_range)
-    {
-      decoder->value -= scaled_range;
-      bit=1;
-    }
-  else
-    {
-      bit=0;
-    }
+int  decode_CABAC_TU_bypass(CABAC_decoder* decoder, int cMax)
+{
+  if (cMax==0) {
+    return 0;
+  }
 
-  logtrace(LogCABAC,"[%3d] -> bit %d  r:%x v:%x\n", logcnt, bit, decoder->range, decoder->value);
-#ifdef DE265_LOG_TRACE
-  logcnt++;
-#endif
+  if (cMax<=16) {
+    uint32_t bins = peek_CABAC_bypass_bins(decoder, cMax);
+    int value = count_leading_one_bins(bins, cMax);
 
-  return bit;
-}
+    // the terminating 0 bin is not coded for value==cMax
+    int nBins = (value<cMax ? value+1 : cMax);
+    skip_CABAC_bypass_bins(decoder, nBins, bins >> (cMax-nBins));
 
+    return value;
+  }
 
-int  decode_CABAC_TU_bypass(CABAC_decoder* decoder, int cMax)
-{
   for (int i=0;i<cMax;i++)
     {
       int bit = decode_CABAC_bypass(decoder);
@@ -336,67 +279,31 @@ int  decode_CABAC_TU(CABAC_decoder* decoder, int cMax, context_model* model)
 }
 
 
-int  decode_CABAC_FL_bypass_parallel(CABAC_decoder* decoder, int nBits)
-{
-  logtrace(LogCABAC,"[%3d] bypass group r:%x v:%x (nBits=%d)\n",logcnt,
-           decoder->range, decoder->value, nBits);
-
-  decoder->value <<= nBits;
-  decoder->bits_needed+=nBits;
-
-  if (decoder->bits_needed >= 0)
-    {
-      if (decoder->bitstream_end > decoder->bitstream_curr) {
-        int input = *decoder->bitstream_curr++;
-        input <<= decoder->bits_needed;
-
-        decoder->bits_needed -= 8;
-        decoder->value |= input;
-      }
-    }
-
-  uint32_t scaled_range = decoder->range << 7;
-  int value = decoder->value / scaled_range;
-  if (unlikely(value>=(1<<nBits))) { value=(1<<nBits)-1; } // may happen with broken bitstreams
-  decoder->value -= value * scaled_range;
-
-  logtrace(LogCABAC,"[%3d] -> value %d  r:%x v:%x\n", logcnt+nBits-1,
-           value, decoder->range, decoder->value);
-
-#ifdef DE265_LOG_TRACE
-  logcnt+=nBits;
-#endif
-
-  return value;
-}
-
-
 int  decode_CABAC_FL_bypass(CABAC_decoder* decoder, int nBits)
 {
   int value=0;
 
-  if (likely(nBits<=8)) {
+  if (likely(nBits<=16)) {
     if (nBits==0) {
       return 0;
     }
-    // we could use decode_CABAC_bypass() for a single bit, but this seems to be slower
-#if 0
     else if (nBits==1) {
       value = decode_CABAC_bypass(decoder);
     }
-#endif
     else {
-      value = decode_CABAC_FL_bypass_parallel(decoder,nBits);
+      value = decode_CABAC_bypass_bins(decoder,nBits);
     }
   }
   else {
-    value = decode_CABAC_FL_bypass_parallel(decoder,8);
-    nBits-=8;
+    value = decode_CABAC_bypass_bins(decoder,16);
+    nBits-=16;
 
-    while (nBits--) {
-      value <<= 1;
-      value |= decode_CABAC_bypass(decoder);
+    while (nBits>16) {
+      value = (value<<16) | decode_CABAC_bypass_bins(decoder,16);
+      nBits-=16;
     }
+
+    value = (value<<nBits) | decode_CABAC_bypass_bins(decoder,nBits);
   }
   logtrace(LogCABAC,"      -> FL: %d\n", value);
 
@@ -423,19 +330,26 @@ int  decode_CABAC_EGk_bypass(CABAC_decoder* decoder, int k)
   int base=0;
   int n=k;
 
+  // unary prefix, decoded in groups of 16 bins
+
   for (;;)
     {
-      int bit = decode_CABAC_bypass(decoder);
-      if (bit==0)
-        break;
-      else {
-        base += 1<<n;
-        n++;
-      }
+      uint32_t bins = peek_CABAC_bypass_bins(decoder, 16);
+      int nOnes = count_leading_one_bins(bins, 16);
 
-      if (n == k+MAX_PREFIX) {
+      if (n+nOnes >= k+MAX_PREFIX) {
         return 0; // TODO: error
       }
+
+      base += ((1<<nOnes)-1) << n;
+      n += nOnes;
+
+      if (nOnes<16) {
+        skip_CABAC_bypass_bins(decoder, nOnes+1, bins >> (16-nOnes-1));
+        break;
+      }
+
+      skip_CABAC_bypass_bins(decoder, 16, bins);
     }
 
   int suffix = decode_CABAC_FL_bypass(decoder, n);
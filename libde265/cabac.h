@@ -23,16 +23,24 @@
 
 #include <stdint.h>
 #include "contextmodel.h"
+#include "util.h"
 
 
+/* The decoder keeps ivlOffset (9 bits) in bits CABAC_SCALE_BITS and above of 'value'.
+   Below, it holds 'bits_left' prefetched bits of the bitstream. The value is refilled
+   with several bytes at once when the prefetched bits are used up.
+   'bitstream_curr' points behind the last prefetched byte.
+ */
+#define CABAC_SCALE_BITS 54
+
 typedef struct {
   uint8_t* bitstream_start;
   uint8_t* bitstream_curr;
   uint8_t* bitstream_end;
 
   uint32_t range;
-  uint32_t value;
-  int16_t  bits_needed;
+  uint64_t value;
+  int      bits_left;
 } CABAC_decoder;
 
 
@@ -48,6 +56,140 @@ int  decode_CABAC_FL_bypass(CABAC_decoder* decoder, int nBits);
 int  decode_CABAC_TR_bypass(CABAC_decoder* decoder, int cRiceParam, int cTRMax);
 int  decode_CABAC_EGk_bypass(CABAC_decoder* decoder, int k);
 
+/* Position in the bitstream behind the last byte that has been used for decoding.
+   Prefetched bytes are not counted.
+ */
+inline const uint8_t* CABAC_decoder_position(const CABAC_decoder* decoder)
+{
+  return decoder->bitstream_curr - (decoder->bits_left >> 3);
+}
+
+
+// --- internals of the decoding engine, inlined into the syntax element decoding ---
+
+extern const uint8_t LPS_table[64][4];
+extern const uint8_t renorm_table[32];
+extern const uint8_t next_state_MPS[64];
+extern const uint8_t next_state_LPS[64];
+
+// Append bytes to the prefetched bits. Behind the end of the bitstream, zero bits are read.
+void CABAC_decoder_refill(CABAC_decoder* decoder);
+
+
+inline int decode_CABAC_bit(CABAC_decoder* decoder, context_model* model)
+{
+  int decoded_bit;
+  int LPS = LPS_table[model->state][ ( decoder->range >> 6 ) - 4 ];
+  decoder->range -= LPS;
+
+  uint64_t scaled_range = (uint64_t)decoder->range << CABAC_SCALE_BITS;
+
+  if (decoder->value < scaled_range)
+    {
+      // MPS path
+
+      decoded_bit = model->MPSbit;
+      model->state = next_state_MPS[model->state];
+
+      if (decoder->range < 256)
+        {
+          decoder->range <<= 1;
+          decoder->value <<= 1;
+          decoder->bits_left--;
+        }
+    }
+  else
+    {
+      // LPS path
+
+      decoder->value -= scaled_range;
+
+      int num_bits = renorm_table[ LPS >> 3 ];
+      decoder->value <<= num_bits;
+      decoder->range   = LPS << num_bits;  /* this is always >= 0x100 except for state 63,
+                                              but state 63 is never used */
+
+      decoded_bit      = 1 - model->MPSbit;
+
+      if (model->state==0) { model->MPSbit = 1-model->MPSbit; }
+      model->state = next_state_LPS[model->state];
+
+      decoder->bits_left -= num_bits;
+    }
+
+  if (unlikely(decoder->bits_left < 0)) {
+    CABAC_decoder_refill(decoder);
+  }
+
+  return decoded_bit;
+}
+
+
+inline int decode_CABAC_bypass(CABAC_decoder* decoder)
+{
+  decoder->value <<= 1;
+  decoder->bits_left--;
+
+  if (unlikely(decoder->bits_left < 0)) {
+    CABAC_decoder_refill(decoder);
+  }
+
+  uint64_t scaled_range = (uint64_t)decoder->range << CABAC_SCALE_BITS;
+  if (decoder->value >= scaled_range)
+    {
+      decoder->value -= scaled_range;
+      return 1;
+    }
+  else
+    {
+      return 0;
+    }
+}
+
+
+/* Get the next nBins (at most 16) bypass bins without consuming them.
+   The first bin is the MSB of the result.
+ */
+inline uint32_t peek_CABAC_bypass_bins(CABAC_decoder* decoder, int nBins)
+{
+  if (decoder->bits_left < nBins) {
+    CABAC_decoder_refill(decoder);
+  }
+
+  uint32_t window = (uint32_t)(decoder->value >> (CABAC_SCALE_BITS - nBins));
+  uint32_t bins = window / decoder->range;
+  if (unlikely(bins >= (1U<<nBins))) { bins = (1U<<nBins)-1; } // may happen with broken bitstreams
+
+  return bins;
+}
+
+/* Consume the first nBins bypass bins. 'bins' are these bins as returned by
+   peek_CABAC_bypass_bins(), shifted down to the nBins LSBs.
+ */
+inline void skip_CABAC_bypass_bins(CABAC_decoder* decoder, int nBins, uint32_t bins)
+{
+  int shift = CABAC_SCALE_BITS - nBins;
+
+  uint32_t window = (uint32_t)(decoder->value >> shift);
+  uint64_t remainder = window - bins * decoder->range;
+  uint64_t prefetched = decoder->value & ((((uint64_t)1) << shift) - 1);
+
+  decoder->value = (remainder << CABAC_SCALE_BITS) | (prefetched << nBins);
+  decoder->bits_left -= nBins;
+
+  if (unlikely(decoder->bits_left < 0)) {
+    CABAC_decoder_refill(decoder);
+  }
+}
+
+// Decode nBins (at most 16) bypass bins at once. The first bin is the MSB of the result.
+inline int decode_CABAC_bypass_bins(CABAC_decoder* decoder, int nBins)
+{
+  uint32_t bins = peek_CABAC_bypass_bins(decoder, nBins);
+  skip_CABAC_bypass_bins(decoder, nBins, bins);
+  return bins;
+}
+
 
 // ---------------------------------------------------------------------------
 
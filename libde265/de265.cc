@@ -241,9 +241,8 @@ LIBDE265_API de265_error de265_start_worker_threads(de265_decoder_context* de265
 {
   decoder_context* ctx = (decoder_context*)de265ctx;
 
-  if (number_of_threads > MAX_THREADS) {
-    number_of_threads = MAX_THREADS;
-  }
+  // replace threads that have been started before or a shared pool
+  ctx->stop_thread_pool();
 
   if (number_of_threads>0) {
     de265_error err = ctx->start_thread_pool(number_of_threads);
@@ -258,6 +257,62 @@ LIBDE265_API de265_error de265_start_worker_threads(de265_decoder_context* de265
 }
 
 
+LIBDE265_API de265_thread_pool* de265_new_thread_pool(int number_of_threads)
+{
+  if (number_of_threads<=0) {
+    return NULL;
+  }
+
+  // Keep the library initialized while the pool exists. Otherwise, the global tables
+  // would be freed and reinitialized whenever the number of decoders drops to zero,
+  // which is not safe while other threads create decoders.
+
+  de265_error init_err = de265_init();
+  if (init_err != DE265_OK) {
+    return NULL;
+  }
+
+  thread_pool* pool = new thread_pool;
+
+  start_thread_pool(pool, number_of_threads);
+  if (pool->num_threads==0) {
+    stop_thread_pool(pool);
+    delete pool;
+    de265_free();
+    return NULL;
+  }
+
+  return (de265_thread_pool*)pool;
+}
+
+
+LIBDE265_API void de265_free_thread_pool(de265_thread_pool* de265pool)
+{
+  thread_pool* pool = (thread_pool*)de265pool;
+
+  if (pool) {
+    stop_thread_pool(pool);
+    delete pool;
+
+    de265_free();
+  }
+}
+
+
+LIBDE265_API de265_error de265_attach_thread_pool(de265_decoder_context* de265ctx,
+                                                  de265_thread_pool* de265pool)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  if (de265pool==NULL) {
+    ctx->stop_thread_pool(); // detach from the current pool
+    return DE265_OK;
+  }
+
+  return ctx->attach_thread_pool((thread_pool*)de265pool);
+}
+
+
 #ifndef LIBDE265_DISABLE_DEPRECATED
 LIBDE265_API de265_error de265_decode_data(de265_decoder_context* de265ctx,
                                            const void* data8, int len)
@@ -330,6 +385,28 @@ LIBDE265_API de265_error de265_push_NAL(de265_decoder_context* de265ctx,
 }
 
 
+LIBDE265_API de265_error de265_push_data_nocopy(de265_decoder_context* de265ctx,
+                                                const void* data8, int len,
+                                                de265_PTS pts, void* user_data)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+  const uint8_t* data = (const uint8_t*)data8;
+
+  return ctx->nal_parser.push_data(data,len,pts,user_data, true);
+}
+
+
+LIBDE265_API de265_error de265_push_NAL_nocopy(de265_decoder_context* de265ctx,
+                                               const void* data8, int len,
+                                               de265_PTS pts, void* user_data)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+  const uint8_t* data = (const uint8_t*)data8;
+
+  return ctx->nal_parser.push_NAL(data,len,pts,user_data, true);
+}
+
+
 LIBDE265_API de265_error de265_decode(de265_decoder_context* de265ctx, int* more)
 {
   decoder_context* ctx = (decoder_context*)de265ctx;
@@ -389,6 +466,39 @@ LIBDE265_API const struct de265_image* de265_get_next_picture(de265_decoder_cont
 }
 
 
+LIBDE265_API const struct de265_image* de265_get_next_picture_retained(de265_decoder_context* de265ctx)
+{
+  struct de265_image* img = (struct de265_image*)de265_peek_next_picture(de265ctx);
+  if (img) {
+    img->add_reference();
+    de265_release_next_picture(de265ctx);
+  }
+
+  return img;
+}
+
+
+LIBDE265_API void de265_retain_picture(const struct de265_image* cimg)
+{
+  struct de265_image* img = (struct de265_image*)cimg;
+
+  img->add_reference();
+}
+
+
+LIBDE265_API void de265_release_picture(const struct de265_image* cimg)
+{
+  struct de265_image* img = (struct de265_image*)cimg;
+
+  // The decoder reuses the picture when it finds it unreferenced. Only when the decoder
+  // has already given it up, we have to delete it here.
+
+  if (img->remove_reference()) {
+    delete img;
+  }
+}
+
+
 LIBDE265_API const struct de265_image* de265_peek_next_picture(de265_decoder_context* de265ctx)
 {
   decoder_context* ctx = (decoder_context*)de265ctx;
@@ -489,6 +599,16 @@ LIBDE265_API void de265_set_parameter_bool(de265_decoder_context* de265ctx, enum
       ctx->param_disable_sao = !!value;
       break;
 
+    case DE265_DECODER_PARAM_SPLIT_PARSING:
+      ctx->param_split_parsing = !!value;
+      break;
+
+    case DE265_DECODER_PARAM_TRACE:
+#ifdef DE265_TRACE
+      ctx->tracer.set_enabled(!!value);
+#endif
+      break;
+
       /*
     case DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT:
       ctx->param_disable_mc_residual_idct = !!value;
@@ -532,6 +652,10 @@ LIBDE265_API void de265_set_parameter_int(de265_decoder_context* de265ctx, enum
       ctx->set_acceleration_functions((enum de265_acceleration)value);
       break;
 
+    case DE265_DECODER_PARAM_MAX_FRAMES_IN_FLIGHT:
+      ctx->param_max_frames_in_flight = value;
+      break;
+
     default:
       assert(false);
       break;
@@ -559,6 +683,16 @@ LIBDE265_API int de265_get_parameter_bool(de265_decoder_context* de265ctx, enum
     case DE265_DECODER_PARAM_DISABLE_SAO:
       return ctx->param_disable_sao;
 
+    case DE265_DECODER_PARAM_SPLIT_PARSING:
+      return ctx->param_split_parsing;
+
+    case DE265_DECODER_PARAM_TRACE:
+#ifdef DE265_TRACE
+      return ctx->tracer.is_enabled();
+#else
+      return false;
+#endif
+
       /*
     case DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT:
       return ctx->param_disable_mc_residual_idct;
@@ -574,6 +708,29 @@ LIBDE265_API int de265_get_parameter_bool(de265_decoder_context* de265ctx, enum
 }
 
 
+#ifdef DE265_TRACE
+LIBDE265_API de265_error de265_write_trace(de265_decoder_context* de265ctx, const char* filename)
+{
+  decoder_context* ctx = (decoder_context*)de265ctx;
+
+  FILE* fh = fopen(filename, "w");
+  if (fh==NULL) {
+    return DE265_ERROR_NO_SUCH_FILE;
+  }
+
+  ctx->tracer.write_chrome_json(fh);
+  fclose(fh);
+
+  return DE265_OK;
+}
+#else
+LIBDE265_API de265_error de265_write_trace(de265_decoder_context*, const char*)
+{
+  return DE265_ERROR_NOT_IMPLEMENTED_YET;
+}
+#endif
+
+
 LIBDE265_API int de265_get_number_of_input_bytes_pending(de265_decoder_context* de265ctx)
 {
   decoder_context* ctx = (decoder_context*)de265ctx;
@@ -131,7 +131,7 @@ typedef enum {
   DE265_WARNING_INVALID_CHROMA_FORMAT=1019,
   DE265_WARNING_SLICE_SEGMENT_ADDRESS_INVALID=1020,
   DE265_WARNING_DEPENDENT_SLICE_WITH_ADDRESS_ZERO=1021,
-  DE265_WARNING_NUMBER_OF_THREADS_LIMITED_TO_MAXIMUM=1022,
+  DE265_WARNING_NUMBER_OF_THREADS_LIMITED_TO_MAXIMUM=1022, // obsolete, there is no thread limit anymore
   DE265_NON_EXISTING_LT_REFERENCE_CANDIDATE_IN_SLICE_HEADER=1023,
   DE265_WARNING_CANNOT_APPLY_SAO_OUT_OF_MEMORY=1024,
   DE265_WARNING_SPS_MISSING_CANNOT_DECODE_SEI=1025,
@@ -203,6 +203,29 @@ LIBDE265_API de265_error de265_start_worker_threads(de265_decoder_context*, int
 /* Free decoder context. May only be called once on a context. */
 LIBDE265_API de265_error de265_free_decoder(de265_decoder_context*);
 
+
+/* === shared thread pool === */
+
+/* A pool of worker threads that can be used by several decoders at once.
+   This is an alternative to de265_start_worker_threads() when many streams
+   are decoded in parallel. Tasks of all attached decoders are executed in the
+   order in which they are added, so that no stream can starve the others. */
+
+typedef void de265_thread_pool; // private structure
+
+/* Get a new thread pool with the given number of worker threads.
+   Returns NULL if no thread could be started. Must be freed with de265_free_thread_pool(). */
+LIBDE265_API de265_thread_pool* de265_new_thread_pool(int number_of_threads);
+
+/* Free the thread pool. All decoders attached to it must have been freed before. */
+LIBDE265_API void de265_free_thread_pool(de265_thread_pool*);
+
+/* Decode with the worker threads of the pool instead of starting own threads.
+   Replaces threads started with de265_start_worker_threads().
+   Passing NULL detaches the decoder from its pool (it then decodes without threads). */
+LIBDE265_API de265_error de265_attach_thread_pool(de265_decoder_context*, de265_thread_pool*);
+
+
 #ifndef LIBDE265_DISABLE_DEPRECATED
 /* Push more data into the decoder, must be raw h265.
    All complete images in the data will be decoded, hence, do not push
@@ -245,6 +268,20 @@ LIBDE265_API void        de265_push_end_of_frame(de265_decoder_context*);
 LIBDE265_API de265_error de265_push_NAL(de265_decoder_context*, const void* data, int length,
                                         de265_PTS pts, void* user_data);
 
+/* Same as de265_push_data() and de265_push_NAL(), but the decoder may refer to the
+   input data instead of copying it. NALs that are not completely contained in the data
+   or that contain stuffing-bytes are still copied.
+   The data must remain valid and unchanged until the decoder has finished decoding all
+   data pushed so far (after de265_flush_data() and decoding to the end), or until the
+   decoder is reset or freed. This suits memory-mapped files or long-lived input buffers.
+*/
+LIBDE265_API de265_error de265_push_data_nocopy(de265_decoder_context*,
+                                                const void* data, int length,
+                                                de265_PTS pts, void* user_data);
+LIBDE265_API de265_error de265_push_NAL_nocopy(de265_decoder_context*,
+                                               const void* data, int length,
+                                               de265_PTS pts, void* user_data);
+
 /* Indicate the end-of-stream. All data pending at the decoder input will be
    pushed into the decoder and the decoded picture queue will be completely emptied.
  */
@@ -293,6 +330,24 @@ LIBDE265_API const struct de265_image* de265_get_next_picture(de265_decoder_cont
    use the data anymore after calling this function. */
 LIBDE265_API void de265_release_next_picture(de265_decoder_context*);
 
+/* Get next decoded picture and remove it from the decoder output queue, like
+   de265_get_next_picture(), but keep a reference to it. The picture data stays valid
+   and its buffer is not reused by the decoder until the last reference is released
+   with de265_release_picture(). Pictures can be released in any order, from any thread
+   and also after the decoder has been reset or freed.
+   Retained pictures occupy space in the decoded picture buffer. If all of it is in use,
+   de265_decode() returns DE265_ERROR_IMAGE_BUFFER_FULL until pictures are released.
+   With custom image allocation functions, release_buffer() is called for the picture
+   only after it has been released. It gets a NULL decoder context if the decoder does
+   not exist anymore. */
+LIBDE265_API const struct de265_image* de265_get_next_picture_retained(de265_decoder_context*); // may return NULL
+
+/* Add another reference to a picture obtained with de265_get_next_picture_retained(). */
+LIBDE265_API void de265_retain_picture(const struct de265_image*);
+
+/* Release a reference to a picture obtained with de265_get_next_picture_retained(). */
+LIBDE265_API void de265_release_picture(const struct de265_image*);
+
 
 LIBDE265_API de265_error de265_get_warning(de265_decoder_context*);
 
@@ -382,9 +437,12 @@ enum de265_param {
   DE265_DECODER_PARAM_SUPPRESS_FAULTY_PICTURES=6, // (bool)  do not output frames with decoding errors, default: no (output all images)
 
   DE265_DECODER_PARAM_DISABLE_DEBLOCKING=7,   // (bool)  disable deblocking
-  DE265_DECODER_PARAM_DISABLE_SAO=8           // (bool)  disable SAO filter
+  DE265_DECODER_PARAM_DISABLE_SAO=8,          // (bool)  disable SAO filter
   //DE265_DECODER_PARAM_DISABLE_MC_RESIDUAL_IDCT=9,     // (bool)  disable decoding of IDCT residuals in MC blocks
   //DE265_DECODER_PARAM_DISABLE_INTRA_RESIDUAL_IDCT=10  // (bool)  disable decoding of IDCT residuals in MC blocks
+  DE265_DECODER_PARAM_MAX_FRAMES_IN_FLIGHT=11, // (int)  max. number of pictures decoded in parallel by the worker threads, default: 0 (automatic)
+  DE265_DECODER_PARAM_SPLIT_PARSING=12, // (bool)  parse slices without WPP/tiles in one thread and reconstruct their CTB rows in parallel, default: no
+  DE265_DECODER_PARAM_TRACE=13 // (bool)  record the timing of all decoding tasks (see de265_write_trace()), default: no
 };
 
 // sorted such that a large ID includes all optimizations from lower IDs
@@ -395,7 +453,7 @@ enum de265_acceleration {
   de265_acceleration_SSE2 = 30,
   de265_acceleration_SSE4 = 40,
   de265_acceleration_AVX  = 50,    // not implemented yet
-  de265_acceleration_AVX2 = 60,    // not implemented yet
+  de265_acceleration_AVX2 = 60,
   de265_acceleration_ARM  = 70,
   de265_acceleration_NEON = 80,
   de265_acceleration_AUTO = 10000
@@ -410,6 +468,12 @@ LIBDE265_API void de265_set_parameter_int(de265_decoder_context*, enum de265_par
 /* Get decoding parameters. */
 LIBDE265_API int  de265_get_parameter_bool(de265_decoder_context*, enum de265_param param);
 
+/* Write the timing trace recorded with DE265_DECODER_PARAM_TRACE as Chrome trace JSON.
+   It can be viewed in chrome://tracing or https://ui.perfetto.dev .
+   Returns DE265_ERROR_NOT_IMPLEMENTED_YET if libde265 has been built without tracing
+   support (DE265_TRACE). */
+LIBDE265_API de265_error de265_write_trace(de265_decoder_context*, const char* filename);
+
 
 
 /* --- optional library initialization --- */
@@ -19,9 +19,11 @@
  */
 
 #include "deblock.h"
+#include "sao.h"
 #include "util.h"
 #include "transform.h"
 #include "de265.h"
+#include "fallback-deblock.h"
 
 #include <assert.h>
 
@@ -399,298 +401,112 @@ static uint8_t table_8_23_tc[54] = {
 
 
 
-// 8.7.2.4
-template <class pixel_t>
-void edge_filtering_luma_internal(de265_image* img, bool vertical,
-                                  int yStart,int yEnd, int xStart,int xEnd)
+// 8.7.2.4.3 / 8.7.2.4.4, parameters of one 4-line luma segment
+static void luma_segment_parameters(de265_image* img, bool vertical, int xDi,int yDi,
+                                    int* beta, int* tc, bool* filterP, bool* filterQ)
 {
-  //printf("luma %d-%d %d-%d\n",xStart,xEnd,yStart,yEnd);
+  int bS = img->get_deblk_bS(xDi,yDi);
 
-  int xIncr = vertical ? 2 : 1;
-  int yIncr = vertical ? 1 : 2;
+  logtrace(LogDeblock,"deblock POC=%d %c --- x:%d y:%d bS:%d---\n",
+           img->PicOrderCntVal,vertical ? 'V':'H',xDi,yDi,bS);
 
-  const int stride = img->get_image_stride(0);
+  if (bS==0) {
+    *beta = 0;
+    *tc = 0;
+    *filterP = *filterQ = false;
+    return;
+  }
 
   int bitDepth_Y = img->sps.BitDepth_Y;
 
-  xEnd = libde265_min(xEnd,img->get_deblk_width());
-  yEnd = libde265_min(yEnd,img->get_deblk_height());
-
-  for (int y=yStart;y<yEnd;y+=yIncr)
-    for (int x=xStart;x<xEnd;x+=xIncr) {
-      // x;y in deblocking units (4x4 pixels)
-
-      int xDi = x<<2; // *4 -> pixel resolution
-      int yDi = y<<2; // *4 -> pixel resolution
-      int bS = img->get_deblk_bS(xDi,yDi);
-
-      //printf("x,y:%d,%d  xDi,yDi:%d,%d\n",x,y,xDi,yDi);
-
-      logtrace(LogDeblock,"deblock POC=%d %c --- x:%d y:%d bS:%d---\n",
-               img->PicOrderCntVal,vertical ? 'V':'H',xDi,yDi,bS);
-
-#if 0
-      {
-        uint8_t* ptr = img->y + stride*yDi + xDi;
-
-        for (int dy=-4;dy<4;dy++) {
-          for (int dx=-4;dx<4;dx++) {
-            printf("%02x ", ptr[dy*stride + dx]);
-            if (dx==-1) printf("| ");
-          }
-          printf("\n");
-          if (dy==-1) printf("-------------------------\n");
-        }
-      }
-#endif
-
-#if 0
-      if (!vertical)
-        {
-          uint8_t* ptr = img->y + stride*yDi + xDi;
-
-          for (int dy=-4;dy<4;dy++) {
-            for (int dx=0;dx<4;dx++) {
-              printf("%02x ", ptr[dy*stride + dx]);
-              if (dx==-1) printf("| ");
-            }
-            printf("\n");
-            if (dy==-1) printf("-------------------------\n");
-          }
-        }
-#endif
-
-      if (bS>0) {
-
-        // 8.7.2.4.3
-
-        pixel_t* ptr = img->get_image_plane_at_pos_NEW<pixel_t>(0, xDi,yDi);
-
-        pixel_t q[4][4], p[4][4];
-        for (int k=0;k<4;k++)
-          for (int i=0;i<4;i++)
-            {
-              if (vertical) {
-                q[k][i] = ptr[ i  +k*stride];
-                p[k][i] = ptr[-i-1+k*stride];
-              }
-              else {
-                q[k][i] = ptr[k + i   *stride];
-                p[k][i] = ptr[k -(i+1)*stride];
-              }
-            }
-
-#if 0
-        for (int k=0;k<4;k++)
-          {
-            for (int i=0;i<4;i++)
-              {
-                printf("%02x ", p[k][3-i]);
-              }
-
-            printf("| ");
-
-            for (int i=0;i<4;i++)
-              {
-                printf("%02x ", q[k][i]);
-              }
-            printf("\n");
-          }
-#endif
-
-
-        int QP_Q = img->get_QPY(xDi,yDi);
-        int QP_P = (vertical ?
-                    img->get_QPY(xDi-1,yDi) :
-                    img->get_QPY(xDi,yDi-1) );
-        int qP_L = (QP_Q+QP_P+1)>>1;
-
-        logtrace(LogDeblock,"QP: %d & %d -> %d\n",QP_Q,QP_P,qP_L);
-
-        int sliceIndexQ00 = img->get_SliceHeaderIndex(xDi,yDi);
-        int beta_offset = img->slices[sliceIndexQ00]->slice_beta_offset;
-        int tc_offset   = img->slices[sliceIndexQ00]->slice_tc_offset;
+  int xP = vertical ? xDi-1 : xDi;
+  int yP = vertical ? yDi : yDi-1;
 
-        int Q_beta = Clip3(0,51, qP_L + beta_offset);
-        int betaPrime = table_8_23_beta[Q_beta];
-        int beta = betaPrime * (1<<(bitDepth_Y - 8));
+  int QP_Q = img->get_QPY(xDi,yDi);
+  int QP_P = img->get_QPY(xP,yP);
+  int qP_L = (QP_Q+QP_P+1)>>1;
 
-        int Q_tc = Clip3(0,53, qP_L + 2*(bS-1) + tc_offset);
-        int tcPrime = table_8_23_tc[Q_tc];
-        int tc = tcPrime * (1<<(bitDepth_Y - 8));
+  logtrace(LogDeblock,"QP: %d & %d -> %d\n",QP_Q,QP_P,qP_L);
 
-        logtrace(LogDeblock,"beta: %d (%d)  tc: %d (%d)\n",beta,beta_offset, tc,tc_offset);
+  int sliceIndexQ00 = img->get_SliceHeaderIndex(xDi,yDi);
+  int beta_offset = img->slices[sliceIndexQ00]->slice_beta_offset;
+  int tc_offset   = img->slices[sliceIndexQ00]->slice_tc_offset;
 
-        int dE=0, dEp=0, dEq=0;
+  int Q_beta = Clip3(0,51, qP_L + beta_offset);
+  int betaPrime = table_8_23_beta[Q_beta];
+  *beta = betaPrime * (1<<(bitDepth_Y - 8));
 
-        if (vertical || !vertical) {
-          int dp0 = abs_value(p[0][2] - 2*p[0][1] + p[0][0]);
-          int dp3 = abs_value(p[3][2] - 2*p[3][1] + p[3][0]);
-          int dq0 = abs_value(q[0][2] - 2*q[0][1] + q[0][0]);
-          int dq3 = abs_value(q[3][2] - 2*q[3][1] + q[3][0]);
+  int Q_tc = Clip3(0,53, qP_L + 2*(bS-1) + tc_offset);
+  int tcPrime = table_8_23_tc[Q_tc];
+  *tc = tcPrime * (1<<(bitDepth_Y - 8));
 
-          int dpq0 = dp0 + dq0;
-          int dpq3 = dp3 + dq3;
+  logtrace(LogDeblock,"beta: %d (%d)  tc: %d (%d)\n",*beta,beta_offset, *tc,tc_offset);
 
-          int dp = dp0 + dp3;
-          int dq = dq0 + dq3;
-          int d  = dpq0+ dpq3;
-
-          if (d<beta) {
-            //int dpq = 2*dpq0;
-            bool dSam0 = (2*dpq0 < (beta>>2) &&
-                          abs_value(p[0][3]-p[0][0])+abs_value(q[0][0]-q[0][3]) < (beta>>3) &&
-                          abs_value(p[0][0]-q[0][0]) < ((5*tc+1)>>1));
-
-            bool dSam3 = (2*dpq3 < (beta>>2) &&
-                          abs_value(p[3][3]-p[3][0])+abs_value(q[3][0]-q[3][3]) < (beta>>3) &&
-                          abs_value(p[3][0]-q[3][0]) < ((5*tc+1)>>1));
-
-            if (dSam0 && dSam3) {
-              dE=2;
-            }
-            else {
-              dE=1;
-            }
-
-            if (dp < ((beta + (beta>>1))>>3)) { dEp=1; }
-            if (dq < ((beta + (beta>>1))>>3)) { dEq=1; }
-
-            logtrace(LogDeblock,"dE:%d dEp:%d dEq:%d\n",dE,dEp,dEq);
-          }
-        }
-        else {
-          // TODO
-          assert(0);
-        }
+  *filterP = true;
+  *filterQ = true;
 
+  if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xP,yP)) *filterP=false;
+  if (img->get_cu_transquant_bypass(xP,yP)) *filterP=false;
 
-        // 8.7.2.4.4
-
-        if (dE != 0) {
-          bool filterP = true;
-          bool filterQ = true;
-
-          if (vertical) {
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi-1,yDi)) filterP=false;
-            if (img->get_cu_transquant_bypass(xDi-1,yDi)) filterP=false;
-
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi,yDi)) filterQ=false;
-            if (img->get_cu_transquant_bypass(xDi,yDi)) filterQ=false;
-          }
-          else {
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi,yDi-1)) filterP=false;
-            if (img->get_cu_transquant_bypass(xDi,yDi-1)) filterP=false;
-
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi,yDi)) filterQ=false;
-            if (img->get_cu_transquant_bypass(xDi,yDi)) filterQ=false;
-          }
-
-          for (int k=0;k<4;k++) {
-            //int nDp,nDq;
-
-            logtrace(LogDeblock,"line:%d\n",k);
-
-            const pixel_t p0 = p[k][0];
-            const pixel_t p1 = p[k][1];
-            const pixel_t p2 = p[k][2];
-            const pixel_t p3 = p[k][3];
-            const pixel_t q0 = q[k][0];
-            const pixel_t q1 = q[k][1];
-            const pixel_t q2 = q[k][2];
-            const pixel_t q3 = q[k][3];
-
-            if (dE==2) {
-              // strong filtering
-
-              //nDp=nDq=3;
-
-              pixel_t pnew[3],qnew[3];
-              pnew[0] = Clip3(p0-2*tc,p0+2*tc, (p2 + 2*p1 + 2*p0 + 2*q0 + q1 +4)>>3);
-              pnew[1] = Clip3(p1-2*tc,p1+2*tc, (p2 + p1 + p0 + q0+2)>>2);
-              pnew[2] = Clip3(p2-2*tc,p2+2*tc, (2*p3 + 3*p2 + p1 + p0 + q0 + 4)>>3);
-              qnew[0] = Clip3(q0-2*tc,q0+2*tc, (p1+2*p0+2*q0+2*q1+q2+4)>>3);
-              qnew[1] = Clip3(q1-2*tc,q1+2*tc, (p0+q0+q1+q2+2)>>2);
-              qnew[2] = Clip3(q2-2*tc,q2+2*tc, (p0+q0+q1+3*q2+2*q3+4)>>3);
-
-              logtrace(LogDeblock,"strong filtering\n");
-
-              if (vertical) {
-                for (int i=0;i<3;i++) {
-                  if (filterP) { ptr[-i-1+k*stride] = pnew[i]; }
-                  if (filterQ) { ptr[ i + k*stride] = qnew[i]; }
-                }
+  if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi,yDi)) *filterQ=false;
+  if (img->get_cu_transquant_bypass(xDi,yDi)) *filterQ=false;
+}
 
-                // ptr[-1+k*stride] = ptr[ 0+k*stride] = 200;
-              }
-              else {
-                for (int i=0;i<3;i++) {
-                  if (filterP) { ptr[ k -(i+1)*stride] = pnew[i]; }
-                  if (filterQ) { ptr[ k + i   *stride] = qnew[i]; }
-                }
-              }
-            }
-            else {
-              // weak filtering
 
-              //nDp=nDq=0;
+// 8.7.2.4
+/* The edges are processed in groups of two 4-line segments (8 lines), which are
+   filtered together by the acceleration functions.
+ */
+template <class pixel_t>
+void edge_filtering_luma_internal(de265_image* img, bool vertical,
+                                  int yStart,int yEnd, int xStart,int xEnd)
+{
+  //printf("luma %d-%d %d-%d\n",xStart,xEnd,yStart,yEnd);
 
-              int delta = (9*(q0-p0) - 3*(q1-p1) + 8)>>4;
-              logtrace(LogDeblock,"delta=%d, tc=%d\n",delta,tc);
+  // second segment of a group, in deblocking units
+  const int xSeg = vertical ? 0 : 1;
+  const int ySeg = vertical ? 1 : 0;
 
-              if (abs_value(delta) < tc*10) {
+  const int stride = img->get_image_stride(0);
 
-                delta = Clip3(-tc,tc,delta);
-                logtrace(LogDeblock," deblk + %d;%d [%02x->%02x]  - %d;%d [%02x->%02x] delta:%d\n",
-                         vertical ? xDi-1 : xDi+k,
-                         vertical ? yDi+k : yDi-1, p0,Clip_BitDepth(p0+delta, bitDepth_Y),
-                         vertical ? xDi   : xDi+k,
-                         vertical ? yDi+k : yDi,   q0,Clip_BitDepth(q0-delta, bitDepth_Y),
-                         delta);
+  const int bitDepth_Y = img->sps.BitDepth_Y;
 
-                if (vertical) {
-                  if (filterP) { ptr[-0-1+k*stride] = Clip_BitDepth(p0+delta, bitDepth_Y); }
-                  if (filterQ) { ptr[ 0  +k*stride] = Clip_BitDepth(q0-delta, bitDepth_Y); }
-                }
-                else {
-                  if (filterP) { ptr[ k -1*stride] = Clip_BitDepth(p0+delta, bitDepth_Y); }
-                  if (filterQ) { ptr[ k +0*stride] = Clip_BitDepth(q0-delta, bitDepth_Y); }
-                }
+  const acceleration_functions& accel = img->decctx->acceleration;
 
-                //ptr[ 0+k*stride] = 200;
+  xEnd = libde265_min(xEnd,img->get_deblk_width());
+  yEnd = libde265_min(yEnd,img->get_deblk_height());
 
-                if (dEp==1 && filterP) {
-                  int delta_p = Clip3(-(tc>>1), tc>>1, (((p2+p0+1)>>1)-p1+delta)>>1);
+  for (int y=yStart;y<yEnd;y+=2)
+    for (int x=xStart;x<xEnd;x+=2) {
+      // x;y in deblocking units (4x4 pixels)
 
-                  logtrace(LogDeblock," deblk dEp %d;%d delta:%d\n",
-                           vertical ? xDi-2 : xDi+k,
-                           vertical ? yDi+k : yDi-2,
-                           delta_p);
+      int xDi = x<<2; // *4 -> pixel resolution
+      int yDi = y<<2; // *4 -> pixel resolution
 
-                  if (vertical) { ptr[-1-1+k*stride] = Clip_BitDepth(p1+delta_p, bitDepth_Y); }
-                  else          { ptr[ k  -2*stride] = Clip_BitDepth(p1+delta_p, bitDepth_Y); }
-                }
+      int  beta[2], tc[2];
+      bool filterP[2], filterQ[2];
 
-                if (dEq==1 && filterQ) {
-                  int delta_q = Clip3(-(tc>>1), tc>>1, (((q2+q0+1)>>1)-q1-delta)>>1);
+      luma_segment_parameters(img,vertical, xDi,yDi, &beta[0],&tc[0],&filterP[0],&filterQ[0]);
 
-                  logtrace(LogDeblock," delkb dEq %d;%d delta:%d\n",
-                           vertical ? xDi+1 : xDi+k,
-                           vertical ? yDi+k : yDi+1,
-                           delta_q);
+      bool complete = (x+xSeg<xEnd && y+ySeg<yEnd);
+      if (complete) {
+        luma_segment_parameters(img,vertical, xDi+4*xSeg,yDi+4*ySeg,
+                                &beta[1],&tc[1],&filterP[1],&filterQ[1]);
+      }
 
-                  if (vertical) { ptr[ 1  +k*stride] = Clip_BitDepth(q1+delta_q, bitDepth_Y); }
-                  else          { ptr[ k  +1*stride] = Clip_BitDepth(q1+delta_q, bitDepth_Y); }
-                }
+      if (tc[0]==0 && (!complete || tc[1]==0)) {
+        continue;
+      }
 
-                //nDp = dEp+1;
-                //nDq = dEq+1;
+      pixel_t* ptr = img->get_image_plane_at_pos_NEW<pixel_t>(0, xDi,yDi);
 
-                //logtrace(LogDeblock,"weak filtering (%d:%d)\n",nDp,nDq);
-              }
-            }
-          }
-        }
+      if (complete) {
+        accel.deblock_luma(vertical, ptr,stride, beta,tc, filterP,filterQ, bitDepth_Y);
+      }
+      else {
+        // Cannot happen with valid streams, since the picture size is a multiple of MinCbSizeY.
+        deblock_luma_segment(ptr, vertical ? 1 : stride, vertical ? stride : 1,
+                             beta[0],tc[0], filterP[0],filterQ[0], bitDepth_Y);
       }
     }
 }
@@ -720,8 +536,62 @@ void edge_filtering_luma_CTB(de265_image* img, bool vertical, int xCtb,int yCtb)
 
 
 
+// 8.7.2.4.5, parameters of one 4-line chroma segment
+static void chroma_segment_parameters(de265_image* img, bool vertical, int cplane,
+                                      int xDi,int yDi, // luma position
+                                      int* tc, bool* filterP, bool* filterQ)
+{
+  int bS = img->get_deblk_bS(xDi,yDi);
+
+  if (bS<=1) {
+    *tc = 0;
+    *filterP = *filterQ = false;
+    return;
+  }
+
+  int cQpPicOffset = (cplane==0 ?
+                      img->pps.pic_cb_qp_offset :
+                      img->pps.pic_cr_qp_offset);
+
+  int xP = vertical ? xDi-1 : xDi;
+  int yP = vertical ? yDi : yDi-1;
+
+  int QP_Q = img->get_QPY(xDi,yDi);
+  int QP_P = img->get_QPY(xP,yP);
+  int qP_i = ((QP_Q+QP_P+1)>>1) + cQpPicOffset;
+  int QP_C;
+  if (img->sps.ChromaArrayType == CHROMA_420) {
+    QP_C = table8_22(qP_i);
+  } else {
+    QP_C = libde265_min(qP_i, 51);
+  }
+
+  logtrace(LogDeblock,"-%s- %d %d: ((%d+%d+1)>>1) + %d = qP_i=%d  (QP_C=%d)\n",
+           cplane==0 ? "Cb" : "Cr", xDi,yDi, QP_Q,QP_P,cQpPicOffset,qP_i,QP_C);
+
+  int sliceIndexQ00 = img->get_SliceHeaderIndex(xDi,yDi);
+  int tc_offset   = img->slices[sliceIndexQ00]->slice_tc_offset;
+
+  int Q = Clip3(0,53, QP_C + 2*(bS-1) + tc_offset);
+
+  int tcPrime = table_8_23_tc[Q];
+  *tc = tcPrime * (1<<(img->sps.BitDepth_C - 8));
+
+  logtrace(LogDeblock,"tc_offset=%d Q=%d tc'=%d tc=%d\n",tc_offset,Q,tcPrime,*tc);
+
+  *filterP = true;
+  if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xP,yP)) *filterP=false;
+  if (img->get_cu_transquant_bypass(xP,yP)) *filterP=false;
+
+  *filterQ = true;
+  if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(xDi,yDi)) *filterQ=false;
+  if (img->get_cu_transquant_bypass(xDi,yDi)) *filterQ=false;
+}
+
+
 // 8.7.2.4
 /** ?Start and ?End values in 4-luma pixels resolution.
+    As for luma, two segments of 4 chroma lines are filtered together.
  */
 template <class pixel_t>
 void edge_filtering_chroma_internal(de265_image* img, bool vertical,
@@ -739,127 +609,54 @@ void edge_filtering_chroma_internal(de265_image* img, bool vertical,
   xIncr *= SubWidthC;
   yIncr *= SubHeightC;
 
+  // second segment of a group, in deblocking units
+  const int xSeg = vertical ? 0 : xIncr;
+  const int ySeg = vertical ? yIncr : 0;
+
   const int stride = img->get_image_stride(1);
 
   xEnd = libde265_min(xEnd,img->get_deblk_width());
   yEnd = libde265_min(yEnd,img->get_deblk_height());
 
-  int bitDepth_C = img->sps.BitDepth_C;
+  const int bitDepth_C = img->sps.BitDepth_C;
 
-  for (int y=yStart;y<yEnd;y+=yIncr)
-    for (int x=xStart;x<xEnd;x+=xIncr) {
+  const acceleration_functions& accel = img->decctx->acceleration;
+
+  for (int y=yStart;y<yEnd;y+=yIncr+ySeg)
+    for (int x=xStart;x<xEnd;x+=xIncr+xSeg) {
       int xDi = x << (3-SubWidthC);
       int yDi = y << (3-SubHeightC);
 
       //printf("x,y:%d,%d  xDi,yDi:%d,%d\n",x,y,xDi,yDi);
 
-      int bS = img->get_deblk_bS(xDi*SubWidthC,yDi*SubHeightC);
-
-      if (bS>1) {
-        // 8.7.2.4.5
-
-        for (int cplane=0;cplane<2;cplane++) {
-          int cQpPicOffset = (cplane==0 ?
-                              img->pps.pic_cb_qp_offset :
-                              img->pps.pic_cr_qp_offset);
-
-          pixel_t* ptr = img->get_image_plane_at_pos_NEW<pixel_t>(cplane+1, xDi,yDi);
-
-          pixel_t p[2][4];
-          pixel_t q[2][4];
-
-          logtrace(LogDeblock,"-%s- %d %d\n",cplane==0 ? "Cb" : "Cr",xDi,yDi);
-
-          for (int i=0;i<2;i++)
-            for (int k=0;k<4;k++)
-              {
-                if (vertical) {
-                  q[i][k] = ptr[ i  +k*stride];
-                  p[i][k] = ptr[-i-1+k*stride];
-                }
-                else {
-                  q[i][k] = ptr[k + i   *stride];
-                  p[i][k] = ptr[k -(i+1)*stride];
-                }
-              }
-
-#if 0
-          for (int k=0;k<4;k++)
-            {
-              for (int i=0;i<2;i++)
-                {
-                  printf("%02x ", p[1-i][k]);
-                }
-
-              printf("| ");
-
-              for (int i=0;i<2;i++)
-                {
-                  printf("%02x ", q[i][k]);
-                }
-              printf("\n");
-            }
-#endif
-
-          int QP_Q = img->get_QPY(SubWidthC*xDi,SubHeightC*yDi);
-          int QP_P = (vertical ?
-                      img->get_QPY(SubWidthC*xDi-1,SubHeightC*yDi) :
-                      img->get_QPY(SubWidthC*xDi,SubHeightC*yDi-1));
-          int qP_i = ((QP_Q+QP_P+1)>>1) + cQpPicOffset;
-          int QP_C;
-          if (img->sps.ChromaArrayType == CHROMA_420) {
-            QP_C = table8_22(qP_i);
-          } else {
-            QP_C = libde265_min(qP_i, 51);
-          }
-
-
-          //printf("POC=%d\n",ctx->img->PicOrderCntVal);
-          logtrace(LogDeblock,"%d %d: ((%d+%d+1)>>1) + %d = qP_i=%d  (QP_C=%d)\n",
-                   SubWidthC*xDi,SubHeightC*yDi, QP_Q,QP_P,cQpPicOffset,qP_i,QP_C);
-
-          int sliceIndexQ00 = img->get_SliceHeaderIndex(SubWidthC*xDi,SubHeightC*yDi);
-          int tc_offset   = img->slices[sliceIndexQ00]->slice_tc_offset;
-
-          int Q = Clip3(0,53, QP_C + 2*(bS-1) + tc_offset);
+      bool complete = (x+xSeg<xEnd && y+ySeg<yEnd);
 
-          int tcPrime = table_8_23_tc[Q];
-          int tc = tcPrime * (1<<(img->sps.BitDepth_C - 8));
+      for (int cplane=0;cplane<2;cplane++) {
+        int  tc[2];
+        bool filterP[2], filterQ[2];
 
-          logtrace(LogDeblock,"tc_offset=%d Q=%d tc'=%d tc=%d\n",tc_offset,Q,tcPrime,tc);
+        chroma_segment_parameters(img,vertical,cplane, xDi*SubWidthC,yDi*SubHeightC,
+                                  &tc[0],&filterP[0],&filterQ[0]);
 
-          if (vertical) {
-            bool filterP = true;
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(SubWidthC*xDi-1,SubHeightC*yDi)) filterP=false;
-            if (img->get_cu_transquant_bypass(SubWidthC*xDi-1,SubHeightC*yDi)) filterP=false;
+        if (complete) {
+          chroma_segment_parameters(img,vertical,cplane,
+                                    (xDi+4*!vertical)*SubWidthC, (yDi+4*vertical)*SubHeightC,
+                                    &tc[1],&filterP[1],&filterQ[1]);
+        }
 
-            bool filterQ = true;
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(SubWidthC*xDi,SubHeightC*yDi)) filterQ=false;
-            if (img->get_cu_transquant_bypass(SubWidthC*xDi,SubHeightC*yDi)) filterQ=false;
+        if (tc[0]==0 && (!complete || tc[1]==0)) {
+          continue;
+        }
 
+        pixel_t* ptr = img->get_image_plane_at_pos_NEW<pixel_t>(cplane+1, xDi,yDi);
 
-            for (int k=0;k<4;k++) {
-              int delta = Clip3(-tc,tc, ((((q[0][k]-p[0][k])<<2)+p[1][k]-q[1][k]+4)>>3));
-              logtrace(LogDeblock,"delta=%d\n",delta);
-              if (filterP) { ptr[-1+k*stride] = Clip_BitDepth(p[0][k]+delta, bitDepth_C); }
-              if (filterQ) { ptr[ 0+k*stride] = Clip_BitDepth(q[0][k]-delta, bitDepth_C); }
-            }
-          }
-          else {
-            bool filterP = true;
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(SubWidthC*xDi,SubHeightC*yDi-1)) filterP=false;
-            if (img->get_cu_transquant_bypass(SubWidthC*xDi,SubHeightC*yDi-1)) filterP=false;
-
-            bool filterQ = true;
-            if (img->sps.pcm_loop_filter_disable_flag && img->get_pcm_flag(SubWidthC*xDi,SubHeightC*yDi)) filterQ=false;
-            if (img->get_cu_transquant_bypass(SubWidthC*xDi,SubHeightC*yDi)) filterQ=false;
-
-            for (int k=0;k<4;k++) {
-              int delta = Clip3(-tc,tc, ((((q[0][k]-p[0][k])<<2)+p[1][k]-q[1][k]+4)>>3));
-              if (filterP) { ptr[ k-1*stride] = Clip_BitDepth(p[0][k]+delta, bitDepth_C); }
-              if (filterQ) { ptr[ k+0*stride] = Clip_BitDepth(q[0][k]-delta, bitDepth_C); }
-            }
-          }
+        if (complete) {
+          accel.deblock_chroma(vertical, ptr,stride, tc, filterP,filterQ, bitDepth_C);
+        }
+        else {
+          // last segment at the right or bottom border of the picture
+          deblock_chroma_segment(ptr, vertical ? 1 : stride, vertical ? stride : 1,
+                                 tc[0], filterP[0],filterQ[0], bitDepth_C);
         }
       }
     }
@@ -890,27 +687,8 @@ void edge_filtering_chroma_CTB(de265_image* img, bool vertical, int xCtb,int yCt
 
 
 
-class thread_task_deblock_CTBRow : public thread_task
+static void deblock_CTB_row(de265_image* img, int ctb_y, bool vertical)
 {
-public:
-  struct de265_image* img;
-  int  ctb_y;
-  bool vertical;
-
-  virtual void work();
-  virtual std::string name() const {
-    char buf[100];
-    sprintf(buf,"deblock-%d",ctb_y);
-    return buf;
-  }
-};
-
-
-void thread_task_deblock_CTBRow::work()
-{
-  state = Running;
-  img->thread_run(this);
-
   int xStart=0;
   int xEnd = img->get_deblk_width();
 
@@ -923,31 +701,6 @@ void thread_task_deblock_CTBRow::work()
     last = img->get_deblk_height();
   }
 
-  int finalProgress = CTB_PROGRESS_DEBLK_V;
-  if (!vertical) finalProgress = CTB_PROGRESS_DEBLK_H;
-
-  int rightCtb = img->sps.PicWidthInCtbsY-1;
-
-  if (vertical) {
-    // pass 1: vertical
-
-    int CtbRow = std::min(ctb_y+1 , img->sps.PicHeightInCtbsY-1);
-    img->wait_for_progress(this, rightCtb,CtbRow, CTB_PROGRESS_PREFILTER);
-  }
-  else {
-    // pass 2: horizontal
-
-    if (ctb_y>0) {
-      img->wait_for_progress(this, rightCtb,ctb_y-1, CTB_PROGRESS_DEBLK_V);
-    }
-
-    img->wait_for_progress(this, rightCtb,ctb_y,  CTB_PROGRESS_DEBLK_V);
-
-    if (ctb_y+1<img->sps.PicHeightInCtbsY) {
-      img->wait_for_progress(this, rightCtb,ctb_y+1, CTB_PROGRESS_DEBLK_V);
-    }
-  }
-
   //printf("deblock %d to %d orientation: %d\n",first,last,vertical);
 
   bool deblocking_enabled;
@@ -973,10 +726,134 @@ void thread_task_deblock_CTBRow::work()
       edge_filtering_chroma(img, vertical, first,last, xStart,xEnd);
     }
   }
+}
+
+
+/* In-loop filters of one CTB-row: vertical deblocking, horizontal deblocking, and SAO of
+   the row above (SAO needs the deblocked first lines of the row below). The last task of
+   the picture also applies SAO to its own row. Without SAO, each task finalizes the row
+   above after its horizontal deblocking.
+   The tasks are pipelined behind slice decoding: each one starts as soon as its CTB-row
+   and the row below are decoded.
+ */
+class thread_task_filter_CTBRow : public thread_task
+{
+public:
+  struct de265_image* img;
+  std::vector<uint8_t>* saoInputLines; // unfiltered SAO input at the CTB-row boundaries
+  int  ctb_y;
+  bool deblock;
+  bool sao;
+
+  virtual void work();
+  virtual std::string name() const {
+    char buf[100];
+    sprintf(buf,"filter-%d",ctb_y);
+    return buf;
+  }
+
+  virtual void get_trace_info(const char** name, int* ctbX, int* ctbY) const {
+    *name = "filter";
+    *ctbX = -1;
+    *ctbY = ctb_y;
+  }
+
+private:
+  void set_row_progress(int y, int progress);
+};
+
+
+void thread_task_filter_CTBRow::set_row_progress(int y, int progress)
+{
+  // Later pictures may use the CTB-row for motion compensation as soon as it is final.
+  if (progress==CTB_PROGRESS_SAO) {
+    img->extend_borders(y,y+1);
+  }
+
+  img->ctb_row_progress[y].set_progress(progress);
+}
+
+
+void thread_task_filter_CTBRow::work()
+{
+  state = Running;
+  img->thread_run(this);
+
+  const int rightCtb = img->sps.PicWidthInCtbsY-1;
+  const int lastCtbRow = img->sps.PicHeightInCtbsY-1;
+
+
+  /* Wait until the input CTB-rows are decoded completely. We cannot wait only
+     for the last CTB in the row, because the rows may be decoded out of order
+     with tiles, or while slice decoding is still running in parallel.
+
+     Deblocking may only start when also the next CTB-row is decoded, because its
+     intra-prediction uses the unfiltered samples of this row.
+     SAO of the row above needs the first lines of this row. */
+
+  int firstRow = (sao && ctb_y>0) ? ctb_y-1 : ctb_y;
+  int lastRow  = deblock ? std::min(ctb_y+1, lastCtbRow) : ctb_y;
+
+  for (int y=firstRow;y<=lastRow;y++)
+    for (int x=0;x<=rightCtb;x++) {
+      img->wait_for_progress(this, x,y, CTB_PROGRESS_PREFILTER);
+    }
+
+
+  if (deblock) {
+    {
+      DE265_TRACE_SCOPE(&img->decctx->tracer, "deblock-V", img->PicOrderCntVal, -1,ctb_y);
+      deblock_CTB_row(img, ctb_y, true);
+    }
+    set_row_progress(ctb_y, CTB_PROGRESS_DEBLK_V);
+
+    // horizontal edges at the top of this row also modify the last lines of the row above
+
+    if (ctb_y>0) {
+      img->wait_for_row_progress(this, ctb_y-1, CTB_PROGRESS_DEBLK_V);
+    }
+
+    {
+      DE265_TRACE_SCOPE(&img->decctx->tracer, "deblock-H", img->PicOrderCntVal, -1,ctb_y);
+      deblock_CTB_row(img, ctb_y, false);
+    }
+
+    set_row_progress(ctb_y, CTB_PROGRESS_DEBLK_H);
+
+    // If there is no SAO, the row above is completely reconstructed after this pass,
+    // since it changed its last lines. The last row has no row below to wait for.
+
+    if (!sao) {
+      if (ctb_y>0) {
+        img->wait_for_row_progress(this, ctb_y-1, CTB_PROGRESS_DEBLK_H);
+        set_row_progress(ctb_y-1, CTB_PROGRESS_SAO);
+      }
+
+      if (ctb_y==lastCtbRow) {
+        set_row_progress(ctb_y, CTB_PROGRESS_SAO);
+      }
+    }
+  }
+
+
+  if (sao) {
+    if (ctb_y>0) {
+      if (deblock) {
+        img->wait_for_row_progress(this, ctb_y-1, CTB_PROGRESS_DEBLK_H);
+      }
+
+      {
+        DE265_TRACE_SCOPE(&img->decctx->tracer, "sao", img->PicOrderCntVal, -1,ctb_y-1);
+        apply_sao_CTB_row(this, img, saoInputLines, ctb_y-1);
+      }
+      set_row_progress(ctb_y-1, CTB_PROGRESS_SAO);
+    }
 
-  for (int x=0;x<=rightCtb;x++) {
-    const int CtbWidth = img->sps.PicWidthInCtbsY;
-    img->ctb_progress[x+ctb_y*CtbWidth].set_progress(finalProgress);
+    if (ctb_y==lastCtbRow) {
+      DE265_TRACE_SCOPE(&img->decctx->tracer, "sao", img->PicOrderCntVal, -1,ctb_y);
+      apply_sao_CTB_row(this, img, saoInputLines, ctb_y);
+      set_row_progress(ctb_y, CTB_PROGRESS_SAO);
+    }
   }
 
   state = Finished;
@@ -984,30 +861,34 @@ void thread_task_deblock_CTBRow::work()
 }
 
 
-void add_deblocking_tasks(image_unit* imgunit)
+void add_inloop_filter_tasks(image_unit* imgunit)
 {
   de265_image* img = imgunit->img;
   decoder_context* ctx = img->decctx;
 
+  bool deblock = !ctx->param_disable_deblocking;
+  bool sao     = !ctx->param_disable_sao && alloc_sao_input_lines(imgunit);
+
+  if (!deblock && !sao) {
+    return;
+  }
+
   int nRows = img->sps.PicHeightInCtbsY;
 
-  int n=0;
-  img->thread_start(nRows*2);
+  img->thread_start(nRows);
 
-  for (int pass=0;pass<2;pass++)
+  for (int y=0;y<nRows;y++)
     {
-      for (int y=0;y<img->sps.PicHeightInCtbsY;y++)
-        {
-          thread_task_deblock_CTBRow* task = new thread_task_deblock_CTBRow;
+      thread_task_filter_CTBRow* task = new(ctx->task_pool) thread_task_filter_CTBRow;
 
-          task->img   = img;
-          task->ctb_y = y;
-          task->vertical = (pass==0);
+      task->img   = img;
+      task->saoInputLines = imgunit->sao_input_lines;
+      task->ctb_y = y;
+      task->deblock = deblock;
+      task->sao   = sao;
 
-          imgunit->tasks.push_back(task);
-          add_task(&ctx->thread_pool_, task);
-          n++;
-        }
+      imgunit->tasks.push_back(task);
+      add_task(ctx->thread_pool_, task);
     }
 }
 
@@ -23,7 +23,8 @@
 
 #include "libde265/decctx.h"
 
-void add_deblocking_tasks(image_unit* imgunit);
+/* Adds the tasks for deblocking and SAO of a picture (one task per CTB-row). */
+void add_inloop_filter_tasks(image_unit* imgunit);
 void apply_deblocking_filter(de265_image* img); //decoder_context* ctx);
 
 #endif
@@ -121,6 +121,8 @@ thread_context::thread_context()
   imgunit = NULL;
   sliceunit = NULL;
 
+  recon = NULL;
+
 
   //memset(this,0,sizeof(thread_context));
 
@@ -145,6 +147,7 @@ slice_unit::slice_unit(decoder_context* decctx)
     imgunit(NULL),
     flush_reorder_buffer(false),
     nThreads(0),
+    nPendingTasks(1),
     first_decoded_CTB_RS(-1),
     last_decoded_CTB_RS(-1),
     thread_contexts(NULL),
@@ -173,11 +176,37 @@ void slice_unit::allocate_thread_contexts(int n)
 }
 
 
-image_unit::image_unit()
+void slice_unit::release_pending_task()
+{
+  if (de265_sync_sub_and_fetch(&nPendingTasks,1)==0) {
+    ctx->mark_whole_slice_as_processed(imgunit, this, CTB_PROGRESS_PREFILTER);
+  }
+}
+
+
+void slice_unit::task_finished()
+{
+  // mark the CTBs first, a following slice segment may start as soon as we are finished
+
+  release_pending_task();
+  finished_threads.increase_progress(1);
+}
+
+
+void slice_unit::all_tasks_added()
+{
+  release_pending_task();
+}
+
+
+image_unit::image_unit(alloc_pool* pool)
 {
   img=NULL;
   role=Invalid;
   state=Unprocessed;
+
+  task_pool = pool;
+  task_heap_allocations_at_start = task_pool->num_heap_allocations();
 }
 
 
@@ -188,8 +217,13 @@ image_unit::~image_unit()
   }
 
   for (int i=0;i<tasks.size();i++) {
-    delete tasks[i];
+    thread_task::delete_task(tasks[i], *task_pool);
   }
+
+  // in the steady state, all tasks should be taken from the pool without heap allocations
+
+  loginfo(LogHighlevel,"%d tasks, %d heap allocations for tasks\n", (int)tasks.size(),
+          task_pool->num_heap_allocations() - task_heap_allocations_at_start);
 }
 
 
@@ -200,6 +234,7 @@ base_context::base_context()
 
 
 decoder_context::decoder_context()
+  : task_pool(THREAD_TASK_POOL_OBJECT_SIZE, 256)
 {
   //memset(ctx, 0, sizeof(decoder_context));
 
@@ -211,6 +246,8 @@ decoder_context::decoder_context()
 
   param_disable_deblocking = false;
   param_disable_sao = false;
+  param_max_frames_in_flight = 0;
+  param_split_parsing = false;
   //param_disable_mc_residual_idct = false;
   //param_disable_intra_residual_idct = false;
 
@@ -236,6 +273,8 @@ decoder_context::decoder_context()
   current_pps = NULL;
 
   //memset(&thread_pool,0,sizeof(struct thread_pool));
+  thread_pool_ = &own_thread_pool;
+  uses_shared_thread_pool = false;
   num_worker_threads = 0;
 
 
@@ -315,6 +354,8 @@ decoder_context::decoder_context()
 
 decoder_context::~decoder_context()
 {
+  abort_images_in_flight();
+
   while (!image_units.empty()) {
     delete image_units.back();
     image_units.pop_back();
@@ -340,9 +381,26 @@ void decoder_context::set_image_allocation_functions(de265_image_allocation* all
 
 de265_error decoder_context::start_thread_pool(int nThreads)
 {
-  ::start_thread_pool(&thread_pool_, nThreads);
+  thread_pool_ = &own_thread_pool;
+  uses_shared_thread_pool = false;
+
+  de265_error err = ::start_thread_pool(thread_pool_, nThreads);
+
+  // if not all threads could be created, continue with the ones we have
+  num_worker_threads = thread_pool_->num_threads;
+
+  return err;
+}
+
+
+de265_error decoder_context::attach_thread_pool(thread_pool* pool)
+{
+  stop_thread_pool();
 
-  num_worker_threads = nThreads;
+  thread_pool_ = pool;
+  uses_shared_thread_pool = true;
+
+  num_worker_threads = pool->num_threads;
 
   return DE265_OK;
 }
@@ -351,8 +409,22 @@ de265_error decoder_context::start_thread_pool(int nThreads)
 void decoder_context::stop_thread_pool()
 {
   if (get_num_worker_threads()>0) {
-    //flush_thread_pool(&ctx->thread_pool);
-    ::stop_thread_pool(&thread_pool_);
+    // the worker threads must not be stopped while they are still decoding pictures
+
+    finish_all_images_in_flight();
+
+    if (uses_shared_thread_pool) {
+      // other decoders may still be using the pool, just detach from it
+
+      thread_pool_ = &own_thread_pool;
+      uses_shared_thread_pool = false;
+    }
+    else {
+      //flush_thread_pool(&ctx->thread_pool);
+      ::stop_thread_pool(thread_pool_);
+    }
+
+    num_worker_threads = 0;
   }
 }
 
@@ -360,8 +432,15 @@ void decoder_context::stop_thread_pool()
 void decoder_context::reset()
 {
   if (num_worker_threads>0) {
-    //flush_thread_pool(&ctx->thread_pool);
-    ::stop_thread_pool(&thread_pool_);
+    abort_images_in_flight();
+
+    // A shared pool keeps running. Since all our images have been finished,
+    // none of its remaining tasks belongs to this decoder.
+
+    if (!uses_shared_thread_pool) {
+      //flush_thread_pool(&ctx->thread_pool);
+      ::stop_thread_pool(thread_pool_);
+    }
   }
 
   // --------------------------------------------------
@@ -421,7 +500,7 @@ void decoder_context::reset()
 
   // --- start threads again ---
 
-  if (num_worker_threads>0) {
+  if (num_worker_threads>0 && !uses_shared_thread_pool) {
     // TODO: need error checking
     start_thread_pool(num_worker_threads);
   }
@@ -440,6 +519,9 @@ void base_context::set_acceleration_functions(enum de265_acceleration l)
   if (l>=de265_acceleration_SSE) {
     init_acceleration_functions_sse(&acceleration);
   }
+  if (l>=de265_acceleration_AVX2) {
+    init_acceleration_functions_avx2(&acceleration);
+  }
 #endif
 #ifdef HAVE_ARM
   if (l>=de265_acceleration_ARM) {
@@ -461,13 +543,18 @@ void decoder_context::init_thread_context(thread_context* tctx)
 
   // --- find QPY that was active at the end of the previous slice ---
 
+  // Only dependent slice segments continue the QP prediction of the previous segment.
+  // Independent slices start with SliceQPY and may be decoded before the previous
+  // slice is finished.
+
   // find the previous CTB in TS order
 
   const pic_parameter_set* pps = &tctx->img->pps;
   const seq_parameter_set* sps = &tctx->img->sps;
 
 
-  if (tctx->shdr->slice_segment_address > 0) {
+  if (tctx->shdr->slice_segment_address > 0 &&
+      tctx->shdr->dependent_slice_segment_flag) {
     int prevCtb = pps->CtbAddrTStoRS[ pps->CtbAddrRStoTS[tctx->shdr->slice_segment_address] -1 ];
 
     int ctbX = prevCtb % sps->PicWidthInCtbsY;
@@ -484,9 +571,7 @@ void decoder_context::init_thread_context(thread_context* tctx)
 
     //printf("READ QPY: %d %d -> %d (should %d)\n",x,y,imgunit->img->get_QPY(x,y), tc.currentQPY);
 
-    //if (tctx->shdr->dependent_slice_segment_flag) {  // TODO: do we need this condition ?
     tctx->currentQPY = tctx->img->get_QPY(x,y);
-      //}
   }
 }
 
@@ -495,13 +580,13 @@ void decoder_context::add_task_decode_CTB_row(thread_context* tctx,
                                               bool firstSliceSubstream,
                                               int ctbRow)
 {
-  thread_task_ctb_row* task = new thread_task_ctb_row;
+  thread_task_ctb_row* task = new(task_pool) thread_task_ctb_row;
   task->firstSliceSubstream = firstSliceSubstream;
   task->tctx = tctx;
   task->debug_startCtbRow = ctbRow;
   tctx->task = task;
 
-  add_task(&thread_pool_, task);
+  add_task(thread_pool_, task);
 
   tctx->imgunit->tasks.push_back(task);
 }
@@ -510,14 +595,27 @@ void decoder_context::add_task_decode_CTB_row(thread_context* tctx,
 void decoder_context::add_task_decode_slice_segment(thread_context* tctx, bool firstSliceSubstream,
                                                     int ctbx,int ctby)
 {
-  thread_task_slice_segment* task = new thread_task_slice_segment;
+  thread_task_slice_segment* task = new(task_pool) thread_task_slice_segment;
   task->firstSliceSubstream = firstSliceSubstream;
   task->tctx = tctx;
   task->debug_startCtbX = ctbx;
   task->debug_startCtbY = ctby;
   tctx->task = task;
 
-  add_task(&thread_pool_, task);
+  add_task(thread_pool_, task);
+
+  tctx->imgunit->tasks.push_back(task);
+}
+
+
+void decoder_context::add_task_reconstruct_CTB_row(thread_context* tctx, int ctbRow)
+{
+  thread_task_reconstruct_ctb_row* task = new(task_pool) thread_task_reconstruct_ctb_row;
+  task->ctbRow = ctbRow;
+  task->tctx = tctx;
+  tctx->task = task;
+
+  add_task(thread_pool_, task);
 
   tctx->imgunit->tasks.push_back(task);
 }
@@ -660,7 +758,7 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
   // --- start a new image if this is the first slice ---
 
   if (shdr->first_slice_segment_in_pic_flag) {
-    image_unit* imgunit = new image_unit;
+    image_unit* imgunit = new image_unit(&task_pool);
     imgunit->img = this->img;
     image_units.push_back(imgunit);
   }
@@ -671,6 +769,7 @@ de265_error decoder_context::read_slice_NAL(bitreader& reader, NAL_unit* nal, na
   if ( ! image_units.empty() ) {
 
     slice_unit* sliceunit = new slice_unit(this);
+    sliceunit->imgunit = image_units.back();
     sliceunit->nal = nal;
     sliceunit->shdr = shdr;
     sliceunit->reader = reader;
@@ -705,6 +804,10 @@ de265_error decoder_context::decode_some(bool* did_work)
 
   if (image_units.empty()) { return DE265_OK; }  // nothing to do
 
+  if (num_worker_threads > 0) {
+    return decode_some_frame_parallel(did_work);
+  }
+
 
   // decode something if there is work to do
 
@@ -750,9 +853,6 @@ de265_error decoder_context::decode_some(bool* did_work)
 
     // mark all CTBs as decoded even if they are not, because faulty input
     // streams could miss part of the picture
-    // TODO: this will not work when slice decoding is parallel to post-filtering,
-    // so we will have to replace this with keeping track of which CTB should have
-    // been decoded (but aren't because of the input stream being faulty)
 
     imgunit->img->mark_all_CTB_progress(CTB_PROGRESS_PREFILTER);
 
@@ -760,10 +860,7 @@ de265_error decoder_context::decode_some(bool* did_work)
 
     // run post-processing filters (deblocking & SAO)
 
-    if (img->decctx->num_worker_threads)
-      run_postprocessing_filters_parallel(imgunit);
-    else
-      run_postprocessing_filters_sequential(imgunit->img);
+    run_postprocessing_filters_sequential(imgunit->img);
 
     // process suffix SEIs
 
@@ -789,6 +886,222 @@ de265_error decoder_context::decode_some(bool* did_work)
 }
 
 
+/* Frame-parallel decoding.
+   When worker threads are available, each picture is started as soon as all of its
+   slices have been received. All its slices and in-loop filters are added as tasks to
+   the thread pool without waiting for them, so that the following pictures can start
+   while the previous ones are still being decoded. Inter prediction waits for the
+   required CTB rows of the reference pictures (see de265_image::wait_for_lines()).
+
+   The image units in flight are always at the front of the queue and they are finished
+   (pushed to the output) strictly in decoding order.
+ */
+de265_error decoder_context::decode_some_frame_parallel(bool* did_work)
+{
+  de265_error err = DE265_OK;
+
+  // start all pictures that have been received completely
+
+  for (;;) {
+    int idx = num_images_in_flight();
+    if (idx >= image_units.size() || !image_unit_is_complete(idx)) {
+      break;
+    }
+
+    *did_work = true;
+
+    if (idx >= max_images_in_flight()) {
+      err = finish_oldest_image_in_flight();
+    }
+    else {
+      err = start_image_unit(image_units[idx]);
+    }
+
+    if (err != DE265_OK) {
+      return err;
+    }
+  }
+
+
+  // output pictures that have been decoded completely
+
+  while (num_images_in_flight() > 0 &&
+         image_units[0]->img->is_completed()) {
+    *did_work = true;
+
+    err = finish_oldest_image_in_flight();
+    if (err != DE265_OK) {
+      return err;
+    }
+  }
+
+
+  // At the end of the stream, there is nothing else to do than waiting for the decoder.
+
+  if (*did_work == false &&
+      num_images_in_flight() > 0 &&
+      nal_parser.get_NAL_queue_length() == 0 &&
+      nal_parser.is_end_of_stream()) {
+    *did_work = true;
+
+    err = finish_oldest_image_in_flight();
+  }
+
+  return err;
+}
+
+
+int decoder_context::max_images_in_flight() const
+{
+  if (param_max_frames_in_flight > 0) {
+    return param_max_frames_in_flight;
+  }
+
+  return std::max(2, std::min(num_worker_threads, 8));
+}
+
+
+int decoder_context::num_images_in_flight() const
+{
+  int n=0;
+  while (n < image_units.size() &&
+         image_units[n]->state == image_unit::InProgress) {
+    n++;
+  }
+
+  return n;
+}
+
+
+// A picture can be started when all its slices have been received.
+bool decoder_context::image_unit_is_complete(int idx) const
+{
+  if (idx+1 < image_units.size()) {
+    return true;  // the next picture has already been started
+  }
+
+  return (nal_parser.number_of_NAL_units_pending()==0 &&
+          (nal_parser.is_end_of_stream() || nal_parser.is_end_of_frame()));
+}
+
+
+de265_error decoder_context::start_image_unit(image_unit* imgunit)
+{
+  de265_error err = DE265_OK;
+
+  DE265_TRACE_SCOPE(&tracer, "start-picture", imgunit->img->PicOrderCntVal, -1,-1);
+
+  imgunit->state = image_unit::InProgress;
+  imgunit->img->set_decoding_in_background(true);
+
+  for (int i=0;i<imgunit->slice_units.size();i++) {
+    de265_error sliceErr = decode_slice_unit_parallel(imgunit, imgunit->slice_units[i]);
+    if (err == DE265_OK) {
+      err = sliceErr;
+    }
+  }
+
+  add_postprocessing_filter_tasks(imgunit);
+
+  return err;
+}
+
+
+de265_error decoder_context::finish_image_unit(image_unit* imgunit)
+{
+  de265_error err = DE265_OK;
+
+  de265_image* img = imgunit->img;
+
+  {
+    DE265_TRACE_SCOPE(&tracer, "wait-for-picture", img->PicOrderCntVal, -1,-1);
+    img->wait_for_completion();
+  }
+
+  // Mark the picture as completely reconstructed, even if the filters did not run.
+  img->mark_all_CTBs_final();
+  img->set_decoding_in_background(false);
+
+  imgunit->state = image_unit::Decoded;
+
+
+  // No later picture can use the removed references anymore, but pictures that were
+  // decoded in parallel could, until now.
+
+  bool flush_reorder_buffer = false;
+
+  for (int i=0;i<imgunit->slice_units.size();i++) {
+    slice_unit* sliceunit = imgunit->slice_units[i];
+
+    remove_images_from_dpb(sliceunit->shdr->RemoveReferencesList);
+    flush_reorder_buffer |= sliceunit->flush_reorder_buffer;
+  }
+
+  if (flush_reorder_buffer) {
+    dpb.flush_reorder_buffer();
+  }
+
+
+  // process suffix SEIs
+
+  for (int i=0;i<imgunit->suffix_SEIs.size();i++) {
+    const sei_message& sei = imgunit->suffix_SEIs[i];
+
+    err = process_sei(&sei, img);
+    if (err != DE265_OK)
+      break;
+  }
+
+
+  push_picture_to_output_queue(imgunit);
+
+  return err;
+}
+
+
+de265_error decoder_context::finish_oldest_image_in_flight()
+{
+  assert(num_images_in_flight() > 0);
+
+  image_unit* imgunit = image_units[0];
+
+  de265_error err = finish_image_unit(imgunit);
+
+  // remove decoded image unit from queue
+
+  delete imgunit;
+
+  pop_front(image_units);
+
+  return err;
+}
+
+
+void decoder_context::finish_all_images_in_flight()
+{
+  while (num_images_in_flight() > 0) {
+    finish_oldest_image_in_flight();
+  }
+}
+
+
+// Wait until the worker threads are done, but throw away the pictures.
+void decoder_context::abort_images_in_flight()
+{
+  for (int i=0;i<image_units.size();i++) {
+    image_unit* imgunit = image_units[i];
+
+    if (imgunit->state == image_unit::InProgress) {
+      imgunit->img->wait_for_completion();
+      imgunit->img->mark_all_CTBs_final();
+      imgunit->img->set_decoding_in_background(false);
+
+      imgunit->state = image_unit::Dropped;
+    }
+  }
+}
+
+
 de265_error decoder_context::decode_slice_unit_sequential(image_unit* imgunit,
                                                           slice_unit* sliceunit)
 {
@@ -807,6 +1120,10 @@ de265_error decoder_context::decode_slice_unit_sequential(image_unit* imgunit,
     return DE265_ERROR_CTB_OUTSIDE_IMAGE_AREA;
   }
 
+  DE265_TRACE_SCOPE(&tracer, "slice-segment", imgunit->img->PicOrderCntVal,
+                    sliceunit->shdr->slice_segment_address % imgunit->img->sps.PicWidthInCtbsY,
+                    sliceunit->shdr->slice_segment_address / imgunit->img->sps.PicWidthInCtbsY);
+
 
   struct thread_context tctx;
 
@@ -832,7 +1149,7 @@ de265_error decoder_context::decode_slice_unit_sequential(image_unit* imgunit,
 
   if (pps->entropy_coding_sync_enabled_flag &&
       sliceunit->shdr->first_slice_segment_in_pic_flag) {
-    imgunit->ctx_models.resize( (img->sps.PicHeightInCtbsY-1) ); //* CONTEXT_MODEL_TABLE_LENGTH );
+    imgunit->ctx_models.resize( (img->sps.PicHeightInCtbsY-1) * pps->num_tile_columns );
   }
 
   sliceunit->nThreads=1;
@@ -851,8 +1168,19 @@ void decoder_context::mark_whole_slice_as_processed(image_unit* imgunit,
 {
   //printf("mark whole slice\n");
 
+  de265_image* img = imgunit->img;
+  const pic_parameter_set* pps = &img->pps;
+  const int nCtbs = pps->CtbAddrRStoTS.size();
+
+
+  // mark all CTBs upto the next slice segment (or the end of the picture) as processed
 
-  // mark all CTBs upto the next slice segment as processed
+  int firstCtb = sliceunit->shdr->slice_segment_address;
+  if (firstCtb >= nCtbs) {
+    return;
+  }
+
+  int endCtbTS = nCtbs;
 
   slice_unit* nextSegment = imgunit->get_next_slice_segment(sliceunit);
   if (nextSegment) {
@@ -862,16 +1190,18 @@ void decoder_context::mark_whole_slice_as_processed(image_unit* imgunit,
            nextSegment->shdr->slice_segment_address);
     */
 
-    for (int ctb=sliceunit->shdr->slice_segment_address;
-         ctb < nextSegment->shdr->slice_segment_address;
-         ctb++)
-      {
-        if (ctb >= imgunit->img->number_of_ctbs())
-          break;
-
-        imgunit->img->ctb_progress[ctb].set_progress(progress);
-      }
+    int nextCtb = nextSegment->shdr->slice_segment_address;
+    if (nextCtb < nCtbs) {
+      endCtbTS = pps->CtbAddrRStoTS[nextCtb];
+    }
   }
+
+  // CTBs are decoded in tile-scan order
+
+  for (int ctbTS = pps->CtbAddrRStoTS[firstCtb]; ctbTS < endCtbTS; ctbTS++)
+    {
+      img->ctb_progress[ pps->CtbAddrTStoRS[ctbTS] ].set_progress(progress);
+    }
 }
 
 
@@ -880,7 +1210,12 @@ de265_error decoder_context::decode_slice_unit_parallel(image_unit* imgunit,
 {
   de265_error err = DE265_OK;
 
-  remove_images_from_dpb(sliceunit->shdr->RemoveReferencesList);
+  // With worker threads, the picture is decoded in the background and the references
+  // are released only when it is finished (see finish_image_unit()).
+
+  if (num_worker_threads == 0) {
+    remove_images_from_dpb(sliceunit->shdr->RemoveReferencesList);
+  }
 
   /*
   printf("-------- decode --------\n");
@@ -901,15 +1236,6 @@ de265_error decoder_context::decode_slice_unit_parallel(image_unit* imgunit,
                     pps->tiles_enabled_flag);
 
 
-  // TODO: remove this warning later when we do frame-parallel decoding
-  if (img->decctx->num_worker_threads > 0 &&
-      pps->entropy_coding_sync_enabled_flag == false &&
-      pps->tiles_enabled_flag == false) {
-
-    img->decctx->add_warning(DE265_WARNING_NO_WPP_CANNOT_USE_MULTITHREADING, true);
-  }
-
-
   // If this is the first slice segment, mark all CTBs before this as processed
   // (the real first slice segment could be missing).
 
@@ -917,27 +1243,26 @@ de265_error decoder_context::decode_slice_unit_parallel(image_unit* imgunit,
     slice_segment_header* shdr = sliceunit->shdr;
     int firstCTB = shdr->slice_segment_address;
 
-    for (int ctb=0;ctb<firstCTB;ctb++) {
-      //printf("mark pre progress %d\n",ctb);
-      img->ctb_progress[ctb].set_progress(CTB_PROGRESS_PREFILTER);
+    if (firstCTB < pps->CtbAddrRStoTS.size()) {
+      for (int ctbTS=0;ctbTS<pps->CtbAddrRStoTS[firstCTB];ctbTS++) {
+        //printf("mark pre progress %d\n",ctb);
+        img->ctb_progress[ pps->CtbAddrTStoRS[ctbTS] ].set_progress(CTB_PROGRESS_PREFILTER);
+      }
     }
   }
 
 
-  // if there is a previous slice that has been completely decoded,
-  // mark all CTBs until the start of this slice as completed
-
-  //printf("this slice: %p\n",sliceunit);
-  slice_unit* prevSlice = imgunit->get_prev_slice_segment(sliceunit);
-  //if (prevSlice) printf("prev slice state: %d\n",prevSlice->state);
-  if (prevSlice && prevSlice->state == slice_unit::Decoded) {
-    mark_whole_slice_as_processed(imgunit,prevSlice,CTB_PROGRESS_PREFILTER);
-  }
+  if (num_worker_threads == 0) {
+    // if there is a previous slice that has been completely decoded,
+    // mark all CTBs until the start of this slice as completed
 
+    //printf("this slice: %p\n",sliceunit);
+    slice_unit* prevSlice = imgunit->get_prev_slice_segment(sliceunit);
+    //if (prevSlice) printf("prev slice state: %d\n",prevSlice->state);
+    if (prevSlice && prevSlice->state == slice_unit::Decoded) {
+      mark_whole_slice_as_processed(imgunit,prevSlice,CTB_PROGRESS_PREFILTER);
+    }
 
-  // TODO: even though we cannot split this into several tasks, we should run it
-  // as a background thread
-  if (!use_WPP && !use_tiles) {
     //printf("SEQ\n");
     err = decode_slice_unit_sequential(imgunit, sliceunit);
     sliceunit->state = slice_unit::Decoded;
@@ -946,29 +1271,30 @@ de265_error decoder_context::decode_slice_unit_parallel(image_unit* imgunit,
   }
 
 
-  if (use_WPP && use_tiles) {
-    // TODO: this is not allowed ... output some warning or error
+  /* With worker threads, the slice segment is only split into tasks here and decoded
+     in the background. The slice segment will be completely processed when all its tasks
+     have finished (see slice_unit::task_finished()). */
 
-    return DE265_WARNING_PPS_HEADER_INVALID;
+  if (sliceunit->shdr->slice_segment_address >= pps->CtbAddrRStoTS.size()) {
+    err = DE265_ERROR_CTB_OUTSIDE_IMAGE_AREA;
   }
-
-
-  if (use_WPP) {
+  else if (use_WPP) {
+    // with tiles enabled as well, each CTB row within a tile is an own task
     //printf("WPP\n");
     err = decode_slice_unit_WPP(imgunit, sliceunit);
-    sliceunit->state = slice_unit::Decoded;
-    mark_whole_slice_as_processed(imgunit,sliceunit,CTB_PROGRESS_PREFILTER);
-    return err;
   }
   else if (use_tiles) {
     //printf("TILE\n");
     err = decode_slice_unit_tiles(imgunit, sliceunit);
-    sliceunit->state = slice_unit::Decoded;
-    mark_whole_slice_as_processed(imgunit,sliceunit,CTB_PROGRESS_PREFILTER);
-    return err;
   }
+  else {
+    // a slice segment without WPP or tiles is decoded as a single task
+
+    err = decode_slice_unit_single_task(imgunit, sliceunit);
+  }
+
+  sliceunit->all_tasks_added();
 
-  assert(false);
   return err;
 }
 
@@ -986,14 +1312,12 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
   int ctbsWidth = img->sps.PicWidthInCtbsY;
 
 
-  assert(img->num_threads_active() == 0);
-
-
   // reserve space to store entropy coding context models for each CTB row
 
   if (shdr->first_slice_segment_in_pic_flag) {
     // reserve space for nRows-1 because we don't need to save the CABAC model in the last CTB row
-    imgunit->ctx_models.resize( (img->sps.PicHeightInCtbsY-1) ); //* CONTEXT_MODEL_TABLE_LENGTH );
+    // (one model per tile column when tiles are also enabled)
+    imgunit->ctx_models.resize( (img->sps.PicHeightInCtbsY-1) * pps->num_tile_columns );
   }
 
 
@@ -1002,15 +1326,24 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
 
   // first CTB in this slice
   int ctbAddrRS = shdr->slice_segment_address;
-  int ctbRow    = ctbAddrRS / ctbsWidth;
+  int ctbAddrTS = pps->CtbAddrRStoTS[ctbAddrRS];
 
   for (int entryPt=0;entryPt<nRows;entryPt++) {
-    // entry points other than the first start at CTB rows
+    // entry points other than the first start at CTB rows (within a tile)
     if (entryPt>0) {
-      ctbRow++;
-      ctbAddrRS = ctbRow * ctbsWidth;
+      do {
+        ctbAddrTS++;
+      } while (ctbAddrTS < img->sps.PicSizeInCtbsY &&
+               !pps->is_tile_column_start(pps->CtbAddrTStoRS[ctbAddrTS] % ctbsWidth));
+
+      if (ctbAddrTS >= img->sps.PicSizeInCtbsY) {
+        err = DE265_WARNING_SLICEHEADER_INVALID;
+        break;
+      }
+
+      ctbAddrRS = pps->CtbAddrTStoRS[ctbAddrTS];
     }
-    else if (nRows>1 && (ctbAddrRS % ctbsWidth) != 0) {
+    else if (nRows>1 && !pps->is_tile_column_start(ctbAddrRS % ctbsWidth)) {
       // If slice segment consists of several WPP rows, each of them
       // has to start at a row.
 
@@ -1032,7 +1365,7 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
     tctx->sliceunit= sliceunit;
     tctx->CtbAddrInTS = pps->CtbAddrRStoTS[ctbAddrRS];
 
-    init_thread_context(tctx);
+    // init_thread_context() is called by the task, because it depends on the previous slice segment
 
 
     // init CABAC
@@ -1058,10 +1391,11 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
 
     // add task
 
-    //printf("start task for ctb-row: %d\n",ctbRow);
+    //printf("start task for ctb-row: %d\n",ctbAddrRS / ctbsWidth);
     img->thread_start(1);
     sliceunit->nThreads++;
-    add_task_decode_CTB_row(tctx, entryPt==0, ctbRow);
+    de265_sync_add_and_fetch(&sliceunit->nPendingTasks, 1);
+    add_task_decode_CTB_row(tctx, entryPt==0, ctbAddrRS / ctbsWidth);
   }
 
 #if 0
@@ -1078,12 +1412,6 @@ de265_error decoder_context::decode_slice_unit_WPP(image_unit* imgunit,
   }
 #endif
 
-  img->wait_for_completion();
-
-  for (int i=0;i<imgunit->tasks.size();i++)
-    delete imgunit->tasks[i];
-  imgunit->tasks.clear();
-
   return DE265_OK;
 }
 
@@ -1099,9 +1427,6 @@ de265_error decoder_context::decode_slice_unit_tiles(image_unit* imgunit,
   int nTiles = shdr->num_entry_point_offsets +1;
   int ctbsWidth = img->sps.PicWidthInCtbsY;
 
-
-  assert(img->num_threads_active() == 0);
-
   sliceunit->allocate_thread_contexts(nTiles);
 
 
@@ -1135,7 +1460,7 @@ de265_error decoder_context::decode_slice_unit_tiles(image_unit* imgunit,
     tctx->sliceunit= sliceunit;
     tctx->CtbAddrInTS = pps->CtbAddrRStoTS[ctbAddrRS];
 
-    init_thread_context(tctx);
+    // init_thread_context() is called by the task, because it depends on the previous slice segment
 
 
     // init CABAC
@@ -1163,18 +1488,93 @@ de265_error decoder_context::decode_slice_unit_tiles(image_unit* imgunit,
     //printf("add tiles thread\n");
     img->thread_start(1);
     sliceunit->nThreads++;
+    de265_sync_add_and_fetch(&sliceunit->nPendingTasks, 1);
     add_task_decode_slice_segment(tctx, entryPt==0,
                                   ctbAddrRS % ctbsWidth,
                                   ctbAddrRS / ctbsWidth);
   }
 
-  img->wait_for_completion();
+  return err;
+}
 
-  for (int i=0;i<imgunit->tasks.size();i++)
-    delete imgunit->tasks[i];
-  imgunit->tasks.clear();
 
-  return err;
+de265_error decoder_context::decode_slice_unit_single_task(image_unit* imgunit,
+                                                           slice_unit* sliceunit)
+{
+  de265_image* img = imgunit->img;
+  slice_segment_header* shdr = sliceunit->shdr;
+  const pic_parameter_set* pps = &img->pps;
+
+  int ctbsWidth = img->sps.PicWidthInCtbsY;
+
+  if (sliceunit->reader.bytes_remaining <= 0) {
+    return DE265_ERROR_PREMATURE_END_OF_SLICE;
+  }
+
+  // The slice segment extends up to the start of the next one (all slices of the picture
+  // are known when it is started). With split parsing, each of its CTB rows gets its own
+  // reconstruction task.
+
+  int firstCtb = shdr->slice_segment_address;
+  int endCtb   = img->sps.PicSizeInCtbsY;
+
+  slice_unit* nextSegment = imgunit->get_next_slice_segment(sliceunit);
+  if (nextSegment && nextSegment->shdr->slice_segment_address > firstCtb) {
+    endCtb = std::min(endCtb, nextSegment->shdr->slice_segment_address);
+  }
+
+  int firstRow = firstCtb / ctbsWidth;
+  int endRow   = (endCtb-1) / ctbsWidth + 1;
+
+  int nReconRows = 0;
+  if (param_split_parsing && endRow-firstRow >= 2) {
+    nReconRows = endRow-firstRow;
+    sliceunit->recon_CTBs.resize(endCtb-firstCtb);
+  }
+
+  sliceunit->allocate_thread_contexts(1 + nReconRows);
+
+
+  // set thread context
+
+  thread_context* tctx = sliceunit->get_thread_context(0);
+
+  tctx->shdr    = shdr;
+  tctx->decctx  = img->decctx;
+  tctx->img     = img;
+  tctx->imgunit = imgunit;
+  tctx->sliceunit= sliceunit;
+  tctx->CtbAddrInTS = pps->CtbAddrRStoTS[shdr->slice_segment_address];
+
+  init_CABAC_decoder(&tctx->cabac_decoder,
+                     sliceunit->reader.data,
+                     sliceunit->reader.bytes_remaining);
+
+
+  // add task
+
+  img->thread_start(1 + nReconRows);
+  sliceunit->nThreads++;
+  de265_sync_add_and_fetch(&sliceunit->nPendingTasks, 1);
+  add_task_decode_slice_segment(tctx, true,
+                                shdr->slice_segment_address % ctbsWidth,
+                                shdr->slice_segment_address / ctbsWidth);
+
+  for (int i=0;i<nReconRows;i++) {
+    thread_context* rowtctx = sliceunit->get_thread_context(1+i);
+
+    rowtctx->shdr    = shdr;
+    rowtctx->decctx  = img->decctx;
+    rowtctx->img     = img;
+    rowtctx->imgunit = imgunit;
+    rowtctx->sliceunit= sliceunit;
+
+    sliceunit->nThreads++;
+    de265_sync_add_and_fetch(&sliceunit->nPendingTasks, 1);
+    add_task_reconstruct_CTB_row(rowtctx, firstRow+i);
+  }
+
+  return DE265_OK;
 }
 
 
@@ -1300,6 +1700,13 @@ de265_error decoder_context::decode(int* more)
 
   if (!ctx->dpb.has_free_dpb_picture(false)) {
     if (more) *more = 1;
+
+    // finishing a picture that is decoded in the background may release some DPB slots
+
+    if (num_images_in_flight() > 0) {
+      return finish_oldest_image_in_flight();
+    }
+
     return DE265_ERROR_IMAGE_BUFFER_FULL;
   }
 
@@ -1432,6 +1839,11 @@ int decoder_context::generate_unavailable_reference_picture(decoder_context* ctx
 {
   assert(ctx->dpb.has_free_dpb_picture(true));
 
+  // the DPB must not change its size while pictures are decoded in the background
+  if (ctx->dpb.new_image_changes_DPB_size()) {
+    ctx->finish_all_images_in_flight();
+  }
+
   int idx = ctx->dpb.new_image(ctx->current_sps, this, 0,0, false);
   assert(idx>=0);
   //printf("-> fill with unavailable POC %d\n",POC);
@@ -1442,6 +1854,7 @@ int decoder_context::generate_unavailable_reference_picture(decoder_context* ctx
                   1<<(sps->BitDepth_C-1),
                   1<<(sps->BitDepth_C-1));
 
+  img->extend_borders();
   img->fill_pred_mode(MODE_INTRA);
 
   img->PicOrderCntVal = POC;
@@ -1885,6 +2298,7 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 #endif
 
     if (!img->decctx->param_disable_deblocking) {
+      DE265_TRACE_SCOPE(&tracer, "deblock", img->PicOrderCntVal, -1,-1);
       apply_deblocking_filter(img);
     }
 
@@ -1894,9 +2308,12 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 #endif
 
     if (!img->decctx->param_disable_sao) {
+      DE265_TRACE_SCOPE(&tracer, "sao", img->PicOrderCntVal, -1,-1);
       apply_sample_adaptive_offset_sequential(img);
     }
 
+    img->extend_borders();
+
 #if SAVE_INTERMEDIATE_IMAGES
     sprintf(buf,"sao-%05d.yuv", img->PicOrderCntVal);
     write_picture_to_file(img, buf);
@@ -1904,24 +2321,9 @@ void decoder_context::run_postprocessing_filters_sequential(de265_image* img)
 }
 
 
-void decoder_context::run_postprocessing_filters_parallel(image_unit* imgunit)
+void decoder_context::add_postprocessing_filter_tasks(image_unit* imgunit)
 {
-  de265_image* img = imgunit->img;
-
-  int saoWaitsForProgress = CTB_PROGRESS_PREFILTER;
-  bool waitForCompletion = false;
-
-  if (!img->decctx->param_disable_deblocking) {
-    add_deblocking_tasks(imgunit);
-    saoWaitsForProgress = CTB_PROGRESS_DEBLK_H;
-  }
-
-  if (!img->decctx->param_disable_sao) {
-    waitForCompletion |= add_sao_tasks(imgunit, saoWaitsForProgress);
-    //apply_sample_adaptive_offset(img);
-  }
-
-  img->wait_for_completion();
+  add_inloop_filter_tasks(imgunit);
 }
 
 /*
@@ -2012,6 +2414,12 @@ bool decoder_context::process_slice_segment_header(decoder_context* ctx, slice_s
 
     int image_buffer_idx;
     bool isOutputImage = (!sps->sample_adaptive_offset_enabled_flag || ctx->param_disable_sao);
+
+    // the DPB must not change its size while pictures are decoded in the background
+    if (ctx->dpb.new_image_changes_DPB_size()) {
+      ctx->finish_all_images_in_flight();
+    }
+
     image_buffer_idx = ctx->dpb.new_image(sps, this, pts, user_data, isOutputImage);
     if (image_buffer_idx == -1) {
       *err = DE265_ERROR_IMAGE_BUFFER_FULL;
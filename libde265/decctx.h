@@ -32,6 +32,7 @@
 #include "libde265/dpb.h"
 #include "libde265/sei.h"
 #include "libde265/threads.h"
+#include "libde265/trace.h"
 #include "libde265/acceleration.h"
 #include "libde265/nal-parser.h"
 
@@ -113,6 +114,9 @@ public:
   slice_unit* sliceunit;
   thread_task* task; // executing thread_task or NULL if not multi-threaded
 
+  // if set, the parser records the reconstruction of the current CTB here instead of doing it
+  ctb_recon_data* recon;
+
 private:
   thread_context(const thread_context&); // not allowed
   const thread_context& operator=(const thread_context&); // not allowed
@@ -162,6 +166,20 @@ public:
   de265_progress_lock finished_threads;
   int nThreads;
 
+  /* Number of decoding tasks of this slice segment that have not ended yet, plus one
+     while the tasks are still being added. When it drops to zero, all CTBs up to the
+     next slice segment are marked as decoded (they may be missing in faulty streams). */
+  de265_sync_int nPendingTasks;
+
+  void task_finished();    // called by each decoding task of this slice segment at its end
+  void all_tasks_added();  // drops the extra count held while adding the tasks
+
+  /* Split parsing and reconstruction: the parsed CTBs of this slice segment, indexed
+     relative to slice_segment_address. 'parsed_CTBs' counts the CTBs that have been parsed
+     and is set to INT_MAX when the parser has finished. */
+  std::vector<ctb_recon_data> recon_CTBs;
+  de265_progress_lock parsed_CTBs;
+
   int first_decoded_CTB_RS; // TODO
   int last_decoded_CTB_RS;  // TODO
 
@@ -173,6 +191,8 @@ public:
   int num_thread_contexts() const { return nThreadContexts; }
 
 private:
+  void release_pending_task();
+
   thread_context* thread_contexts; /* NOTE: cannot use std::vector, because thread_context has
                                       no copy constructor. */
   int nThreadContexts;
@@ -189,11 +209,11 @@ private:
 class image_unit
 {
 public:
-  image_unit();
+  image_unit(alloc_pool* task_pool);
   ~image_unit();
 
   de265_image* img;
-  de265_image  sao_output; // if SAO is used, this is allocated and used as SAO output buffer
+  std::vector<uint8_t> sao_input_lines[3]; // if SAO is used, the unfiltered lines at the CTB-row boundaries
 
   std::vector<slice_unit*> slice_units;
   std::vector<sei_message> suffix_SEIs;
@@ -258,6 +278,8 @@ public:
   } state;
 
   std::vector<thread_task*> tasks; // we are the owner
+  alloc_pool* task_pool;            // the tasks are allocated from this pool
+  int task_heap_allocations_at_start; // for statistics
 
   /* Saved context models for WPP.
      There is one saved model for the initialization of each CTB row.
@@ -292,6 +314,9 @@ class decoder_context : public base_context {
   de265_error start_thread_pool(int nThreads);
   void        stop_thread_pool();
 
+  // use the worker threads of a pool that is shared with other decoders
+  de265_error attach_thread_pool(thread_pool* pool);
+
   void reset();
 
   /* */ seq_parameter_set* get_sps(int id)       { return &sps[id]; }
@@ -317,6 +342,7 @@ class decoder_context : public base_context {
   de265_error decode_slice_unit_parallel(image_unit* imgunit, slice_unit* sliceunit);
   de265_error decode_slice_unit_WPP(image_unit* imgunit, slice_unit* sliceunit);
   de265_error decode_slice_unit_tiles(image_unit* imgunit, slice_unit* sliceunit);
+  de265_error decode_slice_unit_single_task(image_unit* imgunit, slice_unit* sliceunit);
 
 
   void process_nal_hdr(nal_header*);
@@ -361,6 +387,18 @@ class decoder_context : public base_context {
 
   int get_num_worker_threads() const { return num_worker_threads; }
 
+  /* With worker threads, up to this many pictures are decoded concurrently.
+     0 selects a default that depends on the number of worker threads. */
+  int param_max_frames_in_flight;
+
+  /* With worker threads, slice segments without WPP or tiles are parsed by one task while
+     their CTB rows are reconstructed by other tasks. */
+  bool param_split_parsing;
+
+#ifdef DE265_TRACE
+  trace_recorder tracer; // enabled by DE265_DECODER_PARAM_TRACE
+#endif
+
   /* */ de265_image* get_image(int dpb_index)       { return dpb.get_image(dpb_index); }
   const de265_image* get_image(int dpb_index) const { return dpb.get_image(dpb_index); }
 
@@ -390,9 +428,14 @@ class decoder_context : public base_context {
   pic_parameter_set*   current_pps;
 
  public:
-  thread_pool thread_pool_;
+  thread_pool* thread_pool_; // either own_thread_pool or a shared pool
+
+  alloc_pool task_pool; // recycles the memory of the decoding and filtering tasks
 
  private:
+  thread_pool own_thread_pool;
+  bool uses_shared_thread_pool;
+
   int num_worker_threads;
 
 
@@ -495,16 +538,18 @@ class decoder_context : public base_context {
 
   bool flush_reorder_buffer_at_this_frame;
 
- private:
+ public:
   void init_thread_context(thread_context* tctx);
-  void add_task_decode_CTB_row(thread_context* tctx, bool firstSliceSubstream, int ctbRow);
-  void add_task_decode_slice_segment(thread_context* tctx, bool firstSliceSubstream,
-                                     int ctbX,int ctbY);
-
   void mark_whole_slice_as_processed(image_unit* imgunit,
                                      slice_unit* sliceunit,
                                      int progress);
 
+ private:
+  void add_task_decode_CTB_row(thread_context* tctx, bool firstSliceSubstream, int ctbRow);
+  void add_task_decode_slice_segment(thread_context* tctx, bool firstSliceSubstream,
+                                     int ctbX,int ctbY);
+  void add_task_reconstruct_CTB_row(thread_context* tctx, int ctbRow);
+
   void process_picture_order_count(decoder_context* ctx, slice_segment_header* hdr);
   int generate_unavailable_reference_picture(decoder_context* ctx, const seq_parameter_set* sps,
                                              int POC, bool longTerm);
@@ -514,7 +559,22 @@ class decoder_context : public base_context {
 
   void remove_images_from_dpb(const std::vector<int>& removeImageList);
   void run_postprocessing_filters_sequential(struct de265_image* img);
-  void run_postprocessing_filters_parallel(image_unit* img);
+  void add_postprocessing_filter_tasks(image_unit* img);
+
+
+  // --- frame-parallel decoding ---
+
+  de265_error decode_some_frame_parallel(bool* did_work);
+
+  int  max_images_in_flight() const;
+  int  num_images_in_flight() const;
+  bool image_unit_is_complete(int idx) const;
+
+  de265_error start_image_unit(image_unit*);
+  de265_error finish_image_unit(image_unit*);
+  de265_error finish_oldest_image_in_flight();
+  void finish_all_images_in_flight();
+  void abort_images_in_flight();
 };
 
 
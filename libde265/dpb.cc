@@ -31,13 +31,31 @@ decoded_picture_buffer::decoded_picture_buffer()
 {
   max_images_in_DPB  = DPB_DEFAULT_MAX_IMAGES;
   norm_images_in_DPB = DPB_DEFAULT_MAX_IMAGES;
+
+  dpb.reserve(DPB_DEFAULT_MAX_IMAGES);
+}
+
+
+/* Drop the DPB reference to an image. Output pictures that are still retained by the
+   application are deleted by the last de265_release_picture(). They must not refer to
+   the decoder anymore, since it may be gone by then.
+ */
+static void release_DPB_image(de265_image* img)
+{
+  if (img->is_retained()) {
+    img->decctx = NULL;
+  }
+
+  if (img->remove_reference()) {
+    delete img;
+  }
 }
 
 
 decoded_picture_buffer::~decoded_picture_buffer()
 {
   for (int i=0;i<dpb.size();i++)
-    delete dpb[i];
+    release_DPB_image(dpb[i]);
 }
 
 
@@ -64,7 +82,7 @@ bool decoded_picture_buffer::has_free_dpb_picture(bool high_priority) const
 
   // scan for empty slots
   for (int i=0;i<dpb.size();i++) {
-    if (dpb[i]->PicOutputFlag==false && dpb[i]->PicState == UnusedForReference) {
+    if (dpb[i]->can_be_released()) {
       return true;
     }
   }
@@ -73,6 +91,32 @@ bool decoded_picture_buffer::has_free_dpb_picture(bool high_priority) const
 }
 
 
+bool decoded_picture_buffer::new_image_changes_DPB_size() const
+{
+  // this follows the slot selection in new_image()
+
+  int free_image_buffer_idx = -1;
+  for (int i=0;i<(int)dpb.size();i++) {
+    if (dpb[i]->can_be_released()) {
+      free_image_buffer_idx = i;
+      break;
+    }
+  }
+
+  // a new slot is appended
+  if (free_image_buffer_idx == -1) return true;
+
+  // the last slot is removed
+  if ((int)dpb.size() > norm_images_in_DPB &&
+      free_image_buffer_idx != (int)dpb.size()-1 &&
+      dpb.back()->can_be_released()) {
+    return true;
+  }
+
+  return false;
+}
+
+
 int decoded_picture_buffer::DPB_index_of_picture_with_POC(int poc, int currentID, bool preferLongTerm) const
 {
   logdebug(LogHeaders,"DPB_index_of_picture_with_POC POC=%d\n",poc);
@@ -187,12 +231,20 @@ bool decoded_picture_buffer::flush_reorder_buffer()
 void decoded_picture_buffer::clear()
 {
   for (int i=0;i<dpb.size();i++) {
+    // retained pictures are handed over to the application, the slot gets a new image
+
+    if (dpb[i]->is_retained()) {
+      release_DPB_image(dpb[i]);
+      dpb[i] = new de265_image;
+      continue;
+    }
+
     if (dpb[i]->PicOutputFlag ||
         dpb[i]->PicState != UnusedForReference)
       {
         dpb[i]->PicOutputFlag = false;
         dpb[i]->PicState = UnusedForReference;
-        dpb[i]->release();
+        dpb[i]->recycle();
       }
   }
 
@@ -213,9 +265,11 @@ int decoded_picture_buffer::new_image(const seq_parameter_set* sps,
   int free_image_buffer_idx = -1;
   for (int i=0;i<dpb.size();i++) {
     if (dpb[i]->can_be_released()) {
-      dpb[i]->release(); /* TODO: this is surely not the best place to free the image, but
+      dpb[i]->recycle(); /* TODO: this is surely not the best place to free the image, but
                             we have to do it here because releasing it in de265_release_image()
-                            would break the API compatibility. */
+                            would break the API compatibility.
+                            The image planes are kept and reused by alloc_image() below
+                            if the picture size did not change. */
 
       free_image_buffer_idx = i;
       break;
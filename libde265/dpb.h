@@ -47,6 +47,11 @@ public:
      are included in the check. */
   bool has_free_dpb_picture(bool high_priority) const;
 
+  /* Check whether new_image() would add or remove an image slot. The size of the image
+     array must not change while pictures are decoded in the background, because the
+     worker threads access the reference pictures through it. */
+  bool new_image_changes_DPB_size() const;
+
   /* Remove all pictures from DPB and queues. Decoding should be stopped while calling this. */
   void clear();
 
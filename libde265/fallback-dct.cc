@@ -258,7 +258,7 @@ void rotate_coefficients_fallback(int16_t *coeff, int nT)
 
 
 
-static int8_t mat_8_357[4][4] = {
+const int8_t mat_8_357[4][4] = {
   { 29, 55, 74, 84 },
   { 74, 74,  0,-74 },
   { 84,-29,-74, 55 },
@@ -510,7 +510,7 @@ void transform_idst_4x4_fallback(int32_t *dst, const int16_t *coeffs, int bdShif
 
 
 
-static int8_t mat_dct[32][32] = {
+const int8_t mat_dct[32][32] = {
   { 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,      64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64},
   { 90, 90, 88, 85, 82, 78, 73, 67, 61, 54, 46, 38, 31, 22, 13,  4,      -4,-13,-22,-31,-38,-46,-54,-61,-67,-73,-78,-82,-85,-88,-90,-90},
   { 90, 87, 80, 70, 57, 43, 25,  9, -9,-25,-43,-57,-70,-80,-87,-90,     -90,-87,-80,-70,-57,-43,-25, -9,  9, 25, 43, 57, 70, 80, 87, 90},
@@ -548,9 +548,11 @@ static int8_t mat_dct[32][32] = {
 
 
 
+/* All coefficients outside of the top-left extent x extent square must be zero.
+ */
 template <class pixel_t>
 void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
-                        int nT, const int16_t *coeffs, int bit_depth)
+                        int nT, const int16_t *coeffs, int bit_depth, int extent)
 {
   /*
     The effective shift is
@@ -599,7 +601,9 @@ void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
     }
   */
 
-  for (int c=0;c<nT;c++) {
+  // columns c>=extent of g[] are zero and never read
+
+  for (int c=0;c<extent;c++) {
 
     /*
     logtrace(LogTransform,"DCT-V: ");
@@ -612,7 +616,7 @@ void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
 
     // find last non-zero coefficient to reduce computations carried out in DCT
 
-    int lastCol = nT-1;
+    int lastCol = extent-1;
     for (;lastCol>=0;lastCol--) {
       if (coeffs[c+lastCol*nT]) { break; }
     }
@@ -665,7 +669,7 @@ void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
 
     // find last non-zero coefficient to reduce computations carried out in DCT
 
-    int lastCol = nT-1;
+    int lastCol = extent-1;
     for (;lastCol>=0;lastCol--) {
       if (g[y*nT+lastCol]) { break; }
     }
@@ -864,43 +868,107 @@ void transform_idct_32x32_fallback(int32_t *dst, const int16_t *coeffs,
 
 void transform_4x4_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
 {
-  transform_idct_add<uint8_t>(dst,stride,  4, coeffs, 8);
+  transform_idct_add<uint8_t>(dst,stride,  4, coeffs, 8, 4);
 }
 
 void transform_8x8_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
 {
-  transform_idct_add<uint8_t>(dst,stride,  8, coeffs, 8);
+  transform_idct_add<uint8_t>(dst,stride,  8, coeffs, 8, 8);
 }
 
 void transform_16x16_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
 {
-  transform_idct_add<uint8_t>(dst,stride,  16, coeffs, 8);
+  transform_idct_add<uint8_t>(dst,stride,  16, coeffs, 8, 16);
 }
 
 void transform_32x32_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
 {
-  transform_idct_add<uint8_t>(dst,stride,  32, coeffs, 8);
+  transform_idct_add<uint8_t>(dst,stride,  32, coeffs, 8, 32);
 }
 
 
 void transform_4x4_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
 {
-  transform_idct_add<uint16_t>(dst,stride,  4, coeffs, bit_depth);
+  transform_idct_add<uint16_t>(dst,stride,  4, coeffs, bit_depth, 4);
 }
 
 void transform_8x8_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
 {
-  transform_idct_add<uint16_t>(dst,stride,  8, coeffs, bit_depth);
+  transform_idct_add<uint16_t>(dst,stride,  8, coeffs, bit_depth, 8);
 }
 
 void transform_16x16_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
 {
-  transform_idct_add<uint16_t>(dst,stride,  16, coeffs, bit_depth);
+  transform_idct_add<uint16_t>(dst,stride,  16, coeffs, bit_depth, 16);
 }
 
 void transform_32x32_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth)
 {
-  transform_idct_add<uint16_t>(dst,stride,  32, coeffs, bit_depth);
+  transform_idct_add<uint16_t>(dst,stride,  32, coeffs, bit_depth, 32);
+}
+
+
+template <class pixel_t>
+void transform_idct_add_dc(pixel_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth)
+{
+  int r = idct_dc_residual(dc, bit_depth);
+
+  for (int y=0;y<nT;y++)
+    for (int x=0;x<nT;x++) {
+      dst[y*stride+x] = Clip_BitDepth(dst[y*stride+x] + r, bit_depth);
+    }
+}
+
+void transform_add_dc_8_fallback(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT)
+{
+  transform_idct_add_dc<uint8_t>(dst,stride, dc, nT, 8);
+}
+
+void transform_add_dc_16_fallback(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth)
+{
+  transform_idct_add_dc<uint16_t>(dst,stride, dc, nT, bit_depth);
+}
+
+
+void transform_4x4_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent)
+{
+  transform_idct_add<uint8_t>(dst,stride,  4, coeffs, 8, extent);
+}
+
+void transform_8x8_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent)
+{
+  transform_idct_add<uint8_t>(dst,stride,  8, coeffs, 8, extent);
+}
+
+void transform_16x16_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent)
+{
+  transform_idct_add<uint8_t>(dst,stride,  16, coeffs, 8, extent);
+}
+
+void transform_32x32_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent)
+{
+  transform_idct_add<uint8_t>(dst,stride,  32, coeffs, 8, extent);
+}
+
+
+void transform_4x4_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t>(dst,stride,  4, coeffs, bit_depth, extent);
+}
+
+void transform_8x8_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t>(dst,stride,  8, coeffs, bit_depth, extent);
+}
+
+void transform_16x16_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t>(dst,stride,  16, coeffs, bit_depth, extent);
+}
+
+void transform_32x32_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t>(dst,stride,  32, coeffs, bit_depth, extent);
 }
 
 
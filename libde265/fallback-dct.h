@@ -43,6 +43,12 @@ void transform_8x8_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t
 void transform_16x16_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 void transform_32x32_add_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 
+void transform_add_dc_8_fallback(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT);
+void transform_4x4_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+void transform_8x8_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+void transform_16x16_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+void transform_32x32_add_sparse_8_fallback(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+
 
 void transform_skip_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
 void transform_bypass_16_fallback(uint16_t *dst, const int16_t *coeffs, int nT, ptrdiff_t stride, int bit_depth);
@@ -53,10 +59,33 @@ void transform_8x8_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff
 void transform_16x16_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
 void transform_32x32_add_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
 
+void transform_add_dc_16_fallback(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth);
+void transform_4x4_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth);
+void transform_8x8_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth);
+void transform_16x16_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth);
+void transform_32x32_add_sparse_16_fallback(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent, int bit_depth);
+
 void rotate_coefficients_fallback(int16_t *coeff, int nT);
 
 
 void transform_idst_4x4_fallback(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+// DCT basis functions, row k holds the k-th basis function
+extern const int8_t mat_dct[32][32];
+
+// 4x4 DST basis functions
+extern const int8_t mat_8_357[4][4];
+
+/* Residual of an inverse DCT block where only the DC coefficient is non-zero.
+   All samples get the same value.
+ */
+inline int idct_dc_residual(int16_t dc, int bit_depth)
+{
+  int g = Clip3(-32768,32767, (64*dc + (1<<6))>>7);
+
+  int postShift = 20-bit_depth;
+  return (64*g + (1<<(postShift-1))) >> postShift;
+}
+
 void transform_idct_4x4_fallback(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
 void transform_idct_8x8_fallback(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
 void transform_idct_16x16_fallback(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
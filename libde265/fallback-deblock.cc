@@ -0,0 +1,96 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fallback-deblock.h"
+
+
+template <class pixel_t>
+void deblock_luma_fallback(pixel_t* ptr, ptrdiff_t xstride, ptrdiff_t ystride,
+                           const int beta[2], const int tc[2],
+                           const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  for (int i=0;i<2;i++) {
+    deblock_luma_segment(ptr + 4*i*ystride, xstride, ystride,
+                         beta[i], tc[i], filterP[i], filterQ[i], bit_depth);
+  }
+}
+
+
+template <class pixel_t>
+void deblock_chroma_fallback(pixel_t* ptr, ptrdiff_t xstride, ptrdiff_t ystride,
+                             const int tc[2],
+                             const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  for (int i=0;i<2;i++) {
+    deblock_chroma_segment(ptr + 4*i*ystride, xstride, ystride,
+                           tc[i], filterP[i], filterQ[i], bit_depth);
+  }
+}
+
+
+
+void deblock_luma_v_8_fallback(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                               const bool filterP[2], const bool filterQ[2])
+{
+  deblock_luma_fallback(ptr, 1,stride, beta,tc, filterP,filterQ, 8);
+}
+
+void deblock_luma_h_8_fallback(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                               const bool filterP[2], const bool filterQ[2])
+{
+  deblock_luma_fallback(ptr, stride,1, beta,tc, filterP,filterQ, 8);
+}
+
+void deblock_chroma_v_8_fallback(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                                 const bool filterP[2], const bool filterQ[2])
+{
+  deblock_chroma_fallback(ptr, 1,stride, tc, filterP,filterQ, 8);
+}
+
+void deblock_chroma_h_8_fallback(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                                 const bool filterP[2], const bool filterQ[2])
+{
+  deblock_chroma_fallback(ptr, stride,1, tc, filterP,filterQ, 8);
+}
+
+
+void deblock_luma_v_16_fallback(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                                const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  deblock_luma_fallback(ptr, 1,stride, beta,tc, filterP,filterQ, bit_depth);
+}
+
+void deblock_luma_h_16_fallback(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                                const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  deblock_luma_fallback(ptr, stride,1, beta,tc, filterP,filterQ, bit_depth);
+}
+
+void deblock_chroma_v_16_fallback(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                                  const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  deblock_chroma_fallback(ptr, 1,stride, tc, filterP,filterQ, bit_depth);
+}
+
+void deblock_chroma_h_16_fallback(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                                  const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  deblock_chroma_fallback(ptr, stride,1, tc, filterP,filterQ, bit_depth);
+}
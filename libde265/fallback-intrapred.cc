@@ -0,0 +1,214 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fallback-intrapred.h"
+
+#include <string.h>
+
+
+const int intraPredAngle_table[1+34] =
+  { 0, 0,32,26,21,17,13, 9, 5, 2, 0,-2,-5,-9,-13,-17,-21,-26,
+    -32,-26,-21,-17,-13,-9,-5,-2,0,2,5,9,13,17,21,26,32 };
+
+const int invAngle_table[25-10] =
+  { -4096,-1638,-910,-630,-482,-390,-315,-256,
+    -315,-390,-482,-630,-910,-1638,-4096 };
+
+
+// (8.4.4.2.4)
+template <class pixel_t>
+void intra_pred_planar_fallback(pixel_t* pred, ptrdiff_t stride,
+                                const pixel_t* border, int nT)
+{
+  int Log2_nT = Log2(nT);
+
+  for (int y=0;y<nT;y++)
+    for (int x=0;x<nT;x++)
+      {
+        pred[x+y*stride] = ((nT-1-x)*border[-1-y] + (x+1)*border[ 1+nT] +
+                            (nT-1-y)*border[ 1+x] + (y+1)*border[-1-nT] + nT) >> (Log2_nT+1);
+      }
+}
+
+
+// (8.4.4.2.5)
+template <class pixel_t>
+void intra_pred_dc_fallback(pixel_t* pred, ptrdiff_t stride,
+                            const pixel_t* border, int nT, bool filter_edges)
+{
+  int Log2_nT = Log2(nT);
+
+  int dcVal = 0;
+  for (int i=0;i<nT;i++)
+    {
+      dcVal += border[ i+1];
+      dcVal += border[-i-1];
+    }
+
+  dcVal += nT;
+  dcVal >>= Log2_nT+1;
+
+  if (filter_edges) {
+    pred[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
+
+    for (int x=1;x<nT;x++) { pred[x]        = (border[ x+1] + 3*dcVal+2)>>2; }
+    for (int y=1;y<nT;y++) { pred[y*stride] = (border[-y-1] + 3*dcVal+2)>>2; }
+    for (int y=1;y<nT;y++)
+      for (int x=1;x<nT;x++)
+        {
+          pred[x+y*stride] = dcVal;
+        }
+  } else {
+    for (int y=0;y<nT;y++)
+      for (int x=0;x<nT;x++)
+        {
+          pred[x+y*stride] = dcVal;
+        }
+  }
+}
+
+
+// (8.4.4.2.6)
+template <class pixel_t>
+void intra_pred_angular_fallback(pixel_t* pred, ptrdiff_t stride,
+                                 const pixel_t* border, int nT,
+                                 int intraPredMode, bool boundary_filter, int bit_depth)
+{
+  pixel_t  ref_mem[2*64+1];
+  pixel_t* ref=&ref_mem[64];
+
+  int intraPredAngle = intraPredAngle_table[intraPredMode];
+
+  intra_pred_angular_reference(ref, border, nT, intraPredMode);
+
+  if (intraPredMode >= 18) {
+
+    for (int y=0;y<nT;y++)
+      for (int x=0;x<nT;x++)
+        {
+          int iIdx = ((y+1)*intraPredAngle)>>5;
+          int iFact= ((y+1)*intraPredAngle)&31;
+
+          if (iFact != 0) {
+            pred[x+y*stride] = ((32-iFact)*ref[x+iIdx+1] + iFact*ref[x+iIdx+2] + 16)>>5;
+          } else {
+            pred[x+y*stride] = ref[x+iIdx+1];
+          }
+        }
+
+    if (intraPredMode==26 && boundary_filter) {
+      for (int y=0;y<nT;y++) {
+        pred[0+y*stride] = Clip_BitDepth(border[1] + ((border[-1-y] - border[0])>>1), bit_depth);
+      }
+    }
+  }
+  else { // intraPredAngle < 18
+
+    for (int y=0;y<nT;y++)
+      for (int x=0;x<nT;x++)
+        {
+          int iIdx = ((x+1)*intraPredAngle)>>5;  // DIFF (x<->y)
+          int iFact= ((x+1)*intraPredAngle)&31;  // DIFF (x<->y)
+
+          if (iFact != 0) {
+            pred[x+y*stride] = ((32-iFact)*ref[y+iIdx+1] + iFact*ref[y+iIdx+2] + 16)>>5; // DIFF (x<->y)
+          } else {
+            pred[x+y*stride] = ref[y+iIdx+1]; // DIFF (x<->y)
+          }
+        }
+
+    if (intraPredMode==10 && boundary_filter) {  // DIFF 26->10
+      for (int x=0;x<nT;x++) { // DIFF (x<->y)
+        pred[x] = Clip_BitDepth(border[-1] + ((border[1+x] - border[0])>>1), bit_depth); // DIFF (x<->y && neg)
+      }
+    }
+  }
+}
+
+
+// (8.4.4.2.3), [1 2 1] filtering of the reference samples
+template <class pixel_t>
+void intra_pred_smooth_border_fallback(pixel_t* p, int nT)
+{
+  pixel_t  pF_mem[2*64+1];
+  pixel_t* pF = &pF_mem[64];
+
+  for (int i=-(2*nT-1) ; i<=2*nT-1 ; i++)
+    {
+      pF[i] = (p[i+1] + 2*p[i] + p[i-1] + 2) >> 2;
+    }
+
+  memcpy(p-(2*nT-1), pF-(2*nT-1), (4*nT-1) * sizeof(pixel_t));
+}
+
+
+
+void intra_pred_planar_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                                  const uint8_t* border, int nT)
+{
+  intra_pred_planar_fallback(dst,stride, border,nT);
+}
+
+void intra_pred_dc_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                              const uint8_t* border, int nT, bool filter_edges)
+{
+  intra_pred_dc_fallback(dst,stride, border,nT, filter_edges);
+}
+
+void intra_pred_angular_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                                   const uint8_t* border, int nT,
+                                   int intraPredMode, bool boundary_filter)
+{
+  intra_pred_angular_fallback(dst,stride, border,nT, intraPredMode, boundary_filter, 8);
+}
+
+void intra_pred_smooth_border_8_fallback(uint8_t* border, int nT)
+{
+  intra_pred_smooth_border_fallback(border,nT);
+}
+
+
+void intra_pred_planar_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                                   const uint16_t* border, int nT, int bit_depth)
+{
+  (void)bit_depth;
+  intra_pred_planar_fallback(dst,stride, border,nT);
+}
+
+void intra_pred_dc_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                               const uint16_t* border, int nT, bool filter_edges,
+                               int bit_depth)
+{
+  (void)bit_depth;
+  intra_pred_dc_fallback(dst,stride, border,nT, filter_edges);
+}
+
+void intra_pred_angular_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                                    const uint16_t* border, int nT,
+                                    int intraPredMode, bool boundary_filter, int bit_depth)
+{
+  intra_pred_angular_fallback(dst,stride, border,nT, intraPredMode, boundary_filter, bit_depth);
+}
+
+void intra_pred_smooth_border_16_fallback(uint16_t* border, int nT, int bit_depth)
+{
+  (void)bit_depth;
+  intra_pred_smooth_border_fallback(border,nT);
+}
@@ -0,0 +1,88 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLBACK_INTRAPRED_H
+#define FALLBACK_INTRAPRED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "util.h"
+
+
+extern const int intraPredAngle_table[1+34];
+extern const int invAngle_table[25-10];
+
+
+/* All intra prediction functions get the reference samples in 'border', which points
+   to the top-left sample p[-1][-1]. The top row p[x][-1] is at border[1+x] and the
+   left column p[-1][y] is at border[-1-y], for x,y = 0..2*nT-1.
+ */
+
+void intra_pred_planar_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                                  const uint8_t* border, int nT);
+void intra_pred_dc_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                              const uint8_t* border, int nT, bool filter_edges);
+void intra_pred_angular_8_fallback(uint8_t* dst, ptrdiff_t stride,
+                                   const uint8_t* border, int nT,
+                                   int intraPredMode, bool boundary_filter);
+void intra_pred_smooth_border_8_fallback(uint8_t* border, int nT);
+
+void intra_pred_planar_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                                   const uint16_t* border, int nT, int bit_depth);
+void intra_pred_dc_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                               const uint16_t* border, int nT, bool filter_edges,
+                               int bit_depth);
+void intra_pred_angular_16_fallback(uint16_t* dst, ptrdiff_t stride,
+                                    const uint16_t* border, int nT,
+                                    int intraPredMode, bool boundary_filter, int bit_depth);
+void intra_pred_smooth_border_16_fallback(uint16_t* border, int nT, int bit_depth);
+
+
+/* Build the reference sample array ref[-nT..2*nT] for angular prediction (8.4.4.2.6).
+   For modes below 18, the array is built from the left column, such that the
+   prediction can be computed as for the vertical modes and transposed afterwards.
+ */
+template <class pixel_t>
+inline void intra_pred_angular_reference(pixel_t* ref, const pixel_t* border,
+                                         int nT, int intraPredMode)
+{
+  int intraPredAngle = intraPredAngle_table[intraPredMode];
+  int sign = (intraPredMode >= 18) ? 1 : -1;
+
+  for (int x=0;x<=nT;x++)
+    { ref[x] = border[sign*x]; }
+
+  if (intraPredAngle<0) {
+    int invAngle = invAngle_table[intraPredMode-11];
+
+    if ((nT*intraPredAngle)>>5 < -1) {
+      for (int x=(nT*intraPredAngle)>>5; x<=-1; x++) {
+        ref[x] = border[-sign*((x*invAngle+128)>>8)];
+      }
+    }
+  } else {
+    for (int x=nT+1; x<=2*nT;x++) {
+      ref[x] = border[sign*x];
+    }
+  }
+}
+
+#endif
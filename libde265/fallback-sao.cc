@@ -0,0 +1,108 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fallback-sao.h"
+#include "util.h"
+
+
+const int sao_eo_hPos[4][2] = { { -1,1 }, {  0,0 }, { -1,1 }, {  1,-1 } };
+const int sao_eo_vPos[4][2] = { {  0,0 }, { -1,1 }, { -1,1 }, { -1, 1 } };
+
+
+template <class pixel_t>
+void sao_band_fallback(pixel_t* dst, ptrdiff_t dststride,
+                       const pixel_t* src, ptrdiff_t srcstride,
+                       int width, int height, int bandPosition, const int8_t offsets[4],
+                       int bit_depth)
+{
+  const int bandShift = bit_depth-5;
+  const int maxPixelValue = (1<<bit_depth)-1;
+
+  int bandTable[32];
+  for (int k=0;k<32;k++) {
+    bandTable[k] = 0;
+  }
+
+  for (int k=0;k<4;k++) {
+    bandTable[ (k+bandPosition)&31 ] = offsets[k];
+  }
+
+  for (int y=0;y<height;y++)
+    for (int x=0;x<width;x++) {
+      int in = src[x+y*srcstride];
+      dst[x+y*dststride] = Clip3(0,maxPixelValue, in + bandTable[in>>bandShift]);
+    }
+}
+
+
+template <class pixel_t>
+void sao_edge_fallback(pixel_t* dst, ptrdiff_t dststride,
+                       const pixel_t* src, ptrdiff_t srcstride,
+                       int width, int height, int eoClass, const int8_t offsets[5],
+                       int bit_depth)
+{
+  const int maxPixelValue = (1<<bit_depth)-1;
+
+  const ptrdiff_t pos0 = sao_eo_hPos[eoClass][0] + sao_eo_vPos[eoClass][0]*srcstride;
+  const ptrdiff_t pos1 = sao_eo_hPos[eoClass][1] + sao_eo_vPos[eoClass][1]*srcstride;
+
+  for (int y=0;y<height;y++) {
+    const pixel_t* in_ptr = src + y*srcstride;
+
+    for (int x=0;x<width;x++) {
+      int edgeIdx = ( Sign(in_ptr[x] - in_ptr[x+pos0]) +
+                      Sign(in_ptr[x] - in_ptr[x+pos1]) );
+
+      dst[x+y*dststride] = Clip3(0,maxPixelValue, in_ptr[x] + offsets[edgeIdx+2]);
+    }
+  }
+}
+
+
+
+void sao_band_8_fallback(uint8_t* dst, ptrdiff_t dststride,
+                         const uint8_t* src, ptrdiff_t srcstride,
+                         int width, int height, int bandPosition, const int8_t offsets[4])
+{
+  sao_band_fallback(dst,dststride, src,srcstride, width,height, bandPosition,offsets, 8);
+}
+
+void sao_edge_8_fallback(uint8_t* dst, ptrdiff_t dststride,
+                         const uint8_t* src, ptrdiff_t srcstride,
+                         int width, int height, int eoClass, const int8_t offsets[5])
+{
+  sao_edge_fallback(dst,dststride, src,srcstride, width,height, eoClass,offsets, 8);
+}
+
+void sao_band_16_fallback(uint16_t* dst, ptrdiff_t dststride,
+                          const uint16_t* src, ptrdiff_t srcstride,
+                          int width, int height, int bandPosition, const int8_t offsets[4],
+                          int bit_depth)
+{
+  sao_band_fallback(dst,dststride, src,srcstride, width,height, bandPosition,offsets, bit_depth);
+}
+
+void sao_edge_16_fallback(uint16_t* dst, ptrdiff_t dststride,
+                          const uint16_t* src, ptrdiff_t srcstride,
+                          int width, int height, int eoClass, const int8_t offsets[5],
+                          int bit_depth)
+{
+  sao_edge_fallback(dst,dststride, src,srcstride, width,height, eoClass,offsets, bit_depth);
+}
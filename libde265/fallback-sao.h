@@ -0,0 +1,59 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FALLBACK_SAO_H
+#define FALLBACK_SAO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* SAO of a rectangle of samples, without any boundary checks.
+
+   Band offset: 'offsets' are the offsets of the four bands starting at 'bandPosition'.
+   Edge offset: 'offsets' is indexed with edgeIdx+2 (-2..2, offsets[2] is zero). 'src' must
+   have a border of one sample around the rectangle.
+
+   'dst' may be equal to 'src' for band offsets.
+ */
+
+void sao_band_8_fallback(uint8_t* dst, ptrdiff_t dststride,
+                         const uint8_t* src, ptrdiff_t srcstride,
+                         int width, int height, int bandPosition, const int8_t offsets[4]);
+void sao_edge_8_fallback(uint8_t* dst, ptrdiff_t dststride,
+                         const uint8_t* src, ptrdiff_t srcstride,
+                         int width, int height, int eoClass, const int8_t offsets[5]);
+
+void sao_band_16_fallback(uint16_t* dst, ptrdiff_t dststride,
+                          const uint16_t* src, ptrdiff_t srcstride,
+                          int width, int height, int bandPosition, const int8_t offsets[4],
+                          int bit_depth);
+void sao_edge_16_fallback(uint16_t* dst, ptrdiff_t dststride,
+                          const uint16_t* src, ptrdiff_t srcstride,
+                          int width, int height, int eoClass, const int8_t offsets[5],
+                          int bit_depth);
+
+
+// neighbor positions of the four SaoEoClass directions
+
+extern const int sao_eo_hPos[4][2];
+extern const int sao_eo_vPos[4][2];
+
+#endif
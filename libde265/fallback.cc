@@ -21,6 +21,9 @@
 #include "fallback.h"
 #include "fallback-motion.h"
 #include "fallback-dct.h"
+#include "fallback-intrapred.h"
+#include "fallback-deblock.h"
+#include "fallback-sao.h"
 
 
 void init_acceleration_functions_fallback(struct acceleration_functions* accel)
@@ -93,6 +96,11 @@ void init_acceleration_functions_fallback(struct acceleration_functions* accel)
   accel->transform_add_8[1] = transform_8x8_add_8_fallback;
   accel->transform_add_8[2] = transform_16x16_add_8_fallback;
   accel->transform_add_8[3] = transform_32x32_add_8_fallback;
+  accel->transform_add_dc_8 = transform_add_dc_8_fallback;
+  accel->transform_add_sparse_8[0] = transform_4x4_add_sparse_8_fallback;
+  accel->transform_add_sparse_8[1] = transform_8x8_add_sparse_8_fallback;
+  accel->transform_add_sparse_8[2] = transform_16x16_add_sparse_8_fallback;
+  accel->transform_add_sparse_8[3] = transform_32x32_add_sparse_8_fallback;
 
   accel->transform_skip_16 = transform_skip_16_fallback;
   accel->transform_4x4_dst_add_16 = transform_4x4_luma_add_16_fallback;
@@ -100,6 +108,11 @@ void init_acceleration_functions_fallback(struct acceleration_functions* accel)
   accel->transform_add_16[1] = transform_8x8_add_16_fallback;
   accel->transform_add_16[2] = transform_16x16_add_16_fallback;
   accel->transform_add_16[3] = transform_32x32_add_16_fallback;
+  accel->transform_add_dc_16 = transform_add_dc_16_fallback;
+  accel->transform_add_sparse_16[0] = transform_4x4_add_sparse_16_fallback;
+  accel->transform_add_sparse_16[1] = transform_8x8_add_sparse_16_fallback;
+  accel->transform_add_sparse_16[2] = transform_16x16_add_sparse_16_fallback;
+  accel->transform_add_sparse_16[3] = transform_32x32_add_sparse_16_fallback;
 
   accel->rotate_coefficients = rotate_coefficients_fallback;
   accel->add_residual_8  = add_residual_fallback<uint8_t>;
@@ -114,6 +127,31 @@ void init_acceleration_functions_fallback(struct acceleration_functions* accel)
   accel->transform_idct_16x16 = transform_idct_16x16_fallback;
   accel->transform_idct_32x32 = transform_idct_32x32_fallback;
 
+  accel->intra_pred_planar_8 = intra_pred_planar_8_fallback;
+  accel->intra_pred_dc_8 = intra_pred_dc_8_fallback;
+  accel->intra_pred_angular_8 = intra_pred_angular_8_fallback;
+  accel->intra_pred_smooth_border_8 = intra_pred_smooth_border_8_fallback;
+
+  accel->intra_pred_planar_16 = intra_pred_planar_16_fallback;
+  accel->intra_pred_dc_16 = intra_pred_dc_16_fallback;
+  accel->intra_pred_angular_16 = intra_pred_angular_16_fallback;
+  accel->intra_pred_smooth_border_16 = intra_pred_smooth_border_16_fallback;
+
+  accel->deblock_luma_v_8 = deblock_luma_v_8_fallback;
+  accel->deblock_luma_h_8 = deblock_luma_h_8_fallback;
+  accel->deblock_chroma_v_8 = deblock_chroma_v_8_fallback;
+  accel->deblock_chroma_h_8 = deblock_chroma_h_8_fallback;
+
+  accel->deblock_luma_v_16 = deblock_luma_v_16_fallback;
+  accel->deblock_luma_h_16 = deblock_luma_h_16_fallback;
+  accel->deblock_chroma_v_16 = deblock_chroma_v_16_fallback;
+  accel->deblock_chroma_h_16 = deblock_chroma_h_16_fallback;
+
+  accel->sao_band_8 = sao_band_8_fallback;
+  accel->sao_edge_8 = sao_edge_8_fallback;
+  accel->sao_band_16 = sao_band_16_fallback;
+  accel->sao_edge_16 = sao_edge_16_fallback;
+
   accel->fwd_transform_4x4_dst_8 = fdst_4x4_8_fallback;
   accel->fwd_transform_8[0] = fdct_4x4_8_fallback;
   accel->fwd_transform_8[1] = fdct_8x8_8_fallback;
@@ -27,6 +27,7 @@
 #include <assert.h>
 
 #include <limits>
+#include <algorithm>
 
 
 #ifdef HAVE_MALLOC_H
@@ -109,17 +110,34 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
   const int rawChromaWidth  = spec->width  / img->sps.SubWidthC;
   const int rawChromaHeight = spec->height / img->sps.SubHeightC;
 
-  int luma_stride   = (spec->width    + spec->alignment-1) / spec->alignment * spec->alignment;
-  int chroma_stride = (rawChromaWidth + spec->alignment-1) / spec->alignment * spec->alignment;
+  /* Pictures of the decoder get a border around each plane, which is filled after the
+     in-loop filters. The chroma border is rounded up to keep the rows aligned. */
+
+  int luma_border   = 0;
+  int chroma_border = 0;
+
+  if (ctx != NULL) {
+    luma_border   = LUMA_PICTURE_BORDER;
+    chroma_border = (LUMA_PICTURE_BORDER/img->sps.SubWidthC + spec->alignment-1)
+      / spec->alignment * spec->alignment;
+  }
+
+  int luma_stride   = (spec->width    + 2*luma_border   + spec->alignment-1)
+    / spec->alignment * spec->alignment;
+  int chroma_stride = (rawChromaWidth + 2*chroma_border + spec->alignment-1)
+    / spec->alignment * spec->alignment;
 
   assert(img->sps.BitDepth_Y >= 8 && img->sps.BitDepth_Y <= 16);
   assert(img->sps.BitDepth_C >= 8 && img->sps.BitDepth_C <= 16);
 
-  int luma_bpl   = luma_stride   * ((img->sps.BitDepth_Y+7)/8);
-  int chroma_bpl = chroma_stride * ((img->sps.BitDepth_C+7)/8);
+  int luma_bpp   = (img->sps.BitDepth_Y+7)/8;
+  int chroma_bpp = (img->sps.BitDepth_C+7)/8;
 
-  int luma_height   = spec->height;
-  int chroma_height = rawChromaHeight;
+  int luma_bpl   = luma_stride   * luma_bpp;
+  int chroma_bpl = chroma_stride * chroma_bpp;
+
+  int luma_height   = spec->height    + 2*luma_border;
+  int chroma_height = rawChromaHeight + 2*chroma_border;
 
   bool alloc_failed = false;
 
@@ -137,6 +155,7 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
     p[1] = NULL;
     p[2] = NULL;
     chroma_stride = 0;
+    chroma_border = 0;
   }
 
   if (alloc_failed) {
@@ -148,9 +167,15 @@ static int  de265_image_get_buffer(de265_decoder_context* ctx,
     return 0;
   }
 
-  img->set_image_plane(0, p[0], luma_stride, NULL);
-  img->set_image_plane(1, p[1], chroma_stride, NULL);
-  img->set_image_plane(2, p[2], chroma_stride, NULL);
+  // The plane pointers refer to the first picture sample. The start of the allocated
+  // memory is kept as plane user data for de265_image_release_buffer().
+
+  int luma_offset   = (luma_border   * luma_stride   + luma_border)   * luma_bpp;
+  int chroma_offset = (chroma_border * chroma_stride + chroma_border) * chroma_bpp;
+
+  img->set_image_plane(0, p[0] + luma_offset, luma_stride, p[0], luma_border);
+  img->set_image_plane(1, p[1] ? p[1] + chroma_offset : NULL, chroma_stride, p[1], chroma_border);
+  img->set_image_plane(2, p[2] ? p[2] + chroma_offset : NULL, chroma_stride, p[2], chroma_border);
 
   return 1;
 }
@@ -159,7 +184,7 @@ static void de265_image_release_buffer(de265_decoder_context* ctx,
                                        de265_image* img, void* userdata)
 {
   for (int i=0;i<3;i++) {
-    uint8_t* p = (uint8_t*)img->get_image_plane(i);
+    uint8_t* p = (uint8_t*)img->plane_user_data[i];
     if (p) {
       FREE_ALIGNED(p);
     }
@@ -173,10 +198,12 @@ de265_image_allocation de265_image::default_image_allocation = {
 };
 
 
-void de265_image::set_image_plane(int cIdx, uint8_t* mem, int stride, void *userdata)
+void de265_image::set_image_plane(int cIdx, uint8_t* mem, int stride, void *userdata,
+                                  int border)
 {
   pixels[cIdx] = mem;
   plane_user_data[cIdx] = userdata;
+  this->border[cIdx] = border;
 
   if (cIdx==0) { this->stride        = stride; }
   else         { this->chroma_stride = stride; }
@@ -194,6 +221,9 @@ de265_image::de265_image()
   encctx = NULL;
 
   encoder_image_release_func = NULL;
+  image_allocation_userdata = NULL;
+
+  refcount = 1;
 
   //alloc_functions.get_buffer = NULL;
   //alloc_functions.release_buffer = NULL;
@@ -202,6 +232,7 @@ de265_image::de265_image()
     pixels[c] = NULL;
     pixels_confwin[c] = NULL;
     plane_user_data[c] = NULL;
+    border[c] = 0;
   }
 
   width=height=0;
@@ -210,6 +241,7 @@ de265_image::de265_image()
   user_data = NULL;
 
   ctb_progress = NULL;
+  ctb_row_progress = NULL;
 
   integrity = INTEGRITY_NOT_DECODED;
 
@@ -224,6 +256,8 @@ de265_image::de265_image()
   nThreadsFinished = 0;
   nThreadsTotal    = 0;
 
+  decoding_in_background = false;
+
   de265_mutex_init(&mutex);
   de265_cond_init(&finished_cond);
 }
@@ -241,9 +275,18 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
 
   this->sps = *sps;
 
-  release(); /* TODO: review code for efficient allocation when arrays are already
-                allocated to the requested size. Without the release, the old image-data
-                will not be freed. */
+  /* Image planes from the default allocation functions are kept if they have the right
+     size (see below). Planes from user-provided allocation functions are always given
+     back, because the user may expect a release_buffer() call for each picture.
+     The metadata arrays are only reallocated when their size changes. */
+
+  release_slices();
+
+  if (pixels[0] &&
+      (image_allocation_functions.get_buffer != de265_image_get_buffer ||
+       encoder_image_release_func != NULL)) {
+    release_image_planes();
+  }
 
   ID = s_next_image_ID++;
   removed_at_picture_id = std::numeric_limits<int32_t>::max();
@@ -329,9 +372,10 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
   spec.visible_height= height_confwin;
 
 
-  bpp_shift[0] = (sps->BitDepth_Y > 8) ? 1 : 0;
-  bpp_shift[1] = (sps->BitDepth_C > 8) ? 1 : 0;
-  bpp_shift[2] = bpp_shift[1];
+  uint8_t new_bpp_shift[3];
+  new_bpp_shift[0] = (sps->BitDepth_Y > 8) ? 1 : 0;
+  new_bpp_shift[1] = (sps->BitDepth_C > 8) ? 1 : 0;
+  new_bpp_shift[2] = new_bpp_shift[1];
 
 
   // allocate memory and set conformance window pointers
@@ -340,29 +384,57 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
   if (decctx) alloc_userdata = decctx->param_image_allocation_userdata;
   if (encctx) alloc_userdata = encctx->param_image_allocation_userdata; // actually not needed
 
+  de265_image_allocation alloc_functions;
+  void (*release_func)(en265_encoder_context*, de265_image*, void*) = NULL;
+
   if (encctx && useCustomAllocFunc) {
-    encoder_image_release_func = encctx->release_func;
+    release_func = encctx->release_func;
 
     // if we do not provide a release function, use our own
 
-    if (encoder_image_release_func == NULL) {
-      image_allocation_functions = de265_image::default_image_allocation;
+    if (release_func == NULL) {
+      alloc_functions = de265_image::default_image_allocation;
     }
     else {
-      image_allocation_functions.get_buffer     = NULL;
-      image_allocation_functions.release_buffer = NULL;
+      alloc_functions.get_buffer     = NULL;
+      alloc_functions.release_buffer = NULL;
     }
   }
   else if (decctx && useCustomAllocFunc) {
-    image_allocation_functions = decctx->param_image_allocation_functions;
+    alloc_functions = decctx->param_image_allocation_functions;
   }
   else {
-    image_allocation_functions = de265_image::default_image_allocation;
+    alloc_functions = de265_image::default_image_allocation;
+  }
+
+  bool reuse_planes = (pixels[0] != NULL &&
+                       release_func == NULL &&
+                       can_reuse_image_planes(spec, new_bpp_shift, alloc_functions));
+
+  if (pixels[0] && !reuse_planes) {
+    release_image_planes();
   }
 
+  for (int c=0;c<3;c++) {
+    bpp_shift[c] = new_bpp_shift[c];
+  }
+
+  image_allocation_functions = alloc_functions;
+  image_allocation_userdata  = alloc_userdata;
+  encoder_image_release_func = release_func;
+
   bool mem_alloc_success = true;
 
-  if (image_allocation_functions.get_buffer != NULL) {
+  if (reuse_planes) {
+    pixels_confwin[0] = pixels[0] + left*WinUnitX + top*WinUnitY*stride;
+    pixels_confwin[1] = pixels[1] + left + top*chroma_stride;
+    pixels_confwin[2] = pixels[2] + left + top*chroma_stride;
+  }
+  else if (image_allocation_functions.get_buffer != NULL) {
+    loginfo(LogDPB, "allocating image planes %dx%d\n", w,h);
+
+    buffer_spec = spec;
+
     mem_alloc_success = image_allocation_functions.get_buffer(decctx, &spec, this,
                                                               alloc_userdata);
 
@@ -420,14 +492,17 @@ de265_error de265_image::alloc_image(int w,int h, enum de265_chroma c,
 
     // CTB info
 
-    if (ctb_info.data_size != sps->PicSizeInCtbsY)
+    if (ctb_info.data_size != sps->PicSizeInCtbsY ||
+        ctb_info.height_in_units != sps->PicHeightInCtbsY)
       {
         delete[] ctb_progress;
+        delete[] ctb_row_progress;
 
         mem_alloc_success &= ctb_info.alloc(sps->PicWidthInCtbsY, sps->PicHeightInCtbsY,
                                             sps->Log2CtbSizeY);
 
-        ctb_progress = new de265_progress_lock[ ctb_info.data_size ];
+        ctb_progress     = new de265_progress_lock[ ctb_info.data_size ];
+        ctb_row_progress = new de265_progress_lock[ sps->PicHeightInCtbsY ];
       }
 
 
@@ -453,12 +528,35 @@ de265_image::~de265_image()
     delete[] ctb_progress;
   }
 
+  if (ctb_row_progress) {
+    delete[] ctb_row_progress;
+  }
+
   de265_cond_destroy(&finished_cond);
   de265_mutex_destroy(&mutex);
 }
 
 
 void de265_image::release()
+{
+  release_image_planes();
+  release_slices();
+}
+
+
+void de265_image::recycle()
+{
+  if (pixels[0] &&
+      (image_allocation_functions.get_buffer != de265_image_get_buffer ||
+       encoder_image_release_func != NULL)) {
+    release_image_planes();
+  }
+
+  release_slices();
+}
+
+
+void de265_image::release_image_planes()
 {
   // free image memory
 
@@ -470,20 +568,21 @@ void de265_image::release()
       }
       else {
         image_allocation_functions.release_buffer(decctx, this,
-                                                decctx ?
-                                                  decctx->param_image_allocation_userdata :
-                                                  NULL);
+                                                  image_allocation_userdata);
       }
 
       for (int i=0;i<3;i++)
         {
           pixels[i] = NULL;
           pixels_confwin[i] = NULL;
+          border[i] = 0;
         }
     }
+}
 
-  // free slices
 
+void de265_image::release_slices()
+{
   for (int i=0;i<slices.size();i++) {
     delete slices[i];
   }
@@ -491,6 +590,27 @@ void de265_image::release()
 }
 
 
+bool de265_image::can_reuse_image_planes(const de265_image_spec& spec,
+                                         const uint8_t* new_bpp_shift,
+                                         const de265_image_allocation& alloc_functions) const
+{
+  // only our own buffers are reused, their size depends on the format and bit depth only
+
+  if (image_allocation_functions.get_buffer != de265_image_get_buffer ||
+      alloc_functions.get_buffer != de265_image_get_buffer ||
+      encoder_image_release_func != NULL) {
+    return false;
+  }
+
+  return (buffer_spec.format    == spec.format &&
+          buffer_spec.width     == spec.width &&
+          buffer_spec.height    == spec.height &&
+          buffer_spec.alignment == spec.alignment &&
+          bpp_shift[0] == new_bpp_shift[0] &&
+          bpp_shift[1] == new_bpp_shift[1]);
+}
+
+
 void de265_image::fill_image(int y,int cb,int cr)
 {
   if (y>=0) {
@@ -583,6 +703,7 @@ void de265_image::exchange_pixel_data_with(de265_image& b)
     std::swap(pixels[i], b.pixels[i]);
     std::swap(pixels_confwin[i], b.pixels_confwin[i]);
     std::swap(plane_user_data[i], b.plane_user_data[i]);
+    std::swap(border[i], b.border[i]);
   }
 
   std::swap(stride, b.stride);
@@ -635,6 +756,19 @@ void de265_image::thread_finishes(const thread_task* task)
 {
   //printf("finish thread %s\n", task->name().c_str());
 
+#ifdef DE265_TRACE
+  // record the task before finishing it, the decoder may be released afterwards
+  if (decctx && decctx->tracer.is_enabled()) {
+    const char* name;
+    int ctbX, ctbY;
+    task->get_trace_info(&name, &ctbX, &ctbY);
+    decctx->tracer.add_event(name, PicOrderCntVal, ctbX, ctbY,
+                             task->trace_start_time, trace_recorder::now());
+  }
+#else
+  (void)task;
+#endif
+
   de265_mutex_lock(&mutex);
 
   nThreadsRunning--;
@@ -656,11 +790,23 @@ void de265_image::wait_for_progress(thread_task* task, int ctbx,int ctby, int pr
 }
 
 void de265_image::wait_for_progress(thread_task* task, int ctbAddrRS, int progress)
+{
+  wait_for_progress(task, &ctb_progress[ctbAddrRS], progress);
+}
+
+void de265_image::wait_for_row_progress(thread_task* task, int ctby, int progress)
+{
+  wait_for_progress(task, &ctb_row_progress[ctby], progress);
+}
+
+void de265_image::wait_for_progress(thread_task* task, de265_progress_lock* progresslock,
+                                    int progress)
 {
   if (task==NULL) { return; }
 
-  de265_progress_lock* progresslock = &ctb_progress[ctbAddrRS];
   if (progresslock->get_progress() < progress) {
+    DE265_TRACE_SCOPE(&decctx->tracer, "wait", PicOrderCntVal, -1,-1);
+
     thread_blocks();
 
     assert(task!=NULL);
@@ -687,12 +833,110 @@ void de265_image::wait_for_completion()
   de265_mutex_unlock(&mutex);
 }
 
+bool de265_image::is_completed()
+{
+  de265_mutex_lock(&mutex);
+  bool completed = (nThreadsFinished==nThreadsTotal);
+  de265_mutex_unlock(&mutex);
+
+  return completed;
+}
+
 bool de265_image::debug_is_completed() const
 {
   return nThreadsFinished==nThreadsTotal;
 }
 
 
+template <class pixel_t>
+static void extend_plane_borders(pixel_t* p, int stride, int width, int height,
+                                 int border, int yFirst, int yEnd)
+{
+  for (int y=yFirst;y<yEnd;y++) {
+    pixel_t* row = p + y*stride;
+
+    std::fill(row-border, row, row[0]);
+    std::fill(row+width, row+width+border, row[width-1]);
+  }
+
+  const int rowSize = (width + 2*border) * sizeof(pixel_t);
+
+  if (yFirst==0) {
+    for (int y=1;y<=border;y++) {
+      memcpy(p - y*stride - border, p - border, rowSize);
+    }
+  }
+
+  if (yEnd==height) {
+    const pixel_t* last = p + (height-1)*stride;
+
+    for (int y=0;y<border;y++) {
+      memcpy(p + (height+y)*stride - border, last - border, rowSize);
+    }
+  }
+}
+
+
+void de265_image::extend_borders(int firstCtbRow, int endCtbRow)
+{
+  if (border[0]==0) { return; }
+
+  const int log2CtbSize = sps.Log2CtbSizeY;
+
+  for (int c=0;c<3;c++) {
+    if (pixels[c]==NULL) { continue; }
+
+    const int subHeight = (c==0 ? 1 : sps.SubHeightC);
+    const int h = get_height(c);
+
+    int yFirst = (firstCtbRow << log2CtbSize) / subHeight;
+    int yEnd   = libde265_min(h, (endCtbRow << log2CtbSize) / subHeight);
+
+    if (bpp_shift[c]) {
+      extend_plane_borders((uint16_t*)pixels[c], get_image_stride(c), get_width(c), h,
+                           border[c], yFirst, yEnd);
+    }
+    else {
+      extend_plane_borders(pixels[c], get_image_stride(c), get_width(c), h,
+                           border[c], yFirst, yEnd);
+    }
+  }
+}
+
+
+void de265_image::mark_all_CTBs_final()
+{
+  for (int y=0;y<sps.PicHeightInCtbsY;y++) {
+    if (ctb_row_progress[y].get_progress() < CTB_PROGRESS_SAO) {
+      extend_borders(y,y+1);
+    }
+  }
+
+  mark_all_CTB_progress(CTB_PROGRESS_SAO);
+}
+
+
+void de265_image::wait_for_lines(int yFirst, int yLast, int progress) const
+{
+  if (!is_decoding_in_background()) { return; }
+
+  // Lines outside of the picture (clipped or taken from the border) are copies of the
+  // outermost lines.
+
+  yFirst = Clip3(0, height-1, yFirst);
+  yLast  = Clip3(0, height-1, yLast);
+  if (yLast < yFirst)   return;
+
+  for (int ctbY = yFirst >> sps.Log2CtbSizeY; ctbY <= (yLast >> sps.Log2CtbSizeY); ctbY++) {
+    if (ctb_row_progress[ctbY].get_progress() < progress) {
+      DE265_TRACE_SCOPE(&decctx->tracer, "wait-for-reference", PicOrderCntVal, -1,ctbY);
+
+      ctb_row_progress[ctbY].wait_for_progress(progress);
+    }
+  }
+}
+
+
 
 void de265_image::clear_metadata()
 {
@@ -709,6 +953,10 @@ void de265_image::clear_metadata()
   for (int i=0;i<ctb_info.data_size;i++) {
     ctb_progress[i].reset(CTB_PROGRESS_NONE);
   }
+
+  for (int y=0;y<ctb_info.height_in_units;y++) {
+    ctb_row_progress[y].reset(CTB_PROGRESS_NONE);
+  }
 }
 
 
@@ -749,8 +997,8 @@ bool de265_image::available_zscan(int xCurr,int yCurr, int xN,int yN) const
   int xNCtb = xN >> sps.Log2CtbSizeY;
   int yNCtb = yN >> sps.Log2CtbSizeY;
 
-  if (get_SliceAddrRS(xCurrCtb,yCurrCtb) !=
-      get_SliceAddrRS(xNCtb,   yNCtb)) {
+  if (!is_in_same_slice_as_previous_CTB(xCurrCtb + yCurrCtb*sps.PicWidthInCtbsY,
+                                        xNCtb    + yNCtb   *sps.PicWidthInCtbsY)) {
     return false;
   }
 
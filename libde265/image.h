@@ -76,7 +76,13 @@ enum PictureState {
 #define CTB_PROGRESS_PREFILTER 1
 #define CTB_PROGRESS_DEBLK_V   2
 #define CTB_PROGRESS_DEBLK_H   3
-#define CTB_PROGRESS_SAO       4
+#define CTB_PROGRESS_SAO_INPUT 4  // CTB-row has been copied into the SAO input buffer
+#define CTB_PROGRESS_SAO       5  // CTB is completely reconstructed (all in-loop filters applied)
+
+/* Width of the border around the luma plane of decoded pictures. It covers the largest
+   prediction block plus the interpolation filter margin, such that motion compensation
+   can read outside of the reference picture without clipping the coordinates. */
+#define LUMA_PICTURE_BORDER 80
 
 class decoder_context;
 
@@ -241,6 +247,11 @@ struct de265_image {
 
   void release();
 
+  /* Releases the per-picture data, but keeps the image planes (if they were allocated
+     with the default allocation functions) and the metadata arrays. A following
+     alloc_image() with the same geometry reuses them without reallocation. */
+  void recycle();
+
   void fill_image(int y,int u,int v);
   de265_error copy_image(const de265_image* src);
   void copy_lines_from(const de265_image* src, int first, int end);
@@ -252,7 +263,7 @@ struct de265_image {
   /* */ uint8_t* get_image_plane(int cIdx)       { return pixels[cIdx]; }
   const uint8_t* get_image_plane(int cIdx) const { return pixels[cIdx]; }
 
-  void set_image_plane(int cIdx, uint8_t* mem, int stride, void *userdata);
+  void set_image_plane(int cIdx, uint8_t* mem, int stride, void *userdata, int border=0);
 
   uint8_t* get_image_plane_at_pos(int cIdx, int xpos,int ypos)
   {
@@ -298,6 +309,15 @@ struct de265_image {
   int get_luma_stride() const { return stride; }
   int get_chroma_stride() const { return chroma_stride; }
 
+  /* Number of samples that are allocated on each side of the plane in addition to the
+     picture area. It is 0 for planes from user-provided allocation functions. */
+  int get_image_border(int cIdx) const { return border[cIdx]; }
+
+  /* Replicates the outermost samples of the CTB-rows [firstCtbRow;endCtbRow) into the
+     border. The first and last CTB-row also fill the top and bottom border. */
+  void extend_borders(int firstCtbRow, int endCtbRow);
+  void extend_borders() { extend_borders(0, sps.PicHeightInCtbsY); }
+
   int get_width (int cIdx=0) const { return cIdx==0 ? width  : chroma_width;  }
   int get_height(int cIdx=0) const { return cIdx==0 ? height : chroma_height; }
 
@@ -316,7 +336,17 @@ struct de265_image {
     return get_bit_depth(cIdx)>8;
   }
 
-  bool can_be_released() const { return PicOutputFlag==false && PicState==UnusedForReference; }
+  bool can_be_released() const {
+    return PicOutputFlag==false && PicState==UnusedForReference && !is_retained();
+  }
+
+  /* The DPB holds one reference to each of its images. Output pictures that the
+     application retains hold further references and keep the DPB slot occupied.
+     remove_reference() returns true when the last reference is gone and the image
+     has to be deleted. Both may be called from any thread. */
+  void add_reference() { de265_sync_add_and_fetch(&refcount, 1); }
+  bool remove_reference() { return de265_sync_sub_and_fetch(&refcount, 1)==0; }
+  bool is_retained() const { return refcount > 1; }
 
 
   void add_slice_segment_header(slice_segment_header* shdr) {
@@ -352,6 +382,17 @@ private:
 
   int chroma_width, chroma_height;
   int stride, chroma_stride;
+  int border[3];
+
+  de265_sync_int refcount;
+
+  de265_image_spec buffer_spec; // geometry of the allocated image planes
+
+  void release_image_planes();
+  void release_slices();
+  bool can_reuse_image_planes(const de265_image_spec& spec,
+                              const uint8_t* new_bpp_shift,
+                              const de265_image_allocation& alloc_functions) const;
 
 public:
   std::vector<slice_segment_header*> slices;
@@ -400,6 +441,7 @@ public:
   void*     user_data;
   void*     plane_user_data[3];  // this is logically attached to the pixel data pointers
   de265_image_allocation image_allocation_functions; // the functions used for memory allocation
+  void* image_allocation_userdata; // passed to image_allocation_functions.release_buffer()
   void (*encoder_image_release_func)(en265_encoder_context*,
                                      de265_image*,
                                      void* userdata);
@@ -414,14 +456,27 @@ public:
 
   // --- multi core ---
 
-  de265_progress_lock* ctb_progress; // ctb_info_size
+  /* Decoding progress is tracked per CTB, because CTBs are decoded individually.
+     The in-loop filters process whole CTB-rows. Their progress (CTB_PROGRESS_DEBLK_V
+     and above) is only tracked in 'ctb_row_progress'. */
+  de265_progress_lock* ctb_progress;     // ctb_info_size
+  de265_progress_lock* ctb_row_progress; // PicHeightInCtbsY
 
   void mark_all_CTB_progress(int progress) {
     for (int i=0;i<ctb_info.data_size;i++) {
       ctb_progress[i].set_progress(progress);
     }
+
+    for (int y=0;y<ctb_info.height_in_units;y++) {
+      ctb_row_progress[y].set_progress(progress);
+    }
   }
 
+  /* Marks all CTBs as completely reconstructed. The borders of CTB-rows that did not
+     reach this state through the in-loop filters (disabled filters, broken streams) are
+     filled first, because motion compensation relies on them from then on. */
+  void mark_all_CTBs_final();
+
 
   void thread_start(int nThreads);
   void thread_run(const thread_task*);
@@ -434,11 +489,28 @@ public:
 
   void wait_for_progress(thread_task* task, int ctbx,int ctby, int progress);
   void wait_for_progress(thread_task* task, int ctbAddrRS, int progress);
+  void wait_for_row_progress(thread_task* task, int ctby, int progress);
+  void wait_for_progress(thread_task* task, de265_progress_lock*, int progress);
 
   void wait_for_completion();  // block until image is decoded by background threads
+  bool is_completed();         // true if all tasks of the image have finished
   bool debug_is_completed() const;
+
+  /* Frame-parallel decoding: while 'decoding_in_background' is set, the image is still
+     being reconstructed by the worker threads. Pictures that use it as a reference
+     have to wait until the CTB rows they access have reached the given progress.
+     wait_for_lines() returns immediately for images that are not decoded in the background.
+     The flag is cleared only after the image is final, and it is read by the worker threads,
+     hence it is accessed with release/acquire semantics. */
+  void set_decoding_in_background(bool flag) { de265_sync_store_release(&decoding_in_background, flag); }
+  bool is_decoding_in_background() const { return de265_sync_load_acquire(&decoding_in_background); }
+  void wait_for_lines(int yFirst, int yLast, int progress) const;
   int  num_threads_active() const { return nThreadsRunning + nThreadsBlocked; } // for debug only
 
+private:
+  de265_sync_int decoding_in_background;
+
+public:
   //private:
   int   nThreadsQueued;
   int   nThreadsRunning;
@@ -699,6 +771,16 @@ public:
     return ctb_info[ctbRS].SliceAddrRS;
   }
 
+  /* Whether CTB 'ctbRS_N', which precedes CTB 'ctbRS' in decoding order, belongs to the
+     same slice. Only the slice address of the current CTB is read. Hence, this is also
+     correct while the slice containing the neighbor is still being decoded by another thread.
+   */
+  bool is_in_same_slice_as_previous_CTB(int ctbRS, int ctbRS_N) const
+  {
+    int sliceStartTS = pps.CtbAddrRStoTS[ ctb_info[ctbRS].SliceAddrRS ];
+    return pps.CtbAddrRStoTS[ctbRS_N] >= sliceStartTS;
+  }
+
 
   void set_SliceHeaderIndex(int x, int y, int SliceHeaderIndex)
   {
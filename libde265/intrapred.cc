@@ -21,6 +21,9 @@
 #include "intrapred.h"
 #include "transform.h"
 #include "util.h"
+#include "fallback.h"
+#include "fallback-intrapred.h"
+#include "encoder/encoder-context.h"
 #include <assert.h>
 
 
@@ -326,11 +329,18 @@ void fill_border_samples(de265_image* img,
   int xRightCtb = (xBLuma+nT*SubWidth) >> log2CtbSize;
   int yTopCtb   = (yBLuma-1) >> log2CtbSize;
 
-  int currCTBSlice = img->get_SliceAddrRS(xCurrCtb,yCurrCtb);
-  int leftCTBSlice = availableLeft ? img->get_SliceAddrRS(xLeftCtb, yCurrCtb) : -1;
-  int topCTBSlice  = availableTop ? img->get_SliceAddrRS(xCurrCtb, yTopCtb) : -1;
-  int toprightCTBSlice = availableTopRight ? img->get_SliceAddrRS(xRightCtb, yTopCtb) : -1;
-  int topleftCTBSlice  = availableTopLeft  ? img->get_SliceAddrRS(xLeftCtb, yTopCtb) : -1;
+  // The neighbors precede the current CTB in decoding order (or lie in another tile), so
+  // the slice test does not have to read metadata of CTBs that might still be in flight.
+
+  int currCTB = xCurrCtb+yCurrCtb*picWidthInCtbs;
+  bool leftCTBInSlice = availableLeft &&
+    img->is_in_same_slice_as_previous_CTB(currCTB, xLeftCtb+yCurrCtb*picWidthInCtbs);
+  bool topCTBInSlice  = availableTop &&
+    img->is_in_same_slice_as_previous_CTB(currCTB, xCurrCtb+yTopCtb*picWidthInCtbs);
+  bool toprightCTBInSlice = availableTopRight &&
+    img->is_in_same_slice_as_previous_CTB(currCTB, xRightCtb+yTopCtb*picWidthInCtbs);
+  bool topleftCTBInSlice  = availableTopLeft &&
+    img->is_in_same_slice_as_previous_CTB(currCTB, xLeftCtb+yTopCtb*picWidthInCtbs);
 
   /*
   printf("size: %d\n",pps->TileIdRS.size());
@@ -345,10 +355,10 @@ void fill_border_samples(de265_image* img,
   int topleftCTBTileID = availableTopLeft ? pps->TileIdRS[xLeftCtb+yTopCtb*picWidthInCtbs] : -1;
   int toprightCTBTileID= availableTopRight? pps->TileIdRS[xRightCtb+yTopCtb*picWidthInCtbs] : -1;
 
-  if (leftCTBSlice != currCTBSlice  || leftCTBTileID != currCTBTileID ) availableLeft    = false;
-  if (topCTBSlice  != currCTBSlice  || topCTBTileID  != currCTBTileID ) availableTop     = false;
-  if (topleftCTBSlice !=currCTBSlice||topleftCTBTileID!=currCTBTileID ) availableTopLeft = false;
-  if (toprightCTBSlice!=currCTBSlice||toprightCTBTileID!=currCTBTileID) availableTopRight= false;
+  if (!leftCTBInSlice     || leftCTBTileID != currCTBTileID ) availableLeft    = false;
+  if (!topCTBInSlice      || topCTBTileID  != currCTBTileID ) availableTop     = false;
+  if (!topleftCTBInSlice  ||topleftCTBTileID!=currCTBTileID ) availableTopLeft = false;
+  if (!toprightCTBInSlice ||toprightCTBTileID!=currCTBTileID) availableTopRight= false;
 
   int currBlockAddr = pps->MinTbAddrZS[ (xBLuma>>sps->Log2MinTrafoSize) +
                                         (yBLuma>>sps->Log2MinTrafoSize) * sps->PicWidthInTbsY ];
@@ -498,7 +508,8 @@ void fill_border_samples(de265_image* img,
 
 // (8.4.4.2.3)
 template <class pixel_t>
-void intra_prediction_sample_filtering(de265_image* img,
+void intra_prediction_sample_filtering(const acceleration_functions& accel,
+                                       de265_image* img,
                                        pixel_t* p,
                                        int nT, int cIdx,
                                        enum IntraPredMode intraPredMode)
@@ -528,10 +539,10 @@ void intra_prediction_sample_filtering(de265_image* img,
                      abs_value(p[0]+p[-64]-2*p[-32]) < (1<<(img->sps.bit_depth_luma-5)))
       ? 1 : 0;
 
-    pixel_t  pF_mem[2*64+1];
-    pixel_t* pF = &pF_mem[64];
-
     if (biIntFlag) {
+      pixel_t  pF_mem[2*64+1];
+      pixel_t* pF = &pF_mem[64];
+
       pF[-2*nT] = p[-2*nT];
       pF[ 2*nT] = p[ 2*nT];
       pF[    0] = p[    0];
@@ -540,20 +551,13 @@ void intra_prediction_sample_filtering(de265_image* img,
         pF[-i] = p[0] + ((i*(p[-64]-p[0])+32)>>6);
         pF[ i] = p[0] + ((i*(p[ 64]-p[0])+32)>>6);
       }
-    } else {
-      pF[-2*nT] = p[-2*nT];
-      pF[ 2*nT] = p[ 2*nT];
-
-      for (int i=-(2*nT-1) ; i<=2*nT-1 ; i++)
-        {
-          pF[i] = (p[i+1] + 2*p[i] + p[i-1] + 2) >> 2;
-        }
-    }
 
+      // copy back to original array
 
-    // copy back to original array
-
-    memcpy(p-2*nT, pF-2*nT, (4*nT+1) * sizeof(pixel_t));
+      memcpy(p-2*nT, pF-2*nT, (4*nT+1) * sizeof(pixel_t));
+    } else {
+      accel.intra_pred_smooth_border(p, nT, img->get_bit_depth(cIdx));
+    }
   }
   else {
     // do nothing ?
@@ -566,134 +570,56 @@ void intra_prediction_sample_filtering(de265_image* img,
 }
 
 
-const int intraPredAngle_table[1+34] =
-  { 0, 0,32,26,21,17,13, 9, 5, 2, 0,-2,-5,-9,-13,-17,-21,-26,
-    -32,-26,-21,-17,-13,-9,-5,-2,0,2,5,9,13,17,21,26,32 };
+template <class pixel_t>
+void print_prediction(const pixel_t* pred, int stride, int nT)
+{
+  (void)pred; (void)stride; // only used with DE265_LOG_TRACE
 
-static const int invAngle_table[25-10] =
-  { -4096,-1638,-910,-630,-482,-390,-315,-256,
-    -315,-390,-482,-630,-910,-1638,-4096 };
+  for (int y=0;y<nT;y++)
+    {
+      for (int x=0;x<nT;x++)
+        logtrace(LogIntraPred,"%02x ", pred[x+y*stride]);
+
+      logtrace(LogIntraPred,"\n");
+    }
+}
 
 
 // (8.4.4.2.6)
 template <class pixel_t>
-void intra_prediction_angular(de265_image* img,
+void intra_prediction_angular(const acceleration_functions& accel,
+                              de265_image* img,
                               int xB0,int yB0,
                               enum IntraPredMode intraPredMode,
                               int nT,int cIdx,
                               pixel_t* border)
 {
-  pixel_t  ref_mem[2*64+1];
-  pixel_t* ref=&ref_mem[64];
-
   pixel_t* pred;
   int      stride;
   pred   = img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,xB0,yB0);
   stride = img->get_image_stride(cIdx);
 
-  int bit_depth = img->get_bit_depth(cIdx);
-
   assert(intraPredMode<35);
   assert(intraPredMode>=2);
 
-  int intraPredAngle = intraPredAngle_table[intraPredMode];
-
   bool disableIntraBoundaryFilter =
     (img->sps.range_extension.implicit_rdpcm_enabled_flag &&
      img->get_cu_transquant_bypass(xB0,yB0));
 
-  if (intraPredMode >= 18) {
+  bool boundaryFilter = (cIdx==0 && nT<32 && !disableIntraBoundaryFilter);
 
-    for (int x=0;x<=nT;x++)
-      { ref[x] = border[x]; }
-
-    if (intraPredAngle<0) {
-      int invAngle = invAngle_table[intraPredMode-11];
-
-      if ((nT*intraPredAngle)>>5 < -1) {
-        for (int x=(nT*intraPredAngle)>>5; x<=-1; x++) {
-          ref[x] = border[0-((x*invAngle+128)>>8)];
-        }
-      }
-    } else {
-      for (int x=nT+1; x<=2*nT;x++) {
-        ref[x] = border[x];
-      }
-    }
-
-    for (int y=0;y<nT;y++)
-      for (int x=0;x<nT;x++)
-        {
-          int iIdx = ((y+1)*intraPredAngle)>>5;
-          int iFact= ((y+1)*intraPredAngle)&31;
-
-          if (iFact != 0) {
-            pred[x+y*stride] = ((32-iFact)*ref[x+iIdx+1] + iFact*ref[x+iIdx+2] + 16)>>5;
-          } else {
-            pred[x+y*stride] = ref[x+iIdx+1];
-          }
-        }
-
-    if (intraPredMode==26 && cIdx==0 && nT<32 && !disableIntraBoundaryFilter) {
-      for (int y=0;y<nT;y++) {
-        pred[0+y*stride] = Clip_BitDepth(border[1] + ((border[-1-y] - border[0])>>1), bit_depth);
-      }
-    }
-  }
-  else { // intraPredAngle < 18
-
-    for (int x=0;x<=nT;x++)
-      { ref[x] = border[-x]; }  // DIFF (neg)
-
-    if (intraPredAngle<0) {
-      int invAngle = invAngle_table[intraPredMode-11];
-
-      if ((nT*intraPredAngle)>>5 < -1) {
-        for (int x=(nT*intraPredAngle)>>5; x<=-1; x++) {
-          ref[x] = border[((x*invAngle+128)>>8)]; // DIFF (neg)
-        }
-      }
-    } else {
-      for (int x=nT+1; x<=2*nT;x++) {
-        ref[x] = border[-x]; // DIFF (neg)
-      }
-    }
-
-    for (int y=0;y<nT;y++)
-      for (int x=0;x<nT;x++)
-        {
-          int iIdx = ((x+1)*intraPredAngle)>>5;  // DIFF (x<->y)
-          int iFact= ((x+1)*intraPredAngle)&31;  // DIFF (x<->y)
-
-          if (iFact != 0) {
-            pred[x+y*stride] = ((32-iFact)*ref[y+iIdx+1] + iFact*ref[y+iIdx+2] + 16)>>5; // DIFF (x<->y)
-          } else {
-            pred[x+y*stride] = ref[y+iIdx+1]; // DIFF (x<->y)
-          }
-        }
-
-    if (intraPredMode==10 && cIdx==0 && nT<32 && !disableIntraBoundaryFilter) {  // DIFF 26->10
-      for (int x=0;x<nT;x++) { // DIFF (x<->y)
-        pred[x] = Clip_BitDepth(border[-1] + ((border[1+x] - border[0])>>1), bit_depth); // DIFF (x<->y && neg)
-      }
-    }
-  }
+  accel.intra_pred_angular(pred,stride, border,nT, intraPredMode, boundaryFilter,
+                           img->get_bit_depth(cIdx));
 
 
   logtrace(LogIntraPred,"result of angular intra prediction (mode=%d):\n",intraPredMode);
-
-  for (int y=0;y<nT;y++)
-    {
-      for (int x=0;x<nT;x++)
-        logtrace(LogIntraPred,"%02x ", pred[x+y*stride]);
-
-      logtrace(LogIntraPred,"\n");
-    }
+  print_prediction(pred,stride,nT);
 }
 
 
 template <class pixel_t>
-void intra_prediction_planar(de265_image* img,int xB0,int yB0,int nT,int cIdx,
+void intra_prediction_planar(const acceleration_functions& accel,
+                             de265_image* img,int xB0,int yB0,int nT,int cIdx,
                              pixel_t* border)
 {
   pixel_t* pred;
@@ -701,30 +627,17 @@ void intra_prediction_planar(de265_image* img,int xB0,int yB0,int nT,int cIdx,
   pred   = img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,xB0,yB0);
   stride = img->get_image_stride(cIdx);
 
-  int Log2_nT = Log2(nT);
-
-  for (int y=0;y<nT;y++)
-    for (int x=0;x<nT;x++)
-      {
-        pred[x+y*stride] = ((nT-1-x)*border[-1-y] + (x+1)*border[ 1+nT] +
-                            (nT-1-y)*border[ 1+x] + (y+1)*border[-1-nT] + nT) >> (Log2_nT+1);
-      }
+  accel.intra_pred_planar(pred,stride, border,nT, img->get_bit_depth(cIdx));
 
 
   logtrace(LogIntraPred,"result of planar prediction\n");
-
-  for (int y=0;y<nT;y++)
-    {
-      for (int x=0;x<nT;x++)
-        logtrace(LogIntraPred,"%02x ", pred[x+y*stride]);
-
-      logtrace(LogIntraPred,"\n");
-    }
+  print_prediction(pred,stride,nT);
 }
 
 
 template <class pixel_t>
-void intra_prediction_DC(de265_image* img,int xB0,int yB0,int nT,int cIdx,
+void intra_prediction_DC(const acceleration_functions& accel,
+                         de265_image* img,int xB0,int yB0,int nT,int cIdx,
                          pixel_t* border)
 {
   pixel_t* pred;
@@ -732,51 +645,35 @@ void intra_prediction_DC(de265_image* img,int xB0,int yB0,int nT,int cIdx,
   pred   = img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,xB0,yB0);
   stride = img->get_image_stride(cIdx);
 
-  int Log2_nT = Log2(nT);
+  accel.intra_pred_dc(pred,stride, border,nT, cIdx==0 && nT<32, img->get_bit_depth(cIdx));
 
-  int dcVal = 0;
-  for (int i=0;i<nT;i++)
-    {
-      dcVal += border[ i+1];
-      dcVal += border[-i-1];
-    }
 
-  dcVal += nT;
-  dcVal >>= Log2_nT+1;
+  logtrace(LogIntraPred,"INTRAPRED DC\n");
+  print_prediction(pred,stride,nT);
+}
 
-  if (cIdx==0 && nT<32) {
-    pred[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
 
-    for (int x=1;x<nT;x++) { pred[x]        = (border[ x+1] + 3*dcVal+2)>>2; }
-    for (int y=1;y<nT;y++) { pred[y*stride] = (border[-y-1] + 3*dcVal+2)>>2; }
-    for (int y=1;y<nT;y++)
-      for (int x=1;x<nT;x++)
-        {
-          pred[x+y*stride] = dcVal;
-        }
-  } else {
-    for (int y=0;y<nT;y++)
-      for (int x=0;x<nT;x++)
-        {
-          pred[x+y*stride] = dcVal;
-        }
-  }
 
+/* The decoder and the encoder each have their own set of acceleration functions.
+   Images without a context (e.g. temporary images in the encoder) use the fallback functions.
+ */
+static const acceleration_functions& get_acceleration_functions(const de265_image* img)
+{
+  if (img->decctx) { return img->decctx->acceleration; }
+  if (img->encctx) { return img->encctx->acceleration; }
 
-  logtrace(LogIntraPred,"INTRAPRED DC\n");
-  for (int y=0;y<nT;y++)
-    {
-      for (int x=0;x<nT;x++)
-        logtrace(LogIntraPred,"%02x ", pred[x+y*stride]);
+  static struct fallback_functions {
+    acceleration_functions accel;
+    fallback_functions() { init_acceleration_functions_fallback(&accel); }
+  } fallback;
 
-      logtrace(LogIntraPred,"\n");
-    }
+  return fallback.accel;
 }
 
 
-
 template <class pixel_t>
-void decode_intra_prediction_internal(de265_image* img,
+void decode_intra_prediction_internal(const acceleration_functions& accel,
+                                      de265_image* img,
                                       int xB0,int yB0,
                                       enum IntraPredMode intraPredMode,
                                       int nT, int cIdx)
@@ -789,19 +686,19 @@ void decode_intra_prediction_internal(de265_image* img,
   if (img->sps.range_extension.intra_smoothing_disabled_flag == 0 &&
       (cIdx==0 || img->sps.ChromaArrayType==CHROMA_444))
     {
-      intra_prediction_sample_filtering(img, border_pixels, nT, cIdx, intraPredMode);
+      intra_prediction_sample_filtering(accel, img, border_pixels, nT, cIdx, intraPredMode);
     }
 
 
   switch (intraPredMode) {
   case INTRA_PLANAR:
-    intra_prediction_planar(img,xB0,yB0,nT,cIdx, border_pixels);
+    intra_prediction_planar(accel, img,xB0,yB0,nT,cIdx, border_pixels);
     break;
   case INTRA_DC:
-    intra_prediction_DC(img,xB0,yB0,nT,cIdx, border_pixels);
+    intra_prediction_DC(accel, img,xB0,yB0,nT,cIdx, border_pixels);
     break;
   default:
-    intra_prediction_angular(img,xB0,yB0,intraPredMode,nT,cIdx, border_pixels);
+    intra_prediction_angular(accel, img,xB0,yB0,intraPredMode,nT,cIdx, border_pixels);
     break;
   }
 }
@@ -820,10 +717,12 @@ void decode_intra_prediction(de265_image* img,
     xB0,yB0, intraPredMode, nT,cIdx);
   */
 
+  const acceleration_functions& accel = get_acceleration_functions(img);
+
   if (img->high_bit_depth(cIdx)) {
-    decode_intra_prediction_internal<uint16_t>(img,xB0,yB0, intraPredMode,nT,cIdx);
+    decode_intra_prediction_internal<uint16_t>(accel, img,xB0,yB0, intraPredMode,nT,cIdx);
   }
   else {
-    decode_intra_prediction_internal<uint8_t>(img,xB0,yB0, intraPredMode,nT,cIdx);
+    decode_intra_prediction_internal<uint8_t>(accel, img,xB0,yB0, intraPredMode,nT,cIdx);
   }
 }
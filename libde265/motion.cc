@@ -49,7 +49,7 @@ void mc_luma(const base_context* ctx,
              const seq_parameter_set* sps, int mv_x, int mv_y,
              int xP,int yP,
              int16_t* out, int out_stride,
-             const pixel_t* ref, int ref_stride,
+             const pixel_t* ref, int ref_stride, int ref_border,
              int nPbW, int nPbH, int bitDepth_L)
 {
   int xFracL = mv_x & 3;
@@ -71,8 +71,8 @@ void mc_luma(const base_context* ctx,
 
   if (xFracL==0 && yFracL==0) {
 
-    if (xIntOffsL >= 0 && yIntOffsL >= 0 &&
-        nPbW+xIntOffsL <= w && nPbH+yIntOffsL <= h) {
+    if (xIntOffsL >= -ref_border && yIntOffsL >= -ref_border &&
+        nPbW+xIntOffsL <= w+ref_border && nPbH+yIntOffsL <= h+ref_border) {
 
       ctx->acceleration.put_hevc_qpel(out, out_stride,
                                       &ref[yIntOffsL*ref_stride + xIntOffsL],
@@ -130,10 +130,10 @@ void mc_luma(const base_context* ctx,
     const pixel_t* src_ptr;
     int src_stride;
 
-    if (-extra_left + xIntOffsL >= 0 &&
-        -extra_top  + yIntOffsL >= 0 &&
-        nPbW+extra_right  + xIntOffsL < w &&
-        nPbH+extra_bottom + yIntOffsL < h) {
+    if (-extra_left + xIntOffsL >= -ref_border &&
+        -extra_top  + yIntOffsL >= -ref_border &&
+        nPbW+extra_right  + xIntOffsL < w+ref_border &&
+        nPbH+extra_bottom + yIntOffsL < h+ref_border) {
       src_ptr = &ref[xIntOffsL + yIntOffsL*ref_stride];
       src_stride = ref_stride;
     }
@@ -175,7 +175,7 @@ void mc_chroma(const base_context* ctx,
                int mv_x, int mv_y,
                int xP,int yP,
                int16_t* out, int out_stride,
-               const pixel_t* ref, int ref_stride,
+               const pixel_t* ref, int ref_stride, int ref_border,
                int nPbWC, int nPbHC, int bit_depth_C)
 {
   // chroma sample interpolation process (8.5.3.2.2.2)
@@ -199,8 +199,8 @@ void mc_chroma(const base_context* ctx,
   ALIGNED_32(int16_t mcbuffer[MAX_CU_SIZE*(MAX_CU_SIZE+7)]);
 
   if (xFracC == 0 && yFracC == 0) {
-    if (xIntOffsC>=0 && nPbWC+xIntOffsC<=wC &&
-        yIntOffsC>=0 && nPbHC+yIntOffsC<=hC) {
+    if (xIntOffsC>=-ref_border && nPbWC+xIntOffsC<=wC+ref_border &&
+        yIntOffsC>=-ref_border && nPbHC+yIntOffsC<=hC+ref_border) {
       ctx->acceleration.put_hevc_epel(out, out_stride,
                                       &ref[xIntOffsC + yIntOffsC*ref_stride], ref_stride,
                                       nPbWC,nPbHC, 0,0, NULL, bit_depth_C);
@@ -228,8 +228,8 @@ void mc_chroma(const base_context* ctx,
     int extra_right  = 2;
     int extra_bottom = 2;
 
-    if (xIntOffsC>=1 && nPbWC+xIntOffsC<=wC-2 &&
-        yIntOffsC>=1 && nPbHC+yIntOffsC<=hC-2) {
+    if (xIntOffsC>=1-ref_border && nPbWC+xIntOffsC<=wC-2+ref_border &&
+        yIntOffsC>=1-ref_border && nPbHC+yIntOffsC<=hC-2+ref_border) {
       src_ptr = &ref[xIntOffsC + yIntOffsC*ref_stride];
       src_stride = ref_stride;
     }
@@ -357,36 +357,51 @@ void generate_inter_prediction_samples(base_context* ctx,
                  l,vi->mv[l].x,vi->mv[l].y,refPic->PicOrderCntVal);
 
 
+        // With frame-parallel decoding, the reference picture may still be in progress.
+        // Wait until the referenced area (including the interpolation filter margin and
+        // the lines that are modified by the deblocking of the CTB-row below) is final.
+
+        const int yRef = yP + (vi->mv[l].y >> 2);
+        refPic->wait_for_lines(yRef - 8, yRef + nPbH + 8, CTB_PROGRESS_SAO);
+
+
+
         // TODO: must predSamples stride really be nCS or can it be somthing smaller like nPbW?
 
         if (img->high_bit_depth(0)) {
           mc_luma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                   predSamplesL[l],nCS,
                   (const uint16_t*)refPic->get_image_plane(0),
-                  refPic->get_luma_stride(), nPbW,nPbH, bit_depth_L);
+                  refPic->get_luma_stride(), refPic->get_image_border(0),
+                  nPbW,nPbH, bit_depth_L);
         }
         else {
           mc_luma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                   predSamplesL[l],nCS,
                   (const uint8_t*)refPic->get_image_plane(0),
-                  refPic->get_luma_stride(), nPbW,nPbH, bit_depth_L);
+                  refPic->get_luma_stride(), refPic->get_image_border(0),
+                  nPbW,nPbH, bit_depth_L);
         }
 
         if (img->high_bit_depth(0)) {
           mc_chroma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                     predSamplesC[0][l],nCS, (const uint16_t*)refPic->get_image_plane(1),
-                    refPic->get_chroma_stride(), nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
+                    refPic->get_chroma_stride(), refPic->get_image_border(1),
+                    nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
           mc_chroma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                     predSamplesC[1][l],nCS, (const uint16_t*)refPic->get_image_plane(2),
-                    refPic->get_chroma_stride(), nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
+                    refPic->get_chroma_stride(), refPic->get_image_border(1),
+                    nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
         }
         else {
           mc_chroma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                     predSamplesC[0][l],nCS, (const uint8_t*)refPic->get_image_plane(1),
-                    refPic->get_chroma_stride(), nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
+                    refPic->get_chroma_stride(), refPic->get_image_border(1),
+                    nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
           mc_chroma(ctx, &img->sps, vi->mv[l].x, vi->mv[l].y, xP,yP,
                     predSamplesC[1][l],nCS, (const uint8_t*)refPic->get_image_plane(2),
-                    refPic->get_chroma_stride(), nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
+                    refPic->get_chroma_stride(), refPic->get_image_border(1),
+                    nPbW/SubWidthC,nPbH/SubHeightC, bit_depth_C);
         }
       }
     }
@@ -1083,6 +1098,15 @@ void derive_collocated_motion_vectors(base_context* ctx,
     return;
   }
 
+  // frame-parallel decoding: wait until the collocated CTB has been decoded
+
+  if (colImg->is_decoding_in_background()) {
+    const int log2CtbSize = colImg->sps.Log2CtbSizeY;
+    const int ctbAddrRS = (xColPb>>log2CtbSize) + (yColPb>>log2CtbSize)*colImg->sps.PicWidthInCtbsY;
+
+    colImg->ctb_progress[ctbAddrRS].wait_for_progress(CTB_PROGRESS_PREFILTER);
+  }
+
   enum PredMode predMode = colImg->get_pred_mode(xColPb,yColPb);
 
 
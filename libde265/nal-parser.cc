@@ -39,6 +39,8 @@ NAL_unit::NAL_unit()
   nal_data = NULL;
   data_size = 0;
   capacity = 0;
+
+  borrowed_data = NULL;
 }
 
 NAL_unit::~NAL_unit()
@@ -54,12 +56,28 @@ void NAL_unit::clear()
 
   // set size to zero but keep memory
   data_size = 0;
+  borrowed_data = NULL;
 
   skipped_bytes.clear();
 }
 
 LIBDE265_CHECK_RESULT bool NAL_unit::resize(int new_size)
 {
+  // borrowed data is copied into our own buffer before it can be modified
+
+  if (borrowed_data != NULL) {
+    const unsigned char* src = borrowed_data;
+    borrowed_data = NULL;
+
+    if (!resize(new_size > data_size ? new_size : data_size)) {
+      borrowed_data = src;
+      return false;
+    }
+
+    memcpy(nal_data, src, data_size);
+    return true;
+  }
+
   if (capacity < new_size) {
     unsigned char* newbuffer = (unsigned char*)malloc(new_size);
     if (newbuffer == NULL) {
@@ -97,6 +115,12 @@ bool LIBDE265_CHECK_RESULT NAL_unit::set_data(const unsigned char* in_data, int
   return true;
 }
 
+void NAL_unit::set_borrowed_data(const unsigned char* in_data, int n)
+{
+  borrowed_data = in_data;
+  data_size = n;
+}
+
 void NAL_unit::insert_skipped_byte(int pos)
 {
   skipped_bytes.push_back(pos);
@@ -112,40 +136,108 @@ int NAL_unit::num_skipped_bytes_before(int byte_position, int headerLength) cons
   return 0;
 }
 
+/* Emulation prevention bytes and start codes both begin with two zero bytes, which are
+   rare in the coded data. Hence, we only look at the positions of zero bytes, which
+   memchr() finds much faster than a byte-wise loop.
+ */
+
+static const unsigned char* find_zero_zero(const unsigned char* p, const unsigned char* end)
+{
+  while (end-p >= 3) {
+    p = (const unsigned char*)memchr(p, 0, end-p-2);
+    if (p==NULL) {
+      return NULL;
+    }
+
+    if (p[1]==0) {
+      return p;
+    }
+
+    p+=2;
+  }
+
+  return NULL;
+}
+
+
+/* Returns the next start code prefix (00 00 01) in [p;end) or NULL if there is none.
+   'emulation_prevention' is set when 00 00 03 occurs before it.
+ */
+static const unsigned char* find_start_code(const unsigned char* p, const unsigned char* end,
+                                            bool* emulation_prevention)
+{
+  *emulation_prevention = false;
+
+  while ((p = find_zero_zero(p,end)) != NULL) {
+    if (p[2]==1) {
+      return p;
+    }
+    else if (p[2]==3) {
+      *emulation_prevention = true;
+      p+=3;
+    }
+    else {
+      p++;
+    }
+  }
+
+  return NULL;
+}
+
+
+static bool has_emulation_prevention_bytes(const unsigned char* p, int len)
+{
+  const unsigned char* end = p+len;
+
+  while ((p = find_zero_zero(p,end)) != NULL) {
+    if (p[2]==3) {
+      return true;
+    }
+
+    p++;
+  }
+
+  return false;
+}
+
+
 void NAL_unit::remove_stuffing_bytes()
 {
+  if (!has_emulation_prevention_bytes(data(), size())) {
+    return;
+  }
+
+  if (!resize(size())) { // only copies borrowed data, cannot fail otherwise
+    return;
+  }
+
   uint8_t* p = data();
+  const int n = size();
 
-  for (int i=0;i<size()-2;i++)
-    {
-#if 0
-        for (int k=i;k<i+64;k++) 
-          if (i*0+k<size()) {
-            printf("%c%02x", (k==i) ? '[':' ', data()[k]);
-          }
-        printf("\n");
-#endif
+  int in  = 0; // first input byte that has not been moved yet
+  int out = 0; // output position
 
-      if (p[2]!=3 && p[2]!=0) {
-        // fast forward 3 bytes (2+1)
-        p+=2;
-        i+=2;
-      }
-      else {
-        if (p[0]==0 && p[1]==0 && p[2]==3) {
-          //printf("SKIP NAL @ %d\n",i+2+num_skipped_bytes);
-          insert_skipped_byte(i+2 + num_skipped_bytes());
+  const unsigned char* z = p;
 
-          memmove(p+2, p+3, size()-i-3);
-          set_size(size()-1);
+  while ((z = find_zero_zero(z, p+n)) != NULL) {
+    if (z[2]==3) {
+      int pos = z+2 - p;
 
-          p++;
-          i++;
-        }
-      }
+      // remember which byte we removed (position in the input data)
+      insert_skipped_byte(pos);
 
-      p++;
+      memmove(p+out, p+in, pos-in);
+      out += pos-in;
+      in   = pos+1;
+      z   += 3;
+    }
+    else {
+      z++;
     }
+  }
+
+  memmove(p+out, p+in, n-in);
+  set_size(out + n-in);
 }
 
 
@@ -246,12 +338,14 @@ void NAL_Parser::push_to_NAL_queue(NAL_unit* nal)
 }
 
 de265_error NAL_Parser::push_data(const unsigned char* data, int len,
-                                  de265_PTS pts, void* user_data)
+                                  de265_PTS pts, void* user_data, bool borrow)
 {
   end_of_frame = false;
 
+  // When borrowing, the buffer of a new NAL is allocated once we know that we need it.
+
   if (pending_input_NAL == NULL) {
-    pending_input_NAL = alloc_NAL_unit(len+3);
+    pending_input_NAL = alloc_NAL_unit(borrow ? 0 : len+3);
     if (pending_input_NAL == NULL) {
       return DE265_ERROR_OUT_OF_MEMORY;
     }
@@ -263,13 +357,66 @@ de265_error NAL_Parser::push_data(const unsigned char* data, int len,
 
   // Resize output buffer so that complete input would fit.
   // We add 3, because in the worst case 3 extra bytes are created for an input byte.
-  if (!nal->resize(nal->size() + len + 3)) {
-    return DE265_ERROR_OUT_OF_MEMORY;
+  if (!borrow || nal->size()>0) {
+    if (!nal->resize(nal->size() + len + 3)) {
+      return DE265_ERROR_OUT_OF_MEMORY;
+    }
   }
 
   unsigned char* out = nal->data() + nal->size();
+  const unsigned char* end = data+len;
+
+  while (data < end) {
+
+    // Copy the NAL payload up to the next zero byte in one go.
+
+    if (input_push_state==5) {
+      const unsigned char* zero = (const unsigned char*)memchr(data, 0, end-data);
+      const unsigned char* runEnd = (zero ? zero : end);
+
+      memcpy(out, data, runEnd-data);
+      out += runEnd-data;
+      data = runEnd;
+
+      if (zero==NULL) {
+        break;
+      }
+    }
+
+    // At the start of a NAL, check whether it can be referenced instead of copied.
+
+    else if (input_push_state==3 && borrow && out==nal->data()) {
+      bool emulation_prevention = false;
+      const unsigned char* startCode = NULL;
+
+      if (end-data >= 2) {
+        startCode = find_start_code(data+2, end, &emulation_prevention);
+      }
+
+      if (startCode != NULL && !emulation_prevention) {
+        nal->set_borrowed_data(data, startCode-data);
+        push_to_NAL_queue(nal);
+
+        pending_input_NAL = alloc_NAL_unit(0);
+        if (pending_input_NAL == NULL) {
+          return DE265_ERROR_OUT_OF_MEMORY;
+        }
+        pending_input_NAL->pts = pts;
+        pending_input_NAL->user_data = user_data;
+        nal = pending_input_NAL;
+        out = nal->data();
+
+        data = startCode+3;
+        continue;
+      }
+
+      if (!nal->resize(end-data + 3)) {
+        return DE265_ERROR_OUT_OF_MEMORY;
+      }
+
+      out = nal->data();
+    }
 
-  for (int i=0;i<len;i++) {
     /*
     printf("state=%d input=%02x (%p) (output size: %d)\n",ctx->input_push_state, *data, data,
            out - ctx->nal_data.data);
@@ -337,7 +484,7 @@ de265_error NAL_Parser::push_data(const unsigned char* data, int len,
 
         // initialize new, empty NAL unit
 
-        pending_input_NAL = alloc_NAL_unit(len+3);
+        pending_input_NAL = alloc_NAL_unit(borrow ? 0 : len+3);
         if (pending_input_NAL == NULL) {
           return DE265_ERROR_OUT_OF_MEMORY;
         }
@@ -368,7 +515,7 @@ de265_error NAL_Parser::push_data(const unsigned char* data, int len,
 
 
 de265_error NAL_Parser::push_NAL(const unsigned char* data, int len,
-                                 de265_PTS pts, void* user_data)
+                                 de265_PTS pts, void* user_data, bool borrow)
 {
 
   // Cannot use byte-stream input and NAL input at the same time.
@@ -376,16 +523,29 @@ de265_error NAL_Parser::push_NAL(const unsigned char* data, int len,
 
   end_of_frame = false;
 
-  NAL_unit* nal = alloc_NAL_unit(len);
-  if (nal == NULL || !nal->set_data(data, len)) {
-    free_NAL_unit(nal);
-    return DE265_ERROR_OUT_OF_MEMORY;
+  NAL_unit* nal;
+
+  if (borrow && !has_emulation_prevention_bytes(data, len)) {
+    nal = alloc_NAL_unit(0);
+    if (nal == NULL) {
+      return DE265_ERROR_OUT_OF_MEMORY;
+    }
+
+    nal->set_borrowed_data(data, len);
   }
+  else {
+    nal = alloc_NAL_unit(len);
+    if (nal == NULL || !nal->set_data(data, len)) {
+      free_NAL_unit(nal);
+      return DE265_ERROR_OUT_OF_MEMORY;
+    }
+
+    nal->remove_stuffing_bytes();
+  }
+
   nal->pts = pts;
   nal->user_data = user_data;
 
-  nal->remove_stuffing_bytes();
-
   push_to_NAL_queue(nal);
 
   return DE265_OK;
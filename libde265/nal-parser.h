@@ -52,10 +52,15 @@ class NAL_unit {
   LIBDE265_CHECK_RESULT bool append(const unsigned char* data, int n);
   LIBDE265_CHECK_RESULT bool set_data(const unsigned char* data, int n);
 
+  /* Let the NAL unit refer to the input data instead of copying it. The data must stay
+     valid until the NAL unit is released. It is copied before any modification. */
+  void set_borrowed_data(const unsigned char* data, int n);
+  bool is_borrowed() const { return borrowed_data != NULL; }
+
   int size() const { return data_size; }
   void set_size(int s) { data_size=s; }
-  unsigned char* data() { return nal_data; }
-  const unsigned char* data() const { return nal_data; }
+  unsigned char* data() { return borrowed_data ? (unsigned char*)borrowed_data : nal_data; }
+  const unsigned char* data() const { return borrowed_data ? borrowed_data : nal_data; }
 
 
   // --- skipped stuffing bytes ---
@@ -80,6 +85,8 @@ class NAL_unit {
   int data_size;
   int capacity;
 
+  const unsigned char* borrowed_data; // external NAL data (not owned), or NULL
+
   std::vector<int> skipped_bytes; // up to position[x], there were 'x' skipped bytes
 };
 
@@ -90,11 +97,15 @@ class NAL_Parser
   NAL_Parser();
   ~NAL_Parser();
 
+  /* With 'borrow', NAL units that lie completely within the input data and contain no
+     emulation prevention bytes refer to the input instead of copying it. The caller then
+     has to keep the data unchanged until these NAL units are freed. */
+
   de265_error push_data(const unsigned char* data, int len,
-                        de265_PTS pts, void* user_data = NULL);
+                        de265_PTS pts, void* user_data = NULL, bool borrow = false);
 
   de265_error push_NAL(const unsigned char* data, int len,
-                       de265_PTS pts, void* user_data = NULL);
+                       de265_PTS pts, void* user_data = NULL, bool borrow = false);
 
   NAL_unit*   pop_from_NAL_queue();
   de265_error flush_data();
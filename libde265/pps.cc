@@ -988,3 +988,14 @@ bool pic_parameter_set::is_tile_start_CTB(int ctbX,int ctbY) const
 
   return false;
 }
+
+
+bool pic_parameter_set::is_tile_column_start(int ctbX) const
+{
+  for (int i=0;i<num_tile_columns;i++)
+    if (colBd[i]==ctbX) {
+      return true;
+    }
+
+  return false;
+}
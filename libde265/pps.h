@@ -66,6 +66,7 @@ public:
              const seq_parameter_set* sps);
 
   bool is_tile_start_CTB(int ctbX,int ctbY) const;
+  bool is_tile_column_start(int ctbX) const; // whether CTB rows within a tile start at ctbX
   void dump(int fd) const;
 
 
@@ -20,15 +20,67 @@
 
 #include "sao.h"
 #include "util.h"
+#include "fallback-sao.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 
+enum sao_ctb_neighborhood {
+  SAO_NO_BOUNDARIES,        // edge offsets may use the samples of all neighboring CTBs
+  SAO_FILTER_BOUNDARIES,    // some neighbors are in a slice or tile that is not filtered across
+  SAO_UNDECODED_NEIGHBORS   // some neighbors have no slice header
+};
+
+
+static sao_ctb_neighborhood sao_get_ctb_neighborhood(de265_image* img, int xCtb,int yCtb,
+                                                     const slice_segment_header* shdr)
+{
+  const seq_parameter_set* sps = &img->sps;
+  const pic_parameter_set* pps = &img->pps;
+
+  const int tileId = pps->TileIdRS[xCtb + yCtb*sps->PicWidthInCtbsY];
+
+  sao_ctb_neighborhood neighborhood = SAO_NO_BOUNDARIES;
+
+  for (int y=yCtb-1;y<=yCtb+1;y++)
+    for (int x=xCtb-1;x<=xCtb+1;x++) {
+      if (x<0 || y<0 || x>=sps->PicWidthInCtbsY || y>=sps->PicHeightInCtbsY ||
+          (x==xCtb && y==yCtb)) {
+        continue;
+      }
+
+      const slice_segment_header* neighbor = img->get_SliceHeaderCtb(x,y);
+      if (neighbor==NULL) {
+        return SAO_UNDECODED_NEIGHBORS;
+      }
+
+      if ((neighbor->SliceAddrRS < shdr->SliceAddrRS &&
+           shdr->slice_loop_filter_across_slices_enabled_flag==0) ||
+          (neighbor->SliceAddrRS > shdr->SliceAddrRS &&
+           neighbor->slice_loop_filter_across_slices_enabled_flag==0) ||
+          (pps->loop_filter_across_tiles_enabled_flag==0 &&
+           pps->TileIdRS[x + y*sps->PicWidthInCtbsY] != tileId)) {
+        neighborhood = SAO_FILTER_BOUNDARIES;
+      }
+    }
+
+  return neighborhood;
+}
+
+
+/* 'in_ctb' points to the top-left input sample of the CTB. For edge offsets, the input
+   has to include a border of one sample around the CTB.
+   'out_img' points to the output image plane.
+
+   CTBs without PCM or transquant_bypass are processed with the acceleration functions.
+   For edge offsets, only the samples at the CTB border need the boundary tests, and only
+   if a neighboring CTB is in a slice or tile that is not filtered across.
+ */
 template <class pixel_t>
 void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
                         const slice_segment_header* shdr, int cIdx, int nSW,int nSH,
-                        const pixel_t* in_img,  int in_stride,
+                        const pixel_t* in_ctb,  int in_stride,
                         /* */ pixel_t* out_img, int out_stride)
 {
   const sao_info* saoinfo = img->get_sao_info(xCtb,yCtb);
@@ -46,6 +98,8 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
   const int bitDepth = (cIdx==0 ? sps->BitDepth_Y : sps->BitDepth_C);
   const int maxPixelValue = (1<<bitDepth)-1;
 
+  const acceleration_functions& accel = img->decctx->acceleration;
+
   // top left position of CTB in pixels
   const int xC = xCtb*nSW;
   const int yC = yCtb*nSH;
@@ -53,7 +107,8 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
   const int width  = img->get_width(cIdx);
   const int height = img->get_height(cIdx);
 
-  const int ctbSliceAddrRS = img->get_SliceHeader(xC,yC)->SliceAddrRS;
+  // slice of this CTB (xC;yC are in chroma sample units for cIdx>0)
+  const int ctbSliceAddrRS = shdr->SliceAddrRS;
 
   const int picWidthInCtbs = sps->PicWidthInCtbsY;
   const int chromashiftW = sps->get_chroma_shift_W(cIdx);
@@ -72,21 +127,18 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
   const int ctbW = (xC+nSW>width)  ? width -xC : nSW;
   const int ctbH = (yC+nSH>height) ? height-yC : nSH;
 
+  pixel_t* out_ctb = out_img + xC + yC*out_stride;
+
 
   const bool extendedTests = img->get_CTB_has_pcm_or_cu_transquant_bypass(xCtb,yCtb);
 
   if (SaoTypeIdx==2) {
-    int hPos[2], vPos[2];
-    int vPosStride[2]; // vPos[] multiplied by image stride
     int SaoEoClass = (saoinfo->SaoEoClass >> (2*cIdx)) & 0x3;
 
-    switch (SaoEoClass) {
-    case 0: hPos[0]=-1; hPos[1]= 1; vPos[0]= 0; vPos[1]=0; break;
-    case 1: hPos[0]= 0; hPos[1]= 0; vPos[0]=-1; vPos[1]=1; break;
-    case 2: hPos[0]=-1; hPos[1]= 1; vPos[0]=-1; vPos[1]=1; break;
-    case 3: hPos[0]= 1; hPos[1]=-1; vPos[0]=-1; vPos[1]=1; break;
-    }
+    const int* hPos = sao_eo_hPos[SaoEoClass];
+    const int* vPos = sao_eo_vPos[SaoEoClass];
 
+    int vPosStride[2]; // vPos[] multiplied by image stride
     vPosStride[0] = vPos[0] * in_stride;
     vPosStride[1] = vPos[1] * in_stride;
 
@@ -100,11 +152,53 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
     saoOffsetVal[4] = saoinfo->saoOffsetVal[cIdx][4-1];
 
 
+    sao_ctb_neighborhood neighborhood = SAO_UNDECODED_NEIGHBORS;
+    if (!extendedTests) {
+      neighborhood = sao_get_ctb_neighborhood(img, xCtb,yCtb, shdr);
+    }
+
+    if (neighborhood == SAO_NO_BOUNDARIES) {
+      // fast path: only the picture borders have to be excluded
+
+      int x0=0, x1=ctbW, y0=0, y1=ctbH;
+      if (hPos[0]!=0) {
+        if (xC==0)          { x0=1; }
+        if (xC+ctbW==width) { x1=ctbW-1; }
+      }
+      if (vPos[0]!=0) {
+        if (yC==0)           { y0=1; }
+        if (yC+ctbH==height) { y1=ctbH-1; }
+      }
+
+      if (x1>x0 && y1>y0) {
+        accel.sao_edge(out_ctb + x0 + y0*out_stride, out_stride,
+                       in_ctb  + x0 + y0*in_stride,  in_stride,
+                       x1-x0, y1-y0, SaoEoClass, saoOffsetVal, bitDepth);
+      }
+
+      return;
+    }
+
+
+    // With filter boundaries, the inner samples are filtered without tests
+    // and only the samples at the CTB border are processed below.
+
+    const bool borderOnly = (neighborhood == SAO_FILTER_BOUNDARIES && ctbW>2 && ctbH>2);
+
+    if (borderOnly) {
+      accel.sao_edge(out_ctb + 1 + out_stride, out_stride,
+                     in_ctb  + 1 + in_stride,  in_stride,
+                     ctbW-2, ctbH-2, SaoEoClass, saoOffsetVal, bitDepth);
+    }
+
+
     for (int j=0;j<ctbH;j++) {
-      const pixel_t* in_ptr  = &in_img [xC+(yC+j)*in_stride];
-      /* */ pixel_t* out_ptr = &out_img[xC+(yC+j)*out_stride];
+      const pixel_t* in_ptr  = &in_ctb [j*in_stride];
+      /* */ pixel_t* out_ptr = &out_ctb[j*out_stride];
 
-      for (int i=0;i<ctbW;i++) {
+      const int iStep = (borderOnly && j>0 && j<ctbH-1) ? ctbW-1 : 1;
+
+      for (int i=0;i<ctbW;i+=iStep) {
         int edgeIdx = -1;
 
         logtrace(LogSAO, "pos %d,%d\n",xC+i,yC+j);
@@ -130,11 +224,6 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
             }
 
 
-            // This part seems inefficient with all the get_SliceHeaderIndex() calls,
-            // but removing this part (because the input was known to have only a single
-            // slice anyway) reduced computation time only by 1.3%.
-            // TODO: however, this may still be a big part of SAO itself.
-
             slice_segment_header* sliceHeader = img->get_SliceHeader(xS<<chromashiftW,
                                                                      yS<<chromashiftH);
             if (sliceHeader==NULL) { return; }
@@ -183,25 +272,28 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
     int saoLeftClass = saoinfo->sao_band_position[cIdx];
     logtrace(LogSAO,"saoLeftClass: %d\n",saoLeftClass);
 
-    int bandTable[32];
-    memset(bandTable, 0, sizeof(int)*32);
-
-    for (int k=0;k<4;k++) {
-      bandTable[ (k+saoLeftClass)&31 ] = k+1;
+    // Shifts are a strange thing. On x86, >>x actually computes >>(x%64).
+    // So we have to take care of large bandShifts.
+    if (bandShift>=8) {
+      return;
     }
 
-
     /* If PCM or transquant_bypass is used in this CTB, we have to
        run all checks (A).
-       Otherwise, we run a simplified version of the code (B).
-
-       NOTE: this whole part of SAO does not seem to be a significant part of the time spent
+       Otherwise, the whole CTB is processed by the acceleration function (B).
     */
 
     if (extendedTests) {
 
       // (A) full version with all checks
 
+      int bandTable[32];
+      memset(bandTable, 0, sizeof(int)*32);
+
+      for (int k=0;k<4;k++) {
+        bandTable[ (k+saoLeftClass)&31 ] = k+1;
+      }
+
       for (int j=0;j<ctbH;j++)
         for (int i=0;i<ctbW;i++) {
 
@@ -211,22 +303,18 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
             continue;
           }
 
-          int bandIdx = bandTable[ in_img[xC+i+(yC+j)*in_stride]>>bandShift ];
-
-          // Shifts are a strange thing. On x86, >>x actually computes >>(x%64).
-          // So we have to take care of large bandShifts.
-          if (bandShift>=8) { bandIdx=0; }
+          int bandIdx = bandTable[ in_ctb[i+j*in_stride]>>bandShift ];
 
           if (bandIdx>0) {
             int offset = saoinfo->saoOffsetVal[cIdx][bandIdx-1];
 
             logtrace(LogSAO,"%d %d (%d) offset %d  %x -> %x\n",xC+i,yC+j,bandIdx,
                      offset,
-                     in_img[xC+i+(yC+j)*in_stride],
-                     in_img[xC+i+(yC+j)*in_stride]+offset);
+                     in_ctb[i+j*in_stride],
+                     in_ctb[i+j*in_stride]+offset);
 
-            out_img[xC+i+(yC+j)*out_stride] = Clip3(0,maxPixelValue,
-                                                    in_img[xC+i+(yC+j)*in_stride] + offset);
+            out_ctb[i+j*out_stride] = Clip3(0,maxPixelValue,
+                                            in_ctb[i+j*in_stride] + offset);
           }
         }
     }
@@ -234,21 +322,8 @@ void apply_sao_internal(de265_image* img, int xCtb,int yCtb,
       {
         // (B) simplified version (only works if no PCM and transquant_bypass is active)
 
-        for (int j=0;j<ctbH;j++)
-          for (int i=0;i<ctbW;i++) {
-
-            int bandIdx = bandTable[ in_img[xC+i+(yC+j)*in_stride]>>bandShift ];
-
-            // see above
-            if (bandShift>=8) { bandIdx=0; }
-
-            if (bandIdx>0) {
-              int offset = saoinfo->saoOffsetVal[cIdx][bandIdx-1];
-
-              out_img[xC+i+(yC+j)*out_stride] = Clip3(0,maxPixelValue,
-                                                      in_img[xC+i+(yC+j)*in_stride] + offset);
-            }
-          }
+        accel.sao_band(out_ctb, out_stride, in_ctb, in_stride, ctbW, ctbH,
+                       saoLeftClass, saoinfo->saoOffsetVal[cIdx], bitDepth);
       }
   }
 }
@@ -260,14 +335,16 @@ void apply_sao(de265_image* img, int xCtb,int yCtb,
                const pixel_t* in_img,  int in_stride,
                /* */ pixel_t* out_img, int out_stride)
 {
+  const int inOffset = xCtb*nSW + yCtb*nSH*in_stride;
+
   if (img->high_bit_depth(cIdx)) {
     apply_sao_internal<uint16_t>(img,xCtb,yCtb, shdr,cIdx,nSW,nSH,
-                                 (uint16_t*)in_img, in_stride,
+                                 (uint16_t*)in_img + inOffset, in_stride,
                                  (uint16_t*)out_img,out_stride);
   }
   else {
     apply_sao_internal<uint8_t>(img,xCtb,yCtb, shdr,cIdx,nSW,nSH,
-                                in_img, in_stride,
+                                in_img + inOffset, in_stride,
                                 out_img,out_stride);
   }
 }
@@ -313,110 +390,99 @@ void apply_sample_adaptive_offset(de265_image* img)
 }
 
 
-void apply_sample_adaptive_offset_sequential(de265_image* img)
-{
-  if (img->sps.sample_adaptive_offset_enabled_flag==0) {
-    return;
-  }
-
-  int lumaImageSize   = img->get_image_stride(0) * img->get_height(0) * img->get_bytes_per_pixel(0);
-  int chromaImageSize = img->get_image_stride(1) * img->get_height(1) * img->get_bytes_per_pixel(1);
-
-  uint8_t* inputCopy = new uint8_t[ libde265_max(lumaImageSize, chromaImageSize) ];
-  if (inputCopy == NULL) {
-    img->decctx->add_warning(DE265_WARNING_CANNOT_APPLY_SAO_OUT_OF_MEMORY,false);
-    return;
-  }
+/* In-place SAO.
 
+   Edge offsets need the unfiltered neighbors of each sample. Instead of keeping a copy of
+   the whole picture, we save the unfiltered lines at each CTB-row boundary (the last line
+   of the row above and the first line of the row below) before the rows are modified.
+   Within a CTB-row, the unfiltered last column of the previous CTB is kept in a column
+   buffer. Each edge-offset CTB is filtered from a small copy with a one-sample border.
+ */
 
-  int nChannels = 3;
-  if (img->sps.ChromaArrayType == CHROMA_MONO) { nChannels=1; }
+#define SAO_MAX_CTB_SIZE 64
 
-  for (int cIdx=0;cIdx<nChannels;cIdx++) {
 
-    int stride = img->get_image_stride(cIdx);
-    int height = img->get_height(cIdx);
+static int sao_ctb_width(const de265_image* img, int cIdx)
+{
+  return (1<<img->sps.Log2CtbSizeY) / (cIdx==0 ? 1 : img->sps.SubWidthC);
+}
 
-    memcpy(inputCopy, img->get_image_plane(cIdx), stride * height * img->get_bytes_per_pixel(cIdx));
+static int sao_ctb_height(const de265_image* img, int cIdx)
+{
+  return (1<<img->sps.Log2CtbSizeY) / (cIdx==0 ? 1 : img->sps.SubHeightC);
+}
 
-    for (int yCtb=0; yCtb<img->sps.PicHeightInCtbsY; yCtb++)
-      for (int xCtb=0; xCtb<img->sps.PicWidthInCtbsY; xCtb++)
-        {
-          const slice_segment_header* shdr = img->get_SliceHeaderCtb(xCtb,yCtb);
-          if (shdr==NULL) { return; }
+static int sao_num_channels(const de265_image* img)
+{
+  return (img->sps.ChromaArrayType == CHROMA_MONO) ? 1 : 3;
+}
 
-          if (cIdx==0 && shdr->slice_sao_luma_flag) {
-            apply_sao(img, xCtb,yCtb, shdr, 0, 1<<img->sps.Log2CtbSizeY, 1<<img->sps.Log2CtbSizeY,
-                      inputCopy, stride,
-                      img->get_image_plane(0), img->get_image_stride(0));
-          }
 
-          if (cIdx!=0 && shdr->slice_sao_chroma_flag) {
-            int nSW = (1<<img->sps.Log2CtbSizeY) / img->sps.SubWidthC;
-            int nSH = (1<<img->sps.Log2CtbSizeY) / img->sps.SubHeightC;
+static void alloc_sao_line_buffers(const de265_image* img, std::vector<uint8_t>* lines)
+{
+  int nBoundaries = img->sps.PicHeightInCtbsY - 1;
 
-            apply_sao(img, xCtb,yCtb, shdr, cIdx, nSW,nSH,
-                      inputCopy, stride,
-                      img->get_image_plane(cIdx), img->get_image_stride(cIdx));
-          }
-        }
+  for (int cIdx=0;cIdx<sao_num_channels(img);cIdx++) {
+    lines[cIdx].resize(2*nBoundaries * img->get_width(cIdx) * img->get_bytes_per_pixel(cIdx));
   }
-
-  delete[] inputCopy;
 }
 
 
-
-
-class thread_task_sao : public thread_task
+/* Line 'k' (0: last line of the row above, 1: first line of the row below)
+   at the boundary below CTB-row 'ctb_y'. */
+template <class pixel_t>
+static pixel_t* sao_boundary_line(const de265_image* img, const std::vector<uint8_t>* lines,
+                                  int cIdx, int ctb_y, int k)
 {
-public:
-  int  ctb_y;
-  de265_image* img; /* this is where we get the SPS from
-                       (either inputImg or outputImg can be a dummy image)
-                    */
-
-  de265_image* inputImg;
-  de265_image* outputImg;
-  int inputProgress;
-
-  virtual void work();
-  virtual std::string name() const {
-    char buf[100];
-    sprintf(buf,"sao-%d",ctb_y);
-    return buf;
-  }
-};
+  int width = img->get_width(cIdx);
+  return (pixel_t*)&lines[cIdx][0] + (2*ctb_y+k)*width;
+}
 
 
-void thread_task_sao::work()
+static void save_sao_input_lines(de265_image* img, std::vector<uint8_t>* lines, int ctb_y)
 {
-  state = Running;
-  img->thread_run(this);
+  if (ctb_y == img->sps.PicHeightInCtbsY-1) {
+    return; // no boundary below the last row
+  }
 
-  const int rightCtb = img->sps.PicWidthInCtbsY-1;
-  const int ctbSize  = (1<<img->sps.Log2CtbSizeY);
+  for (int cIdx=0;cIdx<sao_num_channels(img);cIdx++) {
+    int y = (ctb_y+1) * sao_ctb_height(img,cIdx);
+    int lineSize = img->get_width(cIdx) * img->get_bytes_per_pixel(cIdx);
 
+    memcpy(&lines[cIdx][(2*ctb_y  )*lineSize], img->get_image_plane_at_pos_any_depth(cIdx,0,y-1), lineSize);
+    memcpy(&lines[cIdx][(2*ctb_y+1)*lineSize], img->get_image_plane_at_pos_any_depth(cIdx,0,y  ), lineSize);
+  }
+}
 
-  // wait until also the CTB-rows below and above are ready
 
-  img->wait_for_progress(this, rightCtb,ctb_y,  inputProgress);
+template <class pixel_t>
+static void apply_sao_inplace_CTB_row(de265_image* img, const std::vector<uint8_t>* lines,
+                                      int ctb_y, int cIdx)
+{
+  const int nSW = sao_ctb_width (img,cIdx);
+  const int nSH = sao_ctb_height(img,cIdx);
 
-  if (ctb_y>0) {
-    img->wait_for_progress(this, rightCtb,ctb_y-1, inputProgress);
-  }
+  const int width  = img->get_width(cIdx);
+  const int height = img->get_height(cIdx);
+  const int stride = img->get_image_stride(cIdx);
 
-  if (ctb_y+1<img->sps.PicHeightInCtbsY) {
-    img->wait_for_progress(this, rightCtb,ctb_y+1, inputProgress);
-  }
+  pixel_t* plane = (pixel_t*)img->get_image_plane(cIdx);
 
+  const int yC   = ctb_y*nSH;
+  const int ctbH = std::min(nSH, height-yC);
 
-  // copy input image to output for this CTB-row
+  const pixel_t* lineAbove = NULL;
+  const pixel_t* lineBelow = NULL;
+  if (ctb_y>0)         { lineAbove = sao_boundary_line<pixel_t>(img,lines,cIdx,ctb_y-1,0); }
+  if (yC+nSH < height) { lineBelow = sao_boundary_line<pixel_t>(img,lines,cIdx,ctb_y  ,1); }
 
-  outputImg->copy_lines_from(inputImg, ctb_y * ctbSize, (ctb_y+1) * ctbSize);
+  assert(nSW <= SAO_MAX_CTB_SIZE && nSH <= SAO_MAX_CTB_SIZE);
 
+  const int inStride = SAO_MAX_CTB_SIZE+2;
+  pixel_t input[(SAO_MAX_CTB_SIZE+2)*(SAO_MAX_CTB_SIZE+2)];
 
-  // process SAO in the CTB-row
+  pixel_t leftColumn[SAO_MAX_CTB_SIZE];
+  bool leftColumnSaved = false; // if false, the left column in the image is still unfiltered
 
   for (int xCtb=0; xCtb<img->sps.PicWidthInCtbsY; xCtb++)
     {
@@ -425,41 +491,96 @@ void thread_task_sao::work()
         break;
       }
 
-      if (shdr->slice_sao_luma_flag) {
-        apply_sao(img, xCtb,ctb_y, shdr, 0, ctbSize, ctbSize,
-                  inputImg ->get_image_plane(0), inputImg ->get_image_stride(0),
-                  outputImg->get_image_plane(0), outputImg->get_image_stride(0));
+      bool enabled = (cIdx==0 ? shdr->slice_sao_luma_flag : shdr->slice_sao_chroma_flag);
+      int SaoTypeIdx = (img->get_sao_info(xCtb,ctb_y)->SaoTypeIdx >> (2*cIdx)) & 0x3;
+
+      if (!enabled || SaoTypeIdx==0) {
+        leftColumnSaved = false; // CTB is not modified
+        continue;
+      }
+
+      const int xC   = xCtb*nSW;
+      const int ctbW = std::min(nSW, width-xC);
+
+      pixel_t* ctb = plane + xC + yC*stride;
+
+      if (SaoTypeIdx==2) {
+        // edge offset: copy the unfiltered input including a border of one sample
+
+        const int i0 = (xC>0 ? -1 : 0);
+        const int i1 = (xC+ctbW < width ? ctbW : ctbW-1);
+
+        for (int j=-1;j<=ctbH;j++) {
+          const pixel_t* src;
+          if      (j<0)     { src = (lineAbove ? lineAbove + xC : NULL); }
+          else if (j==ctbH) { src = (lineBelow ? lineBelow + xC : NULL); }
+          else              { src = ctb + j*stride; }
+
+          if (src) {
+            memcpy(&input[(j+1)*inStride+1+i0], src+i0, (i1-i0+1)*sizeof(pixel_t));
+          }
+        }
+
+        if (xC>0 && leftColumnSaved) {
+          for (int j=0;j<ctbH;j++) {
+            input[(j+1)*inStride] = leftColumn[j];
+          }
+        }
       }
 
-      if (shdr->slice_sao_chroma_flag) {
-        int nSW = ctbSize / img->sps.SubWidthC;
-        int nSH = ctbSize / img->sps.SubHeightC;
+      // save the last column for the next CTB before it is modified
 
-        apply_sao(img, xCtb,ctb_y, shdr, 1, nSW,nSH,
-                  inputImg ->get_image_plane(1), inputImg ->get_image_stride(1),
-                  outputImg->get_image_plane(1), outputImg->get_image_stride(1));
+      for (int j=0;j<ctbH;j++) {
+        leftColumn[j] = ctb[ctbW-1 + j*stride];
+      }
+      leftColumnSaved = true;
 
-        apply_sao(img, xCtb,ctb_y, shdr, 2, nSW,nSH,
-                  inputImg ->get_image_plane(2), inputImg ->get_image_stride(2),
-                  outputImg->get_image_plane(2), outputImg->get_image_stride(2));
+      if (SaoTypeIdx==2) {
+        apply_sao_internal<pixel_t>(img, xCtb,ctb_y, shdr, cIdx, nSW,nSH,
+                                    &input[inStride+1], inStride,
+                                    plane, stride);
+      }
+      else {
+        // band offset: each sample depends only on itself
+        apply_sao_internal<pixel_t>(img, xCtb,ctb_y, shdr, cIdx, nSW,nSH,
+                                    ctb, stride,
+                                    plane, stride);
       }
     }
+}
 
 
-  // mark SAO progress
+static void apply_sao_inplace_CTB_row(de265_image* img, const std::vector<uint8_t>* lines,
+                                      int ctb_y)
+{
+  for (int cIdx=0;cIdx<sao_num_channels(img);cIdx++) {
+    if (img->high_bit_depth(cIdx)) {
+      apply_sao_inplace_CTB_row<uint16_t>(img, lines, ctb_y, cIdx);
+    }
+    else {
+      apply_sao_inplace_CTB_row<uint8_t>(img, lines, ctb_y, cIdx);
+    }
+  }
+}
+
 
-  for (int x=0;x<=rightCtb;x++) {
-    const int CtbWidth = img->sps.PicWidthInCtbsY;
-    img->ctb_progress[x+ctb_y*CtbWidth].set_progress(CTB_PROGRESS_SAO);
+void apply_sample_adaptive_offset_sequential(de265_image* img)
+{
+  if (img->sps.sample_adaptive_offset_enabled_flag==0) {
+    return;
   }
 
+  std::vector<uint8_t> inputLines[3];
+  alloc_sao_line_buffers(img, inputLines);
 
-  state = Finished;
-  img->thread_finishes(this);
+  for (int yCtb=0; yCtb<img->sps.PicHeightInCtbsY; yCtb++) {
+    save_sao_input_lines(img, inputLines, yCtb);
+    apply_sao_inplace_CTB_row(img, inputLines, yCtb);
+  }
 }
 
 
-bool add_sao_tasks(image_unit* imgunit, int saoInputProgress)
+bool alloc_sao_input_lines(image_unit* imgunit)
 {
   de265_image* img = imgunit->img;
 
@@ -467,43 +588,27 @@ bool add_sao_tasks(image_unit* imgunit, int saoInputProgress)
     return false;
   }
 
+  alloc_sao_line_buffers(img, imgunit->sao_input_lines);
 
-  decoder_context* ctx = img->decctx;
-
-  de265_error err = imgunit->sao_output.alloc_image(img->get_width(), img->get_height(),
-                                                    img->get_chroma_format(), &img->sps, false,
-                                                    img->decctx, img->encctx,
-                                                    img->pts, img->user_data, true);
-  if (err != DE265_OK) {
-    img->decctx->add_warning(DE265_WARNING_CANNOT_APPLY_SAO_OUT_OF_MEMORY,false);
-    return false;
-  }
-
-  int nRows = img->sps.PicHeightInCtbsY;
+  return true;
+}
 
-  int n=0;
-  img->thread_start(nRows);
 
-  for (int y=0;y<nRows;y++)
-    {
-      thread_task_sao* task = new thread_task_sao;
+void apply_sao_CTB_row(thread_task* task, de265_image* img,
+                       std::vector<uint8_t>* inputLines, int ctb_y)
+{
+  /* Save the unfiltered lines at the boundary to the row below before they are
+     overwritten. The lines at the boundary above are saved by the task above. */
 
-      task->inputImg  = img;
-      task->outputImg = &imgunit->sao_output;
-      task->img = img;
-      task->ctb_y = y;
-      task->inputProgress = saoInputProgress;
+  save_sao_input_lines(img, inputLines, ctb_y);
 
-      imgunit->tasks.push_back(task);
-      add_task(&ctx->thread_pool_, task);
-      n++;
-    }
+  img->ctb_row_progress[ctb_y].set_progress(CTB_PROGRESS_SAO_INPUT);
 
-  /* Currently need barrier here because when are finished, we have to swap the pixel
-     data back into the main image. */
-  img->wait_for_completion();
+  // the task above has to save our first line before we can modify it
 
-  img->exchange_pixel_data_with(imgunit->sao_output);
+  if (ctb_y>0) {
+    img->wait_for_row_progress(task, ctb_y-1, CTB_PROGRESS_SAO_INPUT);
+  }
 
-  return true;
+  apply_sao_inplace_CTB_row(img, inputLines, ctb_y);
 }
@@ -25,12 +25,20 @@
 
 void apply_sample_adaptive_offset(de265_image* img);
 
-/* requires less memory than the function above */
+/* In-place version of the function above. Only keeps copies of the lines at the CTB-row
+   boundaries. */
 void apply_sample_adaptive_offset_sequential(de265_image* img);
 
-/* saoInputProgress - the CTB progress that SAO will wait for before beginning processing.
-   Returns 'true' if any tasks have been added.
+/* Allocates imgunit->sao_input_lines, which receive the unfiltered lines at the CTB-row
+   boundaries. Returns 'false' if SAO is not used.
  */
-bool add_sao_tasks(image_unit* imgunit, int saoInputProgress);
+bool alloc_sao_input_lines(image_unit* imgunit);
+
+/* Applies SAO in-place to a CTB-row, which must be completely deblocked, including the
+   first line of the row below. Waits until the row above has saved its boundary lines.
+   Used by the in-loop filter tasks.
+ */
+void apply_sao_CTB_row(thread_task* task, de265_image* img,
+                       std::vector<uint8_t>* inputLines, int ctb_y);
 
 #endif
@@ -282,6 +282,8 @@ static de265_error process_sei_decoded_picture_hash(const sei_message* sei, de26
     return DE265_OK;
   }
 
+  DE265_TRACE_SCOPE(&img->decctx->tracer, "hash-check", img->PicOrderCntVal, -1,-1);
+
   //write_picture(img);
 
   int nHashes = img->sps.chroma_format_idc==0 ? 1 : 3;
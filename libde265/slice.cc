@@ -33,6 +33,8 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <algorithm>
 
 
 #define LOCK de265_mutex_lock(&ctx->thread_pool.mutex)
@@ -807,9 +809,16 @@ de265_error slice_segment_header::read(bitreader* br, decoder_context* ctx,
       return DE265_ERROR_CODED_PARAMETER_OUT_OF_RANGE;
     }
 
-    if (pps->entropy_coding_sync_enabled_flag) {
-      // check num_entry_points for valid range
+    // check num_entry_points for valid range
 
+    if (pps->entropy_coding_sync_enabled_flag && pps->tiles_enabled_flag) {
+      // one entry point per CTB row in each tile
+      if (num_entry_point_offsets >= pps->num_tile_columns * sps->PicHeightInCtbsY) {
+        ctx->add_warning(DE265_WARNING_SLICEHEADER_INVALID, false);
+        return DE265_ERROR_CODED_PARAMETER_OUT_OF_RANGE;
+      }
+    }
+    else if (pps->entropy_coding_sync_enabled_flag) {
       int firstCTBRow = slice_segment_address / sps->PicWidthInCtbsY;
       int lastCTBRow  = firstCTBRow + num_entry_point_offsets;
       if (lastCTBRow >= sps->PicHeightInCtbsY) {
@@ -818,7 +827,7 @@ de265_error slice_segment_header::read(bitreader* br, decoder_context* ctx,
       }
     }
 
-    if (pps->tiles_enabled_flag) {
+    else if (pps->tiles_enabled_flag) {
       if (num_entry_point_offsets > pps->num_tile_columns * pps->num_tile_rows) {
         ctx->add_warning(DE265_WARNING_SLICEHEADER_INVALID, false);
         return DE265_ERROR_CODED_PARAMETER_OUT_OF_RANGE;
@@ -2446,17 +2455,60 @@ static int decode_coeff_abs_level_remaining(thread_context* tctx,
 {
   logtrace(LogSlice,"# decode_coeff_abs_level_remaining\n");
 
-  int prefix=-1;
-  int codeword=0;
-  do {
+  CABAC_decoder* decoder = &tctx->cabac_decoder;
+
+  // Look ahead 16 bypass bins. This usually covers the whole prefix and suffix.
+
+  uint32_t bins = peek_CABAC_bypass_bins(decoder, 16);
+
+  int prefix=0;
+  while (prefix<16 && (bins & (0x8000>>prefix))) {
     prefix++;
-    codeword = decode_CABAC_bypass(&tctx->cabac_decoder);
+  }
+
+  if (prefix<16) {
+    int suffixBits = (prefix <= 3 ? cRiceParam : prefix-3+cRiceParam);
+    int nBins = prefix+1+suffixBits;
+
+    if (nBins <= 16) {
+      bins >>= 16-nBins;
+      skip_CABAC_bypass_bins(decoder, nBins, bins);
+
+      int codeword = bins & ((1<<suffixBits)-1);
+      int value;
+      if (prefix <= 3) {
+        value = (prefix<<cRiceParam) + codeword;
+      }
+      else {
+        value = (((1<<(prefix-3))+3-1)<<cRiceParam)+codeword;
+      }
+
+      logtrace(LogSymbols,"$1 coeff_abs_level_remaining=%d\n",value);
+
+      return value;
+    }
+  }
+
+  int codeword;
+
+  if (prefix<16) {
+    skip_CABAC_bypass_bins(decoder, prefix+1, bins >> (16-prefix-1));
+  }
+  else {
+    skip_CABAC_bypass_bins(decoder, 16, bins);
+
+    do {
+      prefix++;
+      codeword = decode_CABAC_bypass(decoder);
 
-    if (prefix>MAX_PREFIX) {
-      return 0; // TODO: error
+      if (prefix>MAX_PREFIX) {
+        return 0; // TODO: error
+      }
     }
+    while (codeword);
+
+    prefix--;
   }
-  while (codeword);
 
   // prefix = nb. 1 bits
 
@@ -2881,8 +2933,7 @@ int check_CTB_available(const de265_image* img,
 
   // TODO: check if this is correct (6.4.1)
 
-  if (img->get_SliceAddrRS_atCtbRS(current_ctbAddrRS) !=
-      img->get_SliceAddrRS_atCtbRS(neighbor_ctbAddrRS)) {
+  if (!img->is_in_same_slice_as_previous_CTB(current_ctbAddrRS, neighbor_ctbAddrRS)) {
     return 0;
   }
 
@@ -3294,20 +3345,23 @@ int residual_coding(thread_context* tctx,
         }
 
 
-      for (int n=0;n<nCoefficients-1;n++) {
-        coeff_sign[n] = decode_CABAC_bypass(&tctx->cabac_decoder);
-        logtrace(LogSlice,"sign[%d] = %d\n", n, coeff_sign[n]);
-      }
+      // n==nCoefficients-1 has no sign bit if it is hidden
 
-      // n==nCoefficients-1
-      if (!pps->sign_data_hiding_flag || !signHidden) {
-        coeff_sign[nCoefficients-1] = decode_CABAC_bypass(&tctx->cabac_decoder);
-        logtrace(LogSlice,"sign[%d] = %d\n", nCoefficients-1, coeff_sign[nCoefficients-1]);
-      }
-      else {
+      int nSigns = nCoefficients;
+      if (pps->sign_data_hiding_flag && signHidden) {
+        nSigns--;
         coeff_sign[nCoefficients-1] = 0;
       }
 
+      if (nSigns>0) {
+        int signs = decode_CABAC_FL_bypass(&tctx->cabac_decoder, nSigns);
+
+        for (int n=0;n<nSigns;n++) {
+          coeff_sign[n] = (signs >> (nSigns-1-n)) & 1;
+          logtrace(LogSlice,"sign[%d] = %d\n", n, coeff_sign[n]);
+        }
+      }
+
 
       // --- decode coefficient value ---
 
@@ -3408,11 +3462,53 @@ int residual_coding(thread_context* tctx,
 }
 
 
+static void record_TU(thread_context* tctx,
+                      int x0,int y0,
+                      int xCUBase,int yCUBase,
+                      int nT, int cIdx, enum PredMode cuPredMode, bool cbf)
+{
+  ctb_recon_data* recon = tctx->recon;
+
+  recon_step step;
+  step.type = recon_step::TransformBlock;
+  step.tb.x0 = x0;
+  step.tb.y0 = y0;
+  step.tb.xCUBase = xCUBase;
+  step.tb.yCUBase = yCUBase;
+  step.tb.nT   = nT;
+  step.tb.cIdx = cIdx;
+  step.tb.cuPredMode = cuPredMode;
+  step.tb.cbf  = cbf;
+  step.tb.cu_transquant_bypass_flag = tctx->cu_transquant_bypass_flag;
+  step.tb.transform_skip_flag = tctx->transform_skip_flag[cIdx];
+  step.tb.explicit_rdpcm_flag = tctx->explicit_rdpcm_flag;
+  step.tb.explicit_rdpcm_dir  = tctx->explicit_rdpcm_dir;
+  step.tb.ResScaleVal = tctx->ResScaleVal;
+  step.tb.qPYPrime  = tctx->qPYPrime;
+  step.tb.qPCbPrime = tctx->qPCbPrime;
+  step.tb.qPCrPrime = tctx->qPCrPrime;
+  step.tb.nCoeff   = (cbf ? tctx->nCoeff[cIdx] : 0);
+  step.tb.coeffIdx = recon->coeffs.size();
+
+  recon->coeffs.insert(recon->coeffs.end(),
+                       tctx->coeffList[cIdx], tctx->coeffList[cIdx] + step.tb.nCoeff);
+  recon->coeffs.insert(recon->coeffs.end(),
+                       tctx->coeffPos[cIdx],  tctx->coeffPos[cIdx]  + step.tb.nCoeff);
+
+  recon->steps.push_back(step);
+}
+
+
 static void decode_TU(thread_context* tctx,
                       int x0,int y0,
                       int xCUBase,int yCUBase,
                       int nT, int cIdx, enum PredMode cuPredMode, bool cbf)
 {
+  if (tctx->recon) {
+    record_TU(tctx, x0,y0, xCUBase,yCUBase, nT, cIdx, cuPredMode, cbf);
+    return;
+  }
+
   de265_image* img = tctx->img;
 
   int residualDpcm = 0;
@@ -4027,6 +4123,32 @@ void read_mvd_coding(thread_context* tctx,
 }
 
 
+static void reconstruct_prediction_unit(thread_context* tctx,
+                                        int xC,int yC, int xB,int yB,
+                                        int nCS, int nPbW,int nPbH, int partIdx)
+{
+  if (tctx->recon) {
+    recon_step step;
+    step.type = recon_step::PredictionUnit;
+    step.pu.xC = xC;
+    step.pu.yC = yC;
+    step.pu.xB = xB;
+    step.pu.yB = yB;
+    step.pu.nCS  = nCS;
+    step.pu.nPbW = nPbW;
+    step.pu.nPbH = nPbH;
+    step.pu.partIdx = partIdx;
+    step.pu.motion  = tctx->motion;
+
+    tctx->recon->steps.push_back(step);
+  }
+  else {
+    decode_prediction_unit(tctx->decctx, tctx->shdr, tctx->img, tctx->motion,
+                           xC,yC,xB,yB, nCS, nPbW,nPbH, partIdx);
+  }
+}
+
+
 void read_prediction_unit_SKIP(thread_context* tctx,
                                int x0, int y0,
                                int nPbW, int nPbH)
@@ -4119,16 +4241,18 @@ void read_prediction_unit(thread_context* tctx,
 
 
 
-  decode_prediction_unit(tctx->decctx, tctx->shdr, tctx->img, tctx->motion,
-                         xC,yC,xB,yB, nCS, nPbW,nPbH, partIdx);
+  reconstruct_prediction_unit(tctx, xC,yC,xB,yB, nCS, nPbW,nPbH, partIdx);
 }
 
 
 
 
+/* Reads the PCM samples of one color component. They are written into the image,
+   or into 'ptr' if it is given (which then has the stride of the block width).
+ */
 template <class pixel_t>
 void read_pcm_samples_internal(thread_context* tctx, int x0, int y0, int log2CbSize,
-                               int cIdx, bitreader& br)
+                               int cIdx, bitreader& br, pixel_t* ptr=NULL)
 {
   const seq_parameter_set* sps = &tctx->img->sps;
 
@@ -4153,10 +4277,11 @@ void read_pcm_samples_internal(thread_context* tctx, int x0, int y0, int log2CbS
     bitDepth = sps->BitDepth_Y;
   }
 
-  pixel_t* ptr;
-  int stride;
-  ptr    = tctx->img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,x0,y0);
-  stride = tctx->img->get_image_stride(cIdx);
+  int stride = w;
+  if (ptr==NULL) {
+    ptr    = tctx->img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,x0,y0);
+    stride = tctx->img->get_image_stride(cIdx);
+  }
 
   int shift = bitDepth - nPcmBits;
 
@@ -4177,19 +4302,48 @@ static void read_pcm_samples(thread_context* tctx, int x0, int y0, int log2CbSiz
   br.nextbits_cnt = 0;
 
 
-  if (tctx->img->high_bit_depth(0)) {
-    read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,0,br);
-  } else {
-    read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,0,br);
-  }
+  if (tctx->recon) {
+    // store the samples of all color components for the reconstruction
+
+    ctb_recon_data* recon = tctx->recon;
+
+    recon_step step;
+    step.type = recon_step::PCMSamples;
+    step.pcm.x0 = x0;
+    step.pcm.y0 = y0;
+    step.pcm.log2CbSize = log2CbSize;
+    step.pcm.sampleIdx = recon->coeffs.size();
+
+    int nComponents = (tctx->img->sps.ChromaArrayType != CHROMA_MONO) ? 3 : 1;
+    for (int cIdx=0;cIdx<nComponents;cIdx++) {
+      int size = 1<<(2*log2CbSize);
+      if (cIdx>0) {
+        size /= tctx->img->sps.SubWidthC * tctx->img->sps.SubHeightC;
+      }
 
-  if (tctx->img->sps.ChromaArrayType != CHROMA_MONO) {
-    if (tctx->img->high_bit_depth(1)) {
-      read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,1,br);
-      read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,2,br);
+      int idx = recon->coeffs.size();
+      recon->coeffs.resize(idx + size);
+      read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,cIdx,br,
+                                          (uint16_t*)&recon->coeffs[idx]);
+    }
+
+    recon->steps.push_back(step);
+  }
+  else {
+    if (tctx->img->high_bit_depth(0)) {
+      read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,0,br);
     } else {
-      read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,1,br);
-      read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,2,br);
+      read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,0,br);
+    }
+
+    if (tctx->img->sps.ChromaArrayType != CHROMA_MONO) {
+      if (tctx->img->high_bit_depth(1)) {
+        read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,1,br);
+        read_pcm_samples_internal<uint16_t>(tctx,x0,y0,log2CbSize,2,br);
+      } else {
+        read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,1,br);
+        read_pcm_samples_internal<uint8_t>(tctx,x0,y0,log2CbSize,2,br);
+      }
     }
   }
 
@@ -4292,8 +4446,7 @@ void read_coding_unit(thread_context* tctx,
     // DECODE
 
     int nCS_L = 1<<log2CbSize;
-    decode_prediction_unit(tctx->decctx,tctx->shdr,tctx->img,tctx->motion,
-                           x0,y0, 0,0, nCS_L, nCS_L,nCS_L, 0);
+    reconstruct_prediction_unit(tctx, x0,y0, 0,0, nCS_L, nCS_L,nCS_L, 0);
   }
   else /* not skipped */ {
     if (shdr->slice_type != SLICE_TYPE_I) {
@@ -4658,30 +4811,50 @@ enum DecodeResult decode_substream(thread_context* tctx,
 
   const int startCtbY = tctx->CtbY;
 
+  // with split parsing, the reconstruction of the CTBs is only recorded
+  std::vector<ctb_recon_data>* recon_CTBs = NULL;
+  if (tctx->sliceunit && !tctx->sliceunit->recon_CTBs.empty()) {
+    recon_CTBs = &tctx->sliceunit->recon_CTBs;
+  }
+
   //printf("start decoding substream at %d;%d\n",tctx->CtbX,tctx->CtbY);
 
+  if (tctx->CtbAddrInRS >= sps->PicSizeInCtbsY) {
+    return Decode_Error;
+  }
+
+  // A substream never leaves its tile. When tiles and WPP are combined, the WPP rows
+  // are the CTB rows within the tile.
+
+  const int tileIdx    = pps->TileIdRS[tctx->CtbAddrInRS];
+  const int tileCol    = tileIdx % pps->num_tile_columns;
+  const int tileStartX = pps->colBd[tileCol];
+  const int tileEndX   = pps->colBd[tileCol+1];
+  const int tileStartY = pps->rowBd[tileIdx / pps->num_tile_columns];
+
   // in WPP mode: initialize CABAC model with stored model from row above
 
   if ((!first_independent_substream || tctx->CtbY != startCtbY) &&
       pps->entropy_coding_sync_enabled_flag &&
-      tctx->CtbY>=1 && tctx->CtbX==0)
+      tctx->CtbY > tileStartY && tctx->CtbX == tileStartX)
     {
-      if (sps->PicWidthInCtbsY>1) {
-        if ((tctx->CtbY-1) >= tctx->imgunit->ctx_models.size()) {
+      if (tileEndX - tileStartX > 1) {
+        int ctxIdx = (tctx->CtbY-1) * pps->num_tile_columns + tileCol;
+        if (ctxIdx >= (int)tctx->imgunit->ctx_models.size()) {
           return Decode_Error;
         }
 
         //printf("CTX wait on %d/%d\n",1,tctx->CtbY-1);
 
         // we have to wait until the context model data is there
-        tctx->img->wait_for_progress(tctx->task, 1,tctx->CtbY-1,CTB_PROGRESS_PREFILTER);
+        tctx->img->wait_for_progress(tctx->task, tileStartX+1,tctx->CtbY-1,CTB_PROGRESS_PREFILTER);
 
         // copy CABAC model from previous CTB row
-        tctx->ctx_model = tctx->imgunit->ctx_models[(tctx->CtbY-1)];
-        tctx->imgunit->ctx_models[(tctx->CtbY-1)].release(); // not used anymore
+        tctx->ctx_model = tctx->imgunit->ctx_models[ctxIdx];
+        tctx->imgunit->ctx_models[ctxIdx].release(); // not used anymore
       }
       else {
-        tctx->img->wait_for_progress(tctx->task, 0,tctx->CtbY-1,CTB_PROGRESS_PREFILTER);
+        tctx->img->wait_for_progress(tctx->task, tileStartX,tctx->CtbY-1,CTB_PROGRESS_PREFILTER);
         initialize_CABAC_models(tctx);
       }
     }
@@ -4691,7 +4864,7 @@ enum DecodeResult decode_substream(thread_context* tctx,
     const int ctbx = tctx->CtbX;
     const int ctby = tctx->CtbY;
 
-    if (ctbx+ctby*ctbW >= tctx->img->pps.CtbAddrRStoTS.size()) {
+    if (ctbx+ctby*ctbW >= (int)tctx->img->pps.CtbAddrRStoTS.size()) {
         return Decode_Error;
     }
 
@@ -4700,13 +4873,15 @@ enum DecodeResult decode_substream(thread_context* tctx,
         return Decode_Error;
     }
 
-    if (block_wpp && ctby>0 && ctbx < ctbW-1) {
+    if (block_wpp && ctby > tileStartY) {
+
+      // wait for the CTB above right (or above, at the right tile border)
 
-      // TODO: if we are in tiles mode and at the right border, do not wait for x+1,y-1
+      int xAbove = std::min(ctbx+1, tileEndX-1);
 
-      //printf("wait on %d/%d (%d)\n",ctbx+1,ctby-1, ctbx+1+(ctby-1)*sps->PicWidthInCtbsY);
+      //printf("wait on %d/%d (%d)\n",xAbove,ctby-1, xAbove+(ctby-1)*sps->PicWidthInCtbsY);
 
-      tctx->img->wait_for_progress(tctx->task, ctbx+1,ctby-1, CTB_PROGRESS_PREFILTER);
+      tctx->img->wait_for_progress(tctx->task, xAbove,ctby-1, CTB_PROGRESS_PREFILTER);
     }
 
     //printf("%p: decode %d;%d\n", tctx, tctx->CtbX,tctx->CtbY);
@@ -4718,22 +4893,34 @@ enum DecodeResult decode_substream(thread_context* tctx,
       return Decode_Error;
     }
 
+    const int reconIdx = tctx->CtbAddrInRS - tctx->shdr->slice_segment_address;
+    if (recon_CTBs) {
+      // the slice segment must not run into the next one
+      if (reconIdx >= (int)recon_CTBs->size()) {
+        return Decode_Error;
+      }
+
+      tctx->recon = &(*recon_CTBs)[reconIdx];
+    }
+
     read_coding_tree_unit(tctx);
 
 
     // save CABAC-model for WPP (except in last CTB row)
 
     if (pps->entropy_coding_sync_enabled_flag &&
-        ctbx == 1 &&
+        ctbx == tileStartX+1 &&
         ctby < sps->PicHeightInCtbsY-1)
       {
+        int ctxIdx = ctby * pps->num_tile_columns + tileCol;
+
         // no storage for context table has been allocated
-        if (tctx->imgunit->ctx_models.size() <= ctby) {
+        if ((int)tctx->imgunit->ctx_models.size() <= ctxIdx) {
           return Decode_Error;
         }
 
-        tctx->imgunit->ctx_models[ctby] = tctx->ctx_model;
-        tctx->imgunit->ctx_models[ctby].decouple(); // store an independent copy
+        tctx->imgunit->ctx_models[ctxIdx] = tctx->ctx_model;
+        tctx->imgunit->ctx_models[ctxIdx].decouple(); // store an independent copy
       }
 
 
@@ -4754,7 +4941,14 @@ enum DecodeResult decode_substream(thread_context* tctx,
       }
     }
 
-    tctx->img->ctb_progress[ctbx+ctby*ctbW].set_progress(CTB_PROGRESS_PREFILTER);
+    if (recon_CTBs) {
+      tctx->recon->parsed = true;
+      tctx->recon = NULL;
+      tctx->sliceunit->parsed_CTBs.set_progress(reconIdx+1);
+    }
+    else {
+      tctx->img->ctb_progress[ctbx+ctby*ctbW].set_progress(CTB_PROGRESS_PREFILTER);
+    }
 
     //printf("%p: decoded %d|%d\n",tctx, ctby,ctbx);
 
@@ -4881,6 +5075,12 @@ std::string thread_task_ctb_row::name() const {
   return buf;
 }
 
+void thread_task_ctb_row::get_trace_info(const char** name, int* ctbX, int* ctbY) const {
+  *name = "ctb-row";
+  *ctbX = -1;
+  *ctbY = debug_startCtbRow;
+}
+
 
 std::string thread_task_slice_segment::name() const {
   char buf[100];
@@ -4888,6 +5088,40 @@ std::string thread_task_slice_segment::name() const {
   return buf;
 }
 
+void thread_task_slice_segment::get_trace_info(const char** name, int* ctbX, int* ctbY) const {
+  *name = "slice-segment";
+  *ctbX = debug_startCtbX;
+  *ctbY = debug_startCtbY;
+}
+
+
+/* Before the first substream of a slice segment starts, the previous slice segment has
+   to be decoded completely. Tasks for independent slices without WPP do not need this,
+   since they share no CABAC or QP state with the previous slice and all prediction
+   checks only look at CTBs within the current slice (see is_in_same_slice_as_previous_CTB()).
+ */
+static void wait_for_previous_slice_segment(thread_context* tctx)
+{
+  slice_unit* prevSliceSegment = tctx->imgunit->get_prev_slice_segment(tctx->sliceunit);
+  if (prevSliceSegment) {
+    prevSliceSegment->finished_threads.wait_for_progress(prevSliceSegment->nThreads);
+  }
+}
+
+
+/* With split parsing, the reconstruction tasks wait for the CTBs of the slice segment
+   to be parsed. When the parser stops (at the end of the slice segment or because of an
+   error), the remaining tasks are released.
+ */
+static void end_of_parsing(thread_context* tctx)
+{
+  tctx->recon = NULL;
+
+  if (!tctx->sliceunit->recon_CTBs.empty()) {
+    tctx->sliceunit->parsed_CTBs.set_progress(INT_MAX);
+  }
+}
+
 
 void thread_task_slice_segment::work()
 {
@@ -4898,6 +5132,13 @@ void thread_task_slice_segment::work()
   state = Running;
   img->thread_run(this);
 
+  if (data->firstSliceSubstream &&
+      tctx->shdr->dependent_slice_segment_flag) {
+    wait_for_previous_slice_segment(tctx);
+  }
+
+  tctx->decctx->init_thread_context(tctx);
+
   setCtbAddrFromTS(tctx);
 
   //printf("%p: A start decoding at %d/%d\n", tctx, tctx->CtbX,tctx->CtbY);
@@ -4905,8 +5146,10 @@ void thread_task_slice_segment::work()
   if (data->firstSliceSubstream) {
     bool success = initialize_CABAC_at_slice_segment_start(tctx);
     if (!success) {
+      end_of_parsing(tctx);
+
       state = Finished;
-      tctx->sliceunit->finished_threads.increase_progress(1);
+      tctx->sliceunit->task_finished();
       img->thread_finishes(this);
       return;
     }
@@ -4919,8 +5162,10 @@ void thread_task_slice_segment::work()
 
   /*enum DecodeResult result =*/ decode_substream(tctx, false, data->firstSliceSubstream);
 
+  end_of_parsing(tctx);
+
   state = Finished;
-  tctx->sliceunit->finished_threads.increase_progress(1);
+  tctx->sliceunit->task_finished();
   img->thread_finishes(this);
 
   return; // DE265_OK;
@@ -4939,43 +5184,64 @@ void thread_task_ctb_row::work()
   state = Running;
   img->thread_run(this);
 
+  if (data->firstSliceSubstream) {
+    wait_for_previous_slice_segment(tctx);
+  }
+
+  tctx->decctx->init_thread_context(tctx);
+
   setCtbAddrFromTS(tctx);
 
   int ctby = tctx->CtbAddrInRS / ctbW;
   int myCtbRow = ctby;
 
+  // the row only extends over the tile it starts in
+
+  const pic_parameter_set* pps = &img->pps;
+  int tileCol = pps->TileIdRS[tctx->CtbAddrInRS] % pps->num_tile_columns;
+  int firstCtbX = pps->colBd[tileCol];
+  int lastCtbX  = pps->colBd[tileCol+1];
+
   //printf("start CTB-row decoding at row %d\n", ctby);
 
   if (data->firstSliceSubstream) {
     bool success = initialize_CABAC_at_slice_segment_start(tctx);
     if (!success) {
       // could not decode this row, mark whole row as finished
-      for (int x=0;x<ctbW;x++) {
+      for (int x=firstCtbX;x<lastCtbX;x++) {
         img->ctb_progress[myCtbRow*ctbW + x].set_progress(CTB_PROGRESS_PREFILTER);
       }
 
       state = Finished;
-      tctx->sliceunit->finished_threads.increase_progress(1);
+      tctx->sliceunit->task_finished();
       img->thread_finishes(this);
       return;
     }
     //initialize_CABAC(tctx);
   }
+  else if (pps->is_tile_start_CTB(tctx->CtbX, tctx->CtbY)) {
+    // the first CTB row of a tile starts with fresh context models (tiles and WPP combined)
+    initialize_CABAC_models(tctx);
+  }
 
   init_CABAC_decoder_2(&tctx->cabac_decoder);
 
   bool firstIndependentSubstream =
     data->firstSliceSubstream && !tctx->shdr->dependent_slice_segment_flag;
 
-  /*enum DecodeResult result =*/
-  decode_substream(tctx, true, firstIndependentSubstream);
+  enum DecodeResult result =
+    decode_substream(tctx, true, firstIndependentSubstream);
 
   // mark progress on remaining CTBs in row (in case of decoder error and early termination)
 
-  // TODO: what about slices that end properly in the middle of a CTB row?
+  // A slice that ends properly in the middle of a CTB row is continued by the next
+  // slice segment. Its CTBs must not be marked, because that one may still be decoding.
+
+  slice_unit* sliceunit = tctx->sliceunit;
+  bool lastSubstream = (tctx == sliceunit->get_thread_context(sliceunit->num_thread_contexts()-1));
 
-  if (tctx->CtbY == myCtbRow) {
-    int lastCtbX = sps->PicWidthInCtbsY; // assume no tiles when WPP is on
+  if (tctx->CtbY == myCtbRow &&
+      (result == Decode_Error || !lastSubstream)) {
     for (int x = tctx->CtbX; x<lastCtbX ; x++) {
 
       if (x        < img->sps.PicWidthInCtbsY &&
@@ -4986,7 +5252,161 @@ void thread_task_ctb_row::work()
   }
 
   state = Finished;
-  tctx->sliceunit->finished_threads.increase_progress(1);
+  tctx->sliceunit->task_finished();
+  img->thread_finishes(this);
+}
+
+
+std::string thread_task_reconstruct_ctb_row::name() const {
+  char buf[100];
+  sprintf(buf,"reconstruct-ctb-row-%d",ctbRow);
+  return buf;
+}
+
+void thread_task_reconstruct_ctb_row::get_trace_info(const char** name, int* ctbX, int* ctbY) const {
+  *name = "reconstruct-ctb-row";
+  *ctbX = -1;
+  *ctbY = ctbRow;
+}
+
+
+template <class pixel_t>
+static void write_pcm_samples(de265_image* img, int x0,int y0, int w,int h, int cIdx,
+                              const int16_t* samples)
+{
+  pixel_t* ptr = img->get_image_plane_at_pos_NEW<pixel_t>(cIdx,x0,y0);
+  int stride = img->get_image_stride(cIdx);
+
+  for (int y=0;y<h;y++)
+    for (int x=0;x<w;x++)
+      {
+        ptr[y*stride+x] = (uint16_t)samples[y*w+x];
+      }
+}
+
+
+static void reconstruct_CTB(thread_context* tctx, const ctb_recon_data& data)
+{
+  de265_image* img = tctx->img;
+
+  for (size_t i=0;i<data.steps.size();i++) {
+    const recon_step& step = data.steps[i];
+
+    switch (step.type) {
+    case recon_step::PredictionUnit:
+      decode_prediction_unit(tctx->decctx, tctx->shdr, img, step.pu.motion,
+                             step.pu.xC,step.pu.yC, step.pu.xB,step.pu.yB,
+                             step.pu.nCS, step.pu.nPbW,step.pu.nPbH, step.pu.partIdx);
+      break;
+
+    case recon_step::TransformBlock:
+      {
+        int cIdx = step.tb.cIdx;
+
+        tctx->cu_transquant_bypass_flag = step.tb.cu_transquant_bypass_flag;
+        tctx->transform_skip_flag[cIdx] = step.tb.transform_skip_flag;
+        tctx->explicit_rdpcm_flag = step.tb.explicit_rdpcm_flag;
+        tctx->explicit_rdpcm_dir  = step.tb.explicit_rdpcm_dir;
+        tctx->ResScaleVal = step.tb.ResScaleVal;
+        tctx->qPYPrime  = step.tb.qPYPrime;
+        tctx->qPCbPrime = step.tb.qPCbPrime;
+        tctx->qPCrPrime = step.tb.qPCrPrime;
+
+        int nCoeff = step.tb.nCoeff;
+        tctx->nCoeff[cIdx] = nCoeff;
+        if (nCoeff) {
+          memcpy(tctx->coeffList[cIdx], &data.coeffs[step.tb.coeffIdx], nCoeff*sizeof(int16_t));
+          memcpy(tctx->coeffPos[cIdx], &data.coeffs[step.tb.coeffIdx+nCoeff],
+                 nCoeff*sizeof(int16_t));
+        }
+
+        decode_TU(tctx, step.tb.x0,step.tb.y0, step.tb.xCUBase,step.tb.yCUBase,
+                  step.tb.nT, cIdx, (enum PredMode)step.tb.cuPredMode, step.tb.cbf);
+      }
+      break;
+
+    case recon_step::PCMSamples:
+      {
+        const int16_t* samples = &data.coeffs[step.pcm.sampleIdx];
+        int nComponents = (img->sps.ChromaArrayType != CHROMA_MONO) ? 3 : 1;
+
+        for (int cIdx=0;cIdx<nComponents;cIdx++) {
+          int x0 = step.pcm.x0;
+          int y0 = step.pcm.y0;
+          int w = 1<<step.pcm.log2CbSize;
+          int h = w;
+
+          if (cIdx>0) {
+            x0 /= img->sps.SubWidthC;
+            y0 /= img->sps.SubHeightC;
+            w  /= img->sps.SubWidthC;
+            h  /= img->sps.SubHeightC;
+          }
+
+          if (img->high_bit_depth(cIdx)) {
+            write_pcm_samples<uint16_t>(img, x0,y0, w,h, cIdx, samples);
+          } else {
+            write_pcm_samples<uint8_t>(img, x0,y0, w,h, cIdx, samples);
+          }
+
+          samples += w*h;
+        }
+      }
+      break;
+    }
+  }
+}
+
+
+void thread_task_reconstruct_ctb_row::work()
+{
+  de265_image* img = tctx->img;
+  slice_unit* sliceunit = tctx->sliceunit;
+
+  const int ctbW = img->sps.PicWidthInCtbsY;
+  const int segmentStart = tctx->shdr->slice_segment_address;
+  const int sliceStart   = tctx->shdr->SliceAddrRS;
+
+  state = Running;
+  img->thread_run(this);
+
+  const int firstCtb = std::max(ctbRow*ctbW, segmentStart);
+  const int endCtb   = std::min((ctbRow+1)*ctbW,
+                                segmentStart + (int)sliceunit->recon_CTBs.size());
+
+  for (int ctbAddrRS = firstCtb; ctbAddrRS < endCtb; ctbAddrRS++) {
+    ctb_recon_data& data = sliceunit->recon_CTBs[ctbAddrRS - segmentStart];
+
+    sliceunit->parsed_CTBs.wait_for_progress(ctbAddrRS - segmentStart + 1);
+    if (!data.parsed) {
+      break; // the parser stopped before this CTB
+    }
+
+    const int ctbX = ctbAddrRS % ctbW;
+    const int ctbY = ctbRow;
+
+    // Wait until the CTBs left and above right are reconstructed. CTBs in other slices
+    // are not used for prediction.
+
+    if (ctbAddrRS == firstCtb && ctbX > 0 && ctbAddrRS-1 >= sliceStart) {
+      img->wait_for_progress(this, ctbX-1,ctbY, CTB_PROGRESS_PREFILTER);
+    }
+
+    if (ctbY > 0) {
+      int xAbove = std::min(ctbX+1, ctbW-1);
+      if (xAbove + (ctbY-1)*ctbW >= sliceStart) {
+        img->wait_for_progress(this, xAbove,ctbY-1, CTB_PROGRESS_PREFILTER);
+      }
+    }
+
+    reconstruct_CTB(tctx, data);
+    data.release();
+
+    img->ctb_progress[ctbAddrRS].set_progress(CTB_PROGRESS_PREFILTER);
+  }
+
+  state = Finished;
+  sliceunit->task_finished();
   img->thread_finishes(this);
 }
 
@@ -5022,7 +5442,7 @@ de265_error read_slice_segment_data(thread_context* tctx)
 
     if (substream>0) {
       if (substream-1 >= tctx->shdr->entry_point_offset.size() ||
-          tctx->cabac_decoder.bitstream_curr - tctx->cabac_decoder.bitstream_start -2 /* -2 because of CABAC init */
+          CABAC_decoder_position(&tctx->cabac_decoder) - tctx->cabac_decoder.bitstream_start -2 /* -2 because of CABAC init */
           != tctx->shdr->entry_point_offset[substream-1]) {
         tctx->decctx->add_warning(DE265_WARNING_INCORRECT_ENTRY_POINT_OFFSET, true);
       }
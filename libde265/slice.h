@@ -29,6 +29,7 @@
 #include "libde265/util.h"
 #include "libde265/refpic.h"
 #include "libde265/threads.h"
+#include "libde265/motion.h"
 #include "contextmodel.h"
 
 #include <vector>
@@ -272,6 +273,66 @@ typedef struct {
 
 
 
+
+/* When parsing and reconstruction are split (DE265_DECODER_PARAM_SPLIT_PARSING), the
+   parser does not reconstruct the CTBs itself. Instead, it records the reconstruction
+   steps of each CTB, which are carried out later by thread_task_reconstruct_ctb_row.
+ */
+struct recon_step
+{
+  enum recon_step_type { PredictionUnit, TransformBlock, PCMSamples } type;
+
+  union {
+    struct {
+      int16_t xC,yC, xB,yB;
+      int16_t nCS, nPbW,nPbH;
+      uint8_t partIdx;
+      motion_spec motion;
+    } pu;
+
+    struct {
+      int16_t x0,y0;            // position of TB in frame (chroma adapted)
+      int16_t xCUBase,yCUBase;  // position of CU in frame (chroma adapted)
+      uint8_t nT, cIdx;
+      uint8_t cuPredMode, cbf;
+
+      uint8_t cu_transquant_bypass_flag;
+      uint8_t transform_skip_flag;
+      uint8_t explicit_rdpcm_flag;
+      uint8_t explicit_rdpcm_dir;
+      int8_t  ResScaleVal;
+      int16_t qPYPrime, qPCbPrime, qPCrPrime;
+
+      uint16_t nCoeff;
+      int coeffIdx;  // index of coefficient values and then positions in ctb_recon_data::coeffs
+    } tb;
+
+    struct {
+      int16_t x0,y0;
+      uint8_t log2CbSize;
+      int sampleIdx; // index of the samples (Y, Cb, Cr) in ctb_recon_data::coeffs
+    } pcm;
+  };
+};
+
+
+class ctb_recon_data
+{
+ public:
+  ctb_recon_data() : parsed(false) { }
+
+  bool parsed;  // false if the parser stopped before this CTB
+
+  std::vector<recon_step> steps;
+  std::vector<int16_t>    coeffs;
+
+  void release() {
+    std::vector<recon_step>().swap(steps);
+    std::vector<int16_t>().swap(coeffs);
+  }
+};
+
+
 de265_error read_slice_segment_data(thread_context* tctx);
 
 bool alloc_and_init_significant_coeff_ctxIdx_lookupTable();
@@ -287,6 +348,7 @@ public:
 
   virtual void work();
   virtual std::string name() const;
+  virtual void get_trace_info(const char** name, int* ctbX, int* ctbY) const;
 };
 
 class thread_task_slice_segment : public thread_task
@@ -298,6 +360,19 @@ public:
 
   virtual void work();
   virtual std::string name() const;
+  virtual void get_trace_info(const char** name, int* ctbX, int* ctbY) const;
+};
+
+// reconstructs the CTBs of one row of a slice segment that have been recorded by the parser
+class thread_task_reconstruct_ctb_row : public thread_task
+{
+public:
+  int    ctbRow;
+  thread_context* tctx;
+
+  virtual void work();
+  virtual std::string name() const;
+  virtual void get_trace_info(const char** name, int* ctbX, int* ctbY) const;
 };
 
 
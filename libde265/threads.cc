@@ -19,6 +19,7 @@
  */
 
 #include "threads.h"
+#include "trace.h"
 #include <assert.h>
 #include <string.h>
 
@@ -28,6 +29,13 @@
 # include <alloca.h>
 #endif
 
+#ifdef DE265_USE_FUTEX
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
 
 #ifndef _WIN32
 // #include <intrin.h>
@@ -83,59 +91,133 @@ void de265_cond_signal(de265_cond* c) { win32_cond_signal(c); }
 
 
 
+// number of polls before a thread waiting for progress goes to sleep
+#define PROGRESS_SPIN_ITERATIONS 100
+
+static inline void cpu_relax()
+{
+#if defined(_MSC_VER)
+  YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#endif
+}
+
+#ifdef DE265_USE_FUTEX
+static void futex_wait(volatile int* addr, int value)
+{
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+static void futex_wake_all(volatile int* addr)
+{
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+
 de265_progress_lock::de265_progress_lock()
 {
   mProgress = 0;
+  mNumWaiters = 0;
 
+#ifdef DE265_USE_FUTEX
+  mWakeups = 0;
+#else
   de265_mutex_init(&mutex);
   de265_cond_init(&cond);
+#endif
 }
 
 de265_progress_lock::~de265_progress_lock()
 {
+#ifndef DE265_USE_FUTEX
   de265_mutex_destroy(&mutex);
   de265_cond_destroy(&cond);
+#endif
 }
 
 void de265_progress_lock::wait_for_progress(int progress)
 {
-  if (mProgress >= progress) {
+  if (get_progress() >= progress) {
     return;
   }
 
+  // The progress is often reached after a short time (e.g. by the CTB-row above).
+  // Poll a little before we put the thread to sleep.
+
+  for (int i=0;i<PROGRESS_SPIN_ITERATIONS;i++) {
+    cpu_relax();
+
+    if (get_progress() >= progress) {
+      return;
+    }
+  }
+
+  /* Register as waiter before checking the progress again. Since the progress is
+     updated before the waiter count is checked in set_progress(), either we see the
+     new progress, or set_progress() sees us and wakes us up. */
+
+  de265_sync_add_and_fetch(&mNumWaiters, 1);
+
+#ifdef DE265_USE_FUTEX
+  for (;;) {
+    int wakeups = __atomic_load_n(&mWakeups, __ATOMIC_ACQUIRE); // read before the progress
+    if (get_progress() >= progress) {
+      break;
+    }
+
+    // returns immediately if there was a wake-up since we read the counter
+    futex_wait(&mWakeups, wakeups);
+  }
+#else
   de265_mutex_lock(&mutex);
-  while (mProgress < progress) {
+  while (get_progress() < progress) {
     de265_cond_wait(&cond, &mutex);
   }
   de265_mutex_unlock(&mutex);
+#endif
+
+  de265_sync_sub_and_fetch(&mNumWaiters, 1);
 }
 
-void de265_progress_lock::set_progress(int progress)
+void de265_progress_lock::wake_waiters()
 {
-  de265_mutex_lock(&mutex);
-
-  if (progress>mProgress) {
-    mProgress = progress;
-
-    de265_cond_broadcast(&cond, &mutex);
+  if (de265_sync_load_acquire(&mNumWaiters) == 0) {
+    return;
   }
 
+#ifdef DE265_USE_FUTEX
+  __sync_add_and_fetch(&mWakeups, 1);
+  futex_wake_all(&mWakeups);
+#else
+  de265_mutex_lock(&mutex);
+  de265_cond_broadcast(&cond, &mutex);
   de265_mutex_unlock(&mutex);
+#endif
 }
 
-void de265_progress_lock::increase_progress(int progress)
+void de265_progress_lock::set_progress(int progress)
 {
-  de265_mutex_lock(&mutex);
+  for (;;) {
+    long current = de265_sync_load_acquire(&mProgress);
+    if (progress <= current) {
+      return;
+    }
 
-  mProgress += progress;
-  de265_cond_broadcast(&cond, &mutex);
+    if (de265_sync_bool_compare_and_swap(&mProgress, current, progress)) {
+      break;
+    }
+  }
 
-  de265_mutex_unlock(&mutex);
+  wake_waiters();
 }
 
-int  de265_progress_lock::get_progress() const
+void de265_progress_lock::increase_progress(int progress)
 {
-  return mProgress;
+  de265_sync_add_and_fetch(&mProgress, progress);
+
+  wake_waiters();
 }
 
 
@@ -184,59 +266,183 @@ void printblks(const thread_pool* pool)
 #endif
 
 
-static THREAD_RESULT worker_thread(THREAD_PARAM pool_ptr)
+thread_task_queue::thread_task_queue()
+  : slots(NULL),
+    mask(0),
+    push_pos(0),
+    pop_pos(0)
 {
-  thread_pool* pool = (thread_pool*)pool_ptr;
+}
 
 
-  de265_mutex_lock(&pool->mutex);
+thread_task_queue::~thread_task_queue()
+{
+  delete[] slots;
+}
 
-  while(true) {
 
-    // wait until we can pick a task or until the pool has been stopped
+void thread_task_queue::init(int capacity)
+{
+  assert((capacity & (capacity-1)) == 0);
+
+  delete[] slots;
+
+  slots = new slot[capacity];
+  mask  = capacity-1;
+
+  for (int i=0;i<capacity;i++) {
+    slots[i].sequence = i;
+    slots[i].task = NULL;
+  }
+
+  push_pos = 0;
+  pop_pos  = 0;
+}
+
+
+/* The positions grow without bound and wrap around. They are only compared by their
+   difference, computed in unsigned arithmetic so that the wrap-around is well defined
+   (de265_sync_int is only 32 bits wide on some platforms). */
+
+static inline long queue_pos_add(long pos, unsigned long n)
+{
+  return (long)((unsigned long)pos + n);
+}
+
+static inline long queue_pos_diff(long a, long b)
+{
+  return (long)((unsigned long)a - (unsigned long)b);
+}
+
 
-    for (;;) {
-      // end waiting if thread-pool has been stopped or we have a task to execute
+bool thread_task_queue::try_push(thread_task* task)
+{
+  long pos = de265_sync_load_acquire(&push_pos);
+  slot* s;
 
-      if (pool->stopped || pool->tasks.size()>0) {
+  for (;;) {
+    s = &slots[pos & mask];
+
+    long diff = queue_pos_diff(de265_sync_load_acquire(&s->sequence), pos);
+    if (diff == 0) {
+      // slot is free, try to reserve it
+      if (de265_sync_bool_compare_and_swap(&push_pos, pos, queue_pos_add(pos,1))) {
         break;
       }
+    }
+    else if (diff < 0) {
+      return false; // queue is full
+    }
+
+    // another thread was faster, try again at the new position
+    pos = de265_sync_load_acquire(&push_pos);
+  }
+
+  s->task = task;
 
-      //printf("going idle\n");
-      de265_cond_wait(&pool->cond_var, &pool->mutex);
+  // make the task visible before the slot is released to the consumers
+  de265_sync_store_release(&s->sequence, queue_pos_add(pos,1));
+
+  return true;
+}
+
+
+thread_task* thread_task_queue::try_pop()
+{
+  long pos = de265_sync_load_acquire(&pop_pos);
+  slot* s;
+
+  for (;;) {
+    s = &slots[pos & mask];
+
+    long diff = queue_pos_diff(de265_sync_load_acquire(&s->sequence), queue_pos_add(pos,1));
+    if (diff == 0) {
+      // slot contains a task, try to take it
+      if (de265_sync_bool_compare_and_swap(&pop_pos, pos, queue_pos_add(pos,1))) {
+        break;
+      }
     }
+    else if (diff < 0) {
+      return NULL; // queue is empty
+    }
+
+    pos = de265_sync_load_acquire(&pop_pos);
+  }
+
+  thread_task* task = s->task;
+
+  // release the slot for the next round of the ring buffer
+  de265_sync_store_release(&s->sequence, queue_pos_add(pos, mask+1));
+
+  return task;
+}
+
+
+static THREAD_RESULT worker_thread(THREAD_PARAM pool_ptr)
+{
+  thread_pool* pool = (thread_pool*)pool_ptr;
+
+  while(true) {
 
     // if the pool was shut down, end the execution
 
-    if (pool->stopped) {
-      de265_mutex_unlock(&pool->mutex);
+    if (de265_sync_load_acquire(&pool->stopped)) {
       return NULL;
     }
 
 
     // get a task
 
-    thread_task* task = pool->tasks.front();
-    pool->tasks.pop_front();
+    thread_task* task = pool->tasks.try_pop();
 
-    pool->num_threads_working++;
+    if (task == NULL) {
+      // Go to sleep until a task is added or the pool has been stopped.
+      // We have to check the queue again after announcing that we are idle,
+      // because add_task() only wakes up threads if there are idle ones.
 
-    //printblks(pool);
+      de265_mutex_lock(&pool->mutex);
+      de265_sync_add_and_fetch(&pool->num_threads_idle, 1);
 
-    de265_mutex_unlock(&pool->mutex);
+      while (!de265_sync_load_acquire(&pool->stopped) &&
+             (task = pool->tasks.try_pop()) == NULL) {
+        //printf("going idle\n");
+        de265_cond_wait(&pool->cond_var, &pool->mutex);
+      }
+
+      de265_sync_sub_and_fetch(&pool->num_threads_idle, 1);
+      de265_mutex_unlock(&pool->mutex);
+
+      if (task == NULL) {
+        continue; // pool has been stopped
+      }
+    }
+
+
+    // Wake up add_task() if it is waiting for a free slot in the queue.
+    // Wait until the queue is half empty to avoid waking it up for every task.
+
+    if (pool->num_threads_waiting_for_space > 0 &&
+        pool->tasks.approximate_size() <= THREAD_POOL_QUEUE_SIZE/2) {
+      de265_mutex_lock(&pool->mutex);
+      de265_cond_signal(&pool->cond_var_space);
+      de265_mutex_unlock(&pool->mutex);
+    }
 
 
     // execute the task
 
-    task->work();
+    de265_sync_add_and_fetch(&pool->num_threads_working, 1);
 
-    // end processing and check if this was the last task to be processed
+    //printblks(pool);
 
-    de265_mutex_lock(&pool->mutex);
+#ifdef DE265_TRACE
+    task->trace_start_time = trace_recorder::now();
+#endif
 
-    pool->num_threads_working--;
+    task->work();
+
+    de265_sync_sub_and_fetch(&pool->num_threads_working, 1);
   }
-  de265_mutex_unlock(&pool->mutex);
 
   return NULL;
 }
@@ -246,20 +452,24 @@ de265_error start_thread_pool(thread_pool* pool, int num_threads)
 {
   de265_error err = DE265_OK;
 
-  // limit number of threads to maximum
+  // allocate per-thread state
 
-  if (num_threads > MAX_THREADS) {
-    num_threads = MAX_THREADS;
-    err = DE265_WARNING_NUMBER_OF_THREADS_LIMITED_TO_MAXIMUM;
-  }
+  pool->thread.resize(num_threads);
+  pool->ctbx.assign(num_threads, 0);
+  pool->ctby.assign(num_threads, 0);
 
   pool->num_threads = 0; // will be increased below
 
   de265_mutex_init(&pool->mutex);
   de265_cond_init(&pool->cond_var);
+  de265_cond_init(&pool->cond_var_space);
+
+  pool->tasks.init(THREAD_POOL_QUEUE_SIZE);
 
   de265_mutex_lock(&pool->mutex);
   pool->num_threads_working = 0;
+  pool->num_threads_idle = 0;
+  pool->num_threads_waiting_for_space = 0;
   pool->stopped = false;
   de265_mutex_unlock(&pool->mutex);
 
@@ -282,10 +492,11 @@ de265_error start_thread_pool(thread_pool* pool, int num_threads)
 void stop_thread_pool(thread_pool* pool)
 {
   de265_mutex_lock(&pool->mutex);
-  pool->stopped = true;
+  de265_sync_store_release(&pool->stopped, true);
   de265_mutex_unlock(&pool->mutex);
 
   de265_cond_broadcast(&pool->cond_var, &pool->mutex);
+  de265_cond_broadcast(&pool->cond_var_space, &pool->mutex);
 
   for (int i=0;i<pool->num_threads;i++) {
     de265_thread_join(pool->thread[i]);
@@ -294,21 +505,45 @@ void stop_thread_pool(thread_pool* pool)
 
   de265_mutex_destroy(&pool->mutex);
   de265_cond_destroy(&pool->cond_var);
+  de265_cond_destroy(&pool->cond_var_space);
 }
 
 
 void   add_task(thread_pool* pool, thread_task* task)
 {
-  de265_mutex_lock(&pool->mutex);
-  if (!pool->stopped) {
+  if (de265_sync_load_acquire(&pool->stopped)) {
+    return;
+  }
 
-    pool->tasks.push_back(task);
+  if (!pool->tasks.try_push(task)) {
+    // The queue is full. Wait until a worker has taken a task out of the queue.
 
-    // wake up one thread
+    de265_mutex_lock(&pool->mutex);
+    de265_sync_add_and_fetch(&pool->num_threads_waiting_for_space, 1);
+
+    bool added;
+    while (!(added = pool->tasks.try_push(task)) &&
+           !de265_sync_load_acquire(&pool->stopped)) {
+      de265_cond_wait(&pool->cond_var_space, &pool->mutex);
+    }
+
+    de265_sync_sub_and_fetch(&pool->num_threads_waiting_for_space, 1);
+    de265_mutex_unlock(&pool->mutex);
 
+    if (!added) {
+      return;
+    }
+  }
+
+  // wake up one thread if there are sleeping ones
+
+  de265_sync_memory_barrier();
+
+  if (de265_sync_load_acquire(&pool->num_threads_idle) > 0) {
+    de265_mutex_lock(&pool->mutex);
     de265_cond_signal(&pool->cond_var);
+    de265_mutex_unlock(&pool->mutex);
   }
-  de265_mutex_unlock(&pool->mutex);
 }
 
 extern inline int de265_sync_sub_and_fetch(de265_sync_int* cnt, int n);
@@ -22,6 +22,7 @@
 #define DE265_THREADS_H
 
 #include "libde265/de265.h"
+#include "libde265/alloc_pool.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -33,6 +34,7 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 #ifndef _WIN32
 #include <pthread.h>
@@ -101,7 +103,62 @@ inline int de265_sync_add_and_fetch(de265_sync_int* cnt, int n)
 #endif
 }
 
+inline bool de265_sync_bool_compare_and_swap(de265_sync_int* cnt, long oldval, long newval)
+{
+#ifdef _WIN32
+  return InterlockedCompareExchange(cnt, newval, oldval) == oldval;
+#else
+  return __sync_bool_compare_and_swap(cnt, oldval, newval);
+#endif
+}
 
+inline void de265_sync_memory_barrier()
+{
+#ifdef _WIN32
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+// Reads a value such that later memory accesses cannot be moved before the read.
+inline long de265_sync_load_acquire(const de265_sync_int* cnt)
+{
+#ifdef _WIN32
+  return *cnt; // volatile reads have acquire semantics in MSVC
+#elif defined(__ATOMIC_ACQUIRE)
+  return __atomic_load_n(cnt, __ATOMIC_ACQUIRE);
+#else
+  long value = *cnt;
+  __sync_synchronize();
+  return value;
+#endif
+}
+
+// Writes a value such that earlier memory accesses cannot be moved after the write.
+inline void de265_sync_store_release(de265_sync_int* cnt, long value)
+{
+#ifdef _WIN32
+  *cnt = value; // volatile writes have release semantics in MSVC
+#elif defined(__ATOMIC_RELEASE)
+  __atomic_store_n(cnt, value, __ATOMIC_RELEASE);
+#else
+  __sync_synchronize();
+  *cnt = value;
+#endif
+}
+
+
+#if defined(__linux__)
+#define DE265_USE_FUTEX 1
+#endif
+
+
+/* A progress counter that threads can wait for.
+   The counter is an atomic integer. Checking or advancing it does not lock anything.
+   A thread waiting for progress spins shortly before it goes to sleep. It sleeps on a
+   futex on Linux, and on a condition variable on other systems.
+ */
 class de265_progress_lock
 {
 public:
@@ -111,16 +168,26 @@ public:
   void wait_for_progress(int progress);
   void set_progress(int progress);
   void increase_progress(int progress);
-  int  get_progress() const;
-  void reset(int value=0) { mProgress=value; }
+  int  get_progress() const { return de265_sync_load_acquire(&mProgress); }
+  void reset(int value=0) { de265_sync_store_release(&mProgress, value); } // only when no thread is waiting
 
 private:
-  int mProgress;
+  de265_sync_int mProgress;
+  de265_sync_int mNumWaiters;
+
+  void wake_waiters();
 
   // private data
 
+#ifdef DE265_USE_FUTEX
+  volatile int mWakeups; // futex word, incremented on each wake-up
+#else
   de265_mutex mutex;
   de265_cond  cond;
+#endif
+
+  de265_progress_lock(const de265_progress_lock&); // no copy
+  de265_progress_lock& operator=(const de265_progress_lock&); // no copy
 };
 
 
@@ -136,10 +203,81 @@ public:
   virtual void work() = 0;
 
   virtual std::string name() const { return "noname"; }
+
+  // for the timing trace: kind of task and the CTB (row) it starts at
+  virtual void get_trace_info(const char** name, int* ctbX, int* ctbY) const {
+    *name = "task"; *ctbX = *ctbY = -1;
+  }
+
+#ifdef DE265_TRACE
+  int64_t trace_start_time; // set when a worker thread starts the task
+#endif
+
+  /* Tasks can be recycled through an alloc_pool:
+       task = new(pool) thread_task_xyz;
+       ...
+       thread_task::delete_task(task, pool);
+   */
+  static void* operator new(size_t size) { return ::operator new(size); }
+  static void* operator new(size_t size, alloc_pool& pool) { return pool.new_obj(size); }
+  static void  operator delete(void* obj) { ::operator delete(obj); }
+  static void  operator delete(void* obj, alloc_pool& pool) { pool.delete_obj(obj); }
+
+  static void delete_task(thread_task* task, alloc_pool& pool) {
+    task->~thread_task();
+    pool.delete_obj(task);
+  }
+};
+
+
+// large enough for all decoder tasks, larger tasks are allocated from the heap
+#define THREAD_TASK_POOL_OBJECT_SIZE 64
+
+
+/* Lock-free FIFO queue for tasks with multiple producers and consumers.
+   It is a ring buffer of fixed size in which each slot carries a sequence number
+   that tells whether it is ready for pushing or popping in the current round.
+
+   Note: the decoder relies on tasks being started in the order in which they were
+   added, because tasks block while waiting for earlier tasks. Hence, we cannot use
+   per-thread queues with work-stealing, which would run tasks out of order.
+ */
+class thread_task_queue
+{
+ public:
+  thread_task_queue();
+  ~thread_task_queue();
+
+  void init(int capacity); // capacity must be a power of two
+
+  bool         try_push(thread_task*); // false if the queue is full
+  thread_task* try_pop();              // NULL if the queue is empty
+
+  int approximate_size() const {
+    return (int)((unsigned long)de265_sync_load_acquire(&push_pos) -
+                 (unsigned long)de265_sync_load_acquire(&pop_pos));
+  }
+
+ private:
+  struct slot {
+    de265_sync_int sequence;
+    thread_task*   task;
+  };
+
+  slot* slots;
+  int   mask;
+
+  // keep producer and consumer positions in separate cache lines
+  de265_sync_int push_pos;
+  char padding[64];
+  de265_sync_int pop_pos;
+
+  thread_task_queue(const thread_task_queue&); // no copy
+  thread_task_queue& operator=(const thread_task_queue&); // no copy
 };
 
 
-#define MAX_THREADS 32
+#define THREAD_POOL_QUEUE_SIZE 4096
 
 /* TODO NOTE: When unblocking a task, we have to check first
    if there are threads waiting because of the run-count limit.
@@ -150,20 +288,26 @@ public:
 class thread_pool
 {
  public:
-  bool stopped;
+  de265_sync_int stopped; // read without the mutex by the workers and add_task()
 
-  std::deque<thread_task*> tasks;  // we are not the owner
+  thread_task_queue tasks;  // we are not the owner
 
-  de265_thread thread[MAX_THREADS];
+  std::vector<de265_thread> thread; // sized by start_thread_pool()
   int num_threads;
 
-  int num_threads_working;
+  de265_sync_int num_threads_working;
+
+  /* Threads only take the mutex when they have to sleep, either because there
+     is no task (workers) or because the queue is full (add_task()). */
+  de265_sync_int num_threads_idle;
+  de265_sync_int num_threads_waiting_for_space;
 
-  int ctbx[MAX_THREADS]; // the CTB the thread is working on
-  int ctby[MAX_THREADS];
+  std::vector<int> ctbx; // the CTB the thread is working on
+  std::vector<int> ctby;
 
   de265_mutex  mutex;
-  de265_cond   cond_var;
+  de265_cond   cond_var;        // signalled when a task has been added
+  de265_cond   cond_var_space;  // signalled when a task has been removed from a full queue
 };
 
 
@@ -0,0 +1,128 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+
+#ifdef DE265_TRACE
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+
+static long current_thread_id()
+{
+#ifdef _WIN32
+  return GetCurrentThreadId();
+#elif defined(__linux__)
+  return syscall(SYS_gettid);
+#else
+  return (long)(size_t)pthread_self();
+#endif
+}
+
+
+trace_recorder::trace_recorder()
+{
+  enabled = false;
+  time_origin = now();
+
+  de265_mutex_init(&mutex);
+}
+
+trace_recorder::~trace_recorder()
+{
+  de265_mutex_destroy(&mutex);
+}
+
+
+int64_t trace_recorder::now()
+{
+#ifdef _WIN32
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (int64_t)(count.QuadPart * 1000000 / freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+
+void trace_recorder::add_event(const char* name, int poc, int ctbX, int ctbY,
+                               int64_t start, int64_t end)
+{
+  trace_event event;
+  event.name   = name;
+  event.start  = start;
+  event.end    = end;
+  event.thread = current_thread_id();
+  event.poc    = poc;
+  event.ctbX   = ctbX;
+  event.ctbY   = ctbY;
+
+  de265_mutex_lock(&mutex);
+  events.push_back(event);
+  de265_mutex_unlock(&mutex);
+}
+
+
+void trace_recorder::clear()
+{
+  de265_mutex_lock(&mutex);
+  events.clear();
+  de265_mutex_unlock(&mutex);
+}
+
+
+/* Each event is written as a "complete event" (ph:X) with timestamps in microseconds.
+   All events are in one process, the threads are identified by their system id.
+ */
+void trace_recorder::write_chrome_json(FILE* fh) const
+{
+  de265_mutex_lock(&mutex);
+
+  fprintf(fh,"{\"traceEvents\":[\n");
+
+  for (size_t i=0;i<events.size();i++) {
+    const trace_event& e = events[i];
+
+    fprintf(fh,"{\"name\":\"%s\",\"cat\":\"libde265\",\"ph\":\"X\",\"pid\":1,\"tid\":%ld,"
+            "\"ts\":%lld,\"dur\":%lld,\"args\":{\"poc\":%d,\"ctb_x\":%d,\"ctb_y\":%d}}%s\n",
+            e.name, e.thread,
+            (long long)(e.start - time_origin), (long long)(e.end - e.start),
+            e.poc, e.ctbX, e.ctbY,
+            i+1<events.size() ? "," : "");
+  }
+
+  fprintf(fh,"],\"displayTimeUnit\":\"ms\"}\n");
+
+  de265_mutex_unlock(&mutex);
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DE265_TRACE_H
+#define DE265_TRACE_H
+
+#include "libde265/threads.h"
+
+#include <stdio.h>
+#include <vector>
+
+/* Timing trace of the decoding stages, only compiled in with DE265_TRACE.
+
+   When enabled (DE265_DECODER_PARAM_TRACE), each task of the thread pool and the
+   per-picture stages are recorded with their start and end time, the thread they
+   ran on, and the picture and CTB they worked on. The record can be saved as
+   Chrome trace JSON (see de265_write_trace()) and viewed in chrome://tracing or
+   https://ui.perfetto.dev .
+ */
+
+#ifdef DE265_TRACE
+
+struct trace_event
+{
+  const char* name; // static string
+  int64_t start, end; // microseconds
+  long thread;
+  int  poc;
+  int  ctbX, ctbY;  // -1 if the stage does not work on a specific CTB (row)
+};
+
+
+class trace_recorder
+{
+ public:
+  trace_recorder();
+  ~trace_recorder();
+
+  void set_enabled(bool flag) { enabled = flag; }
+  bool is_enabled() const { return enabled; }
+
+  static int64_t now(); // microseconds
+
+  // may be called from any thread
+  void add_event(const char* name, int poc, int ctbX, int ctbY, int64_t start, int64_t end);
+
+  void write_chrome_json(FILE*) const;
+  void clear();
+
+ private:
+  bool enabled;
+  int64_t time_origin;
+
+  std::vector<trace_event> events;
+  mutable de265_mutex mutex;
+
+  trace_recorder(const trace_recorder&); // no copy
+  trace_recorder& operator=(const trace_recorder&); // no copy
+};
+
+
+// records the time from its construction until the end of the scope
+class trace_scope
+{
+ public:
+  trace_scope(trace_recorder* r, const char* _name, int _poc, int _ctbX, int _ctbY)
+    : recorder(r->is_enabled() ? r : NULL),
+      name(_name), poc(_poc), ctbX(_ctbX), ctbY(_ctbY)
+  {
+    if (recorder) { start = trace_recorder::now(); }
+  }
+
+  ~trace_scope() {
+    if (recorder) { recorder->add_event(name, poc, ctbX, ctbY, start, trace_recorder::now()); }
+  }
+
+ private:
+  trace_recorder* recorder;
+  const char* name;
+  int poc, ctbX, ctbY;
+  int64_t start;
+};
+
+#define DE265_TRACE_SCOPE(recorder, name, poc, ctbX, ctbY) \
+  trace_scope trace_scope_instance(recorder, name, poc, ctbX, ctbY)
+
+#else
+
+#define DE265_TRACE_SCOPE(recorder, name, poc, ctbX, ctbY)
+
+#endif
+
+#endif
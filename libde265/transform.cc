@@ -67,10 +67,11 @@ void decode_quantization_parameters(thread_context* tctx, int xC,int yC,
 
   int qPY_PRED;
 
-  // first QG in CTB row ?
+  // first QG in CTB row (within the tile) ?
 
   int ctbLSBMask = ((1<<sps->Log2CtbSizeY)-1);
-  bool firstInCTBRow = (xQG == 0 && ((yQG & ctbLSBMask)==0));
+  bool firstInCTBRow = ((xQG & ctbLSBMask)==0 && (yQG & ctbLSBMask)==0 &&
+                        pps->is_tile_column_start(xQG >> sps->Log2CtbSizeY));
 
   // first QG in slice ?    TODO: a "firstQG" flag in the thread context would be faster
 
@@ -201,24 +202,39 @@ void decode_quantization_parameters(thread_context* tctx, int xC,int yC,
 
 
 
+/* 'extent' is the size of the top-left square that contains all non-zero coefficients
+   (4, 8, 16, or 32), or 0 if the block only has a DC coefficient.
+ */
 template <class pixel_t>
 void transform_coefficients(acceleration_functions* acceleration,
                             int16_t* coeff, int coeffStride, int nT, int trType,
-                            pixel_t* dst, int dstStride, int bit_depth)
+                            pixel_t* dst, int dstStride, int bit_depth, int extent)
 {
-  logtrace(LogTransform,"transform --- trType: %d nT: %d\n",trType,nT);
+  logtrace(LogTransform,"transform --- trType: %d nT: %d extent: %d\n",trType,nT,extent);
 
 
   if (trType==1) {
 
     acceleration->transform_4x4_dst_add<pixel_t>(dst, coeff, dstStride, bit_depth);
 
+  } else if (extent==0) {
+
+    acceleration->transform_add_dc<pixel_t>(dst, dstStride, coeff[0], nT, bit_depth);
+
   } else {
 
-    /**/ if (nT==4)  { acceleration->transform_add<pixel_t>(0,dst,coeff,dstStride, bit_depth); }
-    else if (nT==8)  { acceleration->transform_add<pixel_t>(1,dst,coeff,dstStride, bit_depth); }
-    else if (nT==16) { acceleration->transform_add<pixel_t>(2,dst,coeff,dstStride, bit_depth); }
-    else             { acceleration->transform_add<pixel_t>(3,dst,coeff,dstStride, bit_depth); }
+    int sizeIdx;
+    /**/ if (nT==4)  { sizeIdx=0; }
+    else if (nT==8)  { sizeIdx=1; }
+    else if (nT==16) { sizeIdx=2; }
+    else             { sizeIdx=3; }
+
+    if (extent<nT) {
+      acceleration->transform_add_sparse<pixel_t>(sizeIdx,dst,coeff,dstStride, extent, bit_depth);
+    }
+    else {
+      acceleration->transform_add<pixel_t>(sizeIdx,dst,coeff,dstStride, bit_depth);
+    }
   }
 
 #if 0
@@ -389,8 +405,9 @@ void scale_coefficients_internal(thread_context* tctx,
   // can optimize away a lot of code for 8-bit pixels.
   const int bit_depth = ((sizeof(pixel_t)==1) ? 8 : sps->get_bit_depth(cIdx));
 
-  //assert(intra == (tctx->img->get_pred_mode(xT,yT)==MODE_INTRA));
-  int cuPredModeIntra = (tctx->img->get_pred_mode(xT,yT)==MODE_INTRA);
+  // 'intra' is the prediction mode of the CU. We cannot look it up at (xT;yT), because
+  // for chroma, these are not luma coordinates and would address a different CU.
+  int cuPredModeIntra = intra;
 
   bool rotateCoeffs = (sps->range_extension.transform_skip_rotation_enabled_flag &&
                        nT == 4 &&
@@ -598,8 +615,28 @@ void scale_coefficients_internal(thread_context* tctx,
                                         pred, stride, bit_depth, cIdx);
       }
       else {
+        // Find the top-left square that contains all coefficients. The extent of the
+        // inverse transform can be reduced to it.
+
+        int extent;
+        if (tctx->nCoeff[cIdx]==1 && tctx->coeffPos[cIdx][0]==0) {
+          extent = 0;
+        }
+        else {
+          const int log2nT = Log2(nT);
+
+          int xyMask = 0;
+          for (int i=0;i<tctx->nCoeff[cIdx];i++) {
+            int pos = tctx->coeffPos[cIdx][i];
+            xyMask |= (pos & (nT-1)) | (pos >> log2nT);
+          }
+
+          extent = 4;
+          while (extent <= xyMask) { extent *= 2; }
+        }
+
         transform_coefficients(&tctx->decctx->acceleration, coeff, coeffStride, nT, trType,
-                               pred, stride, bit_depth);
+                               pred, stride, bit_depth, extent);
       }
     }
   }
@@ -0,0 +1,699 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "avx2-dct.h"
+#include "sse-dct.h"
+#include "libde265/util.h"
+#include "libde265/fallback-dct.h"
+
+
+/* Residual reconstruction for samples with more than 8 bits, 16 samples per iteration.
+   Blocks smaller than 16x16 are passed to the SSE kernels. */
+
+
+void ff_hevc_add_residual_16_avx2(uint16_t *dst, ptrdiff_t stride,
+                                  const int32_t* r, int nT, int bit_depth)
+{
+  if (nT<16) {
+    ff_hevc_add_residual_16_sse4(dst,stride, r,nT, bit_depth);
+    return;
+  }
+
+  const __m256i maxval = _mm256_set1_epi16((1<<bit_depth)-1);
+
+  for (int y=0;y<nT;y++) {
+    for (int x=0;x<nT;x+=16) {
+      __m256i d  = _mm256_loadu_si256((const __m256i*)&dst[y*stride+x]);
+      __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(d));
+      __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(d,1));
+
+      lo = _mm256_add_epi32(lo, _mm256_loadu_si256((const __m256i*)&r[y*nT+x]));
+      hi = _mm256_add_epi32(hi, _mm256_loadu_si256((const __m256i*)&r[y*nT+x+8]));
+
+      // the pack interleaves the lanes, reorder them to 0,1,2,3
+
+      d = _mm256_permute4x64_epi64(_mm256_packus_epi32(lo,hi), 0xD8);
+      _mm256_storeu_si256((__m256i*)&dst[y*stride+x], _mm256_min_epu16(d, maxval));
+    }
+  }
+}
+
+
+static inline __m256i matrix_pair(int m0, int m1)
+{
+  return _mm256_set1_epi32((int)(((uint32_t)(uint16_t)m1<<16) | (uint16_t)m0));
+}
+
+
+/* Same computation as transform_idct_add() in sse-dct-16.cc.
+   Because the 32-bit sums of both the vertical and the horizontal pass are computed
+   and packed lane by lane, all samples stay in their natural order.
+   All coefficients after 'lastRow' and 'lastCol' must be zero.
+   With pixel_t==int32_t, the residual is written to 'dst' instead of being added. */
+
+template <class pixel_t, int nT>
+static void transform_idct_add(pixel_t *dst, ptrdiff_t stride, const int16_t *coeffs,
+                               int lastRow, int lastCol, int bit_depth)
+{
+  const int fact = 32/nT;
+
+  // --- vertical pass ---
+
+  ALIGNED_32(int16_t g[nT*nT]);
+
+  const __m256i rnd1 = _mm256_set1_epi32(1<<6);
+
+  for (int c=0;c<=lastCol;c+=16) {
+    for (int i=0;i<nT;i++) {
+      __m256i lo = _mm256_setzero_si256();
+      __m256i hi = _mm256_setzero_si256();
+
+      for (int j=0;j<=lastRow;j+=2) {
+        __m256i m = matrix_pair(mat_dct[fact*j][i], mat_dct[fact*(j+1)][i]);
+        __m256i a = _mm256_loadu_si256((const __m256i*)&coeffs[ j   *nT+c]);
+        __m256i b = _mm256_loadu_si256((const __m256i*)&coeffs[(j+1)*nT+c]);
+
+        lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a,b), m));
+        hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a,b), m));
+      }
+
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, rnd1), 7);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, rnd1), 7);
+      _mm256_store_si256((__m256i*)&g[i*nT+c], _mm256_packs_epi32(lo,hi));
+    }
+  }
+
+
+  // --- horizontal pass ---
+
+  __m256i mpairs[nT/2][nT/8];
+
+  for (int j=0;j<=lastCol;j+=2) {
+    for (int i=0;i<nT;i+=16) {
+      __m256i m0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)&mat_dct[fact* j   ][i]));
+      __m256i m1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)&mat_dct[fact*(j+1)][i]));
+
+      mpairs[j/2][i/8  ] = _mm256_unpacklo_epi16(m0,m1);
+      mpairs[j/2][i/8+1] = _mm256_unpackhi_epi16(m0,m1);
+    }
+  }
+
+  const int postShift = 20-bit_depth;
+  const __m256i rnd2   = _mm256_set1_epi32(1<<(postShift-1));
+  const __m128i shift  = _mm_cvtsi32_si128(postShift);
+  const __m256i maxval = _mm256_set1_epi16((1<<bit_depth)-1);
+  const __m256i zero   = _mm256_setzero_si256();
+
+  for (int y=0;y<nT;y++) {
+
+    // sums for the whole row, in the (lane-wise) order of the unpacked matrix pairs
+
+    __m256i sum[nT/8];
+    for (int k=0;k<nT/8;k++) { sum[k] = _mm256_setzero_si256(); }
+
+    for (int j=0;j<=lastCol;j+=2) {
+      int32_t pair;
+      memcpy(&pair, &g[y*nT+j], sizeof(pair));
+      __m256i gg = _mm256_set1_epi32(pair);
+
+      for (int k=0;k<nT/8;k++) {
+        sum[k] = _mm256_add_epi32(sum[k], _mm256_madd_epi16(gg, mpairs[j/2][k]));
+      }
+    }
+
+    for (int i=0;i<nT;i+=16) {
+      __m256i lo = _mm256_sra_epi32(_mm256_add_epi32(sum[i/8  ], rnd2), shift);
+      __m256i hi = _mm256_sra_epi32(_mm256_add_epi32(sum[i/8+1], rnd2), shift);
+
+      pixel_t* out = &dst[y*stride+i];
+
+      if (sizeof(pixel_t)==4) {
+        _mm256_storeu_si256((__m256i*)&out[0], _mm256_permute2x128_si256(lo,hi, 0x20));
+        _mm256_storeu_si256((__m256i*)&out[8], _mm256_permute2x128_si256(lo,hi, 0x31));
+      }
+      else if (sizeof(pixel_t)==1) {
+        __m256i d = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)out));
+        lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(d, zero));
+        hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(d, zero));
+
+        __m256i v = _mm256_packs_epi32(lo,hi);
+        _mm_storeu_si128((__m128i*)out, _mm_packus_epi16(_mm256_castsi256_si128(v),
+                                                         _mm256_extracti128_si256(v,1)));
+      }
+      else {
+        __m256i d = _mm256_loadu_si256((const __m256i*)out);
+        lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(d, zero));
+        hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(d, zero));
+
+        _mm256_storeu_si256((__m256i*)out, _mm256_min_epu16(_mm256_packus_epi32(lo,hi), maxval));
+      }
+    }
+  }
+}
+
+
+/* Full blocks: restrict the transform to the non-zero part first. */
+
+template <class pixel_t, int nT>
+static void transform_idct_add(pixel_t *dst, ptrdiff_t stride,
+                               const int16_t *coeffs, int bit_depth)
+{
+  // last row and column that contain a non-zero coefficient
+
+  __m256i colOr[nT/16];
+  for (int i=0;i<nT/16;i++) { colOr[i] = _mm256_setzero_si256(); }
+
+  int lastRow = -1;
+  for (int y=0;y<nT;y++) {
+    __m256i rowOr = _mm256_setzero_si256();
+    for (int x=0;x<nT;x+=16) {
+      __m256i c = _mm256_loadu_si256((const __m256i*)&coeffs[y*nT+x]);
+      rowOr = _mm256_or_si256(rowOr, c);
+      colOr[x/16] = _mm256_or_si256(colOr[x/16], c);
+    }
+
+    if (!_mm256_testz_si256(rowOr,rowOr)) { lastRow=y; }
+  }
+
+  if (lastRow<0) {
+    if (sizeof(pixel_t)==4) {
+      for (int y=0;y<nT;y++) { memset(&dst[y*stride], 0, nT*sizeof(pixel_t)); }
+    }
+
+    return;
+  }
+
+  ALIGNED_32(uint16_t cols[nT]);
+  for (int i=0;i<nT/16;i++) {
+    _mm256_store_si256((__m256i*)&cols[i*16], colOr[i]);
+  }
+
+  int lastCol=nT-1;
+  while (cols[lastCol]==0) { lastCol--; }
+
+  transform_idct_add<pixel_t,nT>(dst,stride, coeffs, lastRow,lastCol, bit_depth);
+}
+
+
+void ff_hevc_transform_16x16_add_16_avx2(uint16_t *dst, const int16_t *coeffs,
+                                         ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add<uint16_t,16>(dst,stride, coeffs, bit_depth);
+}
+
+void ff_hevc_transform_32x32_add_16_avx2(uint16_t *dst, const int16_t *coeffs,
+                                         ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add<uint16_t,32>(dst,stride, coeffs, bit_depth);
+}
+
+
+/* See ff_hevc_transform_32x32_add_sparse_8_sse4(). */
+
+void ff_hevc_transform_32x32_add_sparse_8_avx2(uint8_t *dst, const int16_t *coeffs,
+                                               ptrdiff_t stride, int extent)
+{
+  if (extent > 16) {
+    ff_hevc_transform_32x32_add_8_sse4(dst, coeffs, stride);
+  }
+  else {
+    transform_idct_add<uint8_t,32>(dst,stride, coeffs, extent-1,extent-1, 8);
+  }
+}
+
+
+void ff_hevc_transform_16x16_add_sparse_16_avx2(uint16_t *dst, const int16_t *coeffs,
+                                                ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t,16>(dst,stride, coeffs, extent-1,extent-1, bit_depth);
+}
+
+void ff_hevc_transform_32x32_add_sparse_16_avx2(uint16_t *dst, const int16_t *coeffs,
+                                                ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t,32>(dst,stride, coeffs, extent-1,extent-1, bit_depth);
+}
+
+
+// --- residuals for cross-component prediction ---
+
+/* The vertical pass saturates to 16 bits, hence only max_coeff_bits==15 is supported.
+   The postShift of the horizontal pass is bdShift = 20-bit_depth. */
+
+void transform_idct_16x16_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_16x16_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  transform_idct_add<int32_t,16>(dst,16, coeffs, 20-bdShift);
+}
+
+void transform_idct_32x32_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_32x32_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  transform_idct_add<int32_t,32>(dst,32, coeffs, 20-bdShift);
+}
+
+
+// --- 4x4 DCT and DST ---
+
+/* The complete 4x4 block is transformed in registers. Two rows are processed
+   per register, one in each 128-bit lane. The result is returned as 32-bit values,
+   rows 0 and 1 in 'r01', rows 2 and 3 in 'r23'. */
+
+static inline __m256i lane_pairs(int a0,int b0, int a1,int b1)
+{
+  __m128i lo = _mm_set1_epi32((int)(((uint32_t)(uint16_t)b0<<16) | (uint16_t)a0));
+  __m128i hi = _mm_set1_epi32((int)(((uint32_t)(uint16_t)b1<<16) | (uint16_t)a1));
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+static inline __m256i row_pairs(const int8_t* m0, const int8_t* m1)
+{
+  __m128i p = _mm_unpacklo_epi16(_mm_cvtepi8_epi16(_mm_cvtsi32_si128(*(const int32_t*)m0)),
+                                 _mm_cvtepi8_epi16(_mm_cvtsi32_si128(*(const int32_t*)m1)));
+  return _mm256_broadcastsi128_si256(p);
+}
+
+static inline void transform_4x4(const int16_t *coeffs, const int8_t* mat, int matStride,
+                                 int postShift, __m256i* r01, __m256i* r23)
+{
+  // matrix row j starts at mat[j*matStride]
+
+  const int8_t* m0 = &mat[0*matStride];
+  const int8_t* m1 = &mat[1*matStride];
+  const int8_t* m2 = &mat[2*matStride];
+  const int8_t* m3 = &mat[3*matStride];
+
+
+  // --- vertical pass ---
+
+  __m128i c01 = _mm_loadu_si128((const __m128i*)&coeffs[0]);
+  __m128i c23 = _mm_loadu_si128((const __m128i*)&coeffs[8]);
+
+  // interleaved pairs of coefficient rows (0,1) and (2,3), in both lanes
+
+  __m256i a = _mm256_broadcastsi128_si256(_mm_unpacklo_epi16(c01, _mm_srli_si128(c01,8)));
+  __m256i b = _mm256_broadcastsi128_si256(_mm_unpacklo_epi16(c23, _mm_srli_si128(c23,8)));
+
+  __m256i g01 = _mm256_add_epi32(_mm256_madd_epi16(a, lane_pairs(m0[0],m1[0], m0[1],m1[1])),
+                                 _mm256_madd_epi16(b, lane_pairs(m2[0],m3[0], m2[1],m3[1])));
+  __m256i g23 = _mm256_add_epi32(_mm256_madd_epi16(a, lane_pairs(m0[2],m1[2], m0[3],m1[3])),
+                                 _mm256_madd_epi16(b, lane_pairs(m2[2],m3[2], m2[3],m3[3])));
+
+  const __m256i rnd1 = _mm256_set1_epi32(1<<6);
+  g01 = _mm256_srai_epi32(_mm256_add_epi32(g01, rnd1), 7);
+  g23 = _mm256_srai_epi32(_mm256_add_epi32(g23, rnd1), 7);
+
+  // saturating pack == Clip3(-32768,32767, ...), lanes hold rows (0,2) and (1,3)
+
+  __m256i g = _mm256_packs_epi32(g01,g23);
+
+
+  // --- horizontal pass ---
+
+  const __m256i h0 = row_pairs(m0,m1);
+  const __m256i h1 = row_pairs(m2,m3);
+
+  __m256i s01 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(g, 0x00), h0),
+                                 _mm256_madd_epi16(_mm256_shuffle_epi32(g, 0x55), h1));
+  __m256i s23 = _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi32(g, 0xAA), h0),
+                                 _mm256_madd_epi16(_mm256_shuffle_epi32(g, 0xFF), h1));
+
+  const __m256i rnd2  = _mm256_set1_epi32(1<<(postShift-1));
+  const __m128i shift = _mm_cvtsi32_si128(postShift);
+
+  *r01 = _mm256_sra_epi32(_mm256_add_epi32(s01, rnd2), shift);
+  *r23 = _mm256_sra_epi32(_mm256_add_epi32(s23, rnd2), shift);
+}
+
+
+static inline void add_4x4_8(uint8_t *dst, ptrdiff_t stride, __m256i r01, __m256i r23)
+{
+  int32_t p[4];
+  for (int y=0;y<4;y++) { memcpy(&p[y], &dst[y*stride], 4); }
+
+  r01 = _mm256_add_epi32(r01, _mm256_cvtepu8_epi32(_mm_insert_epi32(_mm_cvtsi32_si128(p[0]), p[1], 1)));
+  r23 = _mm256_add_epi32(r23, _mm256_cvtepu8_epi32(_mm_insert_epi32(_mm_cvtsi32_si128(p[2]), p[3], 1)));
+
+  // lanes hold rows (0,2) and (1,3)
+
+  __m256i v = _mm256_packs_epi32(r01,r23);
+  v = _mm256_packus_epi16(v,v);
+
+  __m128i v02 = _mm256_castsi256_si128(v);
+  __m128i v13 = _mm256_extracti128_si256(v,1);
+
+  p[0] = _mm_cvtsi128_si32(v02);
+  p[1] = _mm_cvtsi128_si32(v13);
+  p[2] = _mm_extract_epi32(v02,1);
+  p[3] = _mm_extract_epi32(v13,1);
+
+  for (int y=0;y<4;y++) { memcpy(&dst[y*stride], &p[y], 4); }
+}
+
+
+static inline void add_4x4_16(uint16_t *dst, ptrdiff_t stride, __m256i r01, __m256i r23,
+                              int bit_depth)
+{
+  __m128i p01 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&dst[0*stride]),
+                                   _mm_loadl_epi64((const __m128i*)&dst[1*stride]));
+  __m128i p23 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&dst[2*stride]),
+                                   _mm_loadl_epi64((const __m128i*)&dst[3*stride]));
+
+  r01 = _mm256_add_epi32(r01, _mm256_cvtepu16_epi32(p01));
+  r23 = _mm256_add_epi32(r23, _mm256_cvtepu16_epi32(p23));
+
+  // lanes hold rows (0,2) and (1,3)
+
+  __m256i v = _mm256_min_epu16(_mm256_packus_epi32(r01,r23),
+                               _mm256_set1_epi16((1<<bit_depth)-1));
+
+  __m128i v02 = _mm256_castsi256_si128(v);
+  __m128i v13 = _mm256_extracti128_si256(v,1);
+
+  _mm_storel_epi64((__m128i*)&dst[0*stride], v02);
+  _mm_storel_epi64((__m128i*)&dst[1*stride], v13);
+  _mm_storeh_pd((double*)&dst[2*stride], _mm_castsi128_pd(v02));
+  _mm_storeh_pd((double*)&dst[3*stride], _mm_castsi128_pd(v13));
+}
+
+
+/* transform_4x4_luma_add_*_fallback() clip the DST residual to 16 bits
+   (this makes a difference for 16-bit samples only). */
+
+static inline __m256i clip_residual_16(__m256i r)
+{
+  return _mm256_max_epi32(_mm256_min_epi32(r, _mm256_set1_epi32(32767)),
+                          _mm256_set1_epi32(-32768));
+}
+
+
+// the 4x4 DCT uses every 8th row of the 32x32 matrix
+
+void transform_4x4_dst_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_8_357[0][0],4, 20-8, &r01,&r23);
+  add_4x4_8(dst,stride, r01,r23);
+}
+
+void transform_4x4_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride)
+{
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_dct[0][0],8*32, 20-8, &r01,&r23);
+  add_4x4_8(dst,stride, r01,r23);
+}
+
+void transform_4x4_dst_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                   int bit_depth)
+{
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_8_357[0][0],4, 20-bit_depth, &r01,&r23);
+  add_4x4_16(dst,stride, clip_residual_16(r01),clip_residual_16(r23), bit_depth);
+}
+
+void transform_4x4_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                               int bit_depth)
+{
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_dct[0][0],8*32, 20-bit_depth, &r01,&r23);
+  add_4x4_16(dst,stride, r01,r23, bit_depth);
+}
+
+void transform_idst_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idst_4x4_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_8_357[0][0],4, bdShift, &r01,&r23);
+  _mm256_storeu_si256((__m256i*)&dst[0], r01);
+  _mm256_storeu_si256((__m256i*)&dst[8], r23);
+}
+
+void transform_idct_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_4x4_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  __m256i r01,r23;
+  transform_4x4(coeffs, &mat_dct[0][0],8*32, bdShift, &r01,&r23);
+  _mm256_storeu_si256((__m256i*)&dst[0], r01);
+  _mm256_storeu_si256((__m256i*)&dst[8], r23);
+}
+
+
+// --- transform skip, RDPCM, and bypass residuals ---
+
+/* The coefficients and the residual are both stored without padding, so
+   all nT*nT >= 16 values can be processed in consecutive groups of eight. */
+
+static inline __m256i load_coeffs_epi32(const int16_t* coeffs)
+{
+  return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)coeffs));
+}
+
+static inline __m256i scale_ts(__m256i c, __m128i tsShift, __m256i rnd, __m128i bdShift)
+{
+  return _mm256_sra_epi32(_mm256_add_epi32(_mm256_sll_epi32(c, tsShift), rnd), bdShift);
+}
+
+/* Prefix sums within each group of 'n' (4 or 8) consecutive values. */
+
+static inline __m256i prefix_sum(__m256i v, int n)
+{
+  v = _mm256_add_epi32(v, _mm256_slli_si256(v,4));
+  v = _mm256_add_epi32(v, _mm256_slli_si256(v,8));
+
+  if (n==8) {
+    // carry the last sum of the low lane into the high lane
+    __m256i last = _mm256_shuffle_epi32(v, 0xFF);
+    v = _mm256_add_epi32(v, _mm256_permute2x128_si256(last,last, 0x08));
+  }
+
+  return v;
+}
+
+
+void transform_skip_residual_avx2(int32_t *residual, const int16_t *coeffs, int nT,
+                                  int tsShift, int bdShift)
+{
+  const __m256i rnd = _mm256_set1_epi32(1<<(bdShift-1));
+  const __m128i ts  = _mm_cvtsi32_si128(tsShift);
+  const __m128i bd  = _mm_cvtsi32_si128(bdShift);
+
+  for (int i=0;i<nT*nT;i+=8) {
+    __m256i r = scale_ts(load_coeffs_epi32(&coeffs[i]), ts, rnd, bd);
+    _mm256_storeu_si256((__m256i*)&residual[i], r);
+  }
+}
+
+
+void transform_bypass_avx2(int32_t *residual, const int16_t *coeffs, int nT)
+{
+  for (int i=0;i<nT*nT;i+=8) {
+    _mm256_storeu_si256((__m256i*)&residual[i], load_coeffs_epi32(&coeffs[i]));
+  }
+}
+
+
+/* Vertical RDPCM accumulates the rows. For nT==4, two rows are held in one register. */
+
+template <bool scale>
+static inline void rdpcm_v(int32_t* residual, const int16_t* coeffs, int nT,
+                           int tsShift, int bdShift)
+{
+  const __m256i rnd = _mm256_set1_epi32(scale ? 1<<(bdShift-1) : 0);
+  const __m128i ts  = _mm_cvtsi32_si128(tsShift);
+  const __m128i bd  = _mm_cvtsi32_si128(bdShift);
+
+  if (nT==4) {
+    __m256i r01 = load_coeffs_epi32(&coeffs[0]);
+    __m256i r23 = load_coeffs_epi32(&coeffs[8]);
+    if (scale) {
+      r01 = scale_ts(r01, ts, rnd, bd);
+      r23 = scale_ts(r23, ts, rnd, bd);
+    }
+
+    // row1 += row0, then add row1 to rows 2 and 3
+
+    r01 = _mm256_add_epi32(r01, _mm256_permute2x128_si256(r01,r01, 0x08));
+    __m256i row1 = _mm256_permute2x128_si256(r01,r01, 0x11);
+    r23 = _mm256_add_epi32(r23, _mm256_permute2x128_si256(r23,r23, 0x08));
+    r23 = _mm256_add_epi32(r23, row1);
+
+    _mm256_storeu_si256((__m256i*)&residual[0], r01);
+    _mm256_storeu_si256((__m256i*)&residual[8], r23);
+    return;
+  }
+
+  for (int x=0;x<nT;x+=8) {
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int y=0;y<nT;y++) {
+      __m256i c = load_coeffs_epi32(&coeffs[y*nT+x]);
+      if (scale) {
+        c = scale_ts(c, ts, rnd, bd);
+      }
+
+      sum = _mm256_add_epi32(sum, c);
+      _mm256_storeu_si256((__m256i*)&residual[y*nT+x], sum);
+    }
+  }
+}
+
+
+/* Horizontal RDPCM computes prefix sums along the rows. */
+
+template <bool scale>
+static inline void rdpcm_h(int32_t* residual, const int16_t* coeffs, int nT,
+                           int tsShift, int bdShift)
+{
+  const __m256i rnd = _mm256_set1_epi32(scale ? 1<<(bdShift-1) : 0);
+  const __m128i ts  = _mm_cvtsi32_si128(tsShift);
+  const __m128i bd  = _mm_cvtsi32_si128(bdShift);
+
+  if (nT==4) {
+    // each lane holds one row
+
+    for (int i=0;i<16;i+=8) {
+      __m256i c = load_coeffs_epi32(&coeffs[i]);
+      if (scale) {
+        c = scale_ts(c, ts, rnd, bd);
+      }
+
+      _mm256_storeu_si256((__m256i*)&residual[i], prefix_sum(c,4));
+    }
+
+    return;
+  }
+
+  const __m256i lastIdx = _mm256_set1_epi32(7);
+
+  for (int y=0;y<nT;y++) {
+    __m256i carry = _mm256_setzero_si256();
+
+    for (int x=0;x<nT;x+=8) {
+      __m256i c = load_coeffs_epi32(&coeffs[y*nT+x]);
+      if (scale) {
+        c = scale_ts(c, ts, rnd, bd);
+      }
+
+      __m256i sum = _mm256_add_epi32(prefix_sum(c,8), carry);
+      _mm256_storeu_si256((__m256i*)&residual[y*nT+x], sum);
+
+      carry = _mm256_permutevar8x32_epi32(sum, lastIdx);
+    }
+  }
+}
+
+
+void rdpcm_v_avx2(int32_t* residual, const int16_t* coeffs, int nT, int tsShift, int bdShift)
+{
+  rdpcm_v<true>(residual, coeffs, nT, tsShift, bdShift);
+}
+
+void rdpcm_h_avx2(int32_t* residual, const int16_t* coeffs, int nT, int tsShift, int bdShift)
+{
+  rdpcm_h<true>(residual, coeffs, nT, tsShift, bdShift);
+}
+
+void transform_bypass_rdpcm_v_avx2(int32_t *residual, const int16_t *coeffs, int nT)
+{
+  rdpcm_v<false>(residual, coeffs, nT, 0, 0);
+}
+
+void transform_bypass_rdpcm_h_avx2(int32_t *residual, const int16_t *coeffs, int nT)
+{
+  rdpcm_h<false>(residual, coeffs, nT, 0, 0);
+}
+
+
+// --- adding the residual to 8-bit samples ---
+
+void ff_hevc_add_residual_8_avx2(uint8_t *dst, ptrdiff_t stride,
+                                 const int32_t* r, int nT, int bit_depth)
+{
+  (void)bit_depth;
+
+  if (nT==4) {
+    for (int y=0;y<4;y+=2) {
+      int32_t p0,p1;
+      memcpy(&p0, &dst[ y   *stride], 4);
+      memcpy(&p1, &dst[(y+1)*stride], 4);
+
+      __m256i d = _mm256_cvtepu8_epi32(_mm_insert_epi32(_mm_cvtsi32_si128(p0), p1, 1));
+      d = _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i*)&r[y*4]));
+
+      __m128i v = _mm_packs_epi32(_mm256_castsi256_si128(d), _mm256_extracti128_si256(d,1));
+      v = _mm_packus_epi16(v,v);
+
+      p0 = _mm_cvtsi128_si32(v);
+      p1 = _mm_extract_epi32(v,1);
+      memcpy(&dst[ y   *stride], &p0, 4);
+      memcpy(&dst[(y+1)*stride], &p1, 4);
+    }
+
+    return;
+  }
+
+  if (nT==8) {
+    for (int y=0;y<8;y++) {
+      __m256i d = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&dst[y*stride]));
+      d = _mm256_add_epi32(d, _mm256_loadu_si256((const __m256i*)&r[y*8]));
+
+      __m128i v = _mm_packs_epi32(_mm256_castsi256_si128(d), _mm256_extracti128_si256(d,1));
+      _mm_storel_epi64((__m128i*)&dst[y*stride], _mm_packus_epi16(v,v));
+    }
+
+    return;
+  }
+
+  for (int y=0;y<nT;y++) {
+    for (int x=0;x<nT;x+=16) {
+      __m128i d  = _mm_loadu_si128((const __m128i*)&dst[y*stride+x]);
+      __m256i lo = _mm256_cvtepu8_epi32(d);
+      __m256i hi = _mm256_cvtepu8_epi32(_mm_srli_si128(d,8));
+
+      lo = _mm256_add_epi32(lo, _mm256_loadu_si256((const __m256i*)&r[y*nT+x]));
+      hi = _mm256_add_epi32(hi, _mm256_loadu_si256((const __m256i*)&r[y*nT+x+8]));
+
+      // the pack interleaves the lanes, reorder them to 0,1,2,3
+
+      __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo,hi), 0xD8);
+      _mm_storeu_si128((__m128i*)&dst[y*stride+x],
+                       _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v,1)));
+    }
+  }
+}
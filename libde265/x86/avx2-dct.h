@@ -0,0 +1,70 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AVX2_DCT_H
+#define AVX2_DCT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+void transform_4x4_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+void transform_4x4_dst_add_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
+
+void ff_hevc_transform_32x32_add_sparse_8_avx2(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                               int extent);
+
+void ff_hevc_add_residual_8_avx2(uint8_t *dst, ptrdiff_t stride,
+                                 const int32_t* r, int nT, int bit_depth);
+
+
+// samples with more than 8 bits
+
+void ff_hevc_add_residual_16_avx2(uint16_t *dst, ptrdiff_t stride,
+                                  const int32_t* r, int nT, int bit_depth);
+
+void ff_hevc_transform_16x16_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void ff_hevc_transform_32x32_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+void transform_4x4_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void transform_4x4_dst_add_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+void ff_hevc_transform_16x16_add_sparse_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                                int extent, int bit_depth);
+void ff_hevc_transform_32x32_add_sparse_16_avx2(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                                int extent, int bit_depth);
+
+
+// residuals (all bit depths)
+
+void transform_idst_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_4x4_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_16x16_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_32x32_avx2(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+
+void transform_skip_residual_avx2(int32_t *residual, const int16_t *coeffs, int nT,
+                                  int tsShift, int bdShift);
+void transform_bypass_avx2(int32_t *residual, const int16_t *coeffs, int nT);
+void rdpcm_v_avx2(int32_t* residual, const int16_t* coeffs, int nT, int tsShift, int bdShift);
+void rdpcm_h_avx2(int32_t* residual, const int16_t* coeffs, int nT, int tsShift, int bdShift);
+void transform_bypass_rdpcm_v_avx2(int32_t *residual, const int16_t *coeffs, int nT);
+void transform_bypass_rdpcm_h_avx2(int32_t *residual, const int16_t *coeffs, int nT);
+
+#endif
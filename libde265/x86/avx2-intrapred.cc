@@ -0,0 +1,494 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <immintrin.h>
+
+#include "avx2-intrapred.h"
+#include "sse-intrapred.h"
+#include "libde265/util.h"
+#include "libde265/fallback-intrapred.h"
+
+
+/* Same computations as in sse-intrapred.cc, with 16 or 32 samples per register.
+   Blocks that are too small to fill a register are passed to the SSE kernels. */
+
+#define MAX_SIMD_BIT_DEPTH 12
+
+
+static inline __m256i combine(__m128i lo, __m128i hi)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+
+// --- planar ---
+
+void intra_pred_planar_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT)
+{
+  if (nT<16) {
+    intra_pred_planar_8_sse4(dst,stride, border,nT);
+    return;
+  }
+
+  const int nChunks = nT/16;
+  const int topRight   = border[ 1+nT];
+  const int bottomLeft = border[-1-nT];
+
+  __m256i weights[2], vert[2], step[2];
+
+  const __m256i bl = _mm256_set1_epi16(bottomLeft);
+
+  for (int c=0;c<nChunks;c++) {
+    int8_t w[32];
+    for (int i=0;i<16;i++) {
+      int x = c*16+i;
+      w[2*i  ] = nT-1-x;
+      w[2*i+1] = x+1;
+    }
+
+    __m256i top = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(border+1+c*16)));
+
+    weights[c] = _mm256_loadu_si256((const __m256i*)w);
+    vert[c] = _mm256_add_epi16(_mm256_mullo_epi16(top, _mm256_set1_epi16(nT-1)), bl);
+    step[c] = _mm256_sub_epi16(bl, top);
+  }
+
+  const __m256i rnd   = _mm256_set1_epi16(nT);
+  const __m128i shift = _mm_cvtsi32_si128(Log2(nT)+1);
+
+  for (int y=0;y<nT;y++) {
+    const __m256i left = _mm256_set1_epi16((int16_t)(border[-1-y] | (topRight<<8)));
+
+    __m256i r[2];
+    for (int c=0;c<nChunks;c++) {
+      __m256i v = _mm256_add_epi16(_mm256_maddubs_epi16(left, weights[c]), vert[c]);
+      r[c] = _mm256_srl_epi16(_mm256_add_epi16(v, rnd), shift);
+      vert[c] = _mm256_add_epi16(vert[c], step[c]);
+    }
+
+    uint8_t* out = dst+y*stride;
+
+    // the pack interleaves the lanes, reorder them to 0,1,2,3
+
+    if (nT==16) {
+      __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0],r[0]), 0xD8);
+      _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(v));
+    }
+    else {
+      __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi16(r[0],r[1]), 0xD8);
+      _mm256_storeu_si256((__m256i*)out, v);
+    }
+  }
+}
+
+
+void intra_pred_planar_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                               int bit_depth)
+{
+  if (nT<8 || bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_planar_16_sse4(dst,stride, border,nT, bit_depth);
+    return;
+  }
+
+  const int nChunks = nT/8;
+  const int topRight   = border[ 1+nT];
+  const int bottomLeft = border[-1-nT];
+
+  __m256i weights[4], vert[4], step[4];
+
+  const __m256i bl = _mm256_set1_epi32(bottomLeft);
+
+  for (int c=0;c<nChunks;c++) {
+    int16_t w[16];
+    for (int i=0;i<8;i++) {
+      int x = c*8+i;
+      w[2*i  ] = nT-1-x;
+      w[2*i+1] = x+1;
+    }
+
+    __m256i top = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(border+1+c*8)));
+
+    weights[c] = _mm256_loadu_si256((const __m256i*)w);
+    vert[c] = _mm256_add_epi32(_mm256_mullo_epi32(top, _mm256_set1_epi32(nT-1)), bl);
+    step[c] = _mm256_sub_epi32(bl, top);
+  }
+
+  const __m256i rnd   = _mm256_set1_epi32(nT);
+  const __m128i shift = _mm_cvtsi32_si128(Log2(nT)+1);
+
+  for (int y=0;y<nT;y++) {
+    const __m256i left = _mm256_set1_epi32(border[-1-y] | (topRight<<16));
+
+    __m256i r[4];
+    for (int c=0;c<nChunks;c++) {
+      __m256i v = _mm256_add_epi32(_mm256_madd_epi16(left, weights[c]), vert[c]);
+      r[c] = _mm256_srl_epi32(_mm256_add_epi32(v, rnd), shift);
+      vert[c] = _mm256_add_epi32(vert[c], step[c]);
+    }
+
+    uint16_t* out = dst+y*stride;
+
+    if (nT==8) {
+      __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[0],r[0]), 0xD8);
+      _mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(v));
+    }
+    else {
+      for (int c=0;c<nChunks;c+=2) {
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packus_epi32(r[c],r[c+1]), 0xD8);
+        _mm256_storeu_si256((__m256i*)(out+c*8), v);
+      }
+    }
+  }
+}
+
+
+// --- DC ---
+
+void intra_pred_dc_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                          bool filter_edges)
+{
+  if (nT<32 || filter_edges) {
+    intra_pred_dc_8_sse4(dst,stride, border,nT, filter_edges);
+    return;
+  }
+
+  const __m256i zero = _mm256_setzero_si256();
+
+  __m256i sum = _mm256_add_epi64(_mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(border-32)), zero),
+                                 _mm256_sad_epu8(_mm256_loadu_si256((const __m256i*)(border+1)),  zero));
+  __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum,1));
+
+  int dcVal = _mm_cvtsi128_si32(s) + _mm_extract_epi16(s,4);
+  dcVal = (dcVal + 32) >> 6;
+
+  const __m256i dc = _mm256_set1_epi8(dcVal);
+
+  for (int y=0;y<32;y++) {
+    _mm256_storeu_si256((__m256i*)(dst+y*stride), dc);
+  }
+}
+
+
+void intra_pred_dc_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                           bool filter_edges, int bit_depth)
+{
+  if (nT<16 || bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_dc_16_sse4(dst,stride, border,nT, filter_edges, bit_depth);
+    return;
+  }
+
+  const __m256i ones = _mm256_set1_epi16(1);
+
+  __m256i sum = _mm256_setzero_si256();
+  for (int i=0;i<nT;i+=16) {
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(border-nT+i)), ones));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i*)(border+1+i)), ones));
+  }
+
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum,1));
+  s = _mm_add_epi32(s, _mm_srli_si128(s,8));
+  s = _mm_add_epi32(s, _mm_srli_si128(s,4));
+
+  int dcVal = (_mm_cvtsi128_si32(s) + nT) >> (Log2(nT)+1);
+
+  const __m256i dc = _mm256_set1_epi16(dcVal);
+
+  for (int y=0;y<nT;y++) {
+    for (int x=0;x<nT;x+=16) {
+      _mm256_storeu_si256((__m256i*)(dst+y*stride+x), dc);
+    }
+  }
+
+  if (filter_edges) {
+    const __m256i dc3 = _mm256_set1_epi16(3*dcVal+2);
+
+    for (int x=0;x<nT;x+=16) {
+      __m256i top = _mm256_loadu_si256((const __m256i*)(border+1+x));
+      _mm256_storeu_si256((__m256i*)(dst+x), _mm256_srli_epi16(_mm256_add_epi16(top, dc3), 2));
+    }
+
+    for (int y=1;y<nT;y++) { dst[y*stride] = (border[-y-1] + 3*dcVal+2)>>2; }
+
+    dst[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
+  }
+}
+
+
+// --- angular ---
+
+/* 16x16 blocks are computed two rows per register, each 128 bit lane with its own weights.
+   The horizontal modes are transposed with the SSE function. */
+
+void intra_pred_angular_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                               int intraPredMode, bool boundary_filter)
+{
+  if (nT<16) {
+    intra_pred_angular_8_sse4(dst,stride, border,nT, intraPredMode, boundary_filter);
+    return;
+  }
+
+  uint8_t  ref_mem[2*64+1+16];
+  uint8_t* ref=&ref_mem[64];
+
+  intra_pred_angular_reference(ref, border, nT, intraPredMode);
+
+  const int  intraPredAngle = intraPredAngle_table[intraPredMode];
+  const bool vertical = (intraPredMode >= 18);
+
+  ALIGNED_32(uint8_t tmp[32*32]);
+  uint8_t*  out       = vertical ? dst : tmp;
+  ptrdiff_t outStride = vertical ? stride : nT;
+
+  const __m256i rnd = _mm256_set1_epi16(16);
+
+  if (nT==32) {
+    for (int y=0;y<32;y++) {
+      int iIdx = ((y+1)*intraPredAngle)>>5;
+      int iFact= ((y+1)*intraPredAngle)&31;
+
+      const uint8_t* src = ref+iIdx+1;
+      uint8_t* o = out+y*outStride;
+
+      if (iFact==0) {
+        memcpy(o, src, 32);
+        continue;
+      }
+
+      const __m256i w = _mm256_set1_epi16((int16_t)((iFact<<8) | (32-iFact)));
+
+      __m256i a = _mm256_loadu_si256((const __m256i*)(src));
+      __m256i b = _mm256_loadu_si256((const __m256i*)(src+1));
+      __m256i lo = _mm256_maddubs_epi16(_mm256_unpacklo_epi8(a,b), w);
+      __m256i hi = _mm256_maddubs_epi16(_mm256_unpackhi_epi8(a,b), w);
+      lo = _mm256_srli_epi16(_mm256_add_epi16(lo, rnd), 5);
+      hi = _mm256_srli_epi16(_mm256_add_epi16(hi, rnd), 5);
+
+      _mm256_storeu_si256((__m256i*)o, _mm256_packus_epi16(lo,hi));
+    }
+  }
+  else {
+    for (int y=0;y<16;y+=2) {
+      int pos0 = (y+1)*intraPredAngle;
+      int pos1 = (y+2)*intraPredAngle;
+
+      const uint8_t* src0 = ref+(pos0>>5)+1;
+      const uint8_t* src1 = ref+(pos1>>5)+1;
+
+      // iFact==0 gives the weights (32,0), which reproduces the reference samples
+
+      const __m256i w = combine(_mm_set1_epi16((int16_t)(((pos0&31)<<8) | (32-(pos0&31)))),
+                                _mm_set1_epi16((int16_t)(((pos1&31)<<8) | (32-(pos1&31)))));
+
+      __m256i a = combine(_mm_loadu_si128((const __m128i*)(src0)),
+                          _mm_loadu_si128((const __m128i*)(src1)));
+      __m256i b = combine(_mm_loadu_si128((const __m128i*)(src0+1)),
+                          _mm_loadu_si128((const __m128i*)(src1+1)));
+      __m256i lo = _mm256_maddubs_epi16(_mm256_unpacklo_epi8(a,b), w);
+      __m256i hi = _mm256_maddubs_epi16(_mm256_unpackhi_epi8(a,b), w);
+      lo = _mm256_srli_epi16(_mm256_add_epi16(lo, rnd), 5);
+      hi = _mm256_srli_epi16(_mm256_add_epi16(hi, rnd), 5);
+
+      __m256i v = _mm256_packus_epi16(lo,hi);
+      _mm_storeu_si128((__m128i*)(out+ y   *outStride), _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i*)(out+(y+1)*outStride), _mm256_extracti128_si256(v,1));
+    }
+  }
+
+  if (vertical) {
+    if (intraPredMode==26 && boundary_filter) {
+      for (int y=0;y<nT;y++) {
+        dst[y*stride] = Clip1_8bit(border[1] + ((border[-1-y] - border[0])>>1));
+      }
+    }
+  }
+  else {
+    intra_pred_transpose_8_sse4(dst,stride, tmp,nT);
+
+    if (intraPredMode==10 && boundary_filter) {
+      for (int x=0;x<nT;x++) {
+        dst[x] = Clip1_8bit(border[-1] + ((border[1+x] - border[0])>>1));
+      }
+    }
+  }
+}
+
+
+void intra_pred_angular_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                                int intraPredMode, bool boundary_filter, int bit_depth)
+{
+  if (nT<8 || bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_angular_16_sse4(dst,stride, border,nT, intraPredMode, boundary_filter, bit_depth);
+    return;
+  }
+
+  uint16_t  ref_mem[2*64+1+16];
+  uint16_t* ref=&ref_mem[64];
+
+  intra_pred_angular_reference(ref, border, nT, intraPredMode);
+
+  const int  intraPredAngle = intraPredAngle_table[intraPredMode];
+  const bool vertical = (intraPredMode >= 18);
+
+  ALIGNED_32(uint16_t tmp[32*32]);
+  uint16_t* out       = vertical ? dst : tmp;
+  ptrdiff_t outStride = vertical ? stride : nT;
+
+  const __m256i rnd = _mm256_set1_epi32(16);
+
+  if (nT>=16) {
+    for (int y=0;y<nT;y++) {
+      int iIdx = ((y+1)*intraPredAngle)>>5;
+      int iFact= ((y+1)*intraPredAngle)&31;
+
+      const uint16_t* src = ref+iIdx+1;
+      uint16_t* o = out+y*outStride;
+
+      if (iFact==0) {
+        memcpy(o, src, nT*sizeof(uint16_t));
+        continue;
+      }
+
+      const __m256i w = _mm256_set1_epi32((iFact<<16) | (32-iFact));
+
+      for (int x=0;x<nT;x+=16) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(src+x));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src+x+1));
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a,b), w);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a,b), w);
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, rnd), 5);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, rnd), 5);
+
+        _mm256_storeu_si256((__m256i*)(o+x), _mm256_packus_epi32(lo,hi));
+      }
+    }
+  }
+  else {
+    for (int y=0;y<8;y+=2) {
+      int pos0 = (y+1)*intraPredAngle;
+      int pos1 = (y+2)*intraPredAngle;
+
+      const uint16_t* src0 = ref+(pos0>>5)+1;
+      const uint16_t* src1 = ref+(pos1>>5)+1;
+
+      const __m256i w = combine(_mm_set1_epi32(((pos0&31)<<16) | (32-(pos0&31))),
+                                _mm_set1_epi32(((pos1&31)<<16) | (32-(pos1&31))));
+
+      __m256i a = combine(_mm_loadu_si128((const __m128i*)(src0)),
+                          _mm_loadu_si128((const __m128i*)(src1)));
+      __m256i b = combine(_mm_loadu_si128((const __m128i*)(src0+1)),
+                          _mm_loadu_si128((const __m128i*)(src1+1)));
+      __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a,b), w);
+      __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a,b), w);
+      lo = _mm256_srai_epi32(_mm256_add_epi32(lo, rnd), 5);
+      hi = _mm256_srai_epi32(_mm256_add_epi32(hi, rnd), 5);
+
+      __m256i v = _mm256_packus_epi32(lo,hi);
+      _mm_storeu_si128((__m128i*)(out+ y   *outStride), _mm256_castsi256_si128(v));
+      _mm_storeu_si128((__m128i*)(out+(y+1)*outStride), _mm256_extracti128_si256(v,1));
+    }
+  }
+
+  if (vertical) {
+    if (intraPredMode==26 && boundary_filter) {
+      for (int y=0;y<nT;y++) {
+        dst[y*stride] = Clip_BitDepth(border[1] + ((border[-1-y] - border[0])>>1), bit_depth);
+      }
+    }
+  }
+  else {
+    intra_pred_transpose_16_sse4(dst,stride, tmp,nT);
+
+    if (intraPredMode==10 && boundary_filter) {
+      for (int x=0;x<nT;x++) {
+        dst[x] = Clip_BitDepth(border[-1] + ((border[1+x] - border[0])>>1), bit_depth);
+      }
+    }
+  }
+}
+
+
+// --- [1 2 1] filtering of the reference samples ---
+
+void intra_pred_smooth_border_8_avx2(uint8_t* border, int nT)
+{
+  if (nT<16) {
+    intra_pred_smooth_border_8_sse4(border,nT);
+    return;
+  }
+
+  ALIGNED_32(uint8_t pF[4*32]);
+
+  const int n = 4*nT-1;
+  uint8_t* p = border-(2*nT-1);
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i two  = _mm256_set1_epi16(2);
+
+  for (int i=0;i<n;i+=32) {
+    if (i>n-32) { i=n-32; }
+
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p+i-1));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(p+i));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(p+i+1));
+
+    __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a,zero), _mm256_unpacklo_epi8(c,zero));
+    __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a,zero), _mm256_unpackhi_epi8(c,zero));
+    lo = _mm256_add_epi16(lo, _mm256_slli_epi16(_mm256_unpacklo_epi8(b,zero), 1));
+    hi = _mm256_add_epi16(hi, _mm256_slli_epi16(_mm256_unpackhi_epi8(b,zero), 1));
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, two), 2);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2);
+
+    _mm256_storeu_si256((__m256i*)(pF+i), _mm256_packus_epi16(lo,hi));
+  }
+
+  memcpy(p, pF, n);
+}
+
+
+void intra_pred_smooth_border_16_avx2(uint16_t* border, int nT, int bit_depth)
+{
+  if (nT<8 || bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_smooth_border_16_sse4(border,nT, bit_depth);
+    return;
+  }
+
+  ALIGNED_32(uint16_t pF[4*32]);
+
+  const int n = 4*nT-1;
+  uint16_t* p = border-(2*nT-1);
+
+  const __m256i two = _mm256_set1_epi16(2);
+
+  for (int i=0;i<n;i+=16) {
+    if (i>n-16) { i=n-16; }
+
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p+i-1));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(p+i));
+    __m256i c = _mm256_loadu_si256((const __m256i*)(p+i+1));
+
+    __m256i v = _mm256_add_epi16(_mm256_add_epi16(a,c), _mm256_slli_epi16(b,1));
+    v = _mm256_srli_epi16(_mm256_add_epi16(v, two), 2);
+
+    _mm256_storeu_si256((__m256i*)(pF+i), v);
+  }
+
+  memcpy(p, pF, n*sizeof(uint16_t));
+}
@@ -0,0 +1,45 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AVX2_INTRAPRED_H
+#define AVX2_INTRAPRED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void intra_pred_planar_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT);
+void intra_pred_dc_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                          bool filter_edges);
+void intra_pred_angular_8_avx2(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                               int intraPredMode, bool boundary_filter);
+void intra_pred_smooth_border_8_avx2(uint8_t* border, int nT);
+
+
+// samples with more than 8 bits
+
+void intra_pred_planar_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                               int bit_depth);
+void intra_pred_dc_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                           bool filter_edges, int bit_depth);
+void intra_pred_angular_16_avx2(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                                int intraPredMode, bool boundary_filter, int bit_depth);
+void intra_pred_smooth_border_16_avx2(uint16_t* border, int nT, int bit_depth);
+
+#endif
@@ -0,0 +1,564 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+
+#include "avx2-motion.h"
+#include "sse-motion.h"
+#include "libde265/util.h"
+
+
+/* Motion compensation for samples with more than 8 bits.
+
+   Same scheme as the SSE kernels in sse-motion-16.cc, with 16 samples per iteration.
+   The 128-bit lanes are unpacked independently, but since the 32-bit results are
+   packed lane by lane as well, the output samples end up in their natural order.
+   The remaining columns and bit depths above 12 are passed to the SSE kernels.
+ */
+
+#define MAX_PB_SIZE 64
+#define MAX_SIMD_BIT_DEPTH 12
+
+
+// --- prediction weighting ---
+
+static inline void store_16_pixels(uint16_t* dst, __m256i v, __m256i maxval)
+{
+  v = _mm256_min_epi16(_mm256_max_epi16(v, _mm256_setzero_si256()), maxval);
+  _mm256_storeu_si256((__m256i*)dst, v);
+}
+
+
+void ff_hevc_put_unweighted_pred_16_avx2(uint16_t *dst, ptrdiff_t dststride,
+                                         const int16_t *src, ptrdiff_t srcstride,
+                                         int width, int height, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  if (w16) {
+    const int shift1 = 14-bit_depth;
+    const __m256i offset = _mm256_set1_epi16(1<<(shift1-1));
+    const __m256i maxval = _mm256_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift  = _mm_cvtsi32_si128(shift1);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in = &src[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w16;x+=16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&in[x]);
+        v = _mm256_sra_epi16(_mm256_adds_epi16(v, offset), shift);
+        store_16_pixels(&out[x], v, maxval);
+      }
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_unweighted_pred_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                       width-w16, height, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_avg_16_avx2(uint16_t *dst, ptrdiff_t dststride,
+                                           const int16_t *src1, const int16_t *src2,
+                                           ptrdiff_t srcstride, int width,
+                                           int height, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  if (w16) {
+    const int shift2 = 15-bit_depth;
+    const __m256i offset = _mm256_set1_epi16(1<<(shift2-1));
+    const __m256i maxval = _mm256_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift  = _mm_cvtsi32_si128(shift2);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in1 = &src1[y*srcstride];
+      const int16_t* in2 = &src2[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w16;x+=16) {
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)&in1[x]);
+        __m256i v2 = _mm256_loadu_si256((const __m256i*)&in2[x]);
+
+        // saturation only happens when the result is clipped anyway
+
+        __m256i v = _mm256_adds_epi16(_mm256_adds_epi16(v1,v2), offset);
+        store_16_pixels(&out[x], _mm256_sra_epi16(v, shift), maxval);
+      }
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_weighted_pred_avg_16_sse(dst+w16, dststride, src1+w16, src2+w16, srcstride,
+                                         width-w16, height, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_16_avx2(uint16_t *dst, ptrdiff_t dststride,
+                                       const int16_t *src, ptrdiff_t srcstride,
+                                       int width, int height,
+                                       int w,int o,int log2WD, int bit_depth)
+{
+  assert(log2WD>=1);
+
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  if (w16) {
+    const int rnd = (1<<(log2WD-1));
+
+    // multiply-add of (in,1) with (w,rnd) gives in*w+rnd with 32 bit precision
+
+    const __m256i one     = _mm256_set1_epi16(1);
+    const __m256i factors = _mm256_set1_epi32((rnd<<16) | (uint16_t)w);
+    const __m256i offset  = _mm256_set1_epi32(o);
+    const __m256i maxval  = _mm256_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift   = _mm_cvtsi32_si128(log2WD);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in  = &src[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w16;x+=16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)&in[x]);
+
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(v, one), factors);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(v, one), factors);
+        lo = _mm256_add_epi32(_mm256_sra_epi32(lo, shift), offset);
+        hi = _mm256_add_epi32(_mm256_sra_epi32(hi, shift), offset);
+
+        store_16_pixels(&out[x], _mm256_packs_epi32(lo,hi), maxval);
+      }
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_weighted_pred_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                     width-w16, height, w,o,log2WD, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_bipred_16_avx2(uint16_t *dst, ptrdiff_t dststride,
+                                         const int16_t *src1, const int16_t *src2,
+                                         ptrdiff_t srcstride, int width, int height,
+                                         int w1,int o1, int w2,int o2, int log2WD,
+                                         int bit_depth)
+{
+  assert(log2WD>=1);
+
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  if (w16) {
+    const int rnd = ((o1+o2+1) << log2WD);
+
+    // multiply-add of (in1,in2) with (w1,w2) gives in1*w1+in2*w2 with 32 bit precision
+
+    const __m256i factors = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)w2<<16) | (uint16_t)w1));
+    const __m256i offset  = _mm256_set1_epi32(rnd);
+    const __m256i maxval  = _mm256_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift   = _mm_cvtsi32_si128(log2WD+1);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in1 = &src1[y*srcstride];
+      const int16_t* in2 = &src2[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w16;x+=16) {
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)&in1[x]);
+        __m256i v2 = _mm256_loadu_si256((const __m256i*)&in2[x]);
+
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(v1, v2), factors);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(v1, v2), factors);
+        lo = _mm256_sra_epi32(_mm256_add_epi32(lo, offset), shift);
+        hi = _mm256_sra_epi32(_mm256_add_epi32(hi, offset), shift);
+
+        store_16_pixels(&out[x], _mm256_packs_epi32(lo,hi), maxval);
+      }
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_weighted_bipred_16_sse(dst+w16, dststride, src1+w16, src2+w16, srcstride,
+                                       width-w16, height, w1,o1,w2,o2, log2WD, bit_depth);
+  }
+}
+
+
+// --- interpolation filters ---
+
+/* Filter taps, starting at the first sample used by the filter.
+   The quarter-sample filters 1 and 3 only have 7 taps, the last one is zero. */
+
+static const int8_t qpel_filters_16[4][8] = {
+  {  0, 0,  0,  0,  0,  0,  0,  0 },
+  { -1, 4,-10, 58, 17, -5,  1,  0 },
+  { -1, 4,-11, 40, 40,-11,  4, -1 },
+  {  1,-5, 17, 58,-10,  4, -1,  0 }
+};
+
+static const int qpel_extra_before_16[4] = { 0, 3, 3, 2 };
+static const int qpel_taps_16[4]         = { 0, 7, 8, 7 };
+
+static const int8_t epel_filters_16[8][4] = {
+  {  0,  0,  0,  0 },
+  { -2, 58, 10, -2 },
+  { -4, 54, 16, -2 },
+  { -6, 46, 28, -4 },
+  { -4, 36, 36, -4 },
+  { -4, 28, 46, -6 },
+  { -2, 16, 54, -4 },
+  { -2, 10, 58, -2 }
+};
+
+
+// pairs of taps as 16-bit values for _mm256_madd_epi16()
+
+static void init_coeff_pairs(__m256i* coeffs, const int8_t* taps, int nTaps)
+{
+  for (int k=0;k<nTaps;k+=2) {
+    int16_t t1 = (k+1<nTaps ? taps[k+1] : 0);
+    coeffs[k/2] = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)t1<<16) | (uint16_t)taps[k]));
+  }
+}
+
+
+/* Filter of 16 output samples. The input samples of tap k are read from p+k*step,
+   with step 1 for the horizontal and step 'stride' for the vertical filter. */
+
+template <int nTaps, class T>
+static inline __m256i filter(const T* p, ptrdiff_t step, const __m256i* coeffs, __m128i shift)
+{
+  __m256i lo = _mm256_setzero_si256();
+  __m256i hi = _mm256_setzero_si256();
+
+  for (int k=0;k<nTaps;k+=2) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p+k*step));
+    __m256i b = (k+1<nTaps ?
+                 _mm256_loadu_si256((const __m256i*)(p+(k+1)*step)) :
+                 _mm256_setzero_si256());
+
+    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a,b), coeffs[k/2]));
+    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a,b), coeffs[k/2]));
+  }
+
+  return _mm256_packs_epi32(_mm256_sra_epi32(lo,shift), _mm256_sra_epi32(hi,shift));
+}
+
+
+template <int nTaps>
+static void filter_h_block(int16_t *dst, ptrdiff_t dststride,
+                           const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                           int width, int height, const __m256i* coeffs, int bit_depth)
+{
+  const __m128i shift = _mm_cvtsi32_si128(bit_depth-8);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<width;x+=16) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x],
+                          filter<nTaps>(&src[y*srcstride+x], 1, coeffs, shift));
+    }
+  }
+}
+
+
+template <int nTaps>
+static void filter_v_block(int16_t *dst, ptrdiff_t dststride,
+                           const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                           int width, int height, const __m256i* coeffs, int bit_depth)
+{
+  const __m128i shift = _mm_cvtsi32_si128(bit_depth-8);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<width;x+=16) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x],
+                          filter<nTaps>(&src[y*srcstride+x], srcstride, coeffs, shift));
+    }
+  }
+}
+
+
+template <int nTapsH, int nTapsV>
+static void filter_hv_block(int16_t *dst, ptrdiff_t dststride,
+                            const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                            int width, int height,
+                            const __m256i* hcoeffs, const __m256i* vcoeffs, int bit_depth)
+{
+  ALIGNED_32(int16_t tmp[(MAX_PB_SIZE+7)*16]);
+
+  const __m128i hshift = _mm_cvtsi32_si128(bit_depth-8);
+  const __m128i vshift = _mm_cvtsi32_si128(6);
+
+  const int nRows = height + nTapsV-1;
+
+  for (int x=0;x<width;x+=16) {
+    for (int y=0;y<nRows;y++) {
+      _mm256_store_si256((__m256i*)&tmp[y*16],
+                         filter<nTapsH>(src + y*srcstride + x, 1, hcoeffs, hshift));
+    }
+
+    for (int y=0;y<height;y++) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x],
+                          filter<nTapsV>(&tmp[y*16], 16, vcoeffs, vshift));
+    }
+  }
+}
+
+
+typedef void (*qpel_func_16)(int16_t *dst, ptrdiff_t dststride,
+                             const uint16_t *src, ptrdiff_t srcstride,
+                             int width, int height, int16_t* mcbuffer, int bit_depth);
+
+
+// --- quarter-sample luma interpolation ---
+
+void ff_hevc_put_hevc_qpel_pixels_16_avx2(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer,
+                                          int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+  const __m128i shift = _mm_cvtsi32_si128(14-bit_depth);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&src[y*srcstride+x]);
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], _mm256_sll_epi16(v,shift));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_qpel_pixels_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                        width-w16, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_h_16(int xFrac, qpel_func_16 sse_func,
+                      int16_t *dst, ptrdiff_t dststride,
+                      const uint16_t *src, ptrdiff_t srcstride,
+                      int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i coeffs[4];
+  init_coeff_pairs(coeffs, qpel_filters_16[xFrac], qpel_taps_16[xFrac]);
+
+  const uint16_t* in = src - qpel_extra_before_16[xFrac];
+
+  if (qpel_taps_16[xFrac]==8) {
+    filter_h_block<8>(dst,dststride, in,srcstride, w16,height, coeffs, bit_depth);
+  }
+  else {
+    filter_h_block<7>(dst,dststride, in,srcstride, w16,height, coeffs, bit_depth);
+  }
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_v_16(int yFrac, qpel_func_16 sse_func,
+                      int16_t *dst, ptrdiff_t dststride,
+                      const uint16_t *src, ptrdiff_t srcstride,
+                      int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i coeffs[4];
+  init_coeff_pairs(coeffs, qpel_filters_16[yFrac], qpel_taps_16[yFrac]);
+
+  const uint16_t* in = src - qpel_extra_before_16[yFrac]*srcstride;
+
+  if (qpel_taps_16[yFrac]==8) {
+    filter_v_block<8>(dst,dststride, in,srcstride, w16,height, coeffs, bit_depth);
+  }
+  else {
+    filter_v_block<7>(dst,dststride, in,srcstride, w16,height, coeffs, bit_depth);
+  }
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_hv_16(int xFrac, int yFrac, qpel_func_16 sse_func,
+                       int16_t *dst, ptrdiff_t dststride,
+                       const uint16_t *src, ptrdiff_t srcstride,
+                       int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i hcoeffs[4], vcoeffs[4];
+  init_coeff_pairs(hcoeffs, qpel_filters_16[xFrac], qpel_taps_16[xFrac]);
+  init_coeff_pairs(vcoeffs, qpel_filters_16[yFrac], qpel_taps_16[yFrac]);
+
+  const uint16_t* in = (src - qpel_extra_before_16[yFrac]*srcstride
+                        - qpel_extra_before_16[xFrac]);
+
+  bool h8 = (qpel_taps_16[xFrac]==8);
+  bool v8 = (qpel_taps_16[yFrac]==8);
+
+  if      ( h8 &&  v8) filter_hv_block<8,8>(dst,dststride, in,srcstride, w16,height, hcoeffs,vcoeffs, bit_depth);
+  else if ( h8 && !v8) filter_hv_block<8,7>(dst,dststride, in,srcstride, w16,height, hcoeffs,vcoeffs, bit_depth);
+  else if (!h8 &&  v8) filter_hv_block<7,8>(dst,dststride, in,srcstride, w16,height, hcoeffs,vcoeffs, bit_depth);
+  else                 filter_hv_block<7,7>(dst,dststride, in,srcstride, w16,height, hcoeffs,vcoeffs, bit_depth);
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer, bit_depth);
+  }
+}
+
+
+#define QPEL_H(xFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _16_avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                     const uint16_t *src, ptrdiff_t srcstride, \
+                                                     int width, int height, int16_t* mcbuffer, \
+                                                     int bit_depth)     \
+  {                                                                     \
+    qpel_h_16(xFrac, ff_hevc_put_hevc_qpel_h_ ## xFrac ## _16_sse,      \
+              dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+#define QPEL_V(yFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_v_ ## yFrac ## _16_avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                     const uint16_t *src, ptrdiff_t srcstride, \
+                                                     int width, int height, int16_t* mcbuffer, \
+                                                     int bit_depth)     \
+  {                                                                     \
+    qpel_v_16(yFrac, ff_hevc_put_hevc_qpel_v_ ## yFrac ## _16_sse,      \
+              dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+#define QPEL_HV(xFrac,yFrac)                                            \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _v_ ## yFrac ## _16_avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                                     const uint16_t *src, ptrdiff_t srcstride, \
+                                                                     int width, int height, int16_t* mcbuffer, \
+                                                                     int bit_depth) \
+  {                                                                     \
+    qpel_hv_16(xFrac,yFrac, ff_hevc_put_hevc_qpel_h_ ## xFrac ## _v_ ## yFrac ## _16_sse, \
+               dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+QPEL_H(1)
+QPEL_H(2)
+QPEL_H(3)
+
+QPEL_V(1)
+QPEL_V(2)
+QPEL_V(3)
+
+QPEL_HV(1,1)
+QPEL_HV(1,2)
+QPEL_HV(1,3)
+QPEL_HV(2,1)
+QPEL_HV(2,2)
+QPEL_HV(2,3)
+QPEL_HV(3,1)
+QPEL_HV(3,2)
+QPEL_HV(3,3)
+
+
+// --- eighth-sample chroma interpolation ---
+
+void ff_hevc_put_hevc_epel_pixels_16_avx2(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height,
+                                          int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+  const __m128i shift = _mm_cvtsi32_si128(14-bit_depth);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&src[y*srcstride+x]);
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], _mm256_sll_epi16(v,shift));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_pixels_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                        width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_h_16_avx2(int16_t *dst, ptrdiff_t dststride,
+                                     const uint16_t *src, ptrdiff_t srcstride,
+                                     int width, int height,
+                                     int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i coeffs[2];
+  init_coeff_pairs(coeffs, epel_filters_16[mx], 4);
+
+  filter_h_block<4>(dst,dststride, src-1,srcstride, w16,height, coeffs, bit_depth);
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_h_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                   width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_v_16_avx2(int16_t *dst, ptrdiff_t dststride,
+                                     const uint16_t *src, ptrdiff_t srcstride,
+                                     int width, int height,
+                                     int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i coeffs[2];
+  init_coeff_pairs(coeffs, epel_filters_16[my], 4);
+
+  filter_v_block<4>(dst,dststride, src-srcstride,srcstride, w16,height, coeffs, bit_depth);
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_v_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                   width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_hv_16_avx2(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height,
+                                      int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~15 : 0);
+
+  __m256i hcoeffs[2], vcoeffs[2];
+  init_coeff_pairs(hcoeffs, epel_filters_16[mx], 4);
+  init_coeff_pairs(vcoeffs, epel_filters_16[my], 4);
+
+  filter_hv_block<4,4>(dst,dststride, src-srcstride-1,srcstride, w16,height,
+                       hcoeffs,vcoeffs, bit_depth);
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_hv_16_sse(dst+w16, dststride, src+w16, srcstride,
+                                    width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
@@ -0,0 +1,620 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <immintrin.h>
+
+#include "avx2-motion.h"
+#include "sse-motion.h"
+#include "libde265/util.h"
+
+
+/* All kernels process 16 samples of a line per iteration.
+   The remaining columns of blocks whose width is not a multiple of 16 are passed
+   to the SSE kernels. For the weighted prediction, for which there are no SSE kernels,
+   the remaining columns are processed in groups of 8 and then sample by sample.
+ */
+
+#define MAX_PB_SIZE 64
+
+
+// --- prediction weighting ---
+
+static inline void store_16_pixels(uint8_t* dst, __m256i v)
+{
+  // pack to 8 bit and move the results of both lanes into the lower half
+
+  v = _mm256_packus_epi16(v,v);
+  v = _mm256_permute4x64_epi64(v, 0x08);
+
+  _mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(v));
+}
+
+
+void ff_hevc_put_unweighted_pred_8_avx2(uint8_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src, ptrdiff_t srcstride,
+                                        int width, int height)
+{
+  const int w16 = width & ~15;
+  const __m256i offset = _mm256_set1_epi16(32);
+
+  for (int y=0;y<height;y++) {
+    const int16_t* in = &src[y*srcstride];
+    uint8_t* out = &dst[y*dststride];
+
+    for (int x=0;x<w16;x+=16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&in[x]);
+      v = _mm256_srai_epi16(_mm256_adds_epi16(v, offset), 6);
+      store_16_pixels(&out[x], v);
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_unweighted_pred_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                      width-w16, height);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_avg_8_avx2(uint8_t *dst, ptrdiff_t dststride,
+                                          const int16_t *src1, const int16_t *src2,
+                                          ptrdiff_t srcstride, int width,
+                                          int height)
+{
+  const int w16 = width & ~15;
+  const __m256i offset = _mm256_set1_epi16(64);
+
+  for (int y=0;y<height;y++) {
+    const int16_t* in1 = &src1[y*srcstride];
+    const int16_t* in2 = &src2[y*srcstride];
+    uint8_t* out = &dst[y*dststride];
+
+    for (int x=0;x<w16;x+=16) {
+      __m256i v1 = _mm256_loadu_si256((const __m256i*)&in1[x]);
+      __m256i v2 = _mm256_loadu_si256((const __m256i*)&in2[x]);
+
+      // saturation only happens when the result is clipped anyway
+
+      __m256i v = _mm256_adds_epi16(_mm256_adds_epi16(v1,v2), offset);
+      store_16_pixels(&out[x], _mm256_srai_epi16(v, 7));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_weighted_pred_avg_8_sse(dst+w16, dststride,
+                                        src1+w16, src2+w16, srcstride,
+                                        width-w16, height);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_8_avx2(uint8_t *dst, ptrdiff_t dststride,
+                                      const int16_t *src, ptrdiff_t srcstride,
+                                      int width, int height,
+                                      int w,int o,int log2WD)
+{
+  assert(log2WD>=1);
+
+  const int rnd = (1<<(log2WD-1));
+
+  // multiply-add of (in,1) with (w,rnd) gives in*w+rnd with 32 bit precision
+
+  const __m256i one     = _mm256_set1_epi16(1);
+  const __m256i factors = _mm256_set1_epi32((rnd<<16) | (uint16_t)w);
+  const __m256i offset  = _mm256_set1_epi32(o);
+  const __m128i shift   = _mm_cvtsi32_si128(log2WD);
+
+  for (int y=0;y<height;y++) {
+    const int16_t* in  = &src[y*srcstride];
+    uint8_t* out = &dst[y*dststride];
+
+    int x=0;
+    for ( ;x+16<=width;x+=16) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)&in[x]);
+
+      __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(v, one), factors);
+      __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(v, one), factors);
+      lo = _mm256_add_epi32(_mm256_sra_epi32(lo, shift), offset);
+      hi = _mm256_add_epi32(_mm256_sra_epi32(hi, shift), offset);
+
+      store_16_pixels(&out[x], _mm256_packs_epi32(lo,hi));
+    }
+
+    for ( ;x+8<=width;x+=8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&in[x]);
+
+      __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v, _mm256_castsi256_si128(one)),
+                                  _mm256_castsi256_si128(factors));
+      __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v, _mm256_castsi256_si128(one)),
+                                  _mm256_castsi256_si128(factors));
+      lo = _mm_add_epi32(_mm_sra_epi32(lo, shift), _mm256_castsi256_si128(offset));
+      hi = _mm_add_epi32(_mm_sra_epi32(hi, shift), _mm256_castsi256_si128(offset));
+
+      v = _mm_packs_epi32(lo,hi);
+      _mm_storel_epi64((__m128i*)&out[x], _mm_packus_epi16(v,v));
+    }
+
+    for ( ;x<width;x++) {
+      out[x] = Clip1_8bit(((in[x]*w + rnd)>>log2WD) + o);
+    }
+  }
+}
+
+
+void ff_hevc_put_weighted_bipred_8_avx2(uint8_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src1, const int16_t *src2,
+                                        ptrdiff_t srcstride, int width, int height,
+                                        int w1,int o1, int w2,int o2, int log2WD)
+{
+  assert(log2WD>=1);
+
+  const int rnd = ((o1+o2+1) << log2WD);
+
+  // multiply-add of (in1,in2) with (w1,w2) gives in1*w1+in2*w2 with 32 bit precision
+
+  const __m256i factors = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)w2<<16) | (uint16_t)w1));
+  const __m256i offset  = _mm256_set1_epi32(rnd);
+  const __m128i shift   = _mm_cvtsi32_si128(log2WD+1);
+
+  for (int y=0;y<height;y++) {
+    const int16_t* in1 = &src1[y*srcstride];
+    const int16_t* in2 = &src2[y*srcstride];
+    uint8_t* out = &dst[y*dststride];
+
+    int x=0;
+    for ( ;x+16<=width;x+=16) {
+      __m256i v1 = _mm256_loadu_si256((const __m256i*)&in1[x]);
+      __m256i v2 = _mm256_loadu_si256((const __m256i*)&in2[x]);
+
+      __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(v1, v2), factors);
+      __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(v1, v2), factors);
+      lo = _mm256_sra_epi32(_mm256_add_epi32(lo, offset), shift);
+      hi = _mm256_sra_epi32(_mm256_add_epi32(hi, offset), shift);
+
+      store_16_pixels(&out[x], _mm256_packs_epi32(lo,hi));
+    }
+
+    for ( ;x+8<=width;x+=8) {
+      __m128i v1 = _mm_loadu_si128((const __m128i*)&in1[x]);
+      __m128i v2 = _mm_loadu_si128((const __m128i*)&in2[x]);
+
+      __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v1, v2), _mm256_castsi256_si128(factors));
+      __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v1, v2), _mm256_castsi256_si128(factors));
+      lo = _mm_sra_epi32(_mm_add_epi32(lo, _mm256_castsi256_si128(offset)), shift);
+      hi = _mm_sra_epi32(_mm_add_epi32(hi, _mm256_castsi256_si128(offset)), shift);
+
+      __m128i v = _mm_packs_epi32(lo,hi);
+      _mm_storel_epi64((__m128i*)&out[x], _mm_packus_epi16(v,v));
+    }
+
+    for ( ;x<width;x++) {
+      out[x] = Clip1_8bit((in1[x]*w1 + in2[x]*w2 + rnd)>>(log2WD+1));
+    }
+  }
+}
+
+
+// --- interpolation filters ---
+
+/* Filter taps, starting at the first sample used by the filter.
+   The quarter-sample filters 1 and 3 only have 7 taps, the last one is zero. */
+
+static const int8_t qpel_filters[4][8] = {
+  {  0, 0,  0,  0,  0,  0,  0,  0 },
+  { -1, 4,-10, 58, 17, -5,  1,  0 },
+  { -1, 4,-11, 40, 40,-11,  4, -1 },
+  {  1,-5, 17, 58,-10,  4, -1,  0 }
+};
+
+static const int qpel_extra_before[4] = { 0, 3, 3, 2 };
+static const int qpel_taps[4]         = { 0, 7, 8, 7 };
+
+static const int8_t epel_filters[8][4] = {
+  {  0,  0,  0,  0 },
+  { -2, 58, 10, -2 },
+  { -4, 54, 16, -2 },
+  { -6, 46, 28, -4 },
+  { -4, 36, 36, -4 },
+  { -4, 28, 46, -6 },
+  { -2, 16, 54, -4 },
+  { -2, 10, 58, -2 }
+};
+
+static const int epel_extra_before = 1;
+
+
+/* Byte shuffles that collect the input sample pairs for each pair of filter taps.
+   The lower lane computes output samples 0-7, the upper lane samples 8-15. Since a lane
+   only holds 16 input samples, the upper lane is loaded with an offset of (taps-1). */
+
+ALIGNED_32(static const int8_t) qpel_h_shuffle[4][32] = {
+  {  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,
+     1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9 },
+  {  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10,
+     3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11 },
+  {  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12,
+     5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13 },
+  {  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14,
+     7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15 }
+};
+
+ALIGNED_32(static const int8_t) epel_h_shuffle[2][32] = {
+  {  0,  1,  1,  2,  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,
+     5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13 },
+  {  2,  3,  3,  4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10,
+     7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12, 13, 13, 14, 14, 15 }
+};
+
+
+template <int nTaps>
+struct h_filter
+{
+  __m256i shuffle[nTaps/2];
+  __m256i coeffs[nTaps/2];  // pairs of 8-bit taps
+
+  h_filter(const int8_t* taps, const int8_t (*shuffles)[32]) {
+    for (int j=0;j<nTaps/2;j++) {
+      shuffle[j] = _mm256_load_si256((const __m256i*)shuffles[j]);
+      coeffs[j]  = _mm256_set1_epi16((int16_t)((uint8_t)taps[2*j] | ((uint16_t)(uint8_t)taps[2*j+1] << 8)));
+    }
+  }
+
+  // 16 output samples; 'p' points to the first input sample of the filter
+
+  __m256i filter(const uint8_t* p) const {
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)),
+                                         _mm_loadu_si128((const __m128i*)(p+nTaps-1)), 1);
+
+    __m256i sum = _mm256_maddubs_epi16(_mm256_shuffle_epi8(in, shuffle[0]), coeffs[0]);
+    for (int j=1;j<nTaps/2;j++) {
+      sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(_mm256_shuffle_epi8(in, shuffle[j]),
+                                                       coeffs[j]));
+    }
+
+    return sum;
+  }
+};
+
+
+/* Vertical filter on 8-bit input. The result of an 8-bit filter fits into 16 bits. */
+
+template <int nTaps>
+static inline __m256i filter_v_8bit(const uint8_t* p, ptrdiff_t stride, const __m256i* coeffs)
+{
+  __m256i sum = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)p)),
+                                   coeffs[0]);
+
+  for (int k=1;k<nTaps;k++) {
+    __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p+k*stride)));
+    sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(v, coeffs[k]));
+  }
+
+  return sum;
+}
+
+
+/* Vertical filter on the 16-bit output of the horizontal filter, computed with 32 bits
+   and shifted right by 6. 'coeffs' holds pairs of taps as 16-bit values. */
+
+template <int nTaps>
+static inline __m256i filter_v_16bit(const int16_t* p, ptrdiff_t stride, const __m256i* coeffs)
+{
+  __m256i lo = _mm256_setzero_si256();
+  __m256i hi = _mm256_setzero_si256();
+
+  for (int k=0;k<nTaps;k+=2) {
+    __m256i a = _mm256_load_si256((const __m256i*)(p+k*stride));
+    __m256i b = (k+1<nTaps ?
+                 _mm256_load_si256((const __m256i*)(p+(k+1)*stride)) :
+                 _mm256_setzero_si256());
+
+    lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a,b), coeffs[k/2]));
+    hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a,b), coeffs[k/2]));
+  }
+
+  return _mm256_packs_epi32(_mm256_srai_epi32(lo,6), _mm256_srai_epi32(hi,6));
+}
+
+
+static void init_v_coeffs_8bit(__m256i* coeffs, const int8_t* taps, int nTaps)
+{
+  for (int k=0;k<nTaps;k++) {
+    coeffs[k] = _mm256_set1_epi16(taps[k]);
+  }
+}
+
+static void init_v_coeffs_16bit(__m256i* coeffs, const int8_t* taps, int nTaps)
+{
+  for (int k=0;k<nTaps;k+=2) {
+    int16_t t1 = (k+1<nTaps ? taps[k+1] : 0);
+    coeffs[k/2] = _mm256_set1_epi32((int)(((uint32_t)(uint16_t)t1<<16) | (uint16_t)taps[k]));
+  }
+}
+
+
+template <int nTapsH, int nTapsV>
+static void filter_hv(int16_t *dst, ptrdiff_t dststride,
+                      const uint8_t *src, ptrdiff_t srcstride, // first input sample
+                      int width, int height,
+                      const h_filter<nTapsH>& hfilter, const __m256i* vcoeffs)
+{
+  ALIGNED_32(int16_t tmp[(MAX_PB_SIZE+7)*16]);
+
+  const int nRows = height + nTapsV-1;
+
+  for (int x=0;x<width;x+=16) {
+    for (int y=0;y<nRows;y++) {
+      _mm256_store_si256((__m256i*)&tmp[y*16], hfilter.filter(src + y*srcstride + x));
+    }
+
+    for (int y=0;y<height;y++) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x],
+                          filter_v_16bit<nTapsV>(&tmp[y*16], 16, vcoeffs));
+    }
+  }
+}
+
+
+typedef void (*qpel_func)(int16_t *dst, ptrdiff_t dststride,
+                          const uint8_t *src, ptrdiff_t srcstride,
+                          int width, int height, int16_t* mcbuffer);
+
+typedef void (*epel_func)(int16_t *dst, ptrdiff_t dststride,
+                          const uint8_t *src, ptrdiff_t srcstride,
+                          int width, int height,
+                          int mx, int my, int16_t* mcbuffer, int bit_depth);
+
+
+// --- quarter-sample luma interpolation ---
+
+void ff_hevc_put_hevc_qpel_pixels_8_avx2(int16_t *dst, ptrdiff_t dststride,
+                                         const uint8_t *src, ptrdiff_t srcstride,
+                                         int width, int height, int16_t* mcbuffer)
+{
+  const int w16 = width & ~15;
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&src[y*srcstride+x]));
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], _mm256_slli_epi16(v,6));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_qpel_pixels_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                       width-w16, height, mcbuffer);
+  }
+}
+
+
+static void qpel_h(int xFrac, qpel_func sse_func,
+                   int16_t *dst, ptrdiff_t dststride,
+                   const uint8_t *src, ptrdiff_t srcstride,
+                   int width, int height, int16_t* mcbuffer)
+{
+  const int w16 = width & ~15;
+  const h_filter<8> hfilter(qpel_filters[xFrac], qpel_h_shuffle);
+
+  const uint8_t* in = src - qpel_extra_before[xFrac];
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], hfilter.filter(&in[y*srcstride+x]));
+    }
+  }
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer);
+  }
+}
+
+
+static void qpel_v(int yFrac, qpel_func sse_func,
+                   int16_t *dst, ptrdiff_t dststride,
+                   const uint8_t *src, ptrdiff_t srcstride,
+                   int width, int height, int16_t* mcbuffer)
+{
+  const int w16 = width & ~15;
+
+  __m256i coeffs[8];
+  init_v_coeffs_8bit(coeffs, qpel_filters[yFrac], 8);
+
+  const uint8_t* in = src - qpel_extra_before[yFrac]*srcstride;
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      __m256i v;
+      if (qpel_taps[yFrac]==8) { v = filter_v_8bit<8>(&in[y*srcstride+x], srcstride, coeffs); }
+      else                     { v = filter_v_8bit<7>(&in[y*srcstride+x], srcstride, coeffs); }
+
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], v);
+    }
+  }
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer);
+  }
+}
+
+
+static void qpel_hv(int xFrac, int yFrac, qpel_func sse_func,
+                    int16_t *dst, ptrdiff_t dststride,
+                    const uint8_t *src, ptrdiff_t srcstride,
+                    int width, int height, int16_t* mcbuffer)
+{
+  const int w16 = width & ~15;
+  const h_filter<8> hfilter(qpel_filters[xFrac], qpel_h_shuffle);
+
+  __m256i vcoeffs[4];
+  init_v_coeffs_16bit(vcoeffs, qpel_filters[yFrac], 8);
+
+  const uint8_t* in = src - qpel_extra_before[yFrac]*srcstride - qpel_extra_before[xFrac];
+
+  if (qpel_taps[yFrac]==8) {
+    filter_hv<8,8>(dst,dststride, in,srcstride, w16,height, hfilter,vcoeffs);
+  }
+  else {
+    filter_hv<8,7>(dst,dststride, in,srcstride, w16,height, hfilter,vcoeffs);
+  }
+
+  if (w16<width) {
+    sse_func(dst+w16, dststride, src+w16, srcstride, width-w16, height, mcbuffer);
+  }
+}
+
+
+#define QPEL_H(xFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _8_avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                    const uint8_t *src, ptrdiff_t srcstride, \
+                                                    int width, int height, int16_t* mcbuffer) \
+  {                                                                     \
+    qpel_h(xFrac, ff_hevc_put_hevc_qpel_h_ ## xFrac ## _8_sse,          \
+           dst,dststride, src,srcstride, width,height, mcbuffer);       \
+  }
+
+#define QPEL_V(yFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_v_ ## yFrac ## _8_avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                    const uint8_t *src, ptrdiff_t srcstride, \
+                                                    int width, int height, int16_t* mcbuffer) \
+  {                                                                     \
+    qpel_v(yFrac, ff_hevc_put_hevc_qpel_v_ ## yFrac ## _8_sse,          \
+           dst,dststride, src,srcstride, width,height, mcbuffer);       \
+  }
+
+#define QPEL_HV(xFrac,yFrac)                                            \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _v_ ## yFrac ## _avx2(int16_t *dst, ptrdiff_t dststride, \
+                                                                  const uint8_t *src, ptrdiff_t srcstride, \
+                                                                  int width, int height, int16_t* mcbuffer) \
+  {                                                                     \
+    qpel_hv(xFrac,yFrac, ff_hevc_put_hevc_qpel_h_ ## xFrac ## _v_ ## yFrac ## _sse, \
+            dst,dststride, src,srcstride, width,height, mcbuffer);      \
+  }
+
+QPEL_H(1)
+QPEL_H(2)
+QPEL_H(3)
+
+QPEL_V(1)
+QPEL_V(2)
+QPEL_V(3)
+
+QPEL_HV(1,1)
+QPEL_HV(1,2)
+QPEL_HV(1,3)
+QPEL_HV(2,1)
+QPEL_HV(2,2)
+QPEL_HV(2,3)
+QPEL_HV(3,1)
+QPEL_HV(3,2)
+QPEL_HV(3,3)
+
+
+// --- eighth-sample chroma interpolation ---
+
+void ff_hevc_put_hevc_epel_pixels_8_avx2(int16_t *dst, ptrdiff_t dststride,
+                                         const uint8_t *src, ptrdiff_t srcstride,
+                                         int width, int height,
+                                         int mx, int my, int16_t* mcbuffer)
+{
+  const int w16 = width & ~15;
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&src[y*srcstride+x]));
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], _mm256_slli_epi16(v,6));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_pixels_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                       width-w16, height, mx,my, mcbuffer);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_h_8_avx2(int16_t *dst, ptrdiff_t dststride,
+                                    const uint8_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = width & ~15;
+  const h_filter<4> hfilter(epel_filters[mx], epel_h_shuffle);
+
+  const uint8_t* in = src - epel_extra_before;
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x], hfilter.filter(&in[y*srcstride+x]));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_h_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                  width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_v_8_avx2(int16_t *dst, ptrdiff_t dststride,
+                                    const uint8_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = width & ~15;
+
+  __m256i coeffs[4];
+  init_v_coeffs_8bit(coeffs, epel_filters[my], 4);
+
+  const uint8_t* in = src - epel_extra_before*srcstride;
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w16;x+=16) {
+      _mm256_storeu_si256((__m256i*)&dst[y*dststride+x],
+                          filter_v_8bit<4>(&in[y*srcstride+x], srcstride, coeffs));
+    }
+  }
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_v_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                  width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_hv_8_avx2(int16_t *dst, ptrdiff_t dststride,
+                                     const uint8_t *src, ptrdiff_t srcstride,
+                                     int width, int height,
+                                     int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w16 = width & ~15;
+  const h_filter<4> hfilter(epel_filters[mx], epel_h_shuffle);
+
+  __m256i vcoeffs[2];
+  init_v_coeffs_16bit(vcoeffs, epel_filters[my], 4);
+
+  const uint8_t* in = src - epel_extra_before*srcstride - epel_extra_before;
+
+  filter_hv<4,4>(dst,dststride, in,srcstride, w16,height, hfilter,vcoeffs);
+
+  if (w16<width) {
+    ff_hevc_put_hevc_epel_hv_8_sse(dst+w16, dststride, src+w16, srcstride,
+                                   width-w16, height, mx,my, mcbuffer, bit_depth);
+  }
+}
@@ -0,0 +1,475 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <emmintrin.h>
+#include <smmintrin.h>
+
+#include "sse-dct.h"
+#include "libde265/util.h"
+#include "libde265/fallback-dct.h"
+
+
+/* Residual reconstruction for samples with more than 8 bits, and for sparse
+   coefficient blocks of all bit depths.
+
+   The inverse transform is computed as two matrix multiplications, exactly as in
+   transform_idct_add() of the scalar code: the vertical pass is clipped to 16 bits,
+   the horizontal pass is added to the prediction and clipped to the bit depth.
+   Pairs of coefficients are multiplied with pairs of matrix entries by
+   _mm_madd_epi16(). Rows and columns after the last non-zero coefficient are skipped.
+   Hence, the cost is proportional to the area of the non-zero coefficients.
+ */
+
+
+void ff_hevc_add_residual_16_sse4(uint16_t *dst, ptrdiff_t stride,
+                                  const int32_t* r, int nT, int bit_depth)
+{
+  const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+
+  if (nT==4) {
+    for (int y=0;y<4;y++) {
+      __m128i d = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)&dst[y*stride]));
+      d = _mm_add_epi32(d, _mm_loadu_si128((const __m128i*)&r[y*4]));
+
+      d = _mm_min_epu16(_mm_packus_epi32(d,d), maxval);
+      _mm_storel_epi64((__m128i*)&dst[y*stride], d);
+    }
+
+    return;
+  }
+
+  for (int y=0;y<nT;y++) {
+    for (int x=0;x<nT;x+=8) {
+      __m128i d  = _mm_loadu_si128((const __m128i*)&dst[y*stride+x]);
+      __m128i lo = _mm_cvtepu16_epi32(d);
+      __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(d,8));
+
+      lo = _mm_add_epi32(lo, _mm_loadu_si128((const __m128i*)&r[y*nT+x]));
+      hi = _mm_add_epi32(hi, _mm_loadu_si128((const __m128i*)&r[y*nT+x+4]));
+
+      d = _mm_min_epu16(_mm_packus_epi32(lo,hi), maxval);
+      _mm_storeu_si128((__m128i*)&dst[y*stride+x], d);
+    }
+  }
+}
+
+
+// pair of matrix entries (m0,m1) as 16-bit values for _mm_madd_epi16()
+
+static inline __m128i matrix_pair(int m0, int m1)
+{
+  return _mm_set1_epi32((int)(((uint32_t)(uint16_t)m1<<16) | (uint16_t)m0));
+}
+
+
+/* Find the last row and the last column that contain a non-zero coefficient.
+   Returns false if all coefficients are zero. */
+
+static bool find_last_coefficient(const int16_t* coeffs, int nT, int* lastRow, int* lastCol)
+{
+  uint16_t colOr[32];
+  memset(colOr, 0, nT*sizeof(uint16_t));
+
+  *lastRow = -1;
+
+  for (int y=0;y<nT;y++) {
+    uint16_t rowOr=0;
+    for (int x=0;x<nT;x++) {
+      uint16_t c = coeffs[y*nT+x];
+      rowOr    |= c;
+      colOr[x] |= c;
+    }
+
+    if (rowOr) { *lastRow=y; }
+  }
+
+  if (*lastRow<0) {
+    return false;
+  }
+
+  int x=nT-1;
+  while (colOr[x]==0) { x--; }
+  *lastCol = x;
+
+  return true;
+}
+
+
+/* All coefficients after 'lastRow' and 'lastCol' must be zero.
+   With pixel_t==int32_t, the residual is written to 'dst' instead of being added. */
+
+template <class pixel_t, int nT>
+static void transform_idct_add(pixel_t *dst, ptrdiff_t stride, const int16_t *coeffs,
+                               int lastRow, int lastCol, int bit_depth)
+{
+  const int fact = 32/nT;
+  const int W = (nT<8 ? nT : 8); // columns processed in one register
+
+
+  /* Interleaved pairs of matrix rows (j,j+1): mpairs[j/2][i] holds the 16-bit entries
+     mat_dct[fact*j][i] and mat_dct[fact*(j+1)][i], for all rows that are used. */
+
+  ALIGNED_16(int32_t mpairs[nT/2][nT]);
+
+  const int lastPair = (lastRow>lastCol ? lastRow : lastCol)/2;
+
+  for (int j=0;j<=2*lastPair;j+=2) {
+    for (int i=0;i<nT;i+=W) {
+      __m128i m0 = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)&mat_dct[fact* j   ][i]));
+      __m128i m1 = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i*)&mat_dct[fact*(j+1)][i]));
+
+      _mm_store_si128((__m128i*)&mpairs[j/2][i], _mm_unpacklo_epi16(m0,m1));
+      if (W==8) {
+        _mm_store_si128((__m128i*)&mpairs[j/2][i+4], _mm_unpackhi_epi16(m0,m1));
+      }
+    }
+  }
+
+
+  // --- vertical pass ---
+
+  /* Columns are computed in groups of W. Columns of 'g' after the group containing
+     the last non-zero column are zero and are never read in the horizontal pass. */
+
+  ALIGNED_16(int16_t g[nT*nT]);
+
+  const __m128i rnd1 = _mm_set1_epi32(1<<6);
+
+  for (int c=0;c<=lastCol;c+=W) {
+    for (int i=0;i<nT;i++) {
+      __m128i lo = _mm_setzero_si128();
+      __m128i hi = _mm_setzero_si128();
+
+      for (int j=0;j<=lastRow;j+=2) {
+        __m128i m = _mm_set1_epi32(mpairs[j/2][i]);
+
+        __m128i a,b;
+        if (W==8) {
+          a = _mm_loadu_si128((const __m128i*)&coeffs[ j   *nT+c]);
+          b = _mm_loadu_si128((const __m128i*)&coeffs[(j+1)*nT+c]);
+        }
+        else {
+          a = _mm_loadl_epi64((const __m128i*)&coeffs[ j   *nT+c]);
+          b = _mm_loadl_epi64((const __m128i*)&coeffs[(j+1)*nT+c]);
+        }
+
+        lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a,b), m));
+        if (W==8) {
+          hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a,b), m));
+        }
+      }
+
+      // saturating pack == Clip3(-32768,32767, ...)
+
+      lo = _mm_srai_epi32(_mm_add_epi32(lo, rnd1), 7);
+      hi = _mm_srai_epi32(_mm_add_epi32(hi, rnd1), 7);
+      __m128i v = _mm_packs_epi32(lo,hi);
+
+      if (W==8) { _mm_store_si128((__m128i*)&g[i*nT+c], v); }
+      else      { _mm_storel_epi64((__m128i*)&g[i*nT+c], v); }
+    }
+  }
+
+
+  // --- horizontal pass ---
+
+  const int postShift = 20-bit_depth;
+  const __m128i rnd2   = _mm_set1_epi32(1<<(postShift-1));
+  const __m128i shift  = _mm_cvtsi32_si128(postShift);
+  const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+
+  for (int y=0;y<nT;y++) {
+
+    // sums for the whole row, four samples per register
+
+    __m128i sum[nT/4];
+    for (int k=0;k<nT/4;k++) { sum[k] = _mm_setzero_si128(); }
+
+    for (int j=0;j<=lastCol;j+=2) {
+      int32_t pair;
+      memcpy(&pair, &g[y*nT+j], sizeof(pair));
+      __m128i gg = _mm_set1_epi32(pair);
+
+      for (int k=0;k<nT/4;k++) {
+        sum[k] = _mm_add_epi32(sum[k], _mm_madd_epi16(gg, _mm_load_si128((const __m128i*)&mpairs[j/2][4*k])));
+      }
+    }
+
+    for (int i=0;i<nT;i+=W) {
+      __m128i lo = _mm_sra_epi32(_mm_add_epi32(sum[i/4], rnd2), shift);
+      __m128i hi = (W==8 ? _mm_sra_epi32(_mm_add_epi32(sum[i/4+(W/8)], rnd2), shift) : lo);
+
+      pixel_t* out = &dst[y*stride+i];
+
+      if (sizeof(pixel_t)==4) {
+        _mm_storeu_si128((__m128i*)&out[0], lo);
+        if (W==8) { _mm_storeu_si128((__m128i*)&out[4], hi); }
+      }
+      else if (sizeof(pixel_t)==1) {
+        // the saturating packs clip to 0..255
+
+        if (W==8) {
+          __m128i d = _mm_loadl_epi64((const __m128i*)out);
+          lo = _mm_add_epi32(lo, _mm_cvtepu8_epi32(d));
+          hi = _mm_add_epi32(hi, _mm_cvtepu8_epi32(_mm_srli_si128(d,4)));
+
+          __m128i v = _mm_packs_epi32(lo,hi);
+          _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(v,v));
+        }
+        else {
+          int32_t d4;
+          memcpy(&d4, out, 4);
+          lo = _mm_add_epi32(lo, _mm_cvtepu8_epi32(_mm_cvtsi32_si128(d4)));
+
+          __m128i v = _mm_packs_epi32(lo,lo);
+          d4 = _mm_cvtsi128_si32(_mm_packus_epi16(v,v));
+          memcpy(out, &d4, 4);
+        }
+      }
+      else if (W==8) {
+        __m128i d = _mm_loadu_si128((const __m128i*)out);
+        lo = _mm_add_epi32(lo, _mm_cvtepu16_epi32(d));
+        hi = _mm_add_epi32(hi, _mm_cvtepu16_epi32(_mm_srli_si128(d,8)));
+
+        _mm_storeu_si128((__m128i*)out, _mm_min_epu16(_mm_packus_epi32(lo,hi), maxval));
+      }
+      else {
+        __m128i d = _mm_loadl_epi64((const __m128i*)out);
+        lo = _mm_add_epi32(lo, _mm_cvtepu16_epi32(d));
+
+        _mm_storel_epi64((__m128i*)out, _mm_min_epu16(_mm_packus_epi32(lo,lo), maxval));
+      }
+    }
+  }
+}
+
+
+template <int nT>
+static void transform_idct_add_16(uint16_t *dst, ptrdiff_t stride,
+                                  const int16_t *coeffs, int bit_depth)
+{
+  int lastRow, lastCol;
+  if (!find_last_coefficient(coeffs, nT, &lastRow, &lastCol)) {
+    return;
+  }
+
+  transform_idct_add<uint16_t,nT>(dst,stride, coeffs, lastRow,lastCol, bit_depth);
+}
+
+
+void ff_hevc_transform_4x4_add_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                       ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add_16<4>(dst,stride, coeffs, bit_depth);
+}
+
+void ff_hevc_transform_8x8_add_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                       ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add_16<8>(dst,stride, coeffs, bit_depth);
+}
+
+void ff_hevc_transform_16x16_add_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                         ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add_16<16>(dst,stride, coeffs, bit_depth);
+}
+
+void ff_hevc_transform_32x32_add_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                         ptrdiff_t stride, int bit_depth)
+{
+  transform_idct_add_16<32>(dst,stride, coeffs, bit_depth);
+}
+
+
+// --- sparse blocks ---
+
+/* The DC-only kernels add the residual with signed 16-bit arithmetic, which is
+   exact up to MAX_SIMD_BIT_DEPTH. Deeper samples are passed to the fallback function. */
+
+#define MAX_SIMD_BIT_DEPTH 14
+
+void ff_hevc_transform_add_dc_8_sse4(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT)
+{
+  int r = idct_dc_residual(dc, 8);
+
+  // add |r| or subtract |r| with unsigned saturation
+
+  __m128i add = _mm_set1_epi8((char)Clip3(0,255, r));
+  __m128i sub = _mm_set1_epi8((char)Clip3(0,255,-r));
+
+  if (nT==4) {
+    for (int y=0;y<4;y++) {
+      int32_t d4;
+      memcpy(&d4, &dst[y*stride], 4);
+      __m128i d = _mm_subs_epu8(_mm_adds_epu8(_mm_cvtsi32_si128(d4), add), sub);
+      d4 = _mm_cvtsi128_si32(d);
+      memcpy(&dst[y*stride], &d4, 4);
+    }
+  }
+  else if (nT==8) {
+    for (int y=0;y<8;y++) {
+      __m128i d = _mm_loadl_epi64((const __m128i*)&dst[y*stride]);
+      _mm_storel_epi64((__m128i*)&dst[y*stride], _mm_subs_epu8(_mm_adds_epu8(d, add), sub));
+    }
+  }
+  else {
+    for (int y=0;y<nT;y++)
+      for (int x=0;x<nT;x+=16) {
+        __m128i d = _mm_loadu_si128((const __m128i*)&dst[y*stride+x]);
+        _mm_storeu_si128((__m128i*)&dst[y*stride+x], _mm_subs_epu8(_mm_adds_epu8(d, add), sub));
+      }
+  }
+}
+
+
+void ff_hevc_transform_add_dc_16_sse4(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT,
+                                      int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    transform_add_dc_16_fallback(dst,stride, dc, nT, bit_depth);
+    return;
+  }
+
+  // Clipping the residual to the sample range does not change the result,
+  // but the sum cannot overflow 16 bits.
+
+  const int maxSample = (1<<bit_depth)-1;
+  int r = Clip3(-maxSample,maxSample, idct_dc_residual(dc, bit_depth));
+
+  const __m128i res    = _mm_set1_epi16(r);
+  const __m128i maxval = _mm_set1_epi16(maxSample);
+  const __m128i zero   = _mm_setzero_si128();
+
+  if (nT==4) {
+    for (int y=0;y<4;y++) {
+      __m128i d = _mm_add_epi16(_mm_loadl_epi64((const __m128i*)&dst[y*stride]), res);
+      _mm_storel_epi64((__m128i*)&dst[y*stride], _mm_min_epi16(_mm_max_epi16(d, zero), maxval));
+    }
+  }
+  else {
+    for (int y=0;y<nT;y++)
+      for (int x=0;x<nT;x+=8) {
+        __m128i d = _mm_add_epi16(_mm_loadu_si128((const __m128i*)&dst[y*stride+x]), res);
+        _mm_storeu_si128((__m128i*)&dst[y*stride+x], _mm_min_epi16(_mm_max_epi16(d, zero), maxval));
+      }
+  }
+}
+
+
+/* For 8-bit samples, the butterfly kernels in sse-dct.cc are faster than the matrix
+   multiplication unless only a small part of a 32x32 block is non-zero. */
+
+void ff_hevc_transform_8x8_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs,
+                                             ptrdiff_t stride, int extent)
+{
+  (void)extent;
+  ff_hevc_transform_8x8_add_8_sse4(dst, coeffs, stride);
+}
+
+void ff_hevc_transform_16x16_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs,
+                                               ptrdiff_t stride, int extent)
+{
+  (void)extent;
+  ff_hevc_transform_16x16_add_8_sse4(dst, coeffs, stride);
+}
+
+void ff_hevc_transform_32x32_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs,
+                                               ptrdiff_t stride, int extent)
+{
+  if (extent > 8) {
+    ff_hevc_transform_32x32_add_8_sse4(dst, coeffs, stride);
+  }
+  else {
+    transform_idct_add<uint8_t,32>(dst,stride, coeffs, extent-1,extent-1, 8);
+  }
+}
+
+
+void ff_hevc_transform_8x8_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                              ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t,8>(dst,stride, coeffs, extent-1,extent-1, bit_depth);
+}
+
+void ff_hevc_transform_16x16_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                                ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t,16>(dst,stride, coeffs, extent-1,extent-1, bit_depth);
+}
+
+void ff_hevc_transform_32x32_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs,
+                                                ptrdiff_t stride, int extent, int bit_depth)
+{
+  transform_idct_add<uint16_t,32>(dst,stride, coeffs, extent-1,extent-1, bit_depth);
+}
+
+
+// --- residuals for cross-component prediction ---
+
+/* The vertical pass saturates to 16 bits, hence only max_coeff_bits==15 is supported.
+   The postShift of the horizontal pass is bdShift = 20-bit_depth. */
+
+template <int nT>
+static void transform_idct_residual(int32_t *dst, const int16_t *coeffs,
+                                    int bdShift, int max_coeff_bits)
+{
+  (void)max_coeff_bits;
+
+  int lastRow, lastCol;
+  if (!find_last_coefficient(coeffs, nT, &lastRow, &lastCol)) {
+    memset(dst, 0, nT*nT*sizeof(int32_t));
+    return;
+  }
+
+  transform_idct_add<int32_t,nT>(dst,nT, coeffs, lastRow,lastCol, 20-bdShift);
+}
+
+
+void transform_idct_8x8_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_8x8_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  transform_idct_residual<8>(dst, coeffs, bdShift, max_coeff_bits);
+}
+
+void transform_idct_16x16_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_16x16_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  transform_idct_residual<16>(dst, coeffs, bdShift, max_coeff_bits);
+}
+
+void transform_idct_32x32_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits)
+{
+  if (max_coeff_bits != 15) {
+    transform_idct_32x32_fallback(dst, coeffs, bdShift, max_coeff_bits);
+    return;
+  }
+
+  transform_idct_residual<32>(dst, coeffs, bdShift, max_coeff_bits);
+}
@@ -32,4 +32,35 @@ void ff_hevc_transform_8x8_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdi
 void ff_hevc_transform_16x16_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 void ff_hevc_transform_32x32_add_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride);
 
+void ff_hevc_transform_add_dc_8_sse4(uint8_t *dst, ptrdiff_t stride, int16_t dc, int nT);
+void ff_hevc_transform_8x8_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+void ff_hevc_transform_16x16_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+void ff_hevc_transform_32x32_add_sparse_8_sse4(uint8_t *dst, const int16_t *coeffs, ptrdiff_t stride, int extent);
+
+
+// samples with more than 8 bits
+
+void ff_hevc_add_residual_16_sse4(uint16_t *dst, ptrdiff_t stride,
+                                  const int32_t* r, int nT, int bit_depth);
+
+void ff_hevc_transform_4x4_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void ff_hevc_transform_8x8_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void ff_hevc_transform_16x16_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+void ff_hevc_transform_32x32_add_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride, int bit_depth);
+
+void ff_hevc_transform_add_dc_16_sse4(uint16_t *dst, ptrdiff_t stride, int16_t dc, int nT, int bit_depth);
+void ff_hevc_transform_8x8_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                              int extent, int bit_depth);
+void ff_hevc_transform_16x16_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                                int extent, int bit_depth);
+void ff_hevc_transform_32x32_add_sparse_16_sse4(uint16_t *dst, const int16_t *coeffs, ptrdiff_t stride,
+                                                int extent, int bit_depth);
+
+
+// residuals (all bit depths)
+
+void transform_idct_8x8_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_16x16_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+void transform_idct_32x32_sse4(int32_t *dst, const int16_t *coeffs, int bdShift, int max_coeff_bits);
+
 #endif
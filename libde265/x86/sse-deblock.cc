@@ -0,0 +1,479 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+
+#include "sse-deblock.h"
+#include "libde265/fallback-deblock.h"
+
+
+/* Deblocking of an edge group (8 lines), computed exactly as in fallback-deblock.h.
+
+   Each line of the group is one 16-bit lane, such that the samples at the same
+   distance to the edge form one vector (p3..p0, q0..q3). Lanes 0-3 are the first
+   segment, lanes 4-7 the second one. Vertical edges are transposed in and out.
+   The decisions are made on lines 0 and 3 of each segment and broadcast to the
+   other lines of the segment.
+
+   With 16-bit lanes, the intermediate values are exact for bit depths up to
+   MAX_SIMD_BIT_DEPTH, deeper samples are passed to the fallback functions.
+ */
+
+#define MAX_SIMD_BIT_DEPTH 12
+
+
+static inline __m128i load_4(const void* src)
+{
+  int32_t v;
+  memcpy(&v, src, 4);
+  return _mm_cvtsi32_si128(v);
+}
+
+static inline void store_4(void* dst, __m128i v)
+{
+  int32_t d = _mm_cvtsi128_si32(v);
+  memcpy(dst, &d, 4);
+}
+
+static inline void store_2(void* dst, int v)
+{
+  int16_t d = v;
+  memcpy(dst, &d, 2);
+}
+
+
+// one value for each segment
+static inline __m128i segment_values(int v0, int v1)
+{
+  return _mm_set_epi16(v1,v1,v1,v1, v0,v0,v0,v0);
+}
+
+static inline __m128i segment_mask(bool f0, bool f1)
+{
+  return segment_values(-(int)f0, -(int)f1);
+}
+
+// broadcast line 0 / line 3 of each segment to all lines of the segment
+static inline __m128i first_line(__m128i v)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x00), 0x00);
+}
+
+static inline __m128i last_line(__m128i v)
+{
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+}
+
+static inline __m128i clip(__m128i v, __m128i lo, __m128i hi)
+{
+  return _mm_min_epi16(_mm_max_epi16(v, lo), hi);
+}
+
+
+static inline void transpose_8x8_16(__m128i r[8])
+{
+  __m128i a0 = _mm_unpacklo_epi16(r[0],r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0],r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2],r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2],r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4],r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4],r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6],r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6],r[7]);
+
+  __m128i b0 = _mm_unpacklo_epi32(a0,a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0,a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1,a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1,a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4,a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4,a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5,a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5,a7);
+
+  r[0] = _mm_unpacklo_epi64(b0,b4);
+  r[1] = _mm_unpackhi_epi64(b0,b4);
+  r[2] = _mm_unpacklo_epi64(b1,b5);
+  r[3] = _mm_unpackhi_epi64(b1,b5);
+  r[4] = _mm_unpacklo_epi64(b2,b6);
+  r[5] = _mm_unpackhi_epi64(b2,b6);
+  r[6] = _mm_unpacklo_epi64(b3,b7);
+  r[7] = _mm_unpackhi_epi64(b3,b7);
+}
+
+
+// --- luma ---
+
+/* s[0..7] = p3,p2,p1,p0,q0,q1,q2,q3. Filtered samples are written back to s[1..6].
+ */
+static inline void luma_filter(__m128i s[8], const int beta[2], const int tc[2],
+                               const bool filterP[2], const bool filterQ[2], int maxval)
+{
+  const __m128i p3 = s[0], p2 = s[1], p1 = s[2], p0 = s[3];
+  const __m128i q0 = s[4], q1 = s[5], q2 = s[6], q3 = s[7];
+
+  const __m128i vbeta = segment_values(beta[0], beta[1]);
+  const __m128i vtc   = segment_values(tc[0],   tc[1]);
+  const __m128i zero  = _mm_setzero_si128();
+
+
+  // --- decisions (8.7.2.4.3) ---
+
+  __m128i dp = _mm_abs_epi16(_mm_sub_epi16(_mm_add_epi16(p2,p0), _mm_add_epi16(p1,p1)));
+  __m128i dq = _mm_abs_epi16(_mm_sub_epi16(_mm_add_epi16(q2,q0), _mm_add_epi16(q1,q1)));
+  __m128i dpq = _mm_add_epi16(dp,dq);
+
+  __m128i d = _mm_add_epi16(first_line(dpq), last_line(dpq));
+  __m128i filterOn = _mm_cmpgt_epi16(vbeta, d);
+
+  __m128i dSam = _mm_cmpgt_epi16(_mm_srai_epi16(vbeta,2), _mm_add_epi16(dpq,dpq));
+  __m128i flat = _mm_add_epi16(_mm_abs_epi16(_mm_sub_epi16(p3,p0)),
+                               _mm_abs_epi16(_mm_sub_epi16(q0,q3)));
+  dSam = _mm_and_si128(dSam, _mm_cmpgt_epi16(_mm_srai_epi16(vbeta,3), flat));
+  __m128i tc5 = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(vtc, _mm_set1_epi16(5)),
+                                             _mm_set1_epi16(1)), 1);
+  dSam = _mm_and_si128(dSam, _mm_cmpgt_epi16(tc5, _mm_abs_epi16(_mm_sub_epi16(p0,q0))));
+
+  __m128i strong = _mm_and_si128(filterOn, _mm_and_si128(first_line(dSam), last_line(dSam)));
+
+  __m128i sideThreshold = _mm_srai_epi16(_mm_add_epi16(vbeta, _mm_srai_epi16(vbeta,1)), 3);
+  __m128i dEp = _mm_cmpgt_epi16(sideThreshold, _mm_add_epi16(first_line(dp), last_line(dp)));
+  __m128i dEq = _mm_cmpgt_epi16(sideThreshold, _mm_add_epi16(first_line(dq), last_line(dq)));
+
+
+  // --- strong filter ---
+
+  const __m128i four = _mm_set1_epi16(4);
+  const __m128i two  = _mm_set1_epi16(2);
+  const __m128i tc2  = _mm_add_epi16(vtc,vtc);
+
+  __m128i p0q0 = _mm_add_epi16(p0,q0);
+  __m128i p1p0q0q1 = _mm_add_epi16(p0q0, _mm_add_epi16(p1,q1));
+
+  // (p2 + 2*p1 + 2*p0 + 2*q0 + q1 + 4)>>3
+  __m128i sp0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p1p0q0q1, p1p0q0q1),
+                                             _mm_add_epi16(_mm_sub_epi16(p2,q1), four)), 3);
+  // (p2 + p1 + p0 + q0 + 2)>>2
+  __m128i sp1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p2,p1), _mm_add_epi16(p0q0,two)), 2);
+  // (2*p3 + 3*p2 + p1 + p0 + q0 + 4)>>3
+  __m128i sp2 = _mm_add_epi16(_mm_add_epi16(p3,p3), _mm_add_epi16(_mm_add_epi16(p2,p2), p2));
+  sp2 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sp2,p1), _mm_add_epi16(p0q0,four)), 3);
+
+  // (p1 + 2*p0 + 2*q0 + 2*q1 + q2 + 4)>>3
+  __m128i sq0 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p1p0q0q1, p1p0q0q1),
+                                             _mm_add_epi16(_mm_sub_epi16(q2,p1), four)), 3);
+  // (p0 + q0 + q1 + q2 + 2)>>2
+  __m128i sq1 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q2,q1), _mm_add_epi16(p0q0,two)), 2);
+  // (p0 + q0 + q1 + 3*q2 + 2*q3 + 4)>>3
+  __m128i sq2 = _mm_add_epi16(_mm_add_epi16(q3,q3), _mm_add_epi16(_mm_add_epi16(q2,q2), q2));
+  sq2 = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(sq2,q1), _mm_add_epi16(p0q0,four)), 3);
+
+  sp0 = clip(sp0, _mm_sub_epi16(p0,tc2), _mm_add_epi16(p0,tc2));
+  sp1 = clip(sp1, _mm_sub_epi16(p1,tc2), _mm_add_epi16(p1,tc2));
+  sp2 = clip(sp2, _mm_sub_epi16(p2,tc2), _mm_add_epi16(p2,tc2));
+  sq0 = clip(sq0, _mm_sub_epi16(q0,tc2), _mm_add_epi16(q0,tc2));
+  sq1 = clip(sq1, _mm_sub_epi16(q1,tc2), _mm_add_epi16(q1,tc2));
+  sq2 = clip(sq2, _mm_sub_epi16(q2,tc2), _mm_add_epi16(q2,tc2));
+
+
+  // --- weak filter ---
+
+  // delta = (9*(q0-p0) - 3*(q1-p1) + 8)>>4, computed in 32 bit
+
+  const __m128i w93 = _mm_set_epi16(-3,9,-3,9,-3,9,-3,9);
+  __m128i d0 = _mm_sub_epi16(q0,p0);
+  __m128i d1 = _mm_sub_epi16(q1,p1);
+  __m128i deltaLo = _mm_madd_epi16(_mm_unpacklo_epi16(d0,d1), w93);
+  __m128i deltaHi = _mm_madd_epi16(_mm_unpackhi_epi16(d0,d1), w93);
+  deltaLo = _mm_srai_epi32(_mm_add_epi32(deltaLo, _mm_set1_epi32(8)), 4);
+  deltaHi = _mm_srai_epi32(_mm_add_epi32(deltaHi, _mm_set1_epi32(8)), 4);
+  __m128i delta = _mm_packs_epi32(deltaLo, deltaHi);
+
+  __m128i tc10 = _mm_mullo_epi16(vtc, _mm_set1_epi16(10));
+  __m128i weak = _mm_andnot_si128(strong, filterOn);
+  weak = _mm_and_si128(weak, _mm_cmpgt_epi16(tc10, _mm_abs_epi16(delta)));
+
+  delta = clip(delta, _mm_sub_epi16(zero,vtc), vtc);
+
+  const __m128i vmax = _mm_set1_epi16(maxval);
+
+  __m128i wp0 = clip(_mm_add_epi16(p0,delta), zero, vmax);
+  __m128i wq0 = clip(_mm_sub_epi16(q0,delta), zero, vmax);
+
+  __m128i tcHalf = _mm_srai_epi16(vtc,1);
+  __m128i tcHalfNeg = _mm_sub_epi16(zero,tcHalf);
+  __m128i one = _mm_set1_epi16(1);
+
+  // Clip3(-(tc>>1), tc>>1, (((p2+p0+1)>>1)-p1+delta)>>1)
+  __m128i deltaP = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p2,p0),one), 1);
+  deltaP = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(deltaP,p1), delta), 1);
+  deltaP = clip(deltaP, tcHalfNeg, tcHalf);
+  __m128i wp1 = clip(_mm_add_epi16(p1,deltaP), zero, vmax);
+
+  // Clip3(-(tc>>1), tc>>1, (((q2+q0+1)>>1)-q1-delta)>>1)
+  __m128i deltaQ = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q2,q0),one), 1);
+  deltaQ = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(deltaQ,q1), delta), 1);
+  deltaQ = clip(deltaQ, tcHalfNeg, tcHalf);
+  __m128i wq1 = clip(_mm_add_epi16(q1,deltaQ), zero, vmax);
+
+
+  // --- select the filtered samples ---
+
+  const __m128i maskP = segment_mask(filterP[0], filterP[1]);
+  const __m128i maskQ = segment_mask(filterQ[0], filterQ[1]);
+
+  __m128i strongP = _mm_and_si128(strong, maskP);
+  __m128i strongQ = _mm_and_si128(strong, maskQ);
+  __m128i weakP   = _mm_and_si128(weak,   maskP);
+  __m128i weakQ   = _mm_and_si128(weak,   maskQ);
+
+  s[1] = _mm_blendv_epi8(p2, sp2, strongP);
+  s[2] = _mm_blendv_epi8(_mm_blendv_epi8(p1, sp1, strongP), wp1, _mm_and_si128(weakP, dEp));
+  s[3] = _mm_blendv_epi8(_mm_blendv_epi8(p0, sp0, strongP), wp0, weakP);
+  s[4] = _mm_blendv_epi8(_mm_blendv_epi8(q0, sq0, strongQ), wq0, weakQ);
+  s[5] = _mm_blendv_epi8(_mm_blendv_epi8(q1, sq1, strongQ), wq1, _mm_and_si128(weakQ, dEq));
+  s[6] = _mm_blendv_epi8(q2, sq2, strongQ);
+}
+
+
+void deblock_luma_v_8_sse4(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                           const bool filterP[2], const bool filterQ[2])
+{
+  __m128i s[8];
+
+  for (int k=0;k<8;k++) {
+    s[k] = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(ptr-4+k*stride)));
+  }
+
+  transpose_8x8_16(s);
+  luma_filter(s, beta,tc, filterP,filterQ, 255);
+  transpose_8x8_16(s);
+
+  for (int k=0;k<8;k++) {
+    _mm_storel_epi64((__m128i*)(ptr-4+k*stride), _mm_packus_epi16(s[k],s[k]));
+  }
+}
+
+
+void deblock_luma_h_8_sse4(uint8_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                           const bool filterP[2], const bool filterQ[2])
+{
+  __m128i s[8];
+
+  for (int i=0;i<8;i++) {
+    s[i] = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(ptr+(i-4)*stride)));
+  }
+
+  luma_filter(s, beta,tc, filterP,filterQ, 255);
+
+  for (int i=1;i<7;i++) {
+    _mm_storel_epi64((__m128i*)(ptr+(i-4)*stride), _mm_packus_epi16(s[i],s[i]));
+  }
+}
+
+
+void deblock_luma_v_16_sse4(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                            const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    deblock_luma_v_16_fallback(ptr,stride, beta,tc, filterP,filterQ, bit_depth);
+    return;
+  }
+
+  __m128i s[8];
+
+  for (int k=0;k<8;k++) {
+    s[k] = _mm_loadu_si128((const __m128i*)(ptr-4+k*stride));
+  }
+
+  transpose_8x8_16(s);
+  luma_filter(s, beta,tc, filterP,filterQ, (1<<bit_depth)-1);
+  transpose_8x8_16(s);
+
+  for (int k=0;k<8;k++) {
+    _mm_storeu_si128((__m128i*)(ptr-4+k*stride), s[k]);
+  }
+}
+
+
+void deblock_luma_h_16_sse4(uint16_t* ptr, ptrdiff_t stride, const int beta[2], const int tc[2],
+                            const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    deblock_luma_h_16_fallback(ptr,stride, beta,tc, filterP,filterQ, bit_depth);
+    return;
+  }
+
+  __m128i s[8];
+
+  for (int i=0;i<8;i++) {
+    s[i] = _mm_loadu_si128((const __m128i*)(ptr+(i-4)*stride));
+  }
+
+  luma_filter(s, beta,tc, filterP,filterQ, (1<<bit_depth)-1);
+
+  for (int i=1;i<7;i++) {
+    _mm_storeu_si128((__m128i*)(ptr+(i-4)*stride), s[i]);
+  }
+}
+
+
+// --- chroma ---
+
+/* s[0..3] = p1,p0,q0,q1. Filtered samples are written back to s[1..2].
+ */
+static inline void chroma_filter(__m128i s[4], const int tc[2],
+                                 const bool filterP[2], const bool filterQ[2], int maxval)
+{
+  const __m128i p1 = s[0], p0 = s[1], q0 = s[2], q1 = s[3];
+
+  const __m128i vtc  = segment_values(tc[0], tc[1]);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i vmax = _mm_set1_epi16(maxval);
+
+  // Clip3(-tc,tc, ((((q0-p0)<<2)+p1-q1+4)>>3))
+  __m128i delta = _mm_slli_epi16(_mm_sub_epi16(q0,p0), 2);
+  delta = _mm_add_epi16(delta, _mm_sub_epi16(p1,q1));
+  delta = _mm_srai_epi16(_mm_add_epi16(delta, _mm_set1_epi16(4)), 3);
+  delta = clip(delta, _mm_sub_epi16(zero,vtc), vtc);
+
+  __m128i np0 = clip(_mm_add_epi16(p0,delta), zero, vmax);
+  __m128i nq0 = clip(_mm_sub_epi16(q0,delta), zero, vmax);
+
+  s[1] = _mm_blendv_epi8(p0, np0, segment_mask(filterP[0], filterP[1]));
+  s[2] = _mm_blendv_epi8(q0, nq0, segment_mask(filterQ[0], filterQ[1]));
+}
+
+
+// the 8 lines of p1,p0,q0,q1 as columns (4 samples in the low half of each r[k])
+static inline void transpose_8x4_16(const __m128i r[8], __m128i s[4])
+{
+  __m128i a0 = _mm_unpacklo_epi16(r[0],r[1]);
+  __m128i a1 = _mm_unpacklo_epi16(r[2],r[3]);
+  __m128i a2 = _mm_unpacklo_epi16(r[4],r[5]);
+  __m128i a3 = _mm_unpacklo_epi16(r[6],r[7]);
+
+  __m128i b0 = _mm_unpacklo_epi32(a0,a1);
+  __m128i b1 = _mm_unpackhi_epi32(a0,a1);
+  __m128i b2 = _mm_unpacklo_epi32(a2,a3);
+  __m128i b3 = _mm_unpackhi_epi32(a2,a3);
+
+  s[0] = _mm_unpacklo_epi64(b0,b2);
+  s[1] = _mm_unpackhi_epi64(b0,b2);
+  s[2] = _mm_unpacklo_epi64(b1,b3);
+  s[3] = _mm_unpackhi_epi64(b1,b3);
+}
+
+
+void deblock_chroma_v_8_sse4(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                             const bool filterP[2], const bool filterQ[2])
+{
+  __m128i r[8], s[4];
+
+  for (int k=0;k<8;k++) {
+    r[k] = _mm_cvtepu8_epi16(load_4(ptr-2+k*stride));
+  }
+
+  transpose_8x4_16(r,s);
+  chroma_filter(s, tc, filterP,filterQ, 255);
+
+  // (p0,q0) byte pairs of the 8 lines
+  __m128i pq = _mm_packus_epi16(_mm_unpacklo_epi16(s[1],s[2]), _mm_unpackhi_epi16(s[1],s[2]));
+
+  store_2(ptr-1+0*stride, _mm_extract_epi16(pq,0));
+  store_2(ptr-1+1*stride, _mm_extract_epi16(pq,1));
+  store_2(ptr-1+2*stride, _mm_extract_epi16(pq,2));
+  store_2(ptr-1+3*stride, _mm_extract_epi16(pq,3));
+  store_2(ptr-1+4*stride, _mm_extract_epi16(pq,4));
+  store_2(ptr-1+5*stride, _mm_extract_epi16(pq,5));
+  store_2(ptr-1+6*stride, _mm_extract_epi16(pq,6));
+  store_2(ptr-1+7*stride, _mm_extract_epi16(pq,7));
+}
+
+
+void deblock_chroma_h_8_sse4(uint8_t* ptr, ptrdiff_t stride, const int tc[2],
+                             const bool filterP[2], const bool filterQ[2])
+{
+  __m128i s[4];
+
+  for (int i=0;i<4;i++) {
+    s[i] = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(ptr+(i-2)*stride)));
+  }
+
+  chroma_filter(s, tc, filterP,filterQ, 255);
+
+  _mm_storel_epi64((__m128i*)(ptr-stride), _mm_packus_epi16(s[1],s[1]));
+  _mm_storel_epi64((__m128i*)(ptr),        _mm_packus_epi16(s[2],s[2]));
+}
+
+
+void deblock_chroma_v_16_sse4(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                              const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    deblock_chroma_v_16_fallback(ptr,stride, tc, filterP,filterQ, bit_depth);
+    return;
+  }
+
+  __m128i r[8], s[4];
+
+  for (int k=0;k<8;k++) {
+    r[k] = _mm_loadl_epi64((const __m128i*)(ptr-2+k*stride));
+  }
+
+  transpose_8x4_16(r,s);
+  chroma_filter(s, tc, filterP,filterQ, (1<<bit_depth)-1);
+
+  // (p0,q0) sample pairs of lines 0-3 and 4-7
+  __m128i pqLo = _mm_unpacklo_epi16(s[1],s[2]);
+  __m128i pqHi = _mm_unpackhi_epi16(s[1],s[2]);
+
+  store_4(ptr-1+0*stride, pqLo);
+  store_4(ptr-1+1*stride, _mm_srli_si128(pqLo,4));
+  store_4(ptr-1+2*stride, _mm_srli_si128(pqLo,8));
+  store_4(ptr-1+3*stride, _mm_srli_si128(pqLo,12));
+  store_4(ptr-1+4*stride, pqHi);
+  store_4(ptr-1+5*stride, _mm_srli_si128(pqHi,4));
+  store_4(ptr-1+6*stride, _mm_srli_si128(pqHi,8));
+  store_4(ptr-1+7*stride, _mm_srli_si128(pqHi,12));
+}
+
+
+void deblock_chroma_h_16_sse4(uint16_t* ptr, ptrdiff_t stride, const int tc[2],
+                              const bool filterP[2], const bool filterQ[2], int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    deblock_chroma_h_16_fallback(ptr,stride, tc, filterP,filterQ, bit_depth);
+    return;
+  }
+
+  __m128i s[4];
+
+  for (int i=0;i<4;i++) {
+    s[i] = _mm_loadu_si128((const __m128i*)(ptr+(i-2)*stride));
+  }
+
+  chroma_filter(s, tc, filterP,filterQ, (1<<bit_depth)-1);
+
+  _mm_storeu_si128((__m128i*)(ptr-stride), s[1]);
+  _mm_storeu_si128((__m128i*)(ptr),        s[2]);
+}
@@ -0,0 +1,624 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+
+#include "sse-intrapred.h"
+#include "libde265/util.h"
+#include "libde265/fallback-intrapred.h"
+
+
+/* Intra prediction, computed exactly as in fallback-intrapred.cc.
+
+   Samples with more than 8 bits are processed with 16-bit arithmetic (DC, reference
+   filtering) or 32-bit sums from _mm_madd_epi16() (planar, angular). This is exact for
+   bit depths up to MAX_SIMD_BIT_DEPTH, deeper samples are passed to the fallback functions.
+ */
+
+#define MAX_SIMD_BIT_DEPTH 12
+
+
+static inline __m128i load_4(const void* src)
+{
+  int32_t v;
+  memcpy(&v, src, 4);
+  return _mm_cvtsi32_si128(v);
+}
+
+static inline void store_4(void* dst, __m128i v)
+{
+  int32_t d = _mm_cvtsi128_si32(v);
+  memcpy(dst, &d, 4);
+}
+
+
+// --- planar ---
+
+void intra_pred_planar_8_sse4(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT)
+{
+  const int nChunks = (nT+7)/8;
+  const int topRight   = border[ 1+nT];
+  const int bottomLeft = border[-1-nT];
+
+  /* The horizontal part (nT-1-x)*left + (x+1)*topRight is computed with _mm_maddubs_epi16()
+     from the pair (left,topRight). The vertical part (nT-1-y)*top + (y+1)*bottomLeft
+     changes by (bottomLeft-top) from row to row. */
+
+  __m128i weights[4], vert[4], step[4];
+
+  const __m128i bl = _mm_set1_epi16(bottomLeft);
+
+  for (int c=0;c<nChunks;c++) {
+    int8_t w[16];
+    for (int i=0;i<8;i++) {
+      int x = c*8+i;
+      w[2*i  ] = nT-1-x;
+      w[2*i+1] = x+1;
+    }
+
+    __m128i top = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(border+1+c*8)));
+
+    weights[c] = _mm_loadu_si128((const __m128i*)w);
+    vert[c] = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16(nT-1)), bl);
+    step[c] = _mm_sub_epi16(bl, top);
+  }
+
+  const __m128i rnd   = _mm_set1_epi16(nT);
+  const __m128i shift = _mm_cvtsi32_si128(Log2(nT)+1);
+
+  for (int y=0;y<nT;y++) {
+    const __m128i left = _mm_set1_epi16((int16_t)(border[-1-y] | (topRight<<8)));
+
+    __m128i r[4];
+    for (int c=0;c<nChunks;c++) {
+      __m128i v = _mm_add_epi16(_mm_maddubs_epi16(left, weights[c]), vert[c]);
+      r[c] = _mm_srl_epi16(_mm_add_epi16(v, rnd), shift);
+      vert[c] = _mm_add_epi16(vert[c], step[c]);
+    }
+
+    uint8_t* out = dst+y*stride;
+
+    if (nT==4) {
+      store_4(out, _mm_packus_epi16(r[0],r[0]));
+    }
+    else if (nT==8) {
+      _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(r[0],r[0]));
+    }
+    else {
+      for (int c=0;c<nChunks;c+=2) {
+        _mm_storeu_si128((__m128i*)(out+c*8), _mm_packus_epi16(r[c],r[c+1]));
+      }
+    }
+  }
+}
+
+
+void intra_pred_planar_16_sse4(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                               int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_planar_16_fallback(dst,stride, border,nT, bit_depth);
+    return;
+  }
+
+  const int nChunks = nT/4;
+  const int topRight   = border[ 1+nT];
+  const int bottomLeft = border[-1-nT];
+
+  __m128i weights[8], vert[8], step[8];
+
+  const __m128i bl = _mm_set1_epi32(bottomLeft);
+
+  for (int c=0;c<nChunks;c++) {
+    int x = c*4;
+    weights[c] = _mm_setr_epi16(nT-1-x, x+1, nT-2-x, x+2,
+                                nT-3-x, x+3, nT-4-x, x+4);
+
+    __m128i top = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(border+1+x)));
+
+    vert[c] = _mm_add_epi32(_mm_mullo_epi32(top, _mm_set1_epi32(nT-1)), bl);
+    step[c] = _mm_sub_epi32(bl, top);
+  }
+
+  const __m128i rnd   = _mm_set1_epi32(nT);
+  const __m128i shift = _mm_cvtsi32_si128(Log2(nT)+1);
+
+  for (int y=0;y<nT;y++) {
+    const __m128i left = _mm_set1_epi32(border[-1-y] | (topRight<<16));
+
+    __m128i r[8];
+    for (int c=0;c<nChunks;c++) {
+      __m128i v = _mm_add_epi32(_mm_madd_epi16(left, weights[c]), vert[c]);
+      r[c] = _mm_srl_epi32(_mm_add_epi32(v, rnd), shift);
+      vert[c] = _mm_add_epi32(vert[c], step[c]);
+    }
+
+    uint16_t* out = dst+y*stride;
+
+    if (nT==4) {
+      _mm_storel_epi64((__m128i*)out, _mm_packus_epi32(r[0],r[0]));
+    }
+    else {
+      for (int c=0;c<nChunks;c+=2) {
+        _mm_storeu_si128((__m128i*)(out+c*4), _mm_packus_epi32(r[c],r[c+1]));
+      }
+    }
+  }
+}
+
+
+// --- DC ---
+
+void intra_pred_dc_8_sse4(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                          bool filter_edges)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  // sum of the left column border[-nT..-1] and the top row border[1..nT]
+
+  __m128i sum;
+  if (nT==4) {
+    sum = _mm_sad_epu8(_mm_unpacklo_epi32(load_4(border-4), load_4(border+1)), zero);
+  }
+  else if (nT==8) {
+    sum = _mm_sad_epu8(_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(border-8)),
+                                          _mm_loadl_epi64((const __m128i*)(border+1))), zero);
+  }
+  else {
+    sum = zero;
+    for (int i=0;i<nT;i+=16) {
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(border-nT+i)), zero));
+      sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(border+1+i)), zero));
+    }
+  }
+
+  int dcVal = _mm_cvtsi128_si32(sum) + _mm_extract_epi16(sum,4);
+  dcVal = (dcVal + nT) >> (Log2(nT)+1);
+
+  const __m128i dc = _mm_set1_epi8(dcVal);
+
+  for (int y=0;y<nT;y++) {
+    uint8_t* out = dst+y*stride;
+
+    if      (nT==4) { store_4(out, dc); }
+    else if (nT==8) { _mm_storel_epi64((__m128i*)out, dc); }
+    else {
+      for (int x=0;x<nT;x+=16) { _mm_storeu_si128((__m128i*)(out+x), dc); }
+    }
+  }
+
+  if (filter_edges) {
+    const __m128i dc3 = _mm_set1_epi16(3*dcVal+2);
+
+    for (int x=0;x<nT;x+=8) {
+      __m128i top = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)(border+1+x)));
+      __m128i v = _mm_srli_epi16(_mm_add_epi16(top, dc3), 2);
+      v = _mm_packus_epi16(v,v);
+
+      if (nT==4) { store_4(dst, v); }
+      else       { _mm_storel_epi64((__m128i*)(dst+x), v); }
+    }
+
+    for (int y=1;y<nT;y++) { dst[y*stride] = (border[-y-1] + 3*dcVal+2)>>2; }
+
+    dst[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
+  }
+}
+
+
+void intra_pred_dc_16_sse4(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                           bool filter_edges, int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_dc_16_fallback(dst,stride, border,nT, filter_edges, bit_depth);
+    return;
+  }
+
+  const __m128i ones = _mm_set1_epi16(1);
+
+  __m128i sum;
+  if (nT==4) {
+    sum = _mm_madd_epi16(_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(border-4)),
+                                            _mm_loadl_epi64((const __m128i*)(border+1))), ones);
+  }
+  else {
+    sum = _mm_setzero_si128();
+    for (int i=0;i<nT;i+=8) {
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(border-nT+i)), ones));
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(border+1+i)), ones));
+    }
+  }
+
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum,8));
+  sum = _mm_add_epi32(sum, _mm_srli_si128(sum,4));
+
+  int dcVal = (_mm_cvtsi128_si32(sum) + nT) >> (Log2(nT)+1);
+
+  const __m128i dc = _mm_set1_epi16(dcVal);
+
+  for (int y=0;y<nT;y++) {
+    uint16_t* out = dst+y*stride;
+
+    if (nT==4) { _mm_storel_epi64((__m128i*)out, dc); }
+    else {
+      for (int x=0;x<nT;x+=8) { _mm_storeu_si128((__m128i*)(out+x), dc); }
+    }
+  }
+
+  if (filter_edges) {
+    const __m128i dc3 = _mm_set1_epi16(3*dcVal+2);
+
+    if (nT==4) {
+      __m128i top = _mm_loadl_epi64((const __m128i*)(border+1));
+      _mm_storel_epi64((__m128i*)dst, _mm_srli_epi16(_mm_add_epi16(top, dc3), 2));
+    }
+    else {
+      for (int x=0;x<nT;x+=8) {
+        __m128i top = _mm_loadu_si128((const __m128i*)(border+1+x));
+        _mm_storeu_si128((__m128i*)(dst+x), _mm_srli_epi16(_mm_add_epi16(top, dc3), 2));
+      }
+    }
+
+    for (int y=1;y<nT;y++) { dst[y*stride] = (border[-y-1] + 3*dcVal+2)>>2; }
+
+    dst[0] = (border[-1] + 2*dcVal + border[1] +2) >> 2;
+  }
+}
+
+
+// --- transposition ---
+
+void intra_pred_transpose_8_sse4(uint8_t* dst, ptrdiff_t stride, const uint8_t* src, int nT)
+{
+  if (nT==4) {
+    const __m128i shuffle = _mm_setr_epi8(0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15);
+    __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), shuffle);
+
+    for (int y=0;y<4;y++) {
+      store_4(dst+y*stride, v);
+      v = _mm_srli_si128(v,4);
+    }
+
+    return;
+  }
+
+  // blocks of 8x8 samples
+
+  for (int r=0;r<nT;r+=8)
+    for (int c=0;c<nT;c+=8) {
+      const uint8_t* in = src + r*nT + c;
+
+      __m128i a0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(in+0*nT)),
+                                     _mm_loadl_epi64((const __m128i*)(in+1*nT)));
+      __m128i a1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(in+2*nT)),
+                                     _mm_loadl_epi64((const __m128i*)(in+3*nT)));
+      __m128i a2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(in+4*nT)),
+                                     _mm_loadl_epi64((const __m128i*)(in+5*nT)));
+      __m128i a3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(in+6*nT)),
+                                     _mm_loadl_epi64((const __m128i*)(in+7*nT)));
+
+      __m128i b0 = _mm_unpacklo_epi16(a0,a1);
+      __m128i b1 = _mm_unpackhi_epi16(a0,a1);
+      __m128i b2 = _mm_unpacklo_epi16(a2,a3);
+      __m128i b3 = _mm_unpackhi_epi16(a2,a3);
+
+      // each register holds two columns of the input block
+
+      __m128i col[4];
+      col[0] = _mm_unpacklo_epi32(b0,b2);
+      col[1] = _mm_unpackhi_epi32(b0,b2);
+      col[2] = _mm_unpacklo_epi32(b1,b3);
+      col[3] = _mm_unpackhi_epi32(b1,b3);
+
+      uint8_t* out = dst + c*stride + r;
+
+      for (int i=0;i<4;i++) {
+        _mm_storel_epi64((__m128i*)(out+(2*i  )*stride), col[i]);
+        _mm_storel_epi64((__m128i*)(out+(2*i+1)*stride), _mm_srli_si128(col[i],8));
+      }
+    }
+}
+
+
+void intra_pred_transpose_16_sse4(uint16_t* dst, ptrdiff_t stride, const uint16_t* src, int nT)
+{
+  if (nT==4) {
+    __m128i a0 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src+0)),
+                                    _mm_loadl_epi64((const __m128i*)(src+4)));
+    __m128i a1 = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src+8)),
+                                    _mm_loadl_epi64((const __m128i*)(src+12)));
+
+    __m128i c01 = _mm_unpacklo_epi32(a0,a1);
+    __m128i c23 = _mm_unpackhi_epi32(a0,a1);
+
+    _mm_storel_epi64((__m128i*)(dst+0*stride), c01);
+    _mm_storel_epi64((__m128i*)(dst+1*stride), _mm_srli_si128(c01,8));
+    _mm_storel_epi64((__m128i*)(dst+2*stride), c23);
+    _mm_storel_epi64((__m128i*)(dst+3*stride), _mm_srli_si128(c23,8));
+    return;
+  }
+
+  for (int r=0;r<nT;r+=8)
+    for (int c=0;c<nT;c+=8) {
+      const uint16_t* in = src + r*nT + c;
+
+      __m128i a[8];
+      for (int i=0;i<8;i+=2) {
+        __m128i r0 = _mm_loadu_si128((const __m128i*)(in+ i   *nT));
+        __m128i r1 = _mm_loadu_si128((const __m128i*)(in+(i+1)*nT));
+        a[i  ] = _mm_unpacklo_epi16(r0,r1);
+        a[i+1] = _mm_unpackhi_epi16(r0,r1);
+      }
+
+      __m128i b0 = _mm_unpacklo_epi32(a[0],a[2]);
+      __m128i b1 = _mm_unpackhi_epi32(a[0],a[2]);
+      __m128i b2 = _mm_unpacklo_epi32(a[1],a[3]);
+      __m128i b3 = _mm_unpackhi_epi32(a[1],a[3]);
+      __m128i b4 = _mm_unpacklo_epi32(a[4],a[6]);
+      __m128i b5 = _mm_unpackhi_epi32(a[4],a[6]);
+      __m128i b6 = _mm_unpacklo_epi32(a[5],a[7]);
+      __m128i b7 = _mm_unpackhi_epi32(a[5],a[7]);
+
+      uint16_t* out = dst + c*stride + r;
+
+      _mm_storeu_si128((__m128i*)(out+0*stride), _mm_unpacklo_epi64(b0,b4));
+      _mm_storeu_si128((__m128i*)(out+1*stride), _mm_unpackhi_epi64(b0,b4));
+      _mm_storeu_si128((__m128i*)(out+2*stride), _mm_unpacklo_epi64(b1,b5));
+      _mm_storeu_si128((__m128i*)(out+3*stride), _mm_unpackhi_epi64(b1,b5));
+      _mm_storeu_si128((__m128i*)(out+4*stride), _mm_unpacklo_epi64(b2,b6));
+      _mm_storeu_si128((__m128i*)(out+5*stride), _mm_unpackhi_epi64(b2,b6));
+      _mm_storeu_si128((__m128i*)(out+6*stride), _mm_unpacklo_epi64(b3,b7));
+      _mm_storeu_si128((__m128i*)(out+7*stride), _mm_unpackhi_epi64(b3,b7));
+    }
+}
+
+
+// --- angular ---
+
+/* The modes below 18 are computed transposed into a temporary block, which is
+   then copied to the image with intra_pred_transpose_*(). */
+
+void intra_pred_angular_8_sse4(uint8_t* dst, ptrdiff_t stride, const uint8_t* border, int nT,
+                               int intraPredMode, bool boundary_filter)
+{
+  // the loads at the end of a row may read up to 16 samples past ref[2*nT]
+  uint8_t  ref_mem[2*64+1+16];
+  uint8_t* ref=&ref_mem[64];
+
+  intra_pred_angular_reference(ref, border, nT, intraPredMode);
+
+  const int  intraPredAngle = intraPredAngle_table[intraPredMode];
+  const bool vertical = (intraPredMode >= 18);
+
+  ALIGNED_16(uint8_t tmp[32*32]);
+  uint8_t*  out       = vertical ? dst : tmp;
+  ptrdiff_t outStride = vertical ? stride : nT;
+
+  const __m128i rnd = _mm_set1_epi16(16);
+
+  for (int y=0;y<nT;y++) {
+    int iIdx = ((y+1)*intraPredAngle)>>5;
+    int iFact= ((y+1)*intraPredAngle)&31;
+
+    const uint8_t* src = ref+iIdx+1;
+    uint8_t* o = out+y*outStride;
+
+    if (iFact==0) {
+      memcpy(o, src, nT);
+      continue;
+    }
+
+    // sample pairs (ref[i],ref[i+1]) are multiplied with (32-iFact,iFact)
+
+    const __m128i w = _mm_set1_epi16((int16_t)((iFact<<8) | (32-iFact)));
+
+    if (nT<=8) {
+      __m128i a = _mm_loadl_epi64((const __m128i*)(src));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(src+1));
+      __m128i v = _mm_maddubs_epi16(_mm_unpacklo_epi8(a,b), w);
+      v = _mm_srli_epi16(_mm_add_epi16(v, rnd), 5);
+      v = _mm_packus_epi16(v,v);
+
+      if (nT==4) { store_4(o, v); }
+      else       { _mm_storel_epi64((__m128i*)o, v); }
+    }
+    else {
+      for (int x=0;x<nT;x+=16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src+x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src+x+1));
+        __m128i lo = _mm_maddubs_epi16(_mm_unpacklo_epi8(a,b), w);
+        __m128i hi = _mm_maddubs_epi16(_mm_unpackhi_epi8(a,b), w);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, rnd), 5);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, rnd), 5);
+
+        _mm_storeu_si128((__m128i*)(o+x), _mm_packus_epi16(lo,hi));
+      }
+    }
+  }
+
+  if (vertical) {
+    if (intraPredMode==26 && boundary_filter) {
+      for (int y=0;y<nT;y++) {
+        dst[y*stride] = Clip1_8bit(border[1] + ((border[-1-y] - border[0])>>1));
+      }
+    }
+  }
+  else {
+    intra_pred_transpose_8_sse4(dst,stride, tmp,nT);
+
+    if (intraPredMode==10 && boundary_filter) {
+      for (int x=0;x<nT;x++) {
+        dst[x] = Clip1_8bit(border[-1] + ((border[1+x] - border[0])>>1));
+      }
+    }
+  }
+}
+
+
+void intra_pred_angular_16_sse4(uint16_t* dst, ptrdiff_t stride, const uint16_t* border, int nT,
+                                int intraPredMode, bool boundary_filter, int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_angular_16_fallback(dst,stride, border,nT, intraPredMode, boundary_filter, bit_depth);
+    return;
+  }
+
+  uint16_t  ref_mem[2*64+1+16];
+  uint16_t* ref=&ref_mem[64];
+
+  intra_pred_angular_reference(ref, border, nT, intraPredMode);
+
+  const int  intraPredAngle = intraPredAngle_table[intraPredMode];
+  const bool vertical = (intraPredMode >= 18);
+
+  ALIGNED_16(uint16_t tmp[32*32]);
+  uint16_t* out       = vertical ? dst : tmp;
+  ptrdiff_t outStride = vertical ? stride : nT;
+
+  const __m128i rnd = _mm_set1_epi32(16);
+
+  for (int y=0;y<nT;y++) {
+    int iIdx = ((y+1)*intraPredAngle)>>5;
+    int iFact= ((y+1)*intraPredAngle)&31;
+
+    const uint16_t* src = ref+iIdx+1;
+    uint16_t* o = out+y*outStride;
+
+    if (iFact==0) {
+      memcpy(o, src, nT*sizeof(uint16_t));
+      continue;
+    }
+
+    const __m128i w = _mm_set1_epi32((iFact<<16) | (32-iFact));
+
+    if (nT==4) {
+      __m128i a = _mm_loadl_epi64((const __m128i*)(src));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(src+1));
+      __m128i v = _mm_madd_epi16(_mm_unpacklo_epi16(a,b), w);
+      v = _mm_srai_epi32(_mm_add_epi32(v, rnd), 5);
+
+      _mm_storel_epi64((__m128i*)o, _mm_packus_epi32(v,v));
+    }
+    else {
+      for (int x=0;x<nT;x+=8) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(src+x));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src+x+1));
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(a,b), w);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(a,b), w);
+        lo = _mm_srai_epi32(_mm_add_epi32(lo, rnd), 5);
+        hi = _mm_srai_epi32(_mm_add_epi32(hi, rnd), 5);
+
+        _mm_storeu_si128((__m128i*)(o+x), _mm_packus_epi32(lo,hi));
+      }
+    }
+  }
+
+  if (vertical) {
+    if (intraPredMode==26 && boundary_filter) {
+      for (int y=0;y<nT;y++) {
+        dst[y*stride] = Clip_BitDepth(border[1] + ((border[-1-y] - border[0])>>1), bit_depth);
+      }
+    }
+  }
+  else {
+    intra_pred_transpose_16_sse4(dst,stride, tmp,nT);
+
+    if (intraPredMode==10 && boundary_filter) {
+      for (int x=0;x<nT;x++) {
+        dst[x] = Clip_BitDepth(border[-1] + ((border[1+x] - border[0])>>1), bit_depth);
+      }
+    }
+  }
+}
+
+
+// --- [1 2 1] filtering of the reference samples ---
+
+/* The 4*nT-1 filtered samples are computed in blocks. The last block is moved back
+   such that it ends at the last sample; it overlaps with the previous block. */
+
+void intra_pred_smooth_border_8_sse4(uint8_t* border, int nT)
+{
+  if (nT<8) {
+    intra_pred_smooth_border_8_fallback(border,nT);
+    return;
+  }
+
+  ALIGNED_16(uint8_t pF[4*32]);
+
+  const int n = 4*nT-1;
+  uint8_t* p = border-(2*nT-1);
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two  = _mm_set1_epi16(2);
+
+  for (int i=0;i<n;i+=16) {
+    if (i>n-16) { i=n-16; }
+
+    __m128i a = _mm_loadu_si128((const __m128i*)(p+i-1));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p+i));
+    __m128i c = _mm_loadu_si128((const __m128i*)(p+i+1));
+
+    __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a,zero), _mm_unpacklo_epi8(c,zero));
+    __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a,zero), _mm_unpackhi_epi8(c,zero));
+    lo = _mm_add_epi16(lo, _mm_slli_epi16(_mm_unpacklo_epi8(b,zero), 1));
+    hi = _mm_add_epi16(hi, _mm_slli_epi16(_mm_unpackhi_epi8(b,zero), 1));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+
+    _mm_storeu_si128((__m128i*)(pF+i), _mm_packus_epi16(lo,hi));
+  }
+
+  memcpy(p, pF, n);
+}
+
+
+void intra_pred_smooth_border_16_sse4(uint16_t* border, int nT, int bit_depth)
+{
+  if (nT<8 || bit_depth > MAX_SIMD_BIT_DEPTH) {
+    intra_pred_smooth_border_16_fallback(border,nT, bit_depth);
+    return;
+  }
+
+  ALIGNED_16(uint16_t pF[4*32]);
+
+  const int n = 4*nT-1;
+  uint16_t* p = border-(2*nT-1);
+
+  const __m128i two = _mm_set1_epi16(2);
+
+  for (int i=0;i<n;i+=8) {
+    if (i>n-8) { i=n-8; }
+
+    __m128i a = _mm_loadu_si128((const __m128i*)(p+i-1));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p+i));
+    __m128i c = _mm_loadu_si128((const __m128i*)(p+i+1));
+
+    __m128i v = _mm_add_epi16(_mm_add_epi16(a,c), _mm_slli_epi16(b,1));
+    v = _mm_srli_epi16(_mm_add_epi16(v, two), 2);
+
+    _mm_storeu_si128((__m128i*)(pF+i), v);
+  }
+
+  memcpy(p, pF, n*sizeof(uint16_t));
+}
@@ -0,0 +1,590 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <assert.h>
+#include <emmintrin.h>
+#include <smmintrin.h>
+
+#include "sse-motion.h"
+#include "libde265/util.h"
+#include "libde265/fallback-motion.h"
+
+
+/* Motion compensation for samples with more than 8 bits.
+
+   All kernels process 8 samples of a line per iteration. Since the samples have at most
+   12 bits, pairs of them can be multiplied with pairs of filter taps by _mm_madd_epi16()
+   without overflow. The remaining columns of blocks whose width is not a multiple of 8
+   (chroma blocks of width 2, 4, 6, 12) and bit depths above 12 are passed to the
+   scalar fallbacks.
+ */
+
+#define MAX_PB_SIZE 64
+#define MAX_SIMD_BIT_DEPTH 12
+
+
+// --- prediction weighting ---
+
+static inline void store_8_pixels(uint16_t* dst, __m128i v, __m128i maxval)
+{
+  v = _mm_min_epi16(_mm_max_epi16(v, _mm_setzero_si128()), maxval);
+  _mm_storeu_si128((__m128i*)dst, v);
+}
+
+
+void ff_hevc_put_unweighted_pred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src, ptrdiff_t srcstride,
+                                        int width, int height, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  if (w8) {
+    const int shift1 = 14-bit_depth;
+    const __m128i offset = _mm_set1_epi16(1<<(shift1-1));
+    const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift  = _mm_cvtsi32_si128(shift1);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in = &src[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w8;x+=8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&in[x]);
+
+        // saturation only happens when the result is clipped anyway
+
+        v = _mm_sra_epi16(_mm_adds_epi16(v, offset), shift);
+        store_8_pixels(&out[x], v, maxval);
+      }
+    }
+  }
+
+  if (w8<width) {
+    put_unweighted_pred_16_fallback(dst+w8, dststride, src+w8, srcstride,
+                                    width-w8, height, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_avg_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                          const int16_t *src1, const int16_t *src2,
+                                          ptrdiff_t srcstride, int width,
+                                          int height, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  if (w8) {
+    const int shift2 = 15-bit_depth;
+    const __m128i offset = _mm_set1_epi16(1<<(shift2-1));
+    const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift  = _mm_cvtsi32_si128(shift2);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in1 = &src1[y*srcstride];
+      const int16_t* in2 = &src2[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w8;x+=8) {
+        __m128i v1 = _mm_loadu_si128((const __m128i*)&in1[x]);
+        __m128i v2 = _mm_loadu_si128((const __m128i*)&in2[x]);
+
+        __m128i v = _mm_adds_epi16(_mm_adds_epi16(v1,v2), offset);
+        store_8_pixels(&out[x], _mm_sra_epi16(v, shift), maxval);
+      }
+    }
+  }
+
+  if (w8<width) {
+    put_weighted_pred_avg_16_fallback(dst+w8, dststride, src1+w8, src2+w8, srcstride,
+                                      width-w8, height, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_pred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                      const int16_t *src, ptrdiff_t srcstride,
+                                      int width, int height,
+                                      int w,int o,int log2WD, int bit_depth)
+{
+  assert(log2WD>=1);
+
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  if (w8) {
+    const int rnd = (1<<(log2WD-1));
+
+    // multiply-add of (in,1) with (w,rnd) gives in*w+rnd with 32 bit precision
+
+    const __m128i one     = _mm_set1_epi16(1);
+    const __m128i factors = _mm_set1_epi32((rnd<<16) | (uint16_t)w);
+    const __m128i offset  = _mm_set1_epi32(o);
+    const __m128i maxval  = _mm_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift   = _mm_cvtsi32_si128(log2WD);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in  = &src[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w8;x+=8) {
+        __m128i v = _mm_loadu_si128((const __m128i*)&in[x]);
+
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v, one), factors);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v, one), factors);
+        lo = _mm_add_epi32(_mm_sra_epi32(lo, shift), offset);
+        hi = _mm_add_epi32(_mm_sra_epi32(hi, shift), offset);
+
+        store_8_pixels(&out[x], _mm_packs_epi32(lo,hi), maxval);
+      }
+    }
+  }
+
+  if (w8<width) {
+    put_weighted_pred_16_fallback(dst+w8, dststride, src+w8, srcstride,
+                                  width-w8, height, w,o,log2WD, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_weighted_bipred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src1, const int16_t *src2,
+                                        ptrdiff_t srcstride, int width, int height,
+                                        int w1,int o1, int w2,int o2, int log2WD,
+                                        int bit_depth)
+{
+  assert(log2WD>=1);
+
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  if (w8) {
+    const int rnd = ((o1+o2+1) << log2WD);
+
+    // multiply-add of (in1,in2) with (w1,w2) gives in1*w1+in2*w2 with 32 bit precision
+
+    const __m128i factors = _mm_set1_epi32((int)(((uint32_t)(uint16_t)w2<<16) | (uint16_t)w1));
+    const __m128i offset  = _mm_set1_epi32(rnd);
+    const __m128i maxval  = _mm_set1_epi16((1<<bit_depth)-1);
+    const __m128i shift   = _mm_cvtsi32_si128(log2WD+1);
+
+    for (int y=0;y<height;y++) {
+      const int16_t* in1 = &src1[y*srcstride];
+      const int16_t* in2 = &src2[y*srcstride];
+      uint16_t* out = &dst[y*dststride];
+
+      for (int x=0;x<w8;x+=8) {
+        __m128i v1 = _mm_loadu_si128((const __m128i*)&in1[x]);
+        __m128i v2 = _mm_loadu_si128((const __m128i*)&in2[x]);
+
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(v1, v2), factors);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(v1, v2), factors);
+        lo = _mm_sra_epi32(_mm_add_epi32(lo, offset), shift);
+        hi = _mm_sra_epi32(_mm_add_epi32(hi, offset), shift);
+
+        store_8_pixels(&out[x], _mm_packs_epi32(lo,hi), maxval);
+      }
+    }
+  }
+
+  if (w8<width) {
+    put_weighted_bipred_16_fallback(dst+w8, dststride, src1+w8, src2+w8, srcstride,
+                                    width-w8, height, w1,o1,w2,o2, log2WD, bit_depth);
+  }
+}
+
+
+// --- interpolation filters ---
+
+/* Filter taps, starting at the first sample used by the filter.
+   The quarter-sample filters 1 and 3 only have 7 taps, the last one is zero. */
+
+static const int8_t qpel_filters_16[4][8] = {
+  {  0, 0,  0,  0,  0,  0,  0,  0 },
+  { -1, 4,-10, 58, 17, -5,  1,  0 },
+  { -1, 4,-11, 40, 40,-11,  4, -1 },
+  {  1,-5, 17, 58,-10,  4, -1,  0 }
+};
+
+static const int qpel_extra_before_16[4] = { 0, 3, 3, 2 };
+static const int qpel_taps_16[4]         = { 0, 7, 8, 7 };
+
+static const int8_t epel_filters_16[8][4] = {
+  {  0,  0,  0,  0 },
+  { -2, 58, 10, -2 },
+  { -4, 54, 16, -2 },
+  { -6, 46, 28, -4 },
+  { -4, 36, 36, -4 },
+  { -4, 28, 46, -6 },
+  { -2, 16, 54, -4 },
+  { -2, 10, 58, -2 }
+};
+
+
+// pairs of taps as 16-bit values for _mm_madd_epi16()
+
+static void init_coeff_pairs(__m128i* coeffs, const int8_t* taps, int nTaps)
+{
+  for (int k=0;k<nTaps;k+=2) {
+    int16_t t1 = (k+1<nTaps ? taps[k+1] : 0);
+    coeffs[k/2] = _mm_set1_epi32((int)(((uint32_t)(uint16_t)t1<<16) | (uint16_t)taps[k]));
+  }
+}
+
+
+/* Horizontal filter, 8 output samples. 'p' points to the first input sample of the
+   filter. For an odd number of taps, the last sample is paired with zero so that
+   no sample after the filter support is read. */
+
+template <int nTaps>
+static inline __m128i filter_h(const uint16_t* p, const __m128i* coeffs, __m128i shift)
+{
+  __m128i lo = _mm_setzero_si128();
+  __m128i hi = _mm_setzero_si128();
+
+  for (int k=0;k<nTaps;k+=2) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p+k));
+    __m128i b = (k+1<nTaps ?
+                 _mm_loadu_si128((const __m128i*)(p+k+1)) :
+                 _mm_setzero_si128());
+
+    lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a,b), coeffs[k/2]));
+    hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a,b), coeffs[k/2]));
+  }
+
+  return _mm_packs_epi32(_mm_sra_epi32(lo,shift), _mm_sra_epi32(hi,shift));
+}
+
+
+/* Vertical filter, 8 output samples, on either input samples or the output of
+   the horizontal filter. */
+
+template <int nTaps, class T>
+static inline __m128i filter_v(const T* p, ptrdiff_t stride, const __m128i* coeffs, __m128i shift)
+{
+  __m128i lo = _mm_setzero_si128();
+  __m128i hi = _mm_setzero_si128();
+
+  for (int k=0;k<nTaps;k+=2) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p+k*stride));
+    __m128i b = (k+1<nTaps ?
+                 _mm_loadu_si128((const __m128i*)(p+(k+1)*stride)) :
+                 _mm_setzero_si128());
+
+    lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a,b), coeffs[k/2]));
+    hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a,b), coeffs[k/2]));
+  }
+
+  return _mm_packs_epi32(_mm_sra_epi32(lo,shift), _mm_sra_epi32(hi,shift));
+}
+
+
+template <int nTaps>
+static void filter_h_block(int16_t *dst, ptrdiff_t dststride,
+                           const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                           int width, int height, const __m128i* coeffs, int bit_depth)
+{
+  const __m128i shift = _mm_cvtsi32_si128(bit_depth-8);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<width;x+=8) {
+      _mm_storeu_si128((__m128i*)&dst[y*dststride+x],
+                       filter_h<nTaps>(&src[y*srcstride+x], coeffs, shift));
+    }
+  }
+}
+
+
+template <int nTaps>
+static void filter_v_block(int16_t *dst, ptrdiff_t dststride,
+                           const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                           int width, int height, const __m128i* coeffs, int bit_depth)
+{
+  const __m128i shift = _mm_cvtsi32_si128(bit_depth-8);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<width;x+=8) {
+      _mm_storeu_si128((__m128i*)&dst[y*dststride+x],
+                       filter_v<nTaps>(&src[y*srcstride+x], srcstride, coeffs, shift));
+    }
+  }
+}
+
+
+template <int nTapsH, int nTapsV>
+static void filter_hv_block(int16_t *dst, ptrdiff_t dststride,
+                            const uint16_t *src, ptrdiff_t srcstride, // first input sample
+                            int width, int height,
+                            const __m128i* hcoeffs, const __m128i* vcoeffs, int bit_depth)
+{
+  ALIGNED_16(int16_t tmp[(MAX_PB_SIZE+7)*8]);
+
+  const __m128i hshift = _mm_cvtsi32_si128(bit_depth-8);
+  const __m128i vshift = _mm_cvtsi32_si128(6);
+
+  const int nRows = height + nTapsV-1;
+
+  for (int x=0;x<width;x+=8) {
+    for (int y=0;y<nRows;y++) {
+      _mm_store_si128((__m128i*)&tmp[y*8], filter_h<nTapsH>(src + y*srcstride + x, hcoeffs, hshift));
+    }
+
+    for (int y=0;y<height;y++) {
+      _mm_storeu_si128((__m128i*)&dst[y*dststride+x],
+                       filter_v<nTapsV>(&tmp[y*8], 8, vcoeffs, vshift));
+    }
+  }
+}
+
+
+typedef void (*qpel_func_16)(int16_t *out, ptrdiff_t out_stride,
+                             const uint16_t *src, ptrdiff_t srcstride,
+                             int nPbW, int nPbH, int16_t* mcbuffer, int bit_depth);
+
+
+// --- quarter-sample luma interpolation ---
+
+void ff_hevc_put_hevc_qpel_pixels_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                         const uint16_t *src, ptrdiff_t srcstride,
+                                         int width, int height, int16_t* mcbuffer,
+                                         int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+  const __m128i shift = _mm_cvtsi32_si128(14-bit_depth);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w8;x+=8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&src[y*srcstride+x]);
+      _mm_storeu_si128((__m128i*)&dst[y*dststride+x], _mm_sll_epi16(v,shift));
+    }
+  }
+
+  if (w8<width) {
+    put_qpel_0_0_fallback_16(dst+w8, dststride, src+w8, srcstride,
+                             width-w8, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_h_16(int xFrac, qpel_func_16 fallback,
+                      int16_t *dst, ptrdiff_t dststride,
+                      const uint16_t *src, ptrdiff_t srcstride,
+                      int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i coeffs[4];
+  init_coeff_pairs(coeffs, qpel_filters_16[xFrac], qpel_taps_16[xFrac]);
+
+  const uint16_t* in = src - qpel_extra_before_16[xFrac];
+
+  if (qpel_taps_16[xFrac]==8) {
+    filter_h_block<8>(dst,dststride, in,srcstride, w8,height, coeffs, bit_depth);
+  }
+  else {
+    filter_h_block<7>(dst,dststride, in,srcstride, w8,height, coeffs, bit_depth);
+  }
+
+  if (w8<width) {
+    fallback(dst+w8, dststride, src+w8, srcstride, width-w8, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_v_16(int yFrac, qpel_func_16 fallback,
+                      int16_t *dst, ptrdiff_t dststride,
+                      const uint16_t *src, ptrdiff_t srcstride,
+                      int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i coeffs[4];
+  init_coeff_pairs(coeffs, qpel_filters_16[yFrac], qpel_taps_16[yFrac]);
+
+  const uint16_t* in = src - qpel_extra_before_16[yFrac]*srcstride;
+
+  if (qpel_taps_16[yFrac]==8) {
+    filter_v_block<8>(dst,dststride, in,srcstride, w8,height, coeffs, bit_depth);
+  }
+  else {
+    filter_v_block<7>(dst,dststride, in,srcstride, w8,height, coeffs, bit_depth);
+  }
+
+  if (w8<width) {
+    fallback(dst+w8, dststride, src+w8, srcstride, width-w8, height, mcbuffer, bit_depth);
+  }
+}
+
+
+static void qpel_hv_16(int xFrac, int yFrac, qpel_func_16 fallback,
+                       int16_t *dst, ptrdiff_t dststride,
+                       const uint16_t *src, ptrdiff_t srcstride,
+                       int width, int height, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i hcoeffs[4], vcoeffs[4];
+  init_coeff_pairs(hcoeffs, qpel_filters_16[xFrac], qpel_taps_16[xFrac]);
+  init_coeff_pairs(vcoeffs, qpel_filters_16[yFrac], qpel_taps_16[yFrac]);
+
+  const uint16_t* in = (src - qpel_extra_before_16[yFrac]*srcstride
+                        - qpel_extra_before_16[xFrac]);
+
+  bool h8 = (qpel_taps_16[xFrac]==8);
+  bool v8 = (qpel_taps_16[yFrac]==8);
+
+  if      ( h8 &&  v8) filter_hv_block<8,8>(dst,dststride, in,srcstride, w8,height, hcoeffs,vcoeffs, bit_depth);
+  else if ( h8 && !v8) filter_hv_block<8,7>(dst,dststride, in,srcstride, w8,height, hcoeffs,vcoeffs, bit_depth);
+  else if (!h8 &&  v8) filter_hv_block<7,8>(dst,dststride, in,srcstride, w8,height, hcoeffs,vcoeffs, bit_depth);
+  else                 filter_hv_block<7,7>(dst,dststride, in,srcstride, w8,height, hcoeffs,vcoeffs, bit_depth);
+
+  if (w8<width) {
+    fallback(dst+w8, dststride, src+w8, srcstride, width-w8, height, mcbuffer, bit_depth);
+  }
+}
+
+
+#define QPEL_H(xFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _16_sse(int16_t *dst, ptrdiff_t dststride, \
+                                                    const uint16_t *src, ptrdiff_t srcstride, \
+                                                    int width, int height, int16_t* mcbuffer, \
+                                                    int bit_depth)      \
+  {                                                                     \
+    qpel_h_16(xFrac, put_qpel_ ## xFrac ## _0_fallback_16,              \
+              dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+#define QPEL_V(yFrac)                                                   \
+  void ff_hevc_put_hevc_qpel_v_ ## yFrac ## _16_sse(int16_t *dst, ptrdiff_t dststride, \
+                                                    const uint16_t *src, ptrdiff_t srcstride, \
+                                                    int width, int height, int16_t* mcbuffer, \
+                                                    int bit_depth)      \
+  {                                                                     \
+    qpel_v_16(yFrac, put_qpel_0_ ## yFrac ## _fallback_16,              \
+              dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+#define QPEL_HV(xFrac,yFrac)                                            \
+  void ff_hevc_put_hevc_qpel_h_ ## xFrac ## _v_ ## yFrac ## _16_sse(int16_t *dst, ptrdiff_t dststride, \
+                                                                    const uint16_t *src, ptrdiff_t srcstride, \
+                                                                    int width, int height, int16_t* mcbuffer, \
+                                                                    int bit_depth) \
+  {                                                                     \
+    qpel_hv_16(xFrac,yFrac, put_qpel_ ## xFrac ## _ ## yFrac ## _fallback_16, \
+               dst,dststride, src,srcstride, width,height, mcbuffer, bit_depth); \
+  }
+
+QPEL_H(1)
+QPEL_H(2)
+QPEL_H(3)
+
+QPEL_V(1)
+QPEL_V(2)
+QPEL_V(3)
+
+QPEL_HV(1,1)
+QPEL_HV(1,2)
+QPEL_HV(1,3)
+QPEL_HV(2,1)
+QPEL_HV(2,2)
+QPEL_HV(2,3)
+QPEL_HV(3,1)
+QPEL_HV(3,2)
+QPEL_HV(3,3)
+
+
+// --- eighth-sample chroma interpolation ---
+
+void ff_hevc_put_hevc_epel_pixels_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                         const uint16_t *src, ptrdiff_t srcstride,
+                                         int width, int height,
+                                         int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+  const __m128i shift = _mm_cvtsi32_si128(14-bit_depth);
+
+  for (int y=0;y<height;y++) {
+    for (int x=0;x<w8;x+=8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)&src[y*srcstride+x]);
+      _mm_storeu_si128((__m128i*)&dst[y*dststride+x], _mm_sll_epi16(v,shift));
+    }
+  }
+
+  if (w8<width) {
+    put_epel_16_fallback(dst+w8, dststride, src+w8, srcstride,
+                         width-w8, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_h_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                    const uint16_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i coeffs[2];
+  init_coeff_pairs(coeffs, epel_filters_16[mx], 4);
+
+  filter_h_block<4>(dst,dststride, src-1,srcstride, w8,height, coeffs, bit_depth);
+
+  if (w8<width) {
+    put_epel_hv_fallback<uint16_t>(dst+w8, dststride, src+w8, srcstride,
+                                   width-w8, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_v_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                    const uint16_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i coeffs[2];
+  init_coeff_pairs(coeffs, epel_filters_16[my], 4);
+
+  filter_v_block<4>(dst,dststride, src-srcstride,srcstride, w8,height, coeffs, bit_depth);
+
+  if (w8<width) {
+    put_epel_hv_fallback<uint16_t>(dst+w8, dststride, src+w8, srcstride,
+                                   width-w8, height, mx,my, mcbuffer, bit_depth);
+  }
+}
+
+
+void ff_hevc_put_hevc_epel_hv_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                     const uint16_t *src, ptrdiff_t srcstride,
+                                     int width, int height,
+                                     int mx, int my, int16_t* mcbuffer, int bit_depth)
+{
+  const int w8 = (bit_depth <= MAX_SIMD_BIT_DEPTH ? width & ~7 : 0);
+
+  __m128i hcoeffs[2], vcoeffs[2];
+  init_coeff_pairs(hcoeffs, epel_filters_16[mx], 4);
+  init_coeff_pairs(vcoeffs, epel_filters_16[my], 4);
+
+  filter_hv_block<4,4>(dst,dststride, src-srcstride-1,srcstride, w8,height,
+                       hcoeffs,vcoeffs, bit_depth);
+
+  if (w8<width) {
+    put_epel_hv_fallback<uint16_t>(dst+w8, dststride, src+w8, srcstride,
+                                   width-w8, height, mx,my, mcbuffer, bit_depth);
+  }
+}
@@ -101,4 +101,93 @@ void ff_hevc_put_hevc_qpel_h_3_v_3_sse(int16_t *dst, ptrdiff_t dststride,
                                        const uint8_t *src, ptrdiff_t srcstride,
                                        int width, int height, int16_t* mcbuffer);
 
+
+// samples with more than 8 bits
+
+void ff_hevc_put_unweighted_pred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src, ptrdiff_t srcstride,
+                                        int width, int height, int bit_depth);
+
+void ff_hevc_put_weighted_pred_avg_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                          const int16_t *src1, const int16_t *src2,
+                                          ptrdiff_t srcstride, int width,
+                                          int height, int bit_depth);
+
+void ff_hevc_put_weighted_pred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                      const int16_t *src, ptrdiff_t srcstride,
+                                      int width, int height,
+                                      int w,int o,int log2WD, int bit_depth);
+
+void ff_hevc_put_weighted_bipred_16_sse(uint16_t *dst, ptrdiff_t dststride,
+                                        const int16_t *src1, const int16_t *src2,
+                                        ptrdiff_t srcstride, int width, int height,
+                                        int w1,int o1, int w2,int o2, int log2WD,
+                                        int bit_depth);
+
+void ff_hevc_put_hevc_epel_pixels_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                         const uint16_t *src, ptrdiff_t srcstride,
+                                         int width, int height,
+                                         int mx, int my, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_epel_h_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                    const uint16_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_epel_v_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                    const uint16_t *src, ptrdiff_t srcstride,
+                                    int width, int height,
+                                    int mx, int my, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_epel_hv_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                     const uint16_t *src, ptrdiff_t srcstride,
+                                     int width, int height,
+                                     int mx, int my, int16_t* mcbuffer, int bit_depth);
+
+void ff_hevc_put_hevc_qpel_pixels_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                         const uint16_t *src, ptrdiff_t srcstride,
+                                         int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_v_1_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_v_2_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_v_3_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_1_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_1_v_1_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_1_v_2_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_1_v_3_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_2_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_2_v_1_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_2_v_2_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_2_v_3_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_3_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                      const uint16_t *src, ptrdiff_t srcstride,
+                                      int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_3_v_1_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_3_v_2_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+void ff_hevc_put_hevc_qpel_h_3_v_3_16_sse(int16_t *dst, ptrdiff_t dststride,
+                                          const uint16_t *src, ptrdiff_t srcstride,
+                                          int width, int height, int16_t* mcbuffer, int bit_depth);
+
 #endif
@@ -0,0 +1,272 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+
+#include "sse-sao.h"
+#include "libde265/fallback-sao.h"
+
+
+/* SAO, computed exactly as in fallback-sao.cc.
+
+   The offsets are looked up with _mm_shuffle_epi8() from a 16-byte table. For 8-bit
+   samples, the table is split into the positive and negative parts of the offsets, which
+   are applied with saturating arithmetic (this is the clipping to [0;255]). For more than
+   8 bits, the table holds 16-bit offsets and is indexed with byte pairs.
+
+   The columns that do not fill a complete vector are passed to the fallback functions,
+   as are samples with more than MAX_SIMD_BIT_DEPTH bits (signed 16-bit comparisons).
+ */
+
+#define MAX_SIMD_BIT_DEPTH 14
+
+
+// tables of max(offset,0) and max(-offset,0)
+static inline void offset_tables_8(const int8_t* offsets, int n, __m128i* pos, __m128i* neg)
+{
+  int8_t table[16] = { 0 };
+  for (int i=0;i<n;i++) {
+    table[i] = offsets[i];
+  }
+
+  __m128i t = _mm_loadu_si128((const __m128i*)table);
+  *pos = _mm_max_epi8(t, _mm_setzero_si128());
+  *neg = _mm_max_epi8(_mm_sub_epi8(_mm_setzero_si128(), t), _mm_setzero_si128());
+}
+
+static inline __m128i offset_table_16(const int8_t* offsets, int n)
+{
+  int16_t table[8] = { 0 };
+  for (int i=0;i<n;i++) {
+    table[i] = offsets[i];
+  }
+
+  return _mm_loadu_si128((const __m128i*)table);
+}
+
+// 16-bit table index -> shuffle control (byte pair 2*idx, 2*idx+1)
+static inline __m128i table_index_16(__m128i idx)
+{
+  return _mm_add_epi16(_mm_mullo_epi16(idx, _mm_set1_epi16(0x0202)), _mm_set1_epi16(0x0100));
+}
+
+static inline __m128i apply_offsets_8(__m128i v, __m128i idx, __m128i pos, __m128i neg)
+{
+  v = _mm_adds_epu8(v, _mm_shuffle_epi8(pos, idx));
+  return _mm_subs_epu8(v, _mm_shuffle_epi8(neg, idx));
+}
+
+
+// --- band offset ---
+
+static inline __m128i band_index_8(__m128i v, __m128i bandPos)
+{
+  const __m128i mask5 = _mm_set1_epi8(31);
+
+  __m128i band = _mm_and_si128(_mm_srli_epi16(v,3), mask5);
+  __m128i k = _mm_and_si128(_mm_sub_epi8(band, bandPos), mask5);
+
+  // bands outside of the four selected bands get a negative index (zero offset)
+  return _mm_or_si128(k, _mm_cmpgt_epi8(k, _mm_set1_epi8(3)));
+}
+
+
+void sao_band_8_sse4(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride,
+                     int width, int height, int bandPosition, const int8_t offsets[4])
+{
+  __m128i pos,neg;
+  offset_tables_8(offsets,4, &pos,&neg);
+
+  const __m128i bandPos = _mm_set1_epi8(bandPosition);
+
+  int x=0;
+
+  for (int y=0;y<height;y++) {
+    const uint8_t* in  = src + y*srcstride;
+    /* */ uint8_t* out = dst + y*dststride;
+
+    for (x=0; x+16<=width; x+=16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in+x));
+      v = apply_offsets_8(v, band_index_8(v,bandPos), pos,neg);
+      _mm_storeu_si128((__m128i*)(out+x), v);
+    }
+
+    if (x+8<=width) {
+      __m128i v = _mm_loadl_epi64((const __m128i*)(in+x));
+      v = apply_offsets_8(v, band_index_8(v,bandPos), pos,neg);
+      _mm_storel_epi64((__m128i*)(out+x), v);
+      x+=8;
+    }
+  }
+
+  if (x<width) {
+    sao_band_8_fallback(dst+x,dststride, src+x,srcstride, width-x,height, bandPosition,offsets);
+  }
+}
+
+
+void sao_band_16_sse4(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride,
+                      int width, int height, int bandPosition, const int8_t offsets[4],
+                      int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    sao_band_16_fallback(dst,dststride, src,srcstride, width,height, bandPosition,offsets, bit_depth);
+    return;
+  }
+
+  const __m128i table = offset_table_16(offsets,4);
+
+  const __m128i bandShift = _mm_cvtsi32_si128(bit_depth-5);
+  const __m128i bandPos = _mm_set1_epi16(bandPosition);
+  const __m128i mask5 = _mm_set1_epi16(31);
+  const __m128i three = _mm_set1_epi16(3);
+  const __m128i zero  = _mm_setzero_si128();
+  const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+
+  int x=0;
+
+  for (int y=0;y<height;y++) {
+    const uint16_t* in  = src + y*srcstride;
+    /* */ uint16_t* out = dst + y*dststride;
+
+    for (x=0; x+8<=width; x+=8) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in+x));
+
+      __m128i k = _mm_and_si128(_mm_sub_epi16(_mm_srl_epi16(v,bandShift), bandPos), mask5);
+      __m128i idx = _mm_or_si128(table_index_16(k), _mm_cmpgt_epi16(k, three));
+
+      v = _mm_add_epi16(v, _mm_shuffle_epi8(table, idx));
+      v = _mm_min_epi16(_mm_max_epi16(v, zero), maxval);
+      _mm_storeu_si128((__m128i*)(out+x), v);
+    }
+  }
+
+  if (x<width) {
+    sao_band_16_fallback(dst+x,dststride, src+x,srcstride, width-x,height,
+                         bandPosition,offsets, bit_depth);
+  }
+}
+
+
+// --- edge offset ---
+
+// edgeIdx+2 = Sign(c-a) + Sign(c-b) + 2
+static inline __m128i edge_index_8(__m128i c, __m128i a, __m128i b)
+{
+  const __m128i signbit = _mm_set1_epi8((char)0x80);
+
+  c = _mm_xor_si128(c, signbit);
+  a = _mm_xor_si128(a, signbit);
+  b = _mm_xor_si128(b, signbit);
+
+  __m128i signA = _mm_sub_epi8(_mm_cmpgt_epi8(a,c), _mm_cmpgt_epi8(c,a));
+  __m128i signB = _mm_sub_epi8(_mm_cmpgt_epi8(b,c), _mm_cmpgt_epi8(c,b));
+
+  return _mm_add_epi8(_mm_add_epi8(signA,signB), _mm_set1_epi8(2));
+}
+
+
+void sao_edge_8_sse4(uint8_t* dst, ptrdiff_t dststride, const uint8_t* src, ptrdiff_t srcstride,
+                     int width, int height, int eoClass, const int8_t offsets[5])
+{
+  __m128i pos,neg;
+  offset_tables_8(offsets,5, &pos,&neg);
+
+  const ptrdiff_t pos0 = sao_eo_hPos[eoClass][0] + sao_eo_vPos[eoClass][0]*srcstride;
+  const ptrdiff_t pos1 = sao_eo_hPos[eoClass][1] + sao_eo_vPos[eoClass][1]*srcstride;
+
+  int x=0;
+
+  for (int y=0;y<height;y++) {
+    const uint8_t* in  = src + y*srcstride;
+    /* */ uint8_t* out = dst + y*dststride;
+
+    for (x=0; x+16<=width; x+=16) {
+      __m128i c = _mm_loadu_si128((const __m128i*)(in+x));
+      __m128i a = _mm_loadu_si128((const __m128i*)(in+x+pos0));
+      __m128i b = _mm_loadu_si128((const __m128i*)(in+x+pos1));
+
+      c = apply_offsets_8(c, edge_index_8(c,a,b), pos,neg);
+      _mm_storeu_si128((__m128i*)(out+x), c);
+    }
+
+    if (x+8<=width) {
+      __m128i c = _mm_loadl_epi64((const __m128i*)(in+x));
+      __m128i a = _mm_loadl_epi64((const __m128i*)(in+x+pos0));
+      __m128i b = _mm_loadl_epi64((const __m128i*)(in+x+pos1));
+
+      c = apply_offsets_8(c, edge_index_8(c,a,b), pos,neg);
+      _mm_storel_epi64((__m128i*)(out+x), c);
+      x+=8;
+    }
+  }
+
+  if (x<width) {
+    sao_edge_8_fallback(dst+x,dststride, src+x,srcstride, width-x,height, eoClass,offsets);
+  }
+}
+
+
+void sao_edge_16_sse4(uint16_t* dst, ptrdiff_t dststride, const uint16_t* src, ptrdiff_t srcstride,
+                      int width, int height, int eoClass, const int8_t offsets[5],
+                      int bit_depth)
+{
+  if (bit_depth > MAX_SIMD_BIT_DEPTH) {
+    sao_edge_16_fallback(dst,dststride, src,srcstride, width,height, eoClass,offsets, bit_depth);
+    return;
+  }
+
+  const __m128i table = offset_table_16(offsets,5);
+
+  const ptrdiff_t pos0 = sao_eo_hPos[eoClass][0] + sao_eo_vPos[eoClass][0]*srcstride;
+  const ptrdiff_t pos1 = sao_eo_hPos[eoClass][1] + sao_eo_vPos[eoClass][1]*srcstride;
+
+  const __m128i two  = _mm_set1_epi16(2);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i maxval = _mm_set1_epi16((1<<bit_depth)-1);
+
+  int x=0;
+
+  for (int y=0;y<height;y++) {
+    const uint16_t* in  = src + y*srcstride;
+    /* */ uint16_t* out = dst + y*dststride;
+
+    for (x=0; x+8<=width; x+=8) {
+      __m128i c = _mm_loadu_si128((const __m128i*)(in+x));
+      __m128i a = _mm_loadu_si128((const __m128i*)(in+x+pos0));
+      __m128i b = _mm_loadu_si128((const __m128i*)(in+x+pos1));
+
+      __m128i signA = _mm_sub_epi16(_mm_cmpgt_epi16(a,c), _mm_cmpgt_epi16(c,a));
+      __m128i signB = _mm_sub_epi16(_mm_cmpgt_epi16(b,c), _mm_cmpgt_epi16(c,b));
+      __m128i idx = _mm_add_epi16(_mm_add_epi16(signA,signB), two);
+
+      c = _mm_add_epi16(c, _mm_shuffle_epi8(table, table_index_16(idx)));
+      c = _mm_min_epi16(_mm_max_epi16(c, zero), maxval);
+      _mm_storeu_si128((__m128i*)(out+x), c);
+    }
+  }
+
+  if (x<width) {
+    sao_edge_16_fallback(dst+x,dststride, src+x,srcstride, width-x,height,
+                         eoClass,offsets, bit_depth);
+  }
+}
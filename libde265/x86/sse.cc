@@ -18,6 +18,10 @@
  * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
@@ -25,9 +29,13 @@
 #include "x86/sse.h"
 #include "x86/sse-motion.h"
 #include "x86/sse-dct.h"
-
-#ifdef HAVE_CONFIG_H
-#include "config.h"
+#include "x86/sse-intrapred.h"
+#include "x86/sse-deblock.h"
+#include "x86/sse-sao.h"
+#if HAVE_AVX2
+#include "x86/avx2-motion.h"
+#include "x86/avx2-dct.h"
+#include "x86/avx2-intrapred.h"
 #endif
 
 #ifdef __GNUC__
@@ -92,13 +100,237 @@ void init_acceleration_functions_sse(struct acceleration_functions* accel)
     accel->transform_skip_8 = ff_hevc_transform_skip_8_sse;
 
     // actually, for these two functions, the scalar fallback seems to be faster than the SSE code
+    // (the AVX2 kernels below transform the whole block in registers and are faster)
     //accel->transform_4x4_luma_add_8 = ff_hevc_transform_4x4_luma_add_8_sse4; // SSE-4 only TODO
     //accel->transform_4x4_add_8   = ff_hevc_transform_4x4_add_8_sse4;
 
     accel->transform_add_8[1] = ff_hevc_transform_8x8_add_8_sse4;
     accel->transform_add_8[2] = ff_hevc_transform_16x16_add_8_sse4;
     accel->transform_add_8[3] = ff_hevc_transform_32x32_add_8_sse4;
+
+    accel->transform_add_dc_8 = ff_hevc_transform_add_dc_8_sse4;
+    accel->transform_add_sparse_8[1] = ff_hevc_transform_8x8_add_sparse_8_sse4;
+    accel->transform_add_sparse_8[2] = ff_hevc_transform_16x16_add_sparse_8_sse4;
+    accel->transform_add_sparse_8[3] = ff_hevc_transform_32x32_add_sparse_8_sse4;
+
+    accel->put_unweighted_pred_16   = ff_hevc_put_unweighted_pred_16_sse;
+    accel->put_weighted_pred_avg_16 = ff_hevc_put_weighted_pred_avg_16_sse;
+    accel->put_weighted_pred_16     = ff_hevc_put_weighted_pred_16_sse;
+    accel->put_weighted_bipred_16   = ff_hevc_put_weighted_bipred_16_sse;
+
+    accel->put_hevc_epel_16    = ff_hevc_put_hevc_epel_pixels_16_sse;
+    accel->put_hevc_epel_h_16  = ff_hevc_put_hevc_epel_h_16_sse;
+    accel->put_hevc_epel_v_16  = ff_hevc_put_hevc_epel_v_16_sse;
+    accel->put_hevc_epel_hv_16 = ff_hevc_put_hevc_epel_hv_16_sse;
+
+    accel->put_hevc_qpel_16[0][0] = ff_hevc_put_hevc_qpel_pixels_16_sse;
+    accel->put_hevc_qpel_16[0][1] = ff_hevc_put_hevc_qpel_v_1_16_sse;
+    accel->put_hevc_qpel_16[0][2] = ff_hevc_put_hevc_qpel_v_2_16_sse;
+    accel->put_hevc_qpel_16[0][3] = ff_hevc_put_hevc_qpel_v_3_16_sse;
+    accel->put_hevc_qpel_16[1][0] = ff_hevc_put_hevc_qpel_h_1_16_sse;
+    accel->put_hevc_qpel_16[1][1] = ff_hevc_put_hevc_qpel_h_1_v_1_16_sse;
+    accel->put_hevc_qpel_16[1][2] = ff_hevc_put_hevc_qpel_h_1_v_2_16_sse;
+    accel->put_hevc_qpel_16[1][3] = ff_hevc_put_hevc_qpel_h_1_v_3_16_sse;
+    accel->put_hevc_qpel_16[2][0] = ff_hevc_put_hevc_qpel_h_2_16_sse;
+    accel->put_hevc_qpel_16[2][1] = ff_hevc_put_hevc_qpel_h_2_v_1_16_sse;
+    accel->put_hevc_qpel_16[2][2] = ff_hevc_put_hevc_qpel_h_2_v_2_16_sse;
+    accel->put_hevc_qpel_16[2][3] = ff_hevc_put_hevc_qpel_h_2_v_3_16_sse;
+    accel->put_hevc_qpel_16[3][0] = ff_hevc_put_hevc_qpel_h_3_16_sse;
+    accel->put_hevc_qpel_16[3][1] = ff_hevc_put_hevc_qpel_h_3_v_1_16_sse;
+    accel->put_hevc_qpel_16[3][2] = ff_hevc_put_hevc_qpel_h_3_v_2_16_sse;
+    accel->put_hevc_qpel_16[3][3] = ff_hevc_put_hevc_qpel_h_3_v_3_16_sse;
+
+    accel->transform_add_16[0] = ff_hevc_transform_4x4_add_16_sse4;
+    accel->transform_add_16[1] = ff_hevc_transform_8x8_add_16_sse4;
+    accel->transform_add_16[2] = ff_hevc_transform_16x16_add_16_sse4;
+    accel->transform_add_16[3] = ff_hevc_transform_32x32_add_16_sse4;
+
+    accel->transform_add_dc_16 = ff_hevc_transform_add_dc_16_sse4;
+    accel->transform_add_sparse_16[1] = ff_hevc_transform_8x8_add_sparse_16_sse4;
+    accel->transform_add_sparse_16[2] = ff_hevc_transform_16x16_add_sparse_16_sse4;
+    accel->transform_add_sparse_16[3] = ff_hevc_transform_32x32_add_sparse_16_sse4;
+
+    accel->add_residual_16 = ff_hevc_add_residual_16_sse4;
+
+    accel->transform_idct_8x8   = transform_idct_8x8_sse4;
+    accel->transform_idct_16x16 = transform_idct_16x16_sse4;
+    accel->transform_idct_32x32 = transform_idct_32x32_sse4;
+
+    accel->intra_pred_planar_8  = intra_pred_planar_8_sse4;
+    accel->intra_pred_dc_8      = intra_pred_dc_8_sse4;
+    accel->intra_pred_angular_8 = intra_pred_angular_8_sse4;
+    accel->intra_pred_smooth_border_8 = intra_pred_smooth_border_8_sse4;
+
+    accel->intra_pred_planar_16  = intra_pred_planar_16_sse4;
+    accel->intra_pred_dc_16      = intra_pred_dc_16_sse4;
+    accel->intra_pred_angular_16 = intra_pred_angular_16_sse4;
+    accel->intra_pred_smooth_border_16 = intra_pred_smooth_border_16_sse4;
+
+    accel->deblock_luma_v_8   = deblock_luma_v_8_sse4;
+    accel->deblock_luma_h_8   = deblock_luma_h_8_sse4;
+    accel->deblock_chroma_v_8 = deblock_chroma_v_8_sse4;
+    accel->deblock_chroma_h_8 = deblock_chroma_h_8_sse4;
+
+    accel->deblock_luma_v_16   = deblock_luma_v_16_sse4;
+    accel->deblock_luma_h_16   = deblock_luma_h_16_sse4;
+    accel->deblock_chroma_v_16 = deblock_chroma_v_16_sse4;
+    accel->deblock_chroma_h_16 = deblock_chroma_h_16_sse4;
+
+    accel->sao_band_8  = sao_band_8_sse4;
+    accel->sao_edge_8  = sao_edge_8_sse4;
+    accel->sao_band_16 = sao_band_16_sse4;
+    accel->sao_edge_16 = sao_edge_16_sse4;
+  }
+#endif
+}
+
+
+#if HAVE_AVX2
+static bool cpu_supports_avx2()
+{
+  uint32_t ebx7=0, ecx1=0;
+
+#ifdef _MSC_VER
+  int regs[4];
+
+  __cpuid(regs, 0);
+  if (regs[0] < 7) { return false; }
+
+  __cpuid(regs, 1);
+  ecx1 = regs[2];
+
+  __cpuidex(regs, 7, 0);
+  ebx7 = regs[1];
+#else
+  uint32_t eax,ebx,ecx,edx;
+
+  if (__get_cpuid_max(0, NULL) < 7) { return false; }
+
+  if (!__get_cpuid(1, &eax,&ebx,&ecx,&edx)) { return false; }
+  ecx1 = ecx;
+
+  __cpuid_count(7, 0, eax,ebx,ecx,edx);
+  ebx7 = ebx;
+#endif
+
+  int have_OSXSAVE = !!(ecx1 & (1<<27));
+  int have_AVX     = !!(ecx1 & (1<<28));
+  int have_AVX2    = !!(ebx7 & (1<<5));
+
+  if (!have_OSXSAVE || !have_AVX || !have_AVX2) {
+    return false;
   }
+
+  // check that the OS saves the YMM registers
+
+  uint64_t xcr0;
+#ifdef _MSC_VER
+  xcr0 = _xgetbv(0);
+#else
+  uint32_t xcr0_lo, xcr0_hi;
+  __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  xcr0 = ((uint64_t)xcr0_hi << 32) | xcr0_lo;
 #endif
+
+  return (xcr0 & 6) == 6;
 }
+#endif
+
+
+void init_acceleration_functions_avx2(struct acceleration_functions* accel)
+{
+#if HAVE_AVX2
+  if (cpu_supports_avx2()) {
+    accel->put_unweighted_pred_8   = ff_hevc_put_unweighted_pred_8_avx2;
+    accel->put_weighted_pred_avg_8 = ff_hevc_put_weighted_pred_avg_8_avx2;
+    accel->put_weighted_pred_8     = ff_hevc_put_weighted_pred_8_avx2;
+    accel->put_weighted_bipred_8   = ff_hevc_put_weighted_bipred_8_avx2;
 
+    accel->put_hevc_epel_8    = ff_hevc_put_hevc_epel_pixels_8_avx2;
+    accel->put_hevc_epel_h_8  = ff_hevc_put_hevc_epel_h_8_avx2;
+    accel->put_hevc_epel_v_8  = ff_hevc_put_hevc_epel_v_8_avx2;
+    accel->put_hevc_epel_hv_8 = ff_hevc_put_hevc_epel_hv_8_avx2;
+
+    accel->put_hevc_qpel_8[0][0] = ff_hevc_put_hevc_qpel_pixels_8_avx2;
+    accel->put_hevc_qpel_8[0][1] = ff_hevc_put_hevc_qpel_v_1_8_avx2;
+    accel->put_hevc_qpel_8[0][2] = ff_hevc_put_hevc_qpel_v_2_8_avx2;
+    accel->put_hevc_qpel_8[0][3] = ff_hevc_put_hevc_qpel_v_3_8_avx2;
+    accel->put_hevc_qpel_8[1][0] = ff_hevc_put_hevc_qpel_h_1_8_avx2;
+    accel->put_hevc_qpel_8[1][1] = ff_hevc_put_hevc_qpel_h_1_v_1_avx2;
+    accel->put_hevc_qpel_8[1][2] = ff_hevc_put_hevc_qpel_h_1_v_2_avx2;
+    accel->put_hevc_qpel_8[1][3] = ff_hevc_put_hevc_qpel_h_1_v_3_avx2;
+    accel->put_hevc_qpel_8[2][0] = ff_hevc_put_hevc_qpel_h_2_8_avx2;
+    accel->put_hevc_qpel_8[2][1] = ff_hevc_put_hevc_qpel_h_2_v_1_avx2;
+    accel->put_hevc_qpel_8[2][2] = ff_hevc_put_hevc_qpel_h_2_v_2_avx2;
+    accel->put_hevc_qpel_8[2][3] = ff_hevc_put_hevc_qpel_h_2_v_3_avx2;
+    accel->put_hevc_qpel_8[3][0] = ff_hevc_put_hevc_qpel_h_3_8_avx2;
+    accel->put_hevc_qpel_8[3][1] = ff_hevc_put_hevc_qpel_h_3_v_1_avx2;
+    accel->put_hevc_qpel_8[3][2] = ff_hevc_put_hevc_qpel_h_3_v_2_avx2;
+    accel->put_hevc_qpel_8[3][3] = ff_hevc_put_hevc_qpel_h_3_v_3_avx2;
+
+    accel->put_unweighted_pred_16   = ff_hevc_put_unweighted_pred_16_avx2;
+    accel->put_weighted_pred_avg_16 = ff_hevc_put_weighted_pred_avg_16_avx2;
+    accel->put_weighted_pred_16     = ff_hevc_put_weighted_pred_16_avx2;
+    accel->put_weighted_bipred_16   = ff_hevc_put_weighted_bipred_16_avx2;
+
+    accel->put_hevc_epel_16    = ff_hevc_put_hevc_epel_pixels_16_avx2;
+    accel->put_hevc_epel_h_16  = ff_hevc_put_hevc_epel_h_16_avx2;
+    accel->put_hevc_epel_v_16  = ff_hevc_put_hevc_epel_v_16_avx2;
+    accel->put_hevc_epel_hv_16 = ff_hevc_put_hevc_epel_hv_16_avx2;
+
+    accel->put_hevc_qpel_16[0][0] = ff_hevc_put_hevc_qpel_pixels_16_avx2;
+    accel->put_hevc_qpel_16[0][1] = ff_hevc_put_hevc_qpel_v_1_16_avx2;
+    accel->put_hevc_qpel_16[0][2] = ff_hevc_put_hevc_qpel_v_2_16_avx2;
+    accel->put_hevc_qpel_16[0][3] = ff_hevc_put_hevc_qpel_v_3_16_avx2;
+    accel->put_hevc_qpel_16[1][0] = ff_hevc_put_hevc_qpel_h_1_16_avx2;
+    accel->put_hevc_qpel_16[1][1] = ff_hevc_put_hevc_qpel_h_1_v_1_16_avx2;
+    accel->put_hevc_qpel_16[1][2] = ff_hevc_put_hevc_qpel_h_1_v_2_16_avx2;
+    accel->put_hevc_qpel_16[1][3] = ff_hevc_put_hevc_qpel_h_1_v_3_16_avx2;
+    accel->put_hevc_qpel_16[2][0] = ff_hevc_put_hevc_qpel_h_2_16_avx2;
+    accel->put_hevc_qpel_16[2][1] = ff_hevc_put_hevc_qpel_h_2_v_1_16_avx2;
+    accel->put_hevc_qpel_16[2][2] = ff_hevc_put_hevc_qpel_h_2_v_2_16_avx2;
+    accel->put_hevc_qpel_16[2][3] = ff_hevc_put_hevc_qpel_h_2_v_3_16_avx2;
+    accel->put_hevc_qpel_16[3][0] = ff_hevc_put_hevc_qpel_h_3_16_avx2;
+    accel->put_hevc_qpel_16[3][1] = ff_hevc_put_hevc_qpel_h_3_v_1_16_avx2;
+    accel->put_hevc_qpel_16[3][2] = ff_hevc_put_hevc_qpel_h_3_v_2_16_avx2;
+    accel->put_hevc_qpel_16[3][3] = ff_hevc_put_hevc_qpel_h_3_v_3_16_avx2;
+
+    accel->transform_add_16[2] = ff_hevc_transform_16x16_add_16_avx2;
+    accel->transform_add_16[3] = ff_hevc_transform_32x32_add_16_avx2;
+
+    accel->transform_add_sparse_16[2] = ff_hevc_transform_16x16_add_sparse_16_avx2;
+    accel->transform_add_sparse_16[3] = ff_hevc_transform_32x32_add_sparse_16_avx2;
+    accel->transform_add_sparse_8[3]  = ff_hevc_transform_32x32_add_sparse_8_avx2;
+
+    accel->transform_add_8[0]       = transform_4x4_add_8_avx2;
+    accel->transform_4x4_dst_add_8  = transform_4x4_dst_add_8_avx2;
+    accel->transform_add_16[0]      = transform_4x4_add_16_avx2;
+    accel->transform_4x4_dst_add_16 = transform_4x4_dst_add_16_avx2;
+
+    accel->add_residual_8  = ff_hevc_add_residual_8_avx2;
+    accel->add_residual_16 = ff_hevc_add_residual_16_avx2;
+
+    accel->transform_idst_4x4   = transform_idst_4x4_avx2;
+    accel->transform_idct_4x4   = transform_idct_4x4_avx2;
+    accel->transform_idct_16x16 = transform_idct_16x16_avx2;
+    accel->transform_idct_32x32 = transform_idct_32x32_avx2;
+
+    accel->transform_skip_residual  = transform_skip_residual_avx2;
+    accel->rdpcm_v                  = rdpcm_v_avx2;
+    accel->rdpcm_h                  = rdpcm_h_avx2;
+    accel->transform_bypass         = transform_bypass_avx2;
+    accel->transform_bypass_rdpcm_v = transform_bypass_rdpcm_v_avx2;
+    accel->transform_bypass_rdpcm_h = transform_bypass_rdpcm_h_avx2;
+
+    accel->intra_pred_planar_8  = intra_pred_planar_8_avx2;
+    accel->intra_pred_dc_8      = intra_pred_dc_8_avx2;
+    accel->intra_pred_angular_8 = intra_pred_angular_8_avx2;
+    accel->intra_pred_smooth_border_8 = intra_pred_smooth_border_8_avx2;
+
+    accel->intra_pred_planar_16  = intra_pred_planar_16_avx2;
+    accel->intra_pred_dc_16      = intra_pred_dc_16_avx2;
+    accel->intra_pred_angular_16 = intra_pred_angular_16_avx2;
+    accel->intra_pred_smooth_border_16 = intra_pred_smooth_border_16_avx2;
+  }
+#endif
+}
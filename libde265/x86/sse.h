@@ -24,5 +24,6 @@
 #include "acceleration.h"
 
 void init_acceleration_functions_sse(struct acceleration_functions* accel);
+void init_acceleration_functions_avx2(struct acceleration_functions* accel);
 
 #endif
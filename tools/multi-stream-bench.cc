@@ -0,0 +1,426 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Decodes several bitstreams concurrently and reports the aggregate throughput.
+   Each stream is decoded by its own decoder, which is driven by its own application
+   thread. The decoders either start their own worker threads or share one thread pool.
+   For each stream, the time between successive output pictures is recorded and
+   summarized as percentiles. The CPU time and the peak memory usage of the whole
+   process are reported as well, optionally in JSON format.
+ */
+
+#include "libde265/de265.h"
+#include "libde265/threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+static int nStreams = 0;          // 0: one stream per input file
+static int nThreadsPerDecoder = 0;
+static int nPoolThreads = 0;      // >0: all decoders share a pool with this many threads
+static int nRepetitions = 1;
+static const char* jsonFile = NULL;
+
+
+static double get_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  double t  = tv.tv_sec;
+  double ut = tv.tv_usec/1000000.0f;
+  t += ut;
+  return t;
+}
+
+
+static double get_cpu_time()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+          (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec)/1000000.0);
+}
+
+
+static long get_peak_rss_kb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+  return usage.ru_maxrss / 1024; // bytes on OS X
+#else
+  return usage.ru_maxrss;
+#endif
+}
+
+
+static std::vector<uint8_t> read_file(const char* filename)
+{
+  std::vector<uint8_t> data;
+
+  FILE* fh = fopen(filename, "rb");
+  if (fh==NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    exit(10);
+  }
+
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf,1,sizeof(buf),fh)) > 0) {
+    data.insert(data.end(), buf, buf+n);
+  }
+
+  fclose(fh);
+
+  return data;
+}
+
+
+// --- one decoded stream ---
+
+struct stream
+{
+  const char* filename;
+  const std::vector<uint8_t>* data;
+
+  de265_thread_pool* pool;
+
+  // results
+
+  bool   ok;
+  int    nFrames;
+  double startTime, endTime;
+  std::vector<double> frameIntervals; // time between successive output pictures [s]
+};
+
+
+static void* decode_stream(void* arg)
+{
+  stream* s = (stream*)arg;
+
+  s->ok = true;
+  s->nFrames = 0;
+  s->startTime = get_time();
+
+  double lastOutput = s->startTime;
+
+  for (int r=0;r<nRepetitions && s->ok;r++) {
+    de265_decoder_context* ctx = de265_new_decoder();
+
+    if (s->pool) {
+      de265_attach_thread_pool(ctx, s->pool);
+    }
+    else if (nThreadsPerDecoder>0) {
+      de265_start_worker_threads(ctx, nThreadsPerDecoder);
+    }
+
+    // the input stays in memory during the whole run, hence it does not have to be copied
+
+    de265_push_data_nocopy(ctx, &(*s->data)[0], s->data->size(), 0, NULL);
+    de265_flush_data(ctx);
+
+    int more=1;
+    while (more) {
+      more = 0;
+
+      de265_error err = de265_decode(ctx, &more);
+      if (err != DE265_OK && err != DE265_ERROR_WAITING_FOR_INPUT_DATA) {
+        fprintf(stderr,"%s: %s\n", s->filename, de265_get_error_text(err));
+        s->ok = false;
+        break;
+      }
+
+      while (de265_get_next_picture(ctx)) {
+        double now = get_time();
+
+        s->frameIntervals.push_back(now - lastOutput);
+        lastOutput = now;
+
+        s->nFrames++;
+      }
+
+      while (de265_get_warning(ctx) != DE265_OK) { }
+    }
+
+    de265_free_decoder(ctx);
+  }
+
+  s->endTime = get_time();
+
+  return NULL;
+}
+
+
+// --- statistics ---
+
+struct latency_stats
+{
+  double p50, p90, p99, max;
+};
+
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+  if (sorted.empty()) { return 0; }
+
+  // nearest-rank method
+  size_t rank = (size_t)(p/100.0 * sorted.size() + 0.5);
+  if (rank < 1) rank = 1;
+  if (rank > sorted.size()) rank = sorted.size();
+
+  return sorted[rank-1];
+}
+
+
+static latency_stats get_latency_stats(std::vector<double> intervals)
+{
+  std::sort(intervals.begin(), intervals.end());
+
+  latency_stats stats;
+  stats.p50 = percentile(intervals, 50);
+  stats.p90 = percentile(intervals, 90);
+  stats.p99 = percentile(intervals, 99);
+  stats.max = intervals.empty() ? 0 : intervals.back();
+  return stats;
+}
+
+
+static std::string json_string(const char* str)
+{
+  std::string out = "\"";
+  for (const char* p=str; *p; p++) {
+    if (*p=='"' || *p=='\\') { out += '\\'; }
+    out += *p;
+  }
+  out += "\"";
+  return out;
+}
+
+
+static void usage()
+{
+  fprintf(stderr,
+          "usage: multi-stream-bench [options] bitstream [bitstream ...]\n"
+          "  -n, --streams N        number of concurrently decoded streams\n"
+          "                         (default: one per bitstream, bitstreams are used round-robin)\n"
+          "  -t, --threads N        worker threads of each decoder\n"
+          "  -p, --pool N           share one pool of N worker threads between all decoders\n"
+          "  -r, --repeat N         decode each stream N times\n"
+          "  -j, --json FILE        write the results as JSON ('-' for stdout)\n"
+          "  -h, --help             show this help\n");
+}
+
+
+static struct option long_options[] = {
+  {"streams",    required_argument, 0, 'n' },
+  {"threads",    required_argument, 0, 't' },
+  {"pool",       required_argument, 0, 'p' },
+  {"repeat",     required_argument, 0, 'r' },
+  {"json",       required_argument, 0, 'j' },
+  {"help",       no_argument,       0, 'h' },
+  {0,            0,                 0,  0  }
+};
+
+
+int main(int argc, char** argv)
+{
+  for (;;) {
+    int option_index = 0;
+
+    int c = getopt_long(argc, argv, "n:t:p:r:j:h", long_options, &option_index);
+    if (c == -1)
+      break;
+
+    switch (c) {
+    case 'n': nStreams = atoi(optarg); break;
+    case 't': nThreadsPerDecoder = atoi(optarg); break;
+    case 'p': nPoolThreads = atoi(optarg); break;
+    case 'r': nRepetitions = atoi(optarg); break;
+    case 'j': jsonFile = optarg; break;
+    case 'h':
+    default:
+      usage();
+      exit(5);
+    }
+  }
+
+  if (optind == argc) {
+    usage();
+    exit(5);
+  }
+
+  int nFiles = argc-optind;
+  if (nStreams<=0) { nStreams = nFiles; }
+
+
+  // read all input files before the time measurement
+
+  std::vector<std::vector<uint8_t> > files(nFiles);
+  for (int i=0;i<nFiles;i++) {
+    files[i] = read_file(argv[optind+i]);
+  }
+
+
+  // The library initialization is not thread-safe, hence do it before the decoders are
+  // created concurrently.
+
+  if (de265_init() != DE265_OK) {
+    fprintf(stderr,"cannot initialize libde265\n");
+    exit(10);
+  }
+
+  de265_thread_pool* pool = NULL;
+  if (nPoolThreads>0) {
+    pool = de265_new_thread_pool(nPoolThreads);
+    if (pool==NULL) {
+      fprintf(stderr,"cannot start thread pool\n");
+      exit(10);
+    }
+  }
+
+  std::vector<stream> streams(nStreams);
+  for (int i=0;i<nStreams;i++) {
+    streams[i].filename = argv[optind + i%nFiles];
+    streams[i].data = &files[i%nFiles];
+    streams[i].pool = pool;
+  }
+
+
+  // decode all streams concurrently
+
+  double cpuStart = get_cpu_time();
+  double start = get_time();
+
+  std::vector<de265_thread> threads(nStreams);
+  for (int i=0;i<nStreams;i++) {
+    if (de265_thread_create(&threads[i], decode_stream, &streams[i]) != 0) {
+      fprintf(stderr,"cannot start decoding thread\n");
+      exit(10);
+    }
+  }
+
+  for (int i=0;i<nStreams;i++) {
+    de265_thread_join(threads[i]);
+    de265_thread_destroy(&threads[i]);
+  }
+
+  double wallTime = get_time() - start;
+  double cpuTime  = get_cpu_time() - cpuStart;
+
+  if (pool) {
+    de265_free_thread_pool(pool);
+  }
+
+  de265_free();
+
+
+  // --- summary ---
+
+  int totalFrames = 0;
+  bool allOk = true;
+  for (int i=0;i<nStreams;i++) {
+    totalFrames += streams[i].nFrames;
+    allOk &= streams[i].ok;
+  }
+
+  int nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nCPUs<1) nCPUs=1;
+
+  double cpuUtilisation = cpuTime / wallTime / nCPUs;
+  long peakRSS = get_peak_rss_kb();
+
+  printf("stream                          frames     time       fps   latency p50/p90/p99/max [ms]\n");
+  for (int i=0;i<nStreams;i++) {
+    const stream& s = streams[i];
+    double t = s.endTime - s.startTime;
+    latency_stats lat = get_latency_stats(s.frameIntervals);
+
+    printf("%-30s  %6d  %7.3f s  %8.2f   %6.2f %6.2f %6.2f %6.2f%s\n",
+           s.filename, s.nFrames, t, s.nFrames/t,
+           lat.p50*1000, lat.p90*1000, lat.p99*1000, lat.max*1000,
+           s.ok ? "" : "  (error)");
+  }
+
+  printf("\n%d streams, %d frames in %.3f s: %.2f fps\n", nStreams, totalFrames, wallTime,
+         totalFrames/wallTime);
+  printf("CPU time %.3f s, %.1f%% of %d cores, peak RSS %ld KB\n",
+         cpuTime, cpuUtilisation*100, nCPUs, peakRSS);
+
+
+  // --- JSON output ---
+
+  if (jsonFile) {
+    FILE* fh = (strcmp(jsonFile,"-")==0 ? stdout : fopen(jsonFile,"w"));
+    if (fh==NULL) {
+      fprintf(stderr,"cannot write %s\n", jsonFile);
+      exit(10);
+    }
+
+    fprintf(fh,"{\n");
+    fprintf(fh,"  \"streams\": %d,\n", nStreams);
+    fprintf(fh,"  \"threads_per_decoder\": %d,\n", pool ? 0 : nThreadsPerDecoder);
+    fprintf(fh,"  \"pool_threads\": %d,\n", nPoolThreads);
+    fprintf(fh,"  \"repetitions\": %d,\n", nRepetitions);
+    fprintf(fh,"  \"frames\": %d,\n", totalFrames);
+    fprintf(fh,"  \"wall_time_s\": %.6f,\n", wallTime);
+    fprintf(fh,"  \"fps\": %.3f,\n", totalFrames/wallTime);
+    fprintf(fh,"  \"cpu_time_s\": %.6f,\n", cpuTime);
+    fprintf(fh,"  \"cpus\": %d,\n", nCPUs);
+    fprintf(fh,"  \"cpu_utilisation\": %.4f,\n", cpuUtilisation);
+    fprintf(fh,"  \"peak_rss_kb\": %ld,\n", peakRSS);
+    fprintf(fh,"  \"ok\": %s,\n", allOk ? "true" : "false");
+    fprintf(fh,"  \"per_stream\": [\n");
+
+    for (int i=0;i<nStreams;i++) {
+      const stream& s = streams[i];
+      double t = s.endTime - s.startTime;
+      latency_stats lat = get_latency_stats(s.frameIntervals);
+
+      fprintf(fh,"    { \"file\": %s, \"frames\": %d, \"time_s\": %.6f, \"fps\": %.3f, "
+              "\"latency_ms\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f }, "
+              "\"ok\": %s }%s\n",
+              json_string(s.filename).c_str(), s.nFrames, t, s.nFrames/t,
+              lat.p50*1000, lat.p90*1000, lat.p99*1000, lat.max*1000,
+              s.ok ? "true" : "false",
+              i+1<nStreams ? "," : "");
+    }
+
+    fprintf(fh,"  ]\n");
+    fprintf(fh,"}\n");
+
+    if (fh != stdout) {
+      fclose(fh);
+    }
+  }
+
+  return allOk ? 0 : 1;
+}
@@ -18,9 +18,26 @@
  * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdio.h>
 #include <iostream>
 #include <string.h>
+#include <vector>
+
+#include "libde265/acceleration.h"
+#include "libde265/fallback.h"
+#include "libde265/util.h"
+
+#ifdef HAVE_SSE4_1
+#include "libde265/x86/sse.h"
+#endif
+
+#ifdef HAVE_ARM
+#include "libde265/arm/arm.h"
+#endif
 
 
 class Test
@@ -87,6 +104,863 @@ public:
 
 
 
+// --- optimized kernels against the scalar fallback ---
+
+/* The kernel tests run the function tables of all instruction sets that were compiled in
+   with random input and random (valid) block sizes, and compare the output block with the
+   one of the fallback functions. Instruction sets that the CPU does not support leave the
+   table unchanged. The memory around the output block is not compared, since the kernels
+   may use it as scratch space.
+ */
+
+static uint32_t random_state;
+
+static void random_seed(uint32_t seed) { random_state = seed; }
+
+// uniformly distributed in [lo;hi]
+static int random_int(int lo, int hi)
+{
+  random_state = random_state*1103515245 + 12345;
+  return lo + (int)((random_state>>8) % (uint32_t)(hi-lo+1));
+}
+
+
+struct accel_variant
+{
+  const char* name;
+  acceleration_functions accel;
+};
+
+static std::vector<accel_variant> optimized_variants()
+{
+  std::vector<accel_variant> variants;
+
+  accel_variant v;
+  init_acceleration_functions_fallback(&v.accel);
+
+#ifdef HAVE_SSE4_1
+  v.name = "SSE4.1";
+  init_acceleration_functions_sse(&v.accel);
+  variants.push_back(v);
+
+  v.name = "AVX2";
+  init_acceleration_functions_avx2(&v.accel);
+  variants.push_back(v);
+#endif
+
+#ifdef HAVE_ARM
+  v.name = "ARM";
+  init_acceleration_functions_arm(&v.accel);
+  variants.push_back(v);
+#endif
+
+  return variants;
+}
+
+
+template <class T>
+static bool compare_blocks(const T* out, const T* ref, ptrdiff_t stride, int w, int h,
+                           const char* variant, const char* function, bool quiet)
+{
+  for (int y=0;y<h;y++)
+    for (int x=0;x<w;x++) {
+      if (out[x+y*stride] != ref[x+y*stride]) {
+        if (!quiet) {
+          printf("%s %s: %dx%d block differs at (%d;%d): %d instead of %d\n",
+                 variant, function, w,h, x,y, (int)out[x+y*stride], (int)ref[x+y*stride]);
+        }
+        return false;
+      }
+    }
+
+  return true;
+}
+
+
+// size of a prediction block of a random inter CB partitioning
+static void random_PB_size(int* w, int* h)
+{
+  int s = 8 << random_int(0,3);
+
+  switch (random_int(0, s>8 ? 7 : 2)) {
+  case 0: *w=s;     *h=s;     break; // PART_2Nx2N
+  case 1: *w=s;     *h=s/2;   break; // PART_2NxN
+  case 2: *w=s/2;   *h=s;     break; // PART_Nx2N
+  case 3: *w=s/2;   *h=s/2;   break; // PART_NxN
+  case 4: *w=s;     *h=s/4;   break; // PART_2NxnU, PART_2NxnD
+  case 5: *w=s;     *h=s*3/4; break;
+  case 6: *w=s/4;   *h=s;     break; // PART_nLx2N, PART_nRx2N
+  case 7: *w=s*3/4; *h=s;     break;
+  }
+}
+
+// size of the corresponding chroma block in a random chroma format
+static void random_chroma_size(int* w, int* h)
+{
+  switch (random_int(0,2)) {
+  case 0: *w/=2; *h/=2; break; // 4:2:0
+  case 1: *w/=2;        break; // 4:2:2
+  case 2:               break; // 4:4:4
+  }
+}
+
+// range of the interpolated samples (14 bit intermediate precision plus filter overshoot)
+static int16_t random_mc_sample()
+{
+  return random_int(-10240, 26623);
+}
+
+
+#define MC_STRIDE  64  // MAX_CU_SIZE, like the prediction buffers in motion.cc
+#define SRC_STRIDE 96
+
+
+class MotionCompensation8Test : public Test
+{
+public:
+  const char* getName() const { return "mc-8bit"; }
+  const char* getDescription() const { return "8-bit interpolation and weighted prediction kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(1);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    uint8_t srcbuf[SRC_STRIDE*SRC_STRIDE];
+    const uint8_t* src = &srcbuf[8*SRC_STRIDE+8];
+
+    ALIGNED_32(int16_t) mcbuffer[MC_STRIDE*(MC_STRIDE+7)];
+    ALIGNED_32(int16_t) out[MC_STRIDE*MC_STRIDE];
+    ALIGNED_32(int16_t) ref[MC_STRIDE*MC_STRIDE];
+
+    ALIGNED_32(int16_t) pred1[MC_STRIDE*MC_STRIDE];
+    ALIGNED_32(int16_t) pred2[MC_STRIDE*MC_STRIDE];
+    uint8_t dst[SRC_STRIDE*MC_STRIDE];
+    uint8_t dstref[SRC_STRIDE*MC_STRIDE];
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      const acceleration_functions& accel = variants[v].accel;
+      const char* name = variants[v].name;
+
+      for (int i=0;i<2000;i++) {
+        for (int k=0;k<SRC_STRIDE*SRC_STRIDE;k++) { srcbuf[k] = random_int(0,255); }
+
+        int w,h;
+        random_PB_size(&w,&h);
+
+        // luma interpolation
+
+        int dX = random_int(0,3);
+        int dY = random_int(0,3);
+
+        accel   .put_hevc_qpel_8[dX][dY](out, MC_STRIDE, src, SRC_STRIDE, w,h, mcbuffer);
+        fallback.put_hevc_qpel_8[dX][dY](ref, MC_STRIDE, src, SRC_STRIDE, w,h, mcbuffer);
+        ok &= compare_blocks(out,ref,MC_STRIDE, w,h, name, "put_hevc_qpel_8", quiet);
+
+        // chroma interpolation
+
+        int wC=w, hC=h;
+        random_chroma_size(&wC,&hC);
+
+        int mx = random_int(1,7);
+        int my = random_int(1,7);
+
+        accel   .put_hevc_epel_8(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,0, NULL);
+        fallback.put_hevc_epel_8(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,0, NULL);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_8", quiet);
+
+        accel   .put_hevc_epel_h_8(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,0, mcbuffer, 8);
+        fallback.put_hevc_epel_h_8(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,0, mcbuffer, 8);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_h_8", quiet);
+
+        accel   .put_hevc_epel_v_8(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,my, mcbuffer, 8);
+        fallback.put_hevc_epel_v_8(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,my, mcbuffer, 8);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_v_8", quiet);
+
+        accel   .put_hevc_epel_hv_8(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,my, mcbuffer, 8);
+        fallback.put_hevc_epel_hv_8(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,my, mcbuffer, 8);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_hv_8", quiet);
+
+        // weighted prediction, of a luma or a chroma block
+
+        if (random_int(0,1)) { w=wC; h=hC; }
+
+        for (int k=0;k<MC_STRIDE*MC_STRIDE;k++) {
+          pred1[k] = random_mc_sample();
+          pred2[k] = random_mc_sample();
+        }
+
+        int log2Wd = random_int(0,7) + 6;
+        int w1 = (1<<(log2Wd-6)) + random_int(-128,127);
+        int w2 = (1<<(log2Wd-6)) + random_int(-128,127);
+        int o1 = random_int(-128,127);
+        int o2 = random_int(-128,127);
+
+        accel   .put_unweighted_pred_8(dst,    SRC_STRIDE, pred1, MC_STRIDE, w,h);
+        fallback.put_unweighted_pred_8(dstref, SRC_STRIDE, pred1, MC_STRIDE, w,h);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_unweighted_pred_8", quiet);
+
+        accel   .put_weighted_pred_avg_8(dst,    SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h);
+        fallback.put_weighted_pred_avg_8(dstref, SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_pred_avg_8", quiet);
+
+        accel   .put_weighted_pred_8(dst,    SRC_STRIDE, pred1, MC_STRIDE, w,h, w1,o1,log2Wd);
+        fallback.put_weighted_pred_8(dstref, SRC_STRIDE, pred1, MC_STRIDE, w,h, w1,o1,log2Wd);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_pred_8", quiet);
+
+        accel   .put_weighted_bipred_8(dst,    SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h,
+                                       w1,o1, w2,o2, log2Wd);
+        fallback.put_weighted_bipred_8(dstref, SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h,
+                                       w1,o1, w2,o2, log2Wd);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_bipred_8", quiet);
+      }
+    }
+
+    return ok;
+  }
+} mc8test;
+
+
+class MotionCompensation16Test : public Test
+{
+public:
+  const char* getName() const { return "mc-16bit"; }
+  const char* getDescription() const { return "high bit-depth interpolation, weighted prediction and residual kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(2);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    uint16_t srcbuf[SRC_STRIDE*SRC_STRIDE];
+    const uint16_t* src = &srcbuf[8*SRC_STRIDE+8];
+
+    ALIGNED_32(int16_t) mcbuffer[MC_STRIDE*(MC_STRIDE+7)];
+    ALIGNED_32(int16_t) out[MC_STRIDE*MC_STRIDE];
+    ALIGNED_32(int16_t) ref[MC_STRIDE*MC_STRIDE];
+
+    ALIGNED_32(int16_t) pred1[MC_STRIDE*MC_STRIDE];
+    ALIGNED_32(int16_t) pred2[MC_STRIDE*MC_STRIDE];
+    uint16_t dst[SRC_STRIDE*MC_STRIDE];
+    uint16_t dstref[SRC_STRIDE*MC_STRIDE];
+
+    ALIGNED_32(int32_t) residual[32*32];
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      const acceleration_functions& accel = variants[v].accel;
+      const char* name = variants[v].name;
+
+      for (int i=0;i<2000;i++) {
+        int bit_depth = random_int(9,12);
+        int maxval = (1<<bit_depth)-1;
+
+        for (int k=0;k<SRC_STRIDE*SRC_STRIDE;k++) { srcbuf[k] = random_int(0,maxval); }
+
+        int w,h;
+        random_PB_size(&w,&h);
+
+        // luma interpolation
+
+        int dX = random_int(0,3);
+        int dY = random_int(0,3);
+
+        accel   .put_hevc_qpel_16[dX][dY](out, MC_STRIDE, src, SRC_STRIDE, w,h, mcbuffer, bit_depth);
+        fallback.put_hevc_qpel_16[dX][dY](ref, MC_STRIDE, src, SRC_STRIDE, w,h, mcbuffer, bit_depth);
+        ok &= compare_blocks(out,ref,MC_STRIDE, w,h, name, "put_hevc_qpel_16", quiet);
+
+        // chroma interpolation
+
+        int wC=w, hC=h;
+        random_chroma_size(&wC,&hC);
+
+        int mx = random_int(1,7);
+        int my = random_int(1,7);
+
+        accel   .put_hevc_epel_16(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,0, NULL, bit_depth);
+        fallback.put_hevc_epel_16(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,0, NULL, bit_depth);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_16", quiet);
+
+        accel   .put_hevc_epel_h_16(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,0, mcbuffer, bit_depth);
+        fallback.put_hevc_epel_h_16(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,0, mcbuffer, bit_depth);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_h_16", quiet);
+
+        accel   .put_hevc_epel_v_16(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,my, mcbuffer, bit_depth);
+        fallback.put_hevc_epel_v_16(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, 0,my, mcbuffer, bit_depth);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_v_16", quiet);
+
+        accel   .put_hevc_epel_hv_16(out, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,my, mcbuffer, bit_depth);
+        fallback.put_hevc_epel_hv_16(ref, MC_STRIDE, src, SRC_STRIDE, wC,hC, mx,my, mcbuffer, bit_depth);
+        ok &= compare_blocks(out,ref,MC_STRIDE, wC,hC, name, "put_hevc_epel_hv_16", quiet);
+
+        // weighted prediction, of a luma or a chroma block
+
+        if (random_int(0,1)) { w=wC; h=hC; }
+
+        for (int k=0;k<MC_STRIDE*MC_STRIDE;k++) {
+          pred1[k] = random_mc_sample();
+          pred2[k] = random_mc_sample();
+        }
+
+        int shift1 = 14-bit_depth;
+        int log2Wd = random_int(0,7) + shift1;
+        int w1 = (1<<(log2Wd-shift1)) + random_int(-128,127);
+        int w2 = (1<<(log2Wd-shift1)) + random_int(-128,127);
+        int o1 = random_int(-128,127) << (bit_depth-8);
+        int o2 = random_int(-128,127) << (bit_depth-8);
+
+        accel   .put_unweighted_pred_16(dst,    SRC_STRIDE, pred1, MC_STRIDE, w,h, bit_depth);
+        fallback.put_unweighted_pred_16(dstref, SRC_STRIDE, pred1, MC_STRIDE, w,h, bit_depth);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_unweighted_pred_16", quiet);
+
+        accel   .put_weighted_pred_avg_16(dst,    SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h, bit_depth);
+        fallback.put_weighted_pred_avg_16(dstref, SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h, bit_depth);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_pred_avg_16", quiet);
+
+        accel   .put_weighted_pred_16(dst,    SRC_STRIDE, pred1, MC_STRIDE, w,h,
+                                      w1,o1,log2Wd, bit_depth);
+        fallback.put_weighted_pred_16(dstref, SRC_STRIDE, pred1, MC_STRIDE, w,h,
+                                      w1,o1,log2Wd, bit_depth);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_pred_16", quiet);
+
+        accel   .put_weighted_bipred_16(dst,    SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h,
+                                        w1,o1, w2,o2, log2Wd, bit_depth);
+        fallback.put_weighted_bipred_16(dstref, SRC_STRIDE, pred1,pred2, MC_STRIDE, w,h,
+                                        w1,o1, w2,o2, log2Wd, bit_depth);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, w,h, name, "put_weighted_bipred_16", quiet);
+
+        // residual of a transform block
+
+        int nT = 4 << random_int(0,3);
+
+        for (int k=0;k<nT*nT;k++) { residual[k] = random_int(-2*maxval-2, 2*maxval+2); }
+        for (int k=0;k<SRC_STRIDE*MC_STRIDE;k++) { dst[k] = dstref[k] = random_int(0,maxval); }
+
+        accel   .add_residual_16(dst,    SRC_STRIDE, residual, nT, bit_depth);
+        fallback.add_residual_16(dstref, SRC_STRIDE, residual, nT, bit_depth);
+        ok &= compare_blocks(dst,dstref,SRC_STRIDE, nT,nT, name, "add_residual_16", quiet);
+      }
+    }
+
+    return ok;
+  }
+} mc16test;
+
+
+template <class pixel_t>
+static bool test_intra_prediction(const acceleration_functions& accel,
+                                  const acceleration_functions& fallback,
+                                  int bit_depth, const char* name, bool quiet)
+{
+  const int maxval = (1<<bit_depth)-1;
+
+  pixel_t bordermem[4*64+1 + 2*32];
+  pixel_t* border = &bordermem[2*64+32];
+  pixel_t bordermem_ref[4*64+1 + 2*32];
+  pixel_t* border_ref = &bordermem_ref[2*64+32];
+
+  pixel_t out[SRC_STRIDE*32];
+  pixel_t ref[SRC_STRIDE*32];
+
+  bool ok = true;
+
+  for (int i=0;i<1000;i++) {
+    int nT = 4 << random_int(0,3);
+
+    for (int k=0;k<4*64+1+2*32;k++) { bordermem[k] = random_int(0,maxval); }
+
+    // a strong edge between the left and the top samples makes the boundary filters clip
+    if (random_int(0,1)) {
+      for (int k=-2*nT;k<=2*nT;k++) { border[k] = (k<0 ? maxval : 0) + random_int(0,3); }
+    }
+
+    accel   .intra_pred_planar<pixel_t>(out, SRC_STRIDE, border, nT, bit_depth);
+    fallback.intra_pred_planar<pixel_t>(ref, SRC_STRIDE, border, nT, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "intra_pred_planar", quiet);
+
+    // edge filters are only used for luma blocks smaller than 32x32
+    bool filter = (nT<32 && random_int(0,1));
+
+    accel   .intra_pred_dc<pixel_t>(out, SRC_STRIDE, border, nT, filter, bit_depth);
+    fallback.intra_pred_dc<pixel_t>(ref, SRC_STRIDE, border, nT, filter, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "intra_pred_dc", quiet);
+
+    int mode = random_int(2,34);
+
+    accel   .intra_pred_angular<pixel_t>(out, SRC_STRIDE, border, nT, mode, filter, bit_depth);
+    fallback.intra_pred_angular<pixel_t>(ref, SRC_STRIDE, border, nT, mode, filter, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "intra_pred_angular", quiet);
+
+    // the reference samples are only filtered for blocks of 8x8 and larger
+    if (nT>=8) {
+      memcpy(bordermem_ref, bordermem, sizeof(bordermem));
+
+      accel   .intra_pred_smooth_border<pixel_t>(border,     nT, bit_depth);
+      fallback.intra_pred_smooth_border<pixel_t>(border_ref, nT, bit_depth);
+      ok &= compare_blocks(border-2*nT, border_ref-2*nT, 0, 4*nT+1,1,
+                           name, "intra_pred_smooth_border", quiet);
+    }
+  }
+
+  return ok;
+}
+
+
+class IntraPredictionTest : public Test
+{
+public:
+  const char* getName() const { return "intra"; }
+  const char* getDescription() const { return "intra prediction kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(3);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      ok &= test_intra_prediction<uint8_t>(variants[v].accel, fallback, 8,
+                                           variants[v].name, quiet);
+
+      for (int bit_depth=9; bit_depth<=12; bit_depth++) {
+        ok &= test_intra_prediction<uint16_t>(variants[v].accel, fallback, bit_depth,
+                                              variants[v].name, quiet);
+      }
+    }
+
+    return ok;
+  }
+} intratest;
+
+
+static const int deblock_beta_table[] = {
+   0, 6, 7, 8, 9,10,11,12,13,14,15,16,17,18,20,22,24,26,28,30,32,34,36,
+  38,40,42,44,46,48,50,52,54,56,58,60,62,64
+};
+
+static const int deblock_tc_table[] = {
+   0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,13,14,16,18,20,22,24
+};
+
+#define DEBLK_STRIDE 16
+
+/* Fill the lines across an edge with ramps, a step at the edge, and some noise, such
+   that all filter decisions occur.
+ */
+template <class pixel_t>
+static void fill_deblocking_edge(pixel_t* buf, bool vertical, int maxval)
+{
+  pixel_t* ptr = &buf[8*DEBLK_STRIDE+8];
+
+  int base  = random_int(0,maxval);
+  int slope = random_int(-2,2);
+  int step  = random_int(-maxval/16, maxval/16);
+  int noise = random_int(0,1) ? 0 : (1<<random_int(0,4))*(maxval+1)/256;
+
+  for (int k=0;k<8;k++)
+    for (int i=-4;i<4;i++) {
+      int v = base + slope*i + (i>=0 ? step : 0) + random_int(0,noise);
+      if (v<0) v=0;
+      if (v>maxval) v=maxval;
+
+      if (vertical) { ptr[i + k*DEBLK_STRIDE] = v; }
+      else          { ptr[k + i*DEBLK_STRIDE] = v; }
+    }
+}
+
+
+template <class pixel_t>
+static bool test_deblocking(const acceleration_functions& accel,
+                            const acceleration_functions& fallback,
+                            int bit_depth, const char* name, bool quiet)
+{
+  const int maxval = (1<<bit_depth)-1;
+
+  pixel_t buf[DEBLK_STRIDE*DEBLK_STRIDE];
+  pixel_t bufref[DEBLK_STRIDE*DEBLK_STRIDE];
+
+  pixel_t* ptr    = &buf   [8*DEBLK_STRIDE+8];
+  pixel_t* ptrref = &bufref[8*DEBLK_STRIDE+8];
+
+  bool ok = true;
+
+  for (int i=0;i<5000;i++) {
+    bool vertical = random_int(0,1);
+
+    // the 8x8 area around the edge
+    const int first = (vertical ? -4 : -4*DEBLK_STRIDE);
+
+    int beta[2], tc[2];
+    bool filterP[2], filterQ[2];
+
+    for (int s=0;s<2;s++) {
+      if (random_int(0,7)==0) {
+        beta[s] = tc[s] = 0;  // bS==0
+        filterP[s] = filterQ[s] = false;
+      }
+      else {
+        beta[s] = deblock_beta_table[random_int(0,36)] << (bit_depth-8);
+        tc[s]   = deblock_tc_table  [random_int(0,18)] << (bit_depth-8);
+        filterP[s] = random_int(0,7)!=0;  // PCM or transquant bypass
+        filterQ[s] = random_int(0,7)!=0;
+      }
+    }
+
+    fill_deblocking_edge(buf, vertical, maxval);
+    memcpy(bufref, buf, sizeof(buf));
+
+    accel   .deblock_luma<pixel_t>(vertical, ptr,    DEBLK_STRIDE, beta,tc, filterP,filterQ, bit_depth);
+    fallback.deblock_luma<pixel_t>(vertical, ptrref, DEBLK_STRIDE, beta,tc, filterP,filterQ, bit_depth);
+    ok &= compare_blocks(ptr+first, ptrref+first, DEBLK_STRIDE, 8,8,
+                         name, vertical ? "deblock_luma_v" : "deblock_luma_h", quiet);
+
+    fill_deblocking_edge(buf, vertical, maxval);
+    memcpy(bufref, buf, sizeof(buf));
+
+    accel   .deblock_chroma<pixel_t>(vertical, ptr,    DEBLK_STRIDE, tc, filterP,filterQ, bit_depth);
+    fallback.deblock_chroma<pixel_t>(vertical, ptrref, DEBLK_STRIDE, tc, filterP,filterQ, bit_depth);
+    ok &= compare_blocks(ptr+first, ptrref+first, DEBLK_STRIDE, 8,8,
+                         name, vertical ? "deblock_chroma_v" : "deblock_chroma_h", quiet);
+  }
+
+  return ok;
+}
+
+
+class DeblockingTest : public Test
+{
+public:
+  const char* getName() const { return "deblock"; }
+  const char* getDescription() const { return "deblocking filter kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(4);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      ok &= test_deblocking<uint8_t>(variants[v].accel, fallback, 8, variants[v].name, quiet);
+
+      for (int bit_depth=9; bit_depth<=12; bit_depth++) {
+        ok &= test_deblocking<uint16_t>(variants[v].accel, fallback, bit_depth,
+                                        variants[v].name, quiet);
+      }
+    }
+
+    return ok;
+  }
+} deblocktest;
+
+
+template <class pixel_t>
+static bool test_sao(const acceleration_functions& accel,
+                     const acceleration_functions& fallback,
+                     int bit_depth, const char* name, bool quiet)
+{
+  const int maxval = (1<<bit_depth)-1;
+
+  pixel_t srcbuf[SRC_STRIDE*SRC_STRIDE];
+  const pixel_t* src = &srcbuf[8*SRC_STRIDE+8];
+
+  pixel_t out[SRC_STRIDE*64];
+  pixel_t ref[SRC_STRIDE*64];
+
+  bool ok = true;
+
+  for (int i=0;i<2000;i++) {
+    // SAO is applied to parts of CTBs, which can have any size
+    int w = random_int(1,64);
+    int h = random_int(1,64);
+
+    // few different values, such that neighbors are often equal in the edge classification
+    int range = random_int(0,1) ? maxval : 2;
+    int base  = random_int(0,maxval-range);
+    for (int k=0;k<SRC_STRIDE*SRC_STRIDE;k++) { srcbuf[k] = base + random_int(0,range); }
+
+    int log2OffsetScale = (bit_depth>10 ? random_int(0,bit_depth-10) : 0);
+    int maxOffset = (1<<(libde265_min(bit_depth,10)-5))-1;
+
+    int8_t offsets[5];
+    for (int k=0;k<5;k++) {
+      offsets[k] = random_int(-maxOffset,maxOffset) * (1<<log2OffsetScale);
+    }
+
+    int bandPosition = random_int(0,31);
+
+    accel   .sao_band<pixel_t>(out, SRC_STRIDE, src, SRC_STRIDE, w,h, bandPosition, offsets, bit_depth);
+    fallback.sao_band<pixel_t>(ref, SRC_STRIDE, src, SRC_STRIDE, w,h, bandPosition, offsets, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, w,h, name, "sao_band", quiet);
+
+    offsets[2] = 0;
+    int eoClass = random_int(0,3);
+
+    accel   .sao_edge<pixel_t>(out, SRC_STRIDE, src, SRC_STRIDE, w,h, eoClass, offsets, bit_depth);
+    fallback.sao_edge<pixel_t>(ref, SRC_STRIDE, src, SRC_STRIDE, w,h, eoClass, offsets, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, w,h, name, "sao_edge", quiet);
+  }
+
+  return ok;
+}
+
+
+class SAOTest : public Test
+{
+public:
+  const char* getName() const { return "sao"; }
+  const char* getDescription() const { return "SAO band and edge offset kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(5);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      ok &= test_sao<uint8_t>(variants[v].accel, fallback, 8, variants[v].name, quiet);
+
+      for (int bit_depth=9; bit_depth<=12; bit_depth++) {
+        ok &= test_sao<uint16_t>(variants[v].accel, fallback, bit_depth, variants[v].name, quiet);
+      }
+    }
+
+    return ok;
+  }
+} saotest;
+
+
+/* Random coefficients in the top-left extent x extent square of an nT x nT block. Most
+   blocks have small coefficients, some use the full 16 bit range.
+ */
+static void random_coefficients(int16_t* coeffs, int nT, int extent)
+{
+  memset(coeffs, 0, nT*nT*sizeof(int16_t));
+
+  int maxCoeff = (random_int(0,3)==0 ? 32767 : (1<<random_int(2,10)));
+  int n = random_int(1, extent*extent);
+
+  for (int i=0;i<n;i++) {
+    coeffs[random_int(0,extent-1) + random_int(0,extent-1)*nT] = random_int(-maxCoeff,maxCoeff);
+  }
+}
+
+
+template <class pixel_t>
+static bool test_sparse_transforms(const acceleration_functions& accel,
+                                   const acceleration_functions& fallback,
+                                   int bit_depth, const char* name, bool quiet)
+{
+  const int maxval = (1<<bit_depth)-1;
+
+  ALIGNED_32(int16_t) coeffs[32*32];
+  ALIGNED_32(pixel_t) out[SRC_STRIDE*32];
+  ALIGNED_32(pixel_t) ref[SRC_STRIDE*32];
+
+  bool ok = true;
+
+  for (int i=0;i<2000;i++) {
+    int sizeIdx = random_int(0,3);
+    int nT = 4<<sizeIdx;
+
+    // DC only
+
+    random_coefficients(coeffs, nT, 1);
+    for (int k=0;k<SRC_STRIDE*32;k++) { out[k] = ref[k] = random_int(0,maxval); }
+
+    accel   .transform_add_dc<pixel_t>(out, SRC_STRIDE, coeffs[0], nT, bit_depth);
+    fallback.transform_add_dc<pixel_t>(ref, SRC_STRIDE, coeffs[0], nT, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "transform_add_dc", quiet);
+
+    // coefficients in a top-left square smaller than the block
+
+    if (nT>4) {
+      int extent = 4 << random_int(0,sizeIdx-1);
+
+      random_coefficients(coeffs, nT, extent);
+      for (int k=0;k<SRC_STRIDE*32;k++) { out[k] = ref[k] = random_int(0,maxval); }
+
+      accel   .transform_add_sparse<pixel_t>(sizeIdx, out, coeffs, SRC_STRIDE, extent, bit_depth);
+      fallback.transform_add_sparse<pixel_t>(sizeIdx, ref, coeffs, SRC_STRIDE, extent, bit_depth);
+      ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "transform_add_sparse", quiet);
+    }
+  }
+
+  return ok;
+}
+
+
+class SparseTransformTest : public Test
+{
+public:
+  const char* getName() const { return "transform-sparse"; }
+  const char* getDescription() const { return "DC-only and sparse inverse transform kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(6);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      ok &= test_sparse_transforms<uint8_t>(variants[v].accel, fallback, 8,
+                                            variants[v].name, quiet);
+
+      for (int bit_depth=9; bit_depth<=12; bit_depth++) {
+        ok &= test_sparse_transforms<uint16_t>(variants[v].accel, fallback, bit_depth,
+                                               variants[v].name, quiet);
+      }
+    }
+
+    return ok;
+  }
+} sparsetransformtest;
+
+
+template <class pixel_t>
+static bool test_transforms(const acceleration_functions& accel,
+                            const acceleration_functions& fallback,
+                            int bit_depth, const char* name, bool quiet)
+{
+  const int maxval = (1<<bit_depth)-1;
+  const int bdShift = 20-bit_depth;
+  const int max_coeff_bits = 15;
+
+  ALIGNED_32(int16_t) coeffs[32*32];
+  ALIGNED_32(pixel_t) out[SRC_STRIDE*32];
+  ALIGNED_32(pixel_t) ref[SRC_STRIDE*32];
+  ALIGNED_32(int32_t) residual[32*32];
+  ALIGNED_32(int32_t) residual_ref[32*32];
+
+  bool ok = true;
+
+  for (int i=0;i<2000;i++) {
+    int sizeIdx = random_int(0,3);
+    int nT = 4<<sizeIdx;
+
+    random_coefficients(coeffs, nT, nT);
+
+    // inverse transforms with addition to the prediction
+
+    for (int k=0;k<SRC_STRIDE*32;k++) { out[k] = ref[k] = random_int(0,maxval); }
+
+    accel   .transform_add<pixel_t>(sizeIdx, out, coeffs, SRC_STRIDE, bit_depth);
+    fallback.transform_add<pixel_t>(sizeIdx, ref, coeffs, SRC_STRIDE, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "transform_add", quiet);
+
+    if (nT==4) {
+      accel   .transform_4x4_dst_add<pixel_t>(out, coeffs, SRC_STRIDE, bit_depth);
+      fallback.transform_4x4_dst_add<pixel_t>(ref, coeffs, SRC_STRIDE, bit_depth);
+      ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "transform_4x4_dst_add", quiet);
+    }
+
+    // inverse transforms into a residual buffer
+
+    if (nT==4 && random_int(0,1)) {
+      accel   .transform_idst_4x4(residual,     coeffs, bdShift, max_coeff_bits);
+      fallback.transform_idst_4x4(residual_ref, coeffs, bdShift, max_coeff_bits);
+      ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_idst_4x4", quiet);
+    }
+    else {
+      void (*const accel_idct[4])(int32_t*, const int16_t*, int, int) = {
+        accel.transform_idct_4x4,   accel.transform_idct_8x8,
+        accel.transform_idct_16x16, accel.transform_idct_32x32
+      };
+      void (*const fallback_idct[4])(int32_t*, const int16_t*, int, int) = {
+        fallback.transform_idct_4x4,   fallback.transform_idct_8x8,
+        fallback.transform_idct_16x16, fallback.transform_idct_32x32
+      };
+
+      accel_idct   [sizeIdx](residual,     coeffs, bdShift, max_coeff_bits);
+      fallback_idct[sizeIdx](residual_ref, coeffs, bdShift, max_coeff_bits);
+      ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_idct", quiet);
+    }
+
+    accel   .add_residual<pixel_t>(out, SRC_STRIDE, residual_ref, nT, bit_depth);
+    fallback.add_residual<pixel_t>(ref, SRC_STRIDE, residual_ref, nT, bit_depth);
+    ok &= compare_blocks(out,ref,SRC_STRIDE, nT,nT, name, "add_residual", quiet);
+
+    // transform skip, RDPCM and transquant bypass
+
+    const int tsShift = 5 + sizeIdx+2;
+
+    accel   .transform_skip_residual(residual,     coeffs, nT, tsShift, bdShift);
+    fallback.transform_skip_residual(residual_ref, coeffs, nT, tsShift, bdShift);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_skip_residual", quiet);
+
+    accel   .rdpcm_v(residual,     coeffs, nT, tsShift, bdShift);
+    fallback.rdpcm_v(residual_ref, coeffs, nT, tsShift, bdShift);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "rdpcm_v", quiet);
+
+    accel   .rdpcm_h(residual,     coeffs, nT, tsShift, bdShift);
+    fallback.rdpcm_h(residual_ref, coeffs, nT, tsShift, bdShift);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "rdpcm_h", quiet);
+
+    accel   .transform_bypass(residual,     coeffs, nT);
+    fallback.transform_bypass(residual_ref, coeffs, nT);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_bypass", quiet);
+
+    accel   .transform_bypass_rdpcm_v(residual,     coeffs, nT);
+    fallback.transform_bypass_rdpcm_v(residual_ref, coeffs, nT);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_bypass_rdpcm_v", quiet);
+
+    accel   .transform_bypass_rdpcm_h(residual,     coeffs, nT);
+    fallback.transform_bypass_rdpcm_h(residual_ref, coeffs, nT);
+    ok &= compare_blocks(residual,residual_ref,nT, nT,nT, name, "transform_bypass_rdpcm_h", quiet);
+  }
+
+  return ok;
+}
+
+
+class TransformTest : public Test
+{
+public:
+  const char* getName() const { return "transform"; }
+  const char* getDescription() const { return "inverse transform and residual kernels"; }
+
+  bool work(bool quiet) {
+    random_seed(7);
+
+    std::vector<accel_variant> variants = optimized_variants();
+    acceleration_functions fallback;
+    init_acceleration_functions_fallback(&fallback);
+
+    bool ok = true;
+
+    for (size_t v=0;v<variants.size();v++) {
+      ok &= test_transforms<uint8_t>(variants[v].accel, fallback, 8, variants[v].name, quiet);
+
+      for (int bit_depth=9; bit_depth<=12; bit_depth++) {
+        ok &= test_transforms<uint16_t>(variants[v].accel, fallback, bit_depth,
+                                        variants[v].name, quiet);
+      }
+    }
+
+    return ok;
+  }
+} transformtest;
+
+
+
 int main(int argc,char** argv)
 {
   if (argc>=2) {
@@ -0,0 +1,394 @@
+/*
+ * H.265 video codec.
+ * Copyright (c) 2013-2014 struktur AG, Dirk Farin <farin@struktur.de>
+ *
+ * This file is part of libde265.
+ *
+ * libde265 is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libde265 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with libde265.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the task throughput of the decoder thread pool under contention.
+   Many tiny tasks are pushed through the pool and the time until all of them
+   have been executed is measured. For comparison, the same is done with a
+   simple pool that protects a std::deque with a single mutex (the scheme that
+   was used by libde265 before the lock-free task queue).
+
+   If a bitstream is given, the decoding speed is additionally measured for
+   the same range of thread counts. The number of page faults per frame in the
+   second half of the stream shows whether the decoder still allocates memory
+   once it reached its steady state.
+ */
+
+#include "libde265/threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <deque>
+#include <vector>
+
+
+static int nTasks = 200000;
+static int workPerTask = 50;
+static int maxThreads = 128;
+
+
+static long get_page_faults()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+
+double get_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  double t  = tv.tv_sec;
+  double ut = tv.tv_usec/1000000.0f;
+  t += ut;
+  return t;
+}
+
+
+// --- counting task ---
+
+struct completion
+{
+  de265_sync_int nDone;
+  int nTotal;
+
+  de265_mutex mutex;
+  de265_cond  cond;
+};
+
+static volatile int dummy_sink;
+
+class thread_task_count : public thread_task
+{
+public:
+  completion* compl_;
+
+  virtual void work()
+  {
+    int sum=0;
+    for (int i=0;i<workPerTask;i++) { sum += i*i; }
+    dummy_sink = sum;
+
+    if (de265_sync_add_and_fetch(&compl_->nDone, 1) == compl_->nTotal) {
+      de265_mutex_lock(&compl_->mutex);
+      de265_cond_broadcast(&compl_->cond, &compl_->mutex);
+      de265_mutex_unlock(&compl_->mutex);
+    }
+  }
+
+  virtual std::string name() const { return "count"; }
+};
+
+
+static void wait_for_completion(completion* c)
+{
+  de265_mutex_lock(&c->mutex);
+  while (c->nDone != c->nTotal) {
+    de265_cond_wait(&c->cond, &c->mutex);
+  }
+  de265_mutex_unlock(&c->mutex);
+}
+
+
+// --- reference pool: single mutex around a std::deque ---
+
+struct mutex_pool
+{
+  bool stopped;
+
+  std::deque<thread_task*> tasks;
+
+  std::vector<de265_thread> thread;
+  int num_threads;
+
+  de265_mutex mutex;
+  de265_cond  cond_var;
+};
+
+
+#ifndef _WIN32
+#define THREAD_RESULT       void*
+#define THREAD_PARAM        void*
+#else
+#define THREAD_RESULT       DWORD WINAPI
+#define THREAD_PARAM        LPVOID
+#endif
+
+static THREAD_RESULT mutex_pool_worker(THREAD_PARAM pool_ptr)
+{
+  mutex_pool* pool = (mutex_pool*)pool_ptr;
+
+  de265_mutex_lock(&pool->mutex);
+
+  while (true) {
+    while (pool->tasks.size()==0 && !pool->stopped) {
+      de265_cond_wait(&pool->cond_var, &pool->mutex);
+    }
+
+    if (pool->stopped) {
+      de265_mutex_unlock(&pool->mutex);
+      return 0;
+    }
+
+    thread_task* task = pool->tasks.front();
+    pool->tasks.pop_front();
+
+    de265_mutex_unlock(&pool->mutex);
+    task->work();
+    de265_mutex_lock(&pool->mutex);
+  }
+}
+
+
+static void start_mutex_pool(mutex_pool* pool, int num_threads)
+{
+  pool->stopped = false;
+  pool->num_threads = num_threads;
+  pool->thread.resize(num_threads);
+
+  de265_mutex_init(&pool->mutex);
+  de265_cond_init(&pool->cond_var);
+
+  for (int i=0;i<num_threads;i++) {
+    de265_thread_create(&pool->thread[i], mutex_pool_worker, pool);
+  }
+}
+
+
+static void stop_mutex_pool(mutex_pool* pool)
+{
+  de265_mutex_lock(&pool->mutex);
+  pool->stopped = true;
+  de265_mutex_unlock(&pool->mutex);
+
+  de265_cond_broadcast(&pool->cond_var, &pool->mutex);
+
+  for (int i=0;i<pool->num_threads;i++) {
+    de265_thread_join(pool->thread[i]);
+    de265_thread_destroy(&pool->thread[i]);
+  }
+
+  de265_mutex_destroy(&pool->mutex);
+  de265_cond_destroy(&pool->cond_var);
+}
+
+
+static void add_mutex_pool_task(mutex_pool* pool, thread_task* task)
+{
+  de265_mutex_lock(&pool->mutex);
+  pool->tasks.push_back(task);
+  de265_cond_signal(&pool->cond_var);
+  de265_mutex_unlock(&pool->mutex);
+}
+
+
+// --- benchmark ---
+
+static void init_tasks(std::vector<thread_task_count>& tasks, completion* c)
+{
+  c->nDone  = 0;
+  c->nTotal = tasks.size();
+
+  for (size_t i=0;i<tasks.size();i++) {
+    tasks[i].compl_ = c;
+  }
+}
+
+
+static double bench_thread_pool(int nThreads, std::vector<thread_task_count>& tasks, completion* c)
+{
+  thread_pool pool;
+  start_thread_pool(&pool, nThreads);
+
+  init_tasks(tasks, c);
+
+  double start = get_time();
+
+  for (size_t i=0;i<tasks.size();i++) {
+    add_task(&pool, &tasks[i]);
+  }
+
+  wait_for_completion(c);
+
+  double end = get_time();
+
+  stop_thread_pool(&pool);
+
+  return end-start;
+}
+
+
+static double bench_mutex_pool(int nThreads, std::vector<thread_task_count>& tasks, completion* c)
+{
+  mutex_pool pool;
+  start_mutex_pool(&pool, nThreads);
+
+  init_tasks(tasks, c);
+
+  double start = get_time();
+
+  for (size_t i=0;i<tasks.size();i++) {
+    add_mutex_pool_task(&pool, &tasks[i]);
+  }
+
+  wait_for_completion(c);
+
+  double end = get_time();
+
+  stop_mutex_pool(&pool);
+
+  return end-start;
+}
+
+
+static std::vector<uint8_t> read_file(const char* filename)
+{
+  std::vector<uint8_t> data;
+
+  FILE* fh = fopen(filename, "rb");
+  if (fh==NULL) {
+    fprintf(stderr,"cannot open file %s\n", filename);
+    exit(10);
+  }
+
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf,1,sizeof(buf),fh)) > 0) {
+    data.insert(data.end(), buf, buf+n);
+  }
+
+  fclose(fh);
+
+  return data;
+}
+
+
+static double bench_decoding(int nThreads, const std::vector<uint8_t>& stream, int* nFrames,
+                             double* steadyStateFaults)
+{
+  double start = get_time();
+
+  de265_decoder_context* ctx = de265_new_decoder();
+  de265_start_worker_threads(ctx, nThreads);
+
+  de265_push_data(ctx, &stream[0], stream.size(), 0, NULL);
+  de265_flush_data(ctx);
+
+  *nFrames = 0;
+
+  std::vector<long> faults; // page faults at each output frame
+
+  int more=1;
+  while (more) {
+    more = 0;
+
+    de265_error err = de265_decode(ctx, &more);
+    if (err != DE265_OK) {
+      break;
+    }
+
+    if (de265_get_next_picture(ctx)) {
+      (*nFrames)++;
+      faults.push_back(get_page_faults());
+    }
+
+    while (de265_get_warning(ctx) != DE265_OK) { }
+  }
+
+  de265_free_decoder(ctx);
+
+  *steadyStateFaults = 0;
+
+  int n = faults.size();
+  if (n >= 4) {
+    *steadyStateFaults = (faults[n-1] - faults[n/2]) / double(n-1 - n/2);
+  }
+
+  return get_time()-start;
+}
+
+
+int main(int argc, char** argv)
+{
+  while (1) {
+    int c = getopt(argc, argv, "n:w:t:h");
+    if (c == -1) break;
+
+    switch (c) {
+    case 'n': nTasks = atoi(optarg); break;
+    case 'w': workPerTask = atoi(optarg); break;
+    case 't': maxThreads = atoi(optarg); break;
+    case 'h':
+    default:
+      fprintf(stderr,"usage: thread-pool-bench [-n tasks] [-w work per task] [-t max threads] [bitstream]\n");
+      exit(c=='h' ? 0 : 5);
+    }
+  }
+
+  completion c;
+  de265_mutex_init(&c.mutex);
+  de265_cond_init(&c.cond);
+
+  std::vector<thread_task_count> tasks(nTasks);
+
+  printf("%d tasks, %d iterations of work per task\n\n", nTasks, workPerTask);
+  printf("threads   lock-free queue          mutex + deque\n");
+
+  for (int n=1; n<=maxThreads; n*=2) {
+    double tQueue = bench_thread_pool(n, tasks, &c);
+    double tMutex = bench_mutex_pool (n, tasks, &c);
+
+    printf("%7d   %7.3f s %9.0f/s   %7.3f s %9.0f/s\n", n,
+           tQueue, nTasks/tQueue,
+           tMutex, nTasks/tMutex);
+  }
+
+  de265_mutex_destroy(&c.mutex);
+  de265_cond_destroy(&c.cond);
+
+
+  // decoding speed
+
+  if (optind < argc) {
+    std::vector<uint8_t> stream = read_file(argv[optind]);
+
+    de265_disable_logging();
+
+    printf("\ndecoding %s\n\n", argv[optind]);
+    printf("threads   frames      time       fps   speedup   faults/frame\n");
+
+    double t1 = 0;
+
+    for (int n=0; n<=maxThreads; n = (n==0 ? 1 : n*2)) {
+      int nFrames;
+      double faults;
+      double t = bench_decoding(n, stream, &nFrames, &faults);
+      if (n==0) { t1=t; }
+
+      printf("%7d   %6d   %7.3f s  %8.2f   %6.2fx   %12.1f\n", n, nFrames, t, nFrames/t, t1/t, faults);
+    }
+  }
+
+  return 0;
+}